@@ -1,2 +1,4 @@
 from .client import Client
+from .pipelined_client import PipelinedClient
+from .pool import EnginePool
 from .wrapper import LychSim
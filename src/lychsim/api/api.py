@@ -21,18 +21,18 @@ Example:
 """
 
 import cv2
+import functools
 import numpy as np
 import math
 import time
 import os
 import re
-from io import BytesIO
-import PIL.Image
 import sys
 import warnings
 
 from lychsim.api.client import Client
-from lychsim.api.util import ResChecker
+from lychsim.api.pipelined_client import PipelinedClient
+from lychsim.api.util import ResChecker, bmp_view, decode_pool, imdecode, npy_view
 
 
 class UnrealCv_API(object):
@@ -40,7 +40,7 @@ class UnrealCv_API(object):
     A class to interact with UnrealCV, a toolkit for using Unreal Engine (UE) in Python.
     """
 
-    def __init__(self, port, ip, resolution, mode="tcp"):
+    def __init__(self, port, ip, resolution, mode="tcp", window=None):
         """
         Initialize the UnrealCV API.
 
@@ -49,6 +49,7 @@ class UnrealCv_API(object):
             ip (str): The IP address of the UnrealCV Server to connect to.
             resolution (tuple): The resolution of the images.
             mode (str): The connection mode, either 'tcp' or 'unix'. Default is 'tcp'. 'unix' is only for local machine in Linux.
+            window (int): If set, use a PipelinedClient with up to window requests in flight, so batch_cmd and get_img_batch keep the server busy. Default is None, one request at a time.
         """
         self.ip = ip
         self.resolution = resolution  # the resolution is not used.
@@ -57,6 +58,7 @@ class UnrealCv_API(object):
         self.obj_dict = dict()
         self.cam = dict()
         # build a client to connect to the env
+        self.window = window
         self.client = self.connect(ip, port, mode)
         self.client.message_handler = self.message_handler
         self.init_map()
@@ -71,9 +73,13 @@ class UnrealCv_API(object):
             mode (str): The connection mode, either 'tcp' or 'unix'. Default is 'tcp'.
 
         Returns:
-            unrealcv.Client: The connected client.
+            unrealcv.Client: The connected client, a PipelinedClient if the window is set.
         """
-        client = Client((ip, port))
+        if self.window is None:
+            make_client = Client
+        else:
+            make_client = functools.partial(PipelinedClient, window=self.window)
+        client = make_client((ip, port))
         client.connect()
         if mode == "unix":
             if (
@@ -90,9 +96,9 @@ class UnrealCv_API(object):
                 client.disconnect()  # disconnect the client for creating a new socket in linux
                 time.sleep(2)
                 if unix_socket_path is not None and os.path.exists(unix_socket_path):
-                    client = Client(unix_socket_path, "tcp")
+                    client = make_client(unix_socket_path, "tcp")
                 else:
-                    client = Client((ip, port))  # reconnect to the tcp socket
+                    client = make_client((ip, port))  # reconnect to the tcp socket
                 client.connect()
             else:
                 warnings.warn(
@@ -222,12 +228,24 @@ class UnrealCv_API(object):
             >>> print(results)  # [[0, 0, 90], [100.0, 200.0, 300.0]]
         """
 
-        res_list = self.client.request(cmds)
         if decoders is None:  # vset commands do not decode return
-            return res_list
-        for i, res in enumerate(res_list):
-            res_list[i] = decoders[i](res, **kwargs)
-        return res_list
+            return self.client.request(cmds)
+
+        # Decode on the decode pool, cv2 releases the GIL so the images are decoded in parallel
+        pool = decode_pool()
+        if isinstance(self.client, PipelinedClient):
+            # Decode the replies as they arrive, while the later requests are still in flight
+            futures = [self.client.submit(cmd) for cmd in cmds]
+            decoded = [
+                pool.submit(decoders[i], future.result(), **kwargs)
+                for i, future in enumerate(futures)
+            ]
+        else:
+            res_list = self.client.request(cmds)
+            decoded = [
+                pool.submit(decoders[i], res, **kwargs) for i, res in enumerate(res_list)
+            ]
+        return [future.result() for future in decoded]
 
     def save_image(self, cam_id, viewmode, path, return_cmd=False):
         """
@@ -373,21 +391,24 @@ class UnrealCv_API(object):
             dict: The updated camera information with images.
         """
         cmd_list = []
+        decoders = []
         # prepare command list
         for cam_id in cam_info.keys():
             for viewmode in cam_info[cam_id].keys():
                 mode = cam_info[cam_id][viewmode]["mode"]
+                inverse = cam_info[cam_id][viewmode]["inverse"]
                 cmd_list.append(self.get_image(cam_id, viewmode, mode, return_cmd=True))
+                decoders.append(
+                    lambda res, mode=mode, inverse=inverse: self.decoder.decode_img(
+                        res, mode, inverse
+                    )
+                )
 
-        res_list = self.client.request(cmd_list)
-        # decode images and store in cam_info
+        img_list = self.batch_cmd(cmd_list, decoders)
+        # store images in cam_info
         for cam_id in cam_info.keys():
             for viewmode in cam_info[cam_id].keys():
-                mode = cam_info[cam_id][viewmode]["mode"]
-                inverse = cam_info[cam_id][viewmode]["inverse"]
-                cam_info[cam_id][viewmode]["img"] = self.decoder.decode_img(
-                    res_list.pop(0), mode, inverse
-                )
+                cam_info[cam_id][viewmode]["img"] = img_list.pop(0)
         return cam_info
 
     def set_cam_pose(self, cam_id, pose):
@@ -1439,9 +1460,11 @@ class MsgDecoder(object):
         Returns:
             np.ndarray: The decoded image.
         """
-        img = np.asarray(PIL.Image.open(BytesIO(res)))
-        img = img[:, :, :-1]  # delete alpha channel
-        img = img[:, :, ::-1]  # transpose channel order
+        img = imdecode(res)  # BGRA
+        if img is None:
+            raise ValueError("Failed to decode image data")
+        if img.ndim == 3 and img.shape[2] == 4:
+            img = img[:, :, :3]  # delete alpha channel
         return img
 
     def decode_bmp(self, res):
@@ -1451,15 +1474,17 @@ class MsgDecoder(object):
             res (bytes): Raw BMP image data.
 
         Returns:
-            np.ndarray: RGB image array of shape (H, W, 3) in uint8 format.
+            np.ndarray: BGR image array of shape (H, W, 3) in uint8 format, a view of res if it is
+                a bmp of the server.
 
         Raises:
             ValueError: If image decoding fails.
         """
-        nparr = np.frombuffer(res, np.uint8)
-
-        # Decode image using OpenCV
-        img = cv2.imdecode(nparr, cv2.IMREAD_UNCHANGED)
+        # The bmp of the server is uncompressed, use its pixels in place
+        img = bmp_view(res)
+        if img is None:
+            # Decode image using OpenCV
+            img = imdecode(res)
 
         if img is None:
             raise ValueError("Failed to decode image data")
@@ -1479,7 +1504,7 @@ class MsgDecoder(object):
         Returns:
             np.ndarray: The decoded image.
         """
-        img = np.load(BytesIO(res))
+        img = npy_view(res)
         if len(img.shape) == 2:
             img = np.expand_dims(img, axis=-1)
         return img
@@ -1494,7 +1519,7 @@ class MsgDecoder(object):
         Returns:
             np.ndarray: The decoded depth image.
         """
-        depth = np.load(BytesIO(res))
+        depth = npy_view(res)
         if inverse:
             depth = 1 / depth
         return np.expand_dims(depth, axis=-1)
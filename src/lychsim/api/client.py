@@ -41,31 +41,22 @@ class SocketMessage:
         """
         Return only payload, not the raw message, None if failed.
         sock: a blocking socket for read data.
+
+        The payload is a bytearray the socket reads into directly, it is allocated once at its
+        full size, so a large frame is not copied while it arrives.
         """
-        # print(sock.gettimeout())
-        # rbufsize = -1 # From SocketServer.py
-        # rbufsize = 0
-        # rfile = sock.makefile('rb', rbufsize)
+        header = bytearray(8)
         try:
-            # raw_magic = rfile.read(4) # socket is disconnected or invalid
-            raw_magic = b""
-            while len(raw_magic) < 4:
-                recv_data = sock.recv(4)
-                if not recv_data:
-                    # socket closed by server
-                    print("Warning: socket disconnected by server")
-                    break
-                raw_magic += recv_data
+            if not cls._ReceiveInto(sock, memoryview(header)):
+                # socket closed by server
+                print("Warning: socket disconnected by server")
+                return None
         except Exception as e:
             print(f"fail to read raw_magic, exception: {e}")
             _L.debug('Fail to read raw_magic, exception: "%s"', e)
-            raw_magic = None
-
-        if not raw_magic:
-            # _L.debug('socket disconnect by server')
             return None
 
-        magic = struct.unpack(cls.fmt, raw_magic)[0]  # 'I' means unsigned int
+        magic, payload_size = struct.unpack("<II", header)
         if magic != cls.magic:
             print(
                 "Error: receive a malformat message, the message should start from a four bytes uint32 magic number"
@@ -75,38 +66,25 @@ class SocketMessage:
             )
             print("Actually received magic message: %s", repr(magic))
             return None
-            # The next time it will read four bytes again
-
-        # _L.debug('read payload')
-        # raw_payload_size = rfile.read(4)
-        raw_payload_size = sock.recv(4)
-        if not raw_payload_size:
-            print("Warning: socket disconnected by server")
-            return None
-        # print 'Receive raw payload size: %d, %s' % (len(raw_payload_size), raw_payload_size)
-        payload_size = struct.unpack("I", raw_payload_size)[0]
-        # _L.debug('Receive payload size %d', payload_size)
 
         # if the message is incomplete, should wait until all the data received
-        payload = b""
-        remain_size = payload_size
-        while remain_size > 0:
-            # data = rfile.read(remain_size)
-            data = sock.recv(remain_size)
-            if not data:
-                print("recv data is None!")
-                return None
-
-            payload += data
-            bytes_read = len(
-                data
-            )  # len(data) is its string length, but we want length of bytes
-            # print 'bytes_read %d, remain_size %d, read_str %s' % (bytes_read, remain_size, data)
-            assert bytes_read <= remain_size
-            remain_size -= bytes_read
-
+        payload = bytearray(payload_size)
+        if not cls._ReceiveInto(sock, memoryview(payload)):
+            print("recv data is None!")
+            return None
         return payload
 
+    @staticmethod
+    def _ReceiveInto(sock, view):
+        """Fill view from sock, false if the socket is closed first"""
+        received = 0
+        while received < len(view):
+            num_bytes = sock.recv_into(view[received:])
+            if num_bytes == 0:
+                return False
+            received += num_bytes
+        return True
+
     @classmethod
     def WrapAndSendPayload(cls, sock, payload):
         """
@@ -138,6 +116,43 @@ class SocketMessage:
             return False
 
 
+def recv_message(sock):
+    """
+    Read one framed payload from a blocking socket, for tools that talk to the server directly.
+    Unlike SocketMessage.ReceivePayload it raises ConnectionError instead of returning None.
+    """
+    header = bytearray(8)
+    if not SocketMessage._ReceiveInto(sock, memoryview(header)):
+        raise ConnectionError("Server closed the connection")
+    magic, payload_size = struct.unpack("<II", header)
+    if magic != SocketMessage.magic:
+        raise ConnectionError(f"Malformed message, magic {magic:#x}")
+    payload = bytearray(payload_size)
+    if not SocketMessage._ReceiveInto(sock, memoryview(payload)):
+        raise ConnectionError("Server closed the connection")
+    return payload
+
+
+def send_message(sock, payload):
+    """Send one framed payload in a single sendall, raise OSError if it fails"""
+    sock.sendall(struct.pack("<II", SocketMessage.magic, len(payload)) + payload)
+
+
+def connect_socket(endpoint, unix=False):
+    """Open a blocking socket to the server and wait for its connection confirm"""
+    sock = socket.socket(socket.AF_UNIX if unix else socket.AF_INET, socket.SOCK_STREAM)
+    try:
+        sock.connect(endpoint)
+        if not unix:
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        if not recv_message(sock).startswith(b"connected"):
+            raise ConnectionError(f"No connection confirm from {endpoint}")
+    except BaseException:
+        sock.close()
+        raise
+    return sock
+
+
 """
 BaseClient send message out and receiving message in a seperate thread.
 After calling the `send` function, only True or False will be returned
@@ -162,7 +177,7 @@ class Client:
         """
         self.endpoint = endpoint
         self.sock = None  # if socket == None, means client is not connected
-        self.raw_message_regexp = re.compile(rb"(\d{1,}):(.*)")  # A binary regexp
+        self.raw_message_regexp = re.compile(rb"(\d{1,}):")  # A binary regexp
         # self.message_id = 0
         self.wait_response = threading.Event()
         self.send_message_id = 0
@@ -185,11 +200,10 @@ class Client:
         match = self.raw_message_regexp.match(raw_message)
 
         if match:
-            [message_id, message_body] = (
-                int(match.group(1)),
-                match.group(2),
-            )
-            message_body = raw_message[len(match.group(1)) + 1 :]
+            message_id = int(match.group(1))
+            # Drop the id in place, deleting from the front of a bytearray does not copy it
+            del raw_message[: len(match.group(1)) + 1]
+            message_body = raw_message
             # Convert to utf-8 if it's not a byte array (as is the case for images)
             try:
                 message_body = message_body.decode("utf-8")
@@ -32,7 +32,7 @@ import getpass
 import subprocess
 import atexit
 import os
-import docker
+import socket
 import time
 import sys
 import warnings
@@ -367,20 +367,32 @@ class RunUnreal:
         Returns:
             bool: True if the port is free, False otherwise.
         """
-        import socket
-
-        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        try:
-            if "linux" in sys.platform or "darwin" in sys.platform:
-                sock.bind((ip, port))
-            elif "win" in sys.platform:
-                sock.bind((ip, port))
-                sock.connect((ip, port))
-        except Exception as e:
-            sock.close()
-            return False
+        return is_port_free(ip, port)
+
+
+def is_port_free(ip, port):
+    """
+    Check if the port is free, by binding it.
+
+    Args:
+        ip (str): The IP address.
+        port (int): The port number.
+
+    Returns:
+        bool: True if the port is free, False otherwise.
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    try:
+        if "linux" in sys.platform or "darwin" in sys.platform:
+            sock.bind((ip, port))
+        elif "win" in sys.platform:
+            sock.bind((ip, port))
+            sock.connect((ip, port))
+    except Exception as e:
         sock.close()
-        return True
+        return False
+    sock.close()
+    return True
 
 
 # run binary in docker
@@ -393,6 +405,8 @@ class RunDocker:
             path2env (str): The path to the Unreal environment.
             image (str): The Docker image to use. Default is 'zfw1226/unreal:latest'.
         """
+        import docker  # Only needed to run in docker
+
         self.docker_client = docker.from_env()
         self.check_image(target_images=image)
         os.system("xhost +")
@@ -426,7 +440,7 @@ class RunDocker:
             )
             sys.exit()
 
-        client = docker.from_env()
+        client = self.docker_client
         # network_settings = self.container.attrs['NetworkSettings']
         volumes = f"-v {self.path2env}:{ENV_DIR_DOCKER}:rw"
 
@@ -0,0 +1,343 @@
+"""A client that keeps many requests in flight.
+
+``Client`` waits for the reply of a request before it reads the next one and expects the replies
+in the order of the requests, so the server idles while the client sends, decodes and waits.
+``PipelinedClient`` sends requests as they are submitted and matches the replies to their requests
+by id, in any order. A socket thread does all reads and writes with a selector, and every request
+gets a ``concurrent.futures.Future``. Up to ``window`` requests are in flight, ``submit`` blocks
+when the window is full.
+
+Example:
+    >>> client = PipelinedClient(("localhost", 9000), window=256)
+    >>> client.connect()
+    >>> futures = [client.submit(f"vget /camera/{i}/lit png") for i in range(8)]
+    >>> images = [f.result() for f in futures]
+    >>> # In a coroutine
+    >>> location = await asyncio.wrap_future(client.submit("vget /camera/0/location"))
+
+The methods of ``Client`` (``request``, ``request_batch``, ``request_async``, ...) are available
+too, so it can be used in place of it.
+"""
+
+from collections import deque
+from concurrent.futures import Future
+import logging
+import selectors
+import socket
+import struct
+import threading
+
+from lychsim.api.client import SocketMessage
+
+_L = logging.getLogger(__name__)
+
+_HEADER = struct.Struct("<II")
+
+# Frames are joined into one send up to this size
+_MAX_SEND_SIZE = 4 << 20
+
+
+class PipelinedClient:
+    """
+    Send requests without waiting for the replies, and get them as futures.
+    """
+
+    def __init__(self, endpoint, type="inet", window=256):
+        """
+        Parameters:
+        endpoint: a tuple (ip, port), or the path of the unix socket
+        type: unix or inet
+        window: the number of requests in flight, submit blocks when it is reached
+        """
+        self.endpoint = endpoint
+        self.type = type
+        self.window = window
+        self.sock = None
+        self.error = None  # Why the connection was lost
+        self._slots = threading.Semaphore(window)
+        self._lock = threading.Lock()
+        self._pending = {}  # Request id -> Future
+        self._outbox = deque()  # Framed requests not sent yet
+        self._next_id = 0
+        self._closing = False
+        self._wake_r = self._wake_w = None
+        self._thread = None
+
+    def connect(self, timeout=5):
+        """
+        Try to connect to server, return whether connection successful
+        """
+        if self.isconnected():
+            return True
+        if self.type == "unix":
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        elif self.type == "inet":
+            sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        else:
+            raise NotImplementedError
+        try:
+            sock.settimeout(timeout)
+            sock.connect(self.endpoint)
+            if self.type == "inet":
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            message = SocketMessage.ReceivePayload(sock)
+        except OSError as e:
+            _L.error("Can not connect to %s, %s", str(self.endpoint), e)
+            sock.close()
+            return False
+        if message is None or not message.startswith(b"connected"):
+            _L.error("Can not get connection confirm from %s", str(self.endpoint))
+            sock.close()
+            return False
+        _L.info("Got connection confirm: %s", repr(message))
+
+        sock.setblocking(False)
+        self.sock = sock
+        self.error = None
+        self._closing = False
+        self._wake_r, self._wake_w = socket.socketpair()
+        self._wake_r.setblocking(False)
+        self._wake_w.setblocking(False)
+        self._thread = threading.Thread(target=self._io_loop, name="lychsim-io", daemon=True)
+        self._thread.start()
+        return True
+
+    def isconnected(self):
+        """Check whether client is connected to server"""
+        return self.sock is not None and self.error is None
+
+    def disconnect(self):
+        """Disconnect from server, the requests without a reply fail with ConnectionError"""
+        if self._thread is None:
+            return
+        with self._lock:
+            self._closing = True
+        self._wake()
+        self._thread.join()
+        self._thread = None
+        self.sock.close()
+        self.sock = None
+        self._wake_r.close()
+        self._wake_w.close()
+
+    def submit(self, message):
+        """
+        Send a request and return a Future of the reply, a str, or a bytearray if the reply is binary.
+        Blocks while window requests are in flight.
+        """
+        if not isinstance(message, bytes):
+            message = message.encode("utf-8")
+        self._slots.acquire()
+        future = Future()
+        with self._lock:
+            if self.sock is None or self._closing or self.error is not None:
+                self._slots.release()
+                raise ConnectionError(f"Not connected to {self.endpoint}: {self.error}")
+            request_id = self._next_id
+            # The server parses and echoes the id as an int32
+            self._next_id = (self._next_id + 1) & 0x7FFFFFFF
+            self._pending[request_id] = future
+            payload = b"%d:%s" % (request_id, message)
+            self._outbox.append(_HEADER.pack(SocketMessage.magic, len(payload)) + payload)
+        self._wake()
+        return future
+
+    def request(self, message, timeout=5):
+        """
+        Send a request and wait for the reply, as Client.request. A list of messages is sent as a
+        batch, and timeout -1 sends without waiting. Like Client, a positive timeout does not
+        limit the wait.
+        """
+        if timeout < 0:
+            if type(message) is list:
+                self.request_batch_async(message)
+            else:
+                self.request_async(message)
+            return True
+        if type(message) is list:
+            return self.request_batch(message)
+        return self.submit(message).result()
+
+    def request_async(self, message):
+        """
+        Send request without waiting for any reply
+        """
+        if type(message) is list:
+            return self.request_batch_async(message)
+        self.submit(message)
+        return None
+
+    def request_batch_async(self, batch):
+        """
+        Send a batch of requests without waiting for any reply
+        """
+        for message in batch:
+            self.submit(message)
+        return None
+
+    def request_batch(self, batch):
+        """
+        Send a batch of requests, keeping up to window in flight, and return the replies in order
+        """
+        futures = [self.submit(message) for message in batch]
+        return [future.result() for future in futures]
+
+    def num_pending(self):
+        """The number of requests without a reply"""
+        with self._lock:
+            return len(self._pending)
+
+    def _wake(self):
+        try:
+            self._wake_w.send(b"\0")
+        except (BlockingIOError, OSError):
+            pass  # Already woken
+
+    def _io_loop(self):
+        selector = selectors.DefaultSelector()
+        selector.register(self.sock, selectors.EVENT_READ)
+        selector.register(self._wake_r, selectors.EVENT_READ)
+        receiver = _FrameReceiver(self.sock)
+        to_send = None  # memoryview of the bytes being sent
+        want_write = False
+        try:
+            while True:
+                with self._lock:
+                    if self._closing:
+                        break
+                    if to_send is None and self._outbox:
+                        chunks, size = [], 0
+                        while self._outbox and size < _MAX_SEND_SIZE:
+                            chunks.append(self._outbox.popleft())
+                            size += len(chunks[-1])
+                        to_send = memoryview(b"".join(chunks))
+                if want_write != (to_send is not None):
+                    want_write = to_send is not None
+                    events = selectors.EVENT_READ | (selectors.EVENT_WRITE if want_write else 0)
+                    selector.modify(self.sock, events)
+
+                for key, events in selector.select():
+                    if key.fileobj is self._wake_r:
+                        try:
+                            while self._wake_r.recv(4096):
+                                pass
+                        except BlockingIOError:
+                            pass
+                        continue
+                    if events & selectors.EVENT_WRITE and to_send is not None:
+                        try:
+                            sent = self.sock.send(to_send)
+                        except BlockingIOError:
+                            sent = 0
+                        to_send = to_send[sent:] if sent < len(to_send) else None
+                    if events & selectors.EVENT_READ:
+                        for payload in receiver.receive():
+                            self._complete(payload)
+                        if receiver.closed:
+                            raise ConnectionError("The server closed the connection")
+        except Exception as e:
+            _L.error("Connection to %s lost, %s", str(self.endpoint), e)
+            with self._lock:
+                self.error = e
+        finally:
+            selector.close()
+            self._fail_pending(self.error or ConnectionError("Disconnected"))
+
+    def _complete(self, payload):
+        """Complete the future of the request a "<id>:<reply>" payload is for"""
+        colon = payload.find(b":")
+        with self._lock:
+            future = self._pending.pop(int(payload[:colon]), None)
+        if future is None:
+            _L.error("Got a reply to request %s, which was not sent", bytes(payload[:colon]))
+            return
+        self._slots.release()
+        # Drop the id in place, deleting from the front of a bytearray does not copy it
+        del payload[: colon + 1]
+        # Convert to utf-8 if it's not a byte array (as is the case for images)
+        try:
+            body = payload.decode("utf-8")
+        except UnicodeDecodeError:
+            body = payload
+        future.set_result(body)
+
+    def _fail_pending(self, error):
+        with self._lock:
+            pending = list(self._pending.values())
+            self._pending.clear()
+            self._outbox.clear()
+        for future in pending:
+            self._slots.release()
+            future.set_exception(error)
+
+
+class _FrameReceiver:
+    """
+    Read frames from a non-blocking socket without copying them more than once. The socket is
+    read into a reusable buffer, and the payloads of small frames are copied out of it. A large
+    payload is read straight into a bytearray of its size, which becomes the reply.
+    """
+
+    def __init__(self, sock, buffer_size=1 << 20, large_size=64 << 10):
+        self.sock = sock
+        self.buffer = bytearray(buffer_size)
+        self.view = memoryview(self.buffer)
+        self.begin = self.end = 0  # The bytes not parsed yet are buffer[begin:end]
+        self.large_size = large_size
+        self.large = None  # The payload being read into
+        self.large_received = 0
+        self.closed = False
+
+    def receive(self):
+        """Read what is available and return the completed payloads as bytearrays, closed is set
+        if the server closed the connection after them"""
+        payloads = []
+        while True:
+            try:
+                if self.large is not None:
+                    num_bytes = self.sock.recv_into(memoryview(self.large)[self.large_received :])
+                else:
+                    if self.end == len(self.buffer):
+                        self._compact()
+                    num_bytes = self.sock.recv_into(self.view[self.end :])
+            except BlockingIOError:
+                return payloads
+            if num_bytes == 0:
+                self.closed = True
+                return payloads
+
+            if self.large is not None:
+                self.large_received += num_bytes
+                if self.large_received == len(self.large):
+                    payloads.append(self.large)
+                    self.large = None
+            else:
+                self.end += num_bytes
+                self._parse(payloads)
+
+    def _parse(self, payloads):
+        while self.end - self.begin >= _HEADER.size:
+            magic, size = _HEADER.unpack_from(self.buffer, self.begin)
+            if magic != SocketMessage.magic:
+                raise ConnectionError(f"Malformed message, magic {magic:#x}")
+            start = self.begin + _HEADER.size
+            available = self.end - start
+            if available >= size:
+                payloads.append(bytearray(self.view[start : start + size]))
+                self.begin = start + size
+            elif size >= self.large_size:
+                # Move what arrived of it and read the rest in place
+                self.large = bytearray(size)
+                self.large[:available] = self.view[start : self.end]
+                self.large_received = available
+                self.begin = self.end = 0
+                return
+            else:
+                break
+        if self.begin == self.end:
+            self.begin = self.end = 0
+
+    def _compact(self):
+        remaining = self.end - self.begin
+        self.buffer[:remaining] = self.buffer[self.begin : self.end]
+        self.begin, self.end = 0, remaining
@@ -0,0 +1,467 @@
+"""A pool of engine instances on one machine, and a dispatcher that spreads jobs across them.
+
+``RunUnreal`` starts one binary and ``UnrealCv_API`` talks to one server. ``EnginePool`` starts N
+instances, each on its own port and unix socket ``/tmp/unrealcv_<port>.socket``, connects a
+``PipelinedClient`` to each, checks their health and restarts the ones that crash or stop
+answering. Jobs are functions called with an instance and a job, one at a time per instance, so
+an instance takes the next job as soon as it finishes one. Jobs with the same key run on the same
+instance when it is up, so a scene is loaded once per instance.
+
+Example:
+    >>> def render(instance, trajectory):
+    ...     images = []
+    ...     for x, y, z in trajectory:
+    ...         instance.request(f"lych cam set_loc 0 {x} {y} {z}")
+    ...         images.append(instance.request("lych cam get_lit 0 png"))
+    ...     return images
+    >>>
+    >>> with EnginePool.from_binary("path/to/UnrealBinary", 4, offscreen=True) as pool:
+    ...     images = pool.map(render, trajectories)
+    ...     print(pool.metrics())
+
+The command of ``EnginePool`` is a list of arguments, where ``{port}``, ``{index}``, ``{gpu}`` and
+``{unix_path}`` are replaced per instance, so the mock server can stand in for the engine:
+    >>> pool = EnginePool(["lychsim_mock_server", "--port", "{port}", "--unix"], 4)
+"""
+
+from collections import deque
+from concurrent.futures import Future
+import atexit
+import logging
+import os
+import subprocess
+import threading
+import time
+import zlib
+
+from lychsim.api.launcher import RunUnreal, is_port_free
+from lychsim.api.pipelined_client import PipelinedClient
+
+_L = logging.getLogger(__name__)
+
+
+class EngineInstance:
+    """
+    One engine process of a pool and the client connected to it. Jobs are called with it, and
+    send their requests with ``request`` or ``client``, which has the methods of ``Client``.
+    """
+
+    def __init__(self, index, ip, port, gpu=None):
+        self.index = index
+        self.ip = ip
+        self.port = port
+        self.gpu = gpu
+        self.unix_path = f"/tmp/unrealcv_{port}.socket"
+        self.process = None
+        self.client = None
+        self.state = "starting"  # starting, up, down, restarting or failed
+        self.queue = deque()  # Jobs with a key of this instance
+        self.restarts = 0
+        self.jobs = 0
+        self.failed_jobs = 0
+        self.busy_seconds = 0.0
+
+    def request(self, message, timeout=5):
+        """Send a request to the instance and wait for the reply, as Client.request"""
+        return self.client.request(message, timeout)
+
+    def is_alive(self):
+        """Whether the process is running and the client connected"""
+        return (
+            self.process is not None
+            and self.process.poll() is None
+            and self.client is not None
+            and self.client.isconnected()
+        )
+
+
+class EnginePool:
+    """
+    Launch N engine instances, keep them running and dispatch jobs to them.
+    """
+
+    def __init__(
+        self,
+        command,
+        num_instances,
+        ip="127.0.0.1",
+        base_port=9000,
+        type="inet",
+        window=64,
+        gpu_ids=None,
+        env=None,
+        log_dir=None,
+        startup_timeout=120,
+        health_interval=5,
+        health_timeout=30,
+        max_restarts=3,
+        retries=1,
+    ):
+        """
+        Parameters:
+        command: the arguments to launch an instance, {port}, {index}, {gpu} and {unix_path} are replaced
+        num_instances: the number of instances
+        ip: the address the instances listen on
+        base_port: the first port to try, busy ports are skipped
+        type: connect with inet (tcp) or unix sockets
+        window: the requests in flight per instance, see PipelinedClient
+        gpu_ids: the GPUs given to the instances in turn as {gpu}
+        env: environment variables added for the instances, e.g. {"DISPLAY": ":0"}
+        log_dir: if set, the output of instance i goes to log_dir/instance_<i>.log
+        startup_timeout: seconds to wait for an instance to accept a connection
+        health_interval: seconds between the health checks
+        health_timeout: seconds to wait for the reply of a health check, before restarting
+        max_restarts: restarts of an instance before it is given up
+        retries: times a job is run again on another instance when its instance is lost
+        """
+        self.command = list(command)
+        self.num_instances = num_instances
+        self.ip = ip
+        self.base_port = base_port
+        self.type = type
+        self.window = window
+        self.gpu_ids = gpu_ids
+        self.env = env
+        self.log_dir = log_dir
+        self.startup_timeout = startup_timeout
+        self.health_interval = health_interval
+        self.health_timeout = health_timeout
+        self.max_restarts = max_restarts
+        self.retries = retries
+        self.instances = []
+        self._cond = threading.Condition()
+        self._queue = deque()  # Jobs for any instance
+        self._closing = False
+        self._check_now = threading.Event()
+        self._threads = []
+        self._start_time = None
+
+    @classmethod
+    def from_binary(
+        cls,
+        ENV_BIN,
+        num_instances,
+        ENV_MAP=None,
+        resolution=(640, 480),
+        opengl=False,
+        offscreen=False,
+        nullrhi=False,
+        gpu_ids=None,
+        **kwargs,
+    ):
+        """
+        A pool of a packaged binary, found and configured as RunUnreal does. The port and the
+        resolution are passed on the command line, so unrealcv.ini is not changed.
+
+        Args:
+            ENV_BIN (str): The path to the executable Unreal Engine binary.
+            num_instances (int): The number of instances.
+            ENV_MAP (str, optional): The name of the Unreal Engine map. Default is None.
+            resolution (tuple): The resolution of the cameras. Default is (640, 480).
+            opengl (bool): Whether to use OpenGL rendering. Default is False (use Vulkan).
+            offscreen (bool): Whether to render offscreen. Default is False.
+            nullrhi (bool): Whether to use null RHI (turn off the graphics rendering). Default is False.
+            gpu_ids (list, optional): The GPUs given to the instances in turn. Default is None.
+            **kwargs: The other arguments of EnginePool.
+
+        Returns:
+            EnginePool: The pool, not started yet.
+        """
+        launcher = RunUnreal(ENV_BIN, ENV_MAP)
+        command = launcher.set_ue_options(
+            [os.path.abspath(launcher.path2binary)], opengl, offscreen, nullrhi
+        )
+        if gpu_ids is not None:
+            command.append("-graphicsadapter={gpu}")
+        command += [
+            "-UnrealCVPort={port}",
+            f"-UnrealCVWidth={resolution[0]}",
+            f"-UnrealCVHeight={resolution[1]}",
+        ]
+        return cls(command, num_instances, gpu_ids=gpu_ids, **kwargs)
+
+    def start(self):
+        """
+        Launch the instances and wait until all accept a connection.
+
+        Returns:
+            list: The instances.
+        """
+        port = self.base_port
+        for index in range(self.num_instances):
+            while not is_port_free(self.ip, port):
+                port += 1
+            gpu = None if not self.gpu_ids else self.gpu_ids[index % len(self.gpu_ids)]
+            self.instances.append(EngineInstance(index, self.ip, port, gpu))
+            port += 1
+
+        atexit.register(self.close)
+        # Launch all first, so that they load at the same time
+        for instance in self.instances:
+            self._launch(instance)
+        for instance in self.instances:
+            if not self._connect(instance):
+                self.close()
+                raise RuntimeError(f"Can not start instance {instance.index} on port {instance.port}")
+            instance.state = "up"
+            print(f"Instance {instance.index} is up on port {instance.port}, pid:{instance.process.pid}")
+
+        self._start_time = time.perf_counter()
+        for instance in self.instances:
+            thread = threading.Thread(
+                target=self._work, args=(instance,), name=f"lychsim-pool-{instance.index}", daemon=True
+            )
+            thread.start()
+            self._threads.append(thread)
+        monitor = threading.Thread(target=self._monitor, name="lychsim-pool-monitor", daemon=True)
+        monitor.start()
+        self._threads.append(monitor)
+        return self.instances
+
+    def close(self):
+        """
+        Cancel the jobs not started, wait for the running ones and stop the instances.
+        """
+        with self._cond:
+            if self._closing:
+                return
+            self._closing = True
+            pending = list(self._queue)
+            self._queue.clear()
+            for instance in self.instances:
+                pending += instance.queue
+                instance.queue.clear()
+            self._cond.notify_all()
+        for future, _, _, _, _ in pending:
+            # A job run again after its instance was lost is running already
+            if not future.cancel():
+                future.set_exception(RuntimeError("The pool is closed"))
+        self._check_now.set()
+        for thread in self._threads:
+            thread.join()
+        for instance in self.instances:
+            self._stop(instance)
+        atexit.unregister(self.close)
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def submit(self, fn, job, key=None):
+        """
+        Run fn(instance, job) on an instance and return a Future of its result. Jobs with the same
+        key run on the same instance while it is up.
+        """
+        future = Future()
+        with self._cond:
+            if self._closing:
+                raise RuntimeError("The pool is closed")
+            item = (future, fn, job, key, 0)
+            if key is None:
+                self._queue.append(item)
+            else:
+                instance = self._instance_of(key)
+                if instance.state == "failed":
+                    self._queue.append(item)
+                else:
+                    instance.queue.append(item)
+            self._cond.notify_all()
+        return future
+
+    def map(self, fn, jobs, key=None):
+        """
+        Run fn(instance, job) for every job and return the results in order.
+
+        Args:
+            fn (callable): Called with an EngineInstance and a job.
+            jobs (iterable): The jobs.
+            key (callable, optional): The key of a job, see submit. Default is None.
+
+        Returns:
+            list: The results.
+        """
+        futures = [self.submit(fn, job, None if key is None else key(job)) for job in jobs]
+        return [future.result() for future in futures]
+
+    def metrics(self):
+        """
+        Get the throughput of every instance.
+
+        Returns:
+            list: Per instance, the index, port, pid, state, restarts, jobs, failed_jobs,
+                busy_seconds, jobs_per_second and utilization (the share of the time it ran jobs).
+        """
+        elapsed = time.perf_counter() - self._start_time if self._start_time else 0.0
+        with self._cond:
+            return [
+                {
+                    "index": instance.index,
+                    "port": instance.port,
+                    "pid": instance.process.pid if instance.process else None,
+                    "state": instance.state,
+                    "restarts": instance.restarts,
+                    "jobs": instance.jobs,
+                    "failed_jobs": instance.failed_jobs,
+                    "busy_seconds": instance.busy_seconds,
+                    "jobs_per_second": instance.jobs / elapsed if elapsed > 0 else 0.0,
+                    "utilization": instance.busy_seconds / elapsed if elapsed > 0 else 0.0,
+                }
+                for instance in self.instances
+            ]
+
+    def _instance_of(self, key):
+        # crc32 rather than hash, so that a key goes to the same instance in every run
+        return self.instances[zlib.crc32(str(key).encode("utf-8")) % len(self.instances)]
+
+    def _launch(self, instance):
+        fields = {
+            "port": instance.port,
+            "index": instance.index,
+            "gpu": instance.gpu,
+            "unix_path": instance.unix_path,
+        }
+        command = [arg.format(**fields) for arg in self.command]
+        # The port is free, so a socket left there is from an instance that crashed
+        if os.path.exists(instance.unix_path):
+            os.remove(instance.unix_path)
+        env = None if self.env is None else {**os.environ, **self.env}
+        output = subprocess.DEVNULL
+        if self.log_dir is not None:
+            os.makedirs(self.log_dir, exist_ok=True)
+            output = open(os.path.join(self.log_dir, f"instance_{instance.index}.log"), "ab")
+        instance.process = subprocess.Popen(
+            command,
+            stdin=subprocess.DEVNULL,
+            stdout=output,
+            stderr=subprocess.STDOUT,
+            start_new_session=True,
+            env=env,
+        )
+        if output is not subprocess.DEVNULL:
+            output.close()
+
+    def _connect(self, instance):
+        """Wait for the instance to listen and connect to it, return whether it is connected"""
+        deadline = time.perf_counter() + self.startup_timeout
+        while time.perf_counter() < deadline:
+            if instance.process.poll() is not None:
+                _L.error("Instance %d exited with %d", instance.index, instance.process.returncode)
+                return False
+            listening = not is_port_free(instance.ip, instance.port)
+            if self.type == "unix":
+                listening = listening and os.path.exists(instance.unix_path)
+            if listening:
+                if self.type == "unix":
+                    client = PipelinedClient(instance.unix_path, "unix", window=self.window)
+                else:
+                    client = PipelinedClient((instance.ip, instance.port), window=self.window)
+                if client.connect():
+                    instance.client = client
+                    return True
+            time.sleep(0.5)
+        _L.error("Instance %d did not start in %d seconds", instance.index, self.startup_timeout)
+        return False
+
+    def _stop(self, instance):
+        if instance.client is not None:
+            instance.client.disconnect()
+            instance.client = None
+        if instance.process is not None and instance.process.poll() is None:
+            instance.process.terminate()
+            try:
+                instance.process.wait(10)
+            except subprocess.TimeoutExpired:
+                instance.process.kill()
+                instance.process.wait()
+
+    def _is_healthy(self, instance):
+        if not instance.is_alive():
+            return False
+        try:
+            instance.client.submit("vget /unrealcv/status").result(self.health_timeout)
+            return True
+        except Exception as e:
+            _L.error("Health check of instance %d failed, %r", instance.index, e)
+            return False
+
+    def _restart(self, instance):
+        with self._cond:
+            instance.state = "restarting"
+        _L.warning("Restarting instance %d on port %d", instance.index, instance.port)
+        self._stop(instance)
+        while instance.restarts < self.max_restarts and not self._closing:
+            instance.restarts += 1
+            self._launch(instance)
+            if self._connect(instance):
+                with self._cond:
+                    instance.state = "up"
+                    self._cond.notify_all()
+                return
+            self._stop(instance)
+
+        _L.error("Giving up instance %d after %d restarts", instance.index, instance.restarts)
+        with self._cond:
+            instance.state = "failed"
+            # Its keyed jobs run anywhere
+            self._queue.extend(instance.queue)
+            instance.queue.clear()
+            self._cond.notify_all()
+
+    def _monitor(self):
+        while not self._closing:
+            self._check_now.wait(self.health_interval)
+            self._check_now.clear()
+            for instance in self.instances:
+                if self._closing:
+                    break
+                if instance.state == "down" or (
+                    instance.state == "up" and not self._is_healthy(instance)
+                ):
+                    self._restart(instance)
+
+    def _work(self, instance):
+        while True:
+            with self._cond:
+                while not self._closing and (
+                    instance.state != "up" or not (instance.queue or self._queue)
+                ):
+                    if instance.state == "failed":
+                        return
+                    self._cond.wait()
+                if self._closing:
+                    return
+                queue = instance.queue if instance.queue else self._queue
+                future, fn, job, key, attempts = queue.popleft()
+            if attempts == 0 and not future.set_running_or_notify_cancel():
+                continue
+
+            start = time.perf_counter()
+            try:
+                result = fn(instance, job)
+            except Exception as e:
+                lost = isinstance(e, OSError) or not instance.is_alive()
+                with self._cond:
+                    instance.busy_seconds += time.perf_counter() - start
+                    instance.failed_jobs += 1
+                    if lost and instance.state == "up":
+                        # Take no more jobs until the monitor restarts it
+                        instance.state = "down"
+                    if lost and attempts < self.retries and not self._closing:
+                        # Run it again elsewhere, before the jobs queued after it
+                        self._queue.appendleft((future, fn, job, key, attempts + 1))
+                        self._cond.notify_all()
+                        retry = True
+                    else:
+                        retry = False
+                if lost:
+                    self._check_now.set()
+                if not retry:
+                    future.set_exception(e)
+                continue
+            with self._cond:
+                instance.busy_seconds += time.perf_counter() - start
+                instance.jobs += 1
+            future.set_result(result)
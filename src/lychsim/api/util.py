@@ -1,9 +1,11 @@
 # https://github.com/unrealcv/unrealcv/blob/5.2/client/python/unrealcv/util.py
 
+import ast
+from concurrent.futures import ThreadPoolExecutor
+import cv2
 import numpy as np
-import PIL.Image
-from io import BytesIO
 import os
+import struct
 import time
 import warnings
 
@@ -49,6 +51,29 @@ def measure_fps(func, *args, **kwargs):
     return fps
 
 
+_decode_pool = None
+
+
+def decode_pool():
+    """
+    Return the thread pool that decodes images. cv2.imdecode releases the GIL, so the images of a
+    batch are decoded in parallel.
+    """
+    global _decode_pool
+    if _decode_pool is None:
+        _decode_pool = ThreadPoolExecutor(
+            max_workers=min(8, os.cpu_count() or 1), thread_name_prefix="lychsim-decode"
+        )
+    return _decode_pool
+
+
+def imdecode(res):
+    """
+    Return the BGR or BGRA numpy array of a png or bmp reply, None if it can not be decoded
+    """
+    return cv2.imdecode(np.frombuffer(res, np.uint8), cv2.IMREAD_UNCHANGED)
+
+
 def read_png(res):
     """
     Return a numpy array from binary bytes of png format
@@ -61,20 +86,123 @@ def read_png(res):
     Returns
     -------
     numpy.array
-        Numpy array
+        Numpy array, RGB or RGBA
     """
-    img = None
-    try:
-        PIL_img = PIL.Image.open(BytesIO(res))
-        img = np.asarray(PIL_img)
-    except:
+    img = imdecode(res)
+    if img is None:
         print("Read png can not parse response %s" % str(res[:20]))
+        return None
+    if img.ndim == 3:
+        img = cv2.cvtColor(img, cv2.COLOR_BGRA2RGBA if img.shape[2] == 4 else cv2.COLOR_BGR2RGB)
     return img
 
 
+def npy_view(res, offset=0):
+    """
+    Return a numpy array that shares the memory of the npy at offset in res, without copying.
+    The array is read-only if res is bytes.
+
+    Parameters
+    ----------
+    res : bytes, bytearray or memoryview
+        For example, res = client.request('vget /camera/0/depth npy')
+
+    Returns
+    -------
+    numpy.array
+        Numpy array
+    """
+    if bytes(res[offset : offset + 6]) != b"\x93NUMPY":
+        raise ValueError("Not a npy: %s" % str(bytes(res[offset : offset + 20])))
+    major = res[offset + 6]
+    if major == 1:
+        (header_size,) = struct.unpack_from("<H", res, offset + 8)
+        data_offset = offset + 10 + header_size
+    else:
+        (header_size,) = struct.unpack_from("<I", res, offset + 8)
+        data_offset = offset + 12 + header_size
+    header = ast.literal_eval(bytes(res[data_offset - header_size : data_offset]).decode("latin1"))
+    dtype = np.dtype(header["descr"])
+    shape = header["shape"]
+    count = int(np.prod(shape)) if shape else 1
+    arr = np.frombuffer(res, dtype=dtype, count=count, offset=data_offset)
+    return arr.reshape(shape, order="F" if header["fortran_order"] else "C")
+
+
+def bmp_view(res):
+    """
+    Return the BGRA numpy array of a bmp sent by the server, sharing the memory of res, or None if
+    res is not one. FImageUtil::ConvertToBmp writes the pixels top-down after the 54 bytes of
+    headers and their byte count.
+    """
+    if len(res) < 58 or bytes(res[:2]) != b"BM":
+        return None
+    width, height, _, bit_count = struct.unpack_from("<iiHH", res, 18)
+    (num_bytes,) = struct.unpack_from("<i", res, 54)
+    if bit_count != 32 or height >= 0 or num_bytes != width * -height * 4 or len(res) < 58 + num_bytes:
+        return None
+    return np.frombuffer(res, np.uint8, count=num_bytes, offset=58).reshape(-height, width, 4)
+
+
+_RAW_HEADER = struct.Struct("<IHHBB4s2x4IIIQ3d3df")
+_RAW_MAGIC = 0x5452534C  # 'LSRT'
+_RAW_HEADER_SIZE = 128
+_RAW_DTYPES = {1: np.uint8, 2: np.float16, 3: np.float32}
+
+
+def raw_header(res, offset=0):
+    """
+    Parse the header of a raw reply at offset in res, see LychCore/RawTensor.h
+
+    Returns
+    -------
+    dict
+        dtype, shape, channel_order ("BGRA", "RGBA", "D" or "XYZ"), row_stride, trailer_size,
+        frame_id, location, rotation (pitch, yaw, roll) and fov of the camera
+    """
+    if len(res) < offset + _RAW_HEADER_SIZE:
+        raise ValueError("Not a raw tensor: %s" % str(bytes(res[offset : offset + 20])))
+    (magic, version, header_size, dtype, ndims, order, *rest) = _RAW_HEADER.unpack_from(res, offset)
+    if magic != _RAW_MAGIC or version != 1 or header_size != _RAW_HEADER_SIZE:
+        raise ValueError("Not a raw tensor: %s" % str(bytes(res[offset : offset + 20])))
+    shape, (row_stride, trailer_size, frame_id), pose, fov = rest[:4], rest[4:7], rest[7:13], rest[13]
+    return {
+        "dtype": np.dtype(_RAW_DTYPES[dtype]),
+        "shape": tuple(shape[:ndims]),
+        "channel_order": order.rstrip(b"\0").decode("ascii"),
+        "row_stride": row_stride,
+        "trailer_size": trailer_size,
+        "frame_id": frame_id,
+        "location": list(pose[:3]),
+        "rotation": list(pose[3:]),
+        "fov": fov,
+    }
+
+
+def raw_view(res, offset=0):
+    """
+    Return the array of a raw reply at offset in res, sharing its memory, and the header. The
+    tensor is at offset + 128, followed by header["trailer_size"] bytes.
+
+    Parameters
+    ----------
+    res : bytes, bytearray or memoryview
+        For example, res = client.request('lych cam get_lit 0 raw')
+
+    Returns
+    -------
+    tuple
+        (numpy.array, dict), see raw_header
+    """
+    header = raw_header(res, offset)
+    count = int(np.prod(header["shape"]))
+    arr = np.frombuffer(res, dtype=header["dtype"], count=count, offset=offset + _RAW_HEADER_SIZE)
+    return arr.reshape(header["shape"]), header
+
+
 def read_npy(res):
     """
-    Return a numpy array from binary bytes of numpy binary file format
+    Return a numpy array from binary bytes of numpy binary file format, sharing the memory of res
 
     Parameters
     ----------
@@ -89,8 +217,8 @@ def read_npy(res):
     # res is a binary buffer
     arr = None
     try:
-        arr = np.load(BytesIO(res))
-    except:
+        arr = npy_view(res)
+    except Exception:
         print("Read npy can not parse response %s" % str(res[:20]))
     return arr
 
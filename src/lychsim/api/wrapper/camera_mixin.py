@@ -1,40 +1,184 @@
 import io
 import json
+import struct
 
 import numpy as np
 from PIL import Image
 
+from ..util import npy_view, raw_view
+
+
+def region_args(size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None) -> str:
+    """Arguments that crop (x, y, w, h) and resize (w, h) an image on the GPU."""
+    args = ""
+    if roi is not None:
+        args += " -roi=" + ",".join(str(int(v)) for v in roi)
+    if size is not None:
+        args += f" -size={int(size[0])}x{int(size[1])}"
+    return args
+
 
 class CameraCommandsMixin:
     """Mixin for camera-related commands."""
 
-    def get_cam_lit(self, cam_id: int) -> Image.Image:
-        res = self.client.request(f"lych cam get_lit {cam_id} png")
+    def get_cam_lit(self, cam_id: int, size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None) -> Image.Image:
+        res = self.client.request(f"lych cam get_lit {cam_id} png" + region_args(size, roi))
         return Image.open(io.BytesIO(res))
 
+    def flush_writer(self, timeout: float = None) -> dict:
+        """Wait until the files queued by camera commands and the data
+        capture actor are written.
+        Args:
+            timeout (float): Seconds to wait at most, None waits forever.
+        Returns:
+            dict: status ("ok", "timeout" or "failed"), waited, queued_files,
+                and failed / failed_files, the files that could not be saved
+                since the last flush.
+        """
+        cmd = "lych data flush"
+        if timeout is not None:
+            cmd += f" -timeout={timeout}"
+        return json.loads(self.client.request(cmd))
+
+    def get_writer_stats(self, reset: bool = False) -> dict:
+        """Get queued bytes, encode and write time of the file writer threads."""
+        cmd = "lych data writer_stats" + (" -reset" if reset else "")
+        return json.loads(self.client.request(cmd))
+
     def warmup_cam(self, cam_id: int, num_steps: int = 10) -> None:
         for _ in range(num_steps):
             self.client.request(f"lych cam warmup {cam_id}")
 
-    def get_cam_seg(self, cam_id: int) -> Image.Image:
-        res = self.client.request(f"lych cam get_seg {cam_id} png")
-        res = self.client.request(f"lych cam get_seg {cam_id} png")
+    def get_cam_seg(self, cam_id: int, size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None) -> Image.Image:
+        res = self.client.request(f"lych cam get_seg {cam_id} png" + region_args(size, roi))
+        res = self.client.request(f"lych cam get_seg {cam_id} png" + region_args(size, roi))
         return Image.open(io.BytesIO(res))
 
-    def get_cam_normal(self, cam_id: int) -> Image.Image:
-        res = self.client.request(f"lych cam get_normal {cam_id} png")
-        res = self.client.request(f"lych cam get_normal {cam_id} png")
+    def get_seg_stats(
+        self, cam_id: int, mask: str = None, min_pixels: int = 1
+    ) -> tuple[dict, np.ndarray | Image.Image | None]:
+        """Get per-object pixel counts, 2D boxes and truncation flags.
+        Args:
+            cam_id (int): Camera ID.
+            mask (str): If "png", "bmp" or "npy", also return the segmentation mask.
+                The npy mask is uint8 (H, W, 4) in BGRA order.
+            min_pixels (int): Skip objects with fewer visible pixels.
+        Returns:
+            tuple: (stats, mask). stats maps object names to a dict with
+                color, pixels, bbox [xmin, ymin, xmax, ymax] and truncated
+                [left, top, right, bottom]. Objects grouped under one color
+                share a comma-separated name.
+        """
+        cmd = f"lych cam get_seg_stats {cam_id} -min_pixels={min_pixels}"
+        if mask is not None:
+            cmd += f" -mask={mask}"
+        res = self.client.request(cmd)
+        if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LSEG":
+            raise ValueError(f"Failed to get seg stats for camera {cam_id}: {res}")
+
+        _, _, row_size, width, height, num_rows, mask_bytes = struct.unpack_from("<IHHiiII", res, 0)
+        offset = 24
+        rows = np.frombuffer(
+            res,
+            dtype=np.dtype([("rgb", "u1", 3), ("trunc", "u1"), ("pixels", "<u4"), ("bbox", "<i4", 4)]),
+            count=num_rows,
+            offset=offset,
+        )
+        offset += num_rows * row_size
+
+        stats = {}
+        for row in rows:
+            (length,) = struct.unpack_from("<H", res, offset)
+            name = res[offset + 2 : offset + 2 + length].decode("utf-8")
+            offset += 2 + length
+            stats[name] = {
+                "color": row["rgb"].tolist(),
+                "pixels": int(row["pixels"]),
+                "bbox": row["bbox"].tolist(),
+                "truncated": [bool(row["trunc"] >> i & 1) for i in range(4)],
+            }
+
+        mask_data = None
+        if mask_bytes > 0 and mask == "npy":
+            mask_data = npy_view(res, offset)
+        elif mask_bytes > 0:
+            mask_data = Image.open(io.BytesIO(res[offset : offset + mask_bytes]))
+        return stats, mask_data
+
+    def get_cam_normal(self, cam_id: int, size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None) -> Image.Image:
+        res = self.client.request(f"lych cam get_normal {cam_id} png" + region_args(size, roi))
+        res = self.client.request(f"lych cam get_normal {cam_id} png" + region_args(size, roi))
         normal = np.array(Image.open(io.BytesIO(res)))[:, :, :3]
         return Image.fromarray(normal)
 
-    def get_cam_depth(self, cam_id: int) -> np.ndarray:
-        res = self.client.request(f"lych cam get_depth {cam_id} npy")
+    def get_cam_depth(self, cam_id: int, size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None) -> np.ndarray:
+        res = self.client.request(f"lych cam get_depth {cam_id} npy" + region_args(size, roi))
         try:
-            depth = np.load(io.BytesIO(res))
-            return depth
+            return npy_view(res)
         except Exception:
             raise ValueError(f"Failed to get depth for camera {cam_id}: {res}")
 
+    def get_cam_raw(
+        self, cam_id: int, mode: str = "lit", size: tuple[int, int] = None, roi: tuple[int, int, int, int] = None
+    ) -> tuple[np.ndarray, dict]:
+        """Get an image in the raw format, without encoding or decoding it.
+        Args:
+            cam_id (int): Camera ID.
+            mode (str): "lit", "seg", "normal" or "depth".
+            size, roi: Crop and resize on the GPU, see get_cam_lit.
+        Returns:
+            tuple: (array, header). The array is uint8 (H, W, 4) in the order
+                of header["channel_order"], "BGRA", or float32 (H, W) for
+                depth. The header has frame_id and the location, rotation and
+                fov of the camera when it was captured, see util.raw_header.
+        """
+        res = self.client.request(f"lych cam get_{mode} {cam_id} raw" + region_args(size, roi))
+        try:
+            return raw_view(res)
+        except Exception:
+            raise ValueError(f"Failed to get raw {mode} for camera {cam_id}: {res}")
+
+    def get_cam_multi(
+        self,
+        cam_ids: list[int],
+        mode: str = "lit",
+        fmt: str = None,
+        size: tuple[int, int] = None,
+        roi: tuple[int, int, int, int] = None,
+    ) -> dict:
+        """Capture many cameras with one command and one GPU readback.
+        Args:
+            cam_ids (list[int]): Camera IDs, the sensors of a stereo camera
+                are rendered back to back.
+            mode (str): "lit", "depth", "normal" or "seg".
+            fmt (str): "png" or "bmp" for images, "npy" for depth (default),
+                or "raw" for both.
+            size, roi: Crop and resize every image on the GPU, see get_cam_lit.
+        Returns:
+            dict: Camera ID to a PIL image, or a numpy array for depth. With
+                "raw", to a (array, header) tuple, see get_cam_raw.
+        """
+        cmd = f"lych cam get_multi {mode} " + " ".join(str(int(i)) for i in cam_ids)
+        if fmt is not None:
+            cmd += f" -format={fmt}"
+        res = self.client.request(cmd + region_args(size, roi))
+        if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LMCP":
+            raise ValueError(f"Failed to capture cameras {cam_ids}: {res}")
+
+        _, _, num_parts = struct.unpack_from("<IHH", res, 0)
+        parts = [struct.unpack_from("<iIII", res, 8 + 16 * i) for i in range(num_parts)]
+        offset = 8 + 16 * num_parts
+        images = {}
+        for cam_id, _, _, num_bytes in parts:
+            if fmt == "raw":
+                images[cam_id] = raw_view(res, offset)
+            elif mode == "depth":
+                images[cam_id] = npy_view(res, offset)
+            else:
+                images[cam_id] = Image.open(io.BytesIO(res[offset : offset + num_bytes]))
+            offset += num_bytes
+        return images
+
     def get_cam_loc(self, cam_id: int) -> list:
         """Get camera location in world space.
         Args:
@@ -110,5 +254,61 @@ class CameraCommandsMixin:
         res = self.client.request(f"lych cam get_annots {cam_id}")
         return json.loads(res)
 
+    def project_objects(
+        self,
+        cam_id: int,
+        obj_ids: list[str] = None,
+        what: tuple[str, ...] = ("aabb", "obb", "kp", "joints"),
+    ) -> dict:
+        """Project 3D boxes, keypoints and joints to pixels on the server.
+        Args:
+            cam_id (int): Camera ID.
+            obj_ids (list[str]): Objects to project, all objects if None.
+            what (tuple[str, ...]): Any of "aabb", "obb", "kp" and "joints".
+        Returns:
+            dict: Maps object names to a dict of (N, 3) arrays of [u, v, depth]
+                for "aabb" and "obb" (8 corners in get_bbox3d order), "kp" and
+                "joints", plus "kp_names" and "joint_names". A non-positive
+                depth means the point is behind the camera.
+        """
+        targets = "-all" if obj_ids is None else " ".join(obj_ids)
+        res = self.client.request(f"lych cam project {cam_id} {targets} -what={','.join(what)}")
+        if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LPRJ":
+            raise ValueError(f"Failed to project objects for camera {cam_id}: {res}")
+
+        _, _, _, _, _, num_actors, num_points, _ = struct.unpack_from("<IHHiiIII", res, 0)
+        offset = struct.calcsize("<IHHiiIII")
+        uvd = np.frombuffer(res, dtype="<f4", count=num_points * 3, offset=offset).reshape(-1, 3)
+        offset += num_points * 12
+        table = np.frombuffer(
+            res,
+            dtype=np.dtype([("offset", "<u4"), ("counts", "<u2", 4)]),
+            count=num_actors,
+            offset=offset,
+        )
+        offset += num_actors * 12
+
+        def read_name(offset):
+            (length,) = struct.unpack_from("<H", res, offset)
+            return res[offset + 2 : offset + 2 + length].decode("utf-8"), offset + 2 + length
+
+        outputs = {}
+        for row in table:
+            name, offset = read_name(offset)
+            n_aabb, n_obb, n_kp, n_joints = [int(x) for x in row["counts"]]
+            start = int(row["offset"])
+            entry = {}
+            for key, count in (("aabb", n_aabb), ("obb", n_obb), ("kp", n_kp), ("joints", n_joints)):
+                entry[key] = uvd[start : start + count]
+                start += count
+            point_names = []
+            for _ in range(n_kp + n_joints):
+                point_name, offset = read_name(offset)
+                point_names.append(point_name)
+            entry["kp_names"] = point_names[:n_kp]
+            entry["joint_names"] = point_names[n_kp:]
+            outputs[name] = entry
+        return outputs
+
     def clear_annot_comps(self) -> None:
         self.client.request("lych cam clear_annot_comps")
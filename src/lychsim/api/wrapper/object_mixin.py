@@ -1,8 +1,86 @@
+import base64
 import json
 import re
+import struct
+import time
 
 import numpy as np
 
+from ..util import raw_view
+
+
+def decode_obj_snapshot(res: bytes) -> dict:
+    """Decode the binary reply of "lych obj get_annots -format=bin".
+
+    Returns:
+        dict: "object_id" and "guid" lists, plus one float32 array of shape
+            (num_objects, width) per column (valid, aabb_center, aabb_extent,
+            bounds_center, bounds_extent, location, rotation, scale, color).
+    """
+    if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LOBJ":
+        raise ValueError(f"Invalid object snapshot: {res[:64]}")
+    _, _, num_columns, num_rows = struct.unpack_from("<IHHI", res, 0)
+    offset = 12
+    columns = []
+    for _ in range(num_columns):
+        name_len = res[offset]
+        name = res[offset + 1 : offset + 1 + name_len].decode("ascii")
+        width = res[offset + 1 + name_len]
+        columns.append((name, width))
+        offset += 2 + name_len
+    offset = (offset + 3) // 4 * 4
+
+    snapshot = {}
+    for name, width in columns:
+        count = num_rows * width
+        snapshot[name] = np.frombuffer(res, dtype="<f4", count=count, offset=offset).reshape(num_rows, width)
+        offset += count * 4
+
+    strings = []
+    for _ in range(num_rows * 2):
+        (length,) = struct.unpack_from("<H", res, offset)
+        strings.append(res[offset + 2 : offset + 2 + length].decode("utf-8"))
+        offset += 2 + length
+    snapshot["object_id"] = strings[0::2]
+    snapshot["guid"] = strings[1::2]
+    return snapshot
+
+
+def decode_obj_mesh(res: bytes) -> dict:
+    """Decode the binary reply of "lych obj get_mesh".
+
+    Returns:
+        dict: "vertices" float32 (V, 3), "normals" float32 (V, 3) and "faces"
+            uint32 (I / 3, 3) when requested, and "sections", one dict per mesh
+            component with its name, lod and vertex and index ranges.
+    """
+    if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LMSH":
+        raise ValueError(f"Invalid mesh data: {res[:64]}")
+    _, _, flags, num_vertices, num_indices, num_sections = struct.unpack_from("<IHHIII", res, 0)
+    offset = 20
+    sections = []
+    for _ in range(num_sections):
+        v_offset, v_count, i_offset, i_count, lod = struct.unpack_from("<IIIIi", res, offset)
+        sections.append(
+            dict(vertex_offset=v_offset, vertex_count=v_count, index_offset=i_offset, index_count=i_count, lod=lod)
+        )
+        offset += 20
+
+    mesh = {"vertices": np.frombuffer(res, dtype="<f4", count=num_vertices * 3, offset=offset).reshape(-1, 3)}
+    offset += num_vertices * 12
+    if flags & 1:
+        mesh["normals"] = np.frombuffer(res, dtype="<f4", count=num_vertices * 3, offset=offset).reshape(-1, 3)
+        offset += num_vertices * 12
+    if flags & 2:
+        mesh["faces"] = np.frombuffer(res, dtype="<u4", count=num_indices, offset=offset).reshape(-1, 3)
+        offset += num_indices * 4
+    for section in sections:
+        (length,) = struct.unpack_from("<H", res, offset)
+        section["name"] = res[offset + 2 : offset + 2 + length].decode("utf-8")
+        offset += 2 + length
+    mesh["sections"] = sections
+    return mesh
+
 
 class ObjectCommandsMixin:
     """Mixin for object-related commands."""
@@ -53,6 +131,32 @@ class ObjectCommandsMixin:
             params += f" -rot={rot}"
         self.client.request(f"lych obj update {obj_id}{params}")
 
+    def update_objs(self, records: list[dict]) -> str:
+        """Update transforms of many objects in one command.
+        Args:
+            records (list[dict]): Each record has "obj_id" and any of "loc"
+                [x, y, z], "rot" [pitch, yaw, roll] and "scale" [sx, sy, sz].
+        Returns:
+            str: One status code per record, "0" ok, "1" object not found,
+                "2" nothing to update.
+        """
+        buf = bytearray(struct.pack("<II", 0x4D46584C, len(records)))
+        for record in records:
+            obj_id = record["obj_id"].encode("utf-8")
+            mask = 0
+            values = [0.0] * 9
+            for bit, key in enumerate(("loc", "rot", "scale")):
+                if record.get(key) is not None:
+                    mask |= 1 << bit
+                    values[bit * 3 : bit * 3 + 3] = [float(x) for x in record[key]]
+            buf += struct.pack("<H", len(obj_id)) + obj_id
+            buf += struct.pack("<B9f", mask, *values)
+        data = base64.b64encode(bytes(buf)).decode("ascii")
+        res = json.loads(self.client.request(f"lych obj update_batch -data={data}"))
+        if res["status"] != "ok":
+            raise ValueError(f"Failed to update objects: {res['status']}")
+        return res["codes"]
+
     def get_obj_mask(
         self, cam_id: int, obj_id: str | list[str] = None
     ) -> tuple[list[str], np.ndarray]:
@@ -96,7 +200,15 @@ class ObjectCommandsMixin:
         res = self.client.request("lych obj list_selected")
         return json.loads(res)
 
-    def get_obj_annots(self) -> dict:
+    def get_obj_annots(self, format: str = "json") -> dict:
+        """Get annotations of all objects.
+        Args:
+            format (str): "json" for the per-object dict, or "bin" for a packed
+                column snapshot, see decode_obj_snapshot.
+        """
+        if format == "bin":
+            res = self.client.request("lych obj get_annots -all -format=bin")
+            return decode_obj_snapshot(res)
         res = self.client.request("lych obj get_annots -all")
         try:
             return json.loads(res)
@@ -114,9 +226,175 @@ class ObjectCommandsMixin:
         rot_str = " ".join(map(str, rot))
         self.client.request(f"lych obj add {obj_id} {obj_path} {loc_str} {rot_str}")
 
+    def spawn_objs(
+        self, objects: list[dict], budget_ms: float = None, physics: bool = True, wait: bool = True
+    ) -> dict:
+        """Spawn many objects in the background from one manifest.
+        Args:
+            objects (list[dict]): Each object has "path" and optionally "name",
+                "loc" [x, y, z], "rot" [pitch, yaw, roll] and "scale" [sx, sy, sz].
+            budget_ms (float): Time spent spawning per engine tick.
+            physics (bool): Simulate physics on the spawned objects, as add_obj does.
+            wait (bool): Poll until the job is done.
+        Returns:
+            dict: The job status, see spawn_status.
+        """
+        paths = {}
+        records = bytearray()
+        for obj in objects:
+            index = paths.setdefault(obj["path"], len(paths))
+            name = obj.get("name", "").encode("utf-8")
+            values = list(obj.get("loc", (0, 0, 0))) + list(obj.get("rot", (0, 0, 0))) + list(obj.get("scale", (1, 1, 1)))
+            records += struct.pack("<H", len(name)) + name + struct.pack("<I9f", index, *map(float, values))
+        buf = bytearray(struct.pack("<II", 0x4E50534C, len(paths)))
+        for path in paths:
+            path = path.encode("utf-8")
+            buf += struct.pack("<H", len(path)) + path
+        buf += struct.pack("<I", len(objects)) + records
+
+        data = base64.b64encode(bytes(buf)).decode("ascii")
+        cmd = f"lych obj spawn_batch -data={data}"
+        if budget_ms is not None:
+            cmd += f" -budget_ms={budget_ms}"
+        if not physics:
+            cmd += " -no_physics"
+        res = json.loads(self.client.request(cmd))
+        if res["status"] != "ok":
+            raise ValueError(f"Failed to spawn objects: {res['status']}")
+        status = self.spawn_status(res["job"])
+        while wait and not status["done"]:
+            time.sleep(0.05)
+            status = self.spawn_status(res["job"])
+        return status
+
+    def spawn_status(self, job: int, cancel: bool = False) -> dict:
+        """Progress of a spawn job: state, total, spawned, failed,
+        assets_loaded, assets_total, elapsed and the first errors. A finished
+        job is reported once, then the server forgets it."""
+        res = self.client.request(f"lych obj spawn_status {job}" + (" -cancel" if cancel else ""))
+        return json.loads(res)
+
     def del_obj(self, obj_id: str) -> None:
         self.client.request(f"lych obj del {obj_id}")
 
+    def get_obj_mesh(
+        self, obj_id: str, lod: int = 0, space: str = "world", normals: bool = False, indices: bool = False
+    ) -> dict:
+        """Get the vertices of an object for one LOD, see decode_obj_mesh.
+        Args:
+            space (str): "world", or "local" for the space of the actor.
+        """
+        cmd = f"lych obj get_mesh {obj_id} -lod={lod} -space={space}"
+        if normals:
+            cmd += " -normals"
+        if indices:
+            cmd += " -indices"
+        res = self.client.request(cmd)
+        if isinstance(res, str):
+            raise ValueError(f"Failed to get mesh: {res}")
+        return decode_obj_mesh(res)
+
+    def get_skinned_verts(self, obj_id: str | list[str] = None, lod: int = 0, raw: bool = False) -> dict[str, np.ndarray]:
+        """Get posed world space vertices of skinned meshes, skinned in parallel.
+        Args:
+            obj_id: One or more object IDs, or None for all objects with a skinned mesh.
+            raw (bool): Use the raw format of get_cam_raw, with the actor
+                table after the vertices.
+        Returns:
+            dict: Object ID to a float32 array of shape (num_vertices, 3).
+        """
+        targets = "-all" if obj_id is None else obj_id if isinstance(obj_id, str) else " ".join(obj_id)
+        res = self.client.request(f"lych obj get_skinned_verts {targets} -lod={lod}" + (" -format=raw" if raw else ""))
+        if raw:
+            try:
+                vertices, _ = raw_view(res)
+            except Exception:
+                raise ValueError(f"Failed to get skinned vertices: {res}")
+            # The trailer is the actor table, uint32 num actors, {offset, count}, then the names
+            offset = 128 + vertices.nbytes
+            (num_actors,) = struct.unpack_from("<I", res, offset)
+            table = np.frombuffer(res, dtype="<u4", count=num_actors * 2, offset=offset + 4).reshape(-1, 2)
+            offset += 4 + num_actors * 8
+            outputs = {}
+            for start, count in table:
+                (length,) = struct.unpack_from("<H", res, offset)
+                name = res[offset + 2 : offset + 2 + length].decode("utf-8")
+                offset += 2 + length
+                outputs[name] = vertices[start : start + count]
+            return outputs
+        if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LSKV":
+            raise ValueError(f"Failed to get skinned vertices: {res}")
+        _, _, _, num_actors, num_vertices = struct.unpack_from("<IHHII", res, 0)
+        table = np.frombuffer(res, dtype="<u4", count=num_actors * 2, offset=16).reshape(-1, 2)
+        offset = 16 + num_actors * 8
+        vertices = np.frombuffer(res, dtype="<f4", count=num_vertices * 3, offset=offset).reshape(-1, 3)
+        offset += num_vertices * 12
+        outputs = {}
+        for start, count in table:
+            (length,) = struct.unpack_from("<H", res, offset)
+            name = res[offset + 2 : offset + 2 + length].decode("utf-8")
+            offset += 2 + length
+            outputs[name] = vertices[start : start + count]
+        return outputs
+
+    def get_bones(self, obj_id: str | list[str] = None, space: str = "world", names: bool = True) -> dict:
+        """Get all bone transforms of skeletal meshes in one reply.
+        Args:
+            obj_id: One or more object IDs, or None for all objects.
+            space (str): "world" or "component".
+            names (bool): Also return the bone names, only needed once per skeleton.
+        Returns:
+            dict: Object ID to a dict with "transforms", a float32 array of shape
+                (num_bones, 3, 4), "valid", a bool array of shape (num_bones,) that is
+                False for bones not evaluated at the current LOD (their transforms are
+                stale), "skeleton", the skeletal mesh path, and "bone_names" if requested.
+        """
+        if obj_id is None:
+            cmd = "lych obj get_bones -all"
+        else:
+            obj_id_str = obj_id if isinstance(obj_id, str) else " ".join(obj_id)
+            cmd = f"lych obj get_bones {obj_id_str}"
+        cmd += f" -space={space}" + (" -names" if names else "")
+        res = self.client.request(cmd)
+        if not isinstance(res, (bytes, bytearray)) or res[:4] != b"LBON":
+            raise ValueError(f"Failed to get bones: {res}")
+        _, version, _, num_actors, num_skeletons, num_bones = struct.unpack_from("<IHHIII", res, 0)
+        table = np.frombuffer(res, dtype="<u4", count=num_actors * 3, offset=20).reshape(-1, 3)
+        offset = 20 + num_actors * 12
+        transforms = np.frombuffer(res, dtype="<f4", count=num_bones * 12, offset=offset).reshape(-1, 3, 4)
+        offset += num_bones * 48
+        if version >= 2:
+            valid = np.frombuffer(res, dtype=np.uint8, count=num_bones, offset=offset).astype(bool)
+            offset += num_bones
+        else:
+            valid = np.ones(num_bones, dtype=bool)
+
+        def read_str():
+            nonlocal offset
+            (length,) = struct.unpack_from("<H", res, offset)
+            s = res[offset + 2 : offset + 2 + length].decode("utf-8")
+            offset += 2 + length
+            return s
+
+        skeletons = []
+        for _ in range(num_skeletons):
+            path = read_str()
+            (num_names,) = struct.unpack_from("<I", res, offset)
+            offset += 4
+            skeletons.append((path, [read_str() for _ in range(num_names)]))
+        outputs = {}
+        for start, count, skeleton in table:
+            path, bone_names = skeletons[skeleton]
+            bones = {
+                "transforms": transforms[start : start + count],
+                "valid": valid[start : start + count],
+                "skeleton": path,
+            }
+            if names:
+                bones["bone_names"] = bone_names
+            outputs[read_str()] = bones
+        return outputs
+
     def get_mesh_extent(self, obj_id: str | list[str]) -> dict:
         obj_id_str = obj_id if isinstance(obj_id, str) else " ".join(obj_id)
         res = self.client.request(f"lych obj get_mesh_extent {obj_id_str}")
@@ -0,0 +1,57 @@
+import json
+
+
+class SimCommandsMixin:
+    """Mixin for simulation control commands."""
+
+    def set_lockstep(self, enable: bool = True, dt: float = None) -> dict:
+        """Pause the world between commands, it only advances with step.
+        Args:
+            enable (bool): Turn the lockstep mode on or off.
+            dt (float): Fixed delta time of a tick in seconds, 1/30 by default.
+        Returns:
+            dict: status, lockstep, dt, total_ticks and game_time.
+        """
+        cmd = "lych sim lockstep " + ("on" if enable else "off")
+        if dt is not None:
+            cmd += f" -dt={dt}"
+        return json.loads(self.client.request(cmd))
+
+    def get_lockstep(self) -> dict:
+        return json.loads(self.client.request("lych sim lockstep"))
+
+    def step(self, num_ticks: int = 1, dt: float = None, capture: bool = False) -> dict:
+        """Advance the world by exactly num_ticks fixed time steps, the reply
+        is sent after the last tick.
+        Args:
+            num_ticks (int): Number of ticks.
+            dt (float): Change the delta time of the lockstep mode.
+            capture (bool): Save a frame with every data capture actor after
+                the last tick.
+        Returns:
+            dict: status, ticks, captured, dt, total_ticks and game_time.
+        """
+        cmd = f"lych sim step {num_ticks}"
+        if dt is not None:
+            cmd += f" -dt={dt}"
+        if capture:
+            cmd += " -capture"
+        return json.loads(self.client.request(cmd))
+
+    def set_headless(self, enable: bool = True) -> dict:
+        """Only render the camera sensors, skip the main viewport, audio, HUD
+        and on screen debug messages.
+        """
+        return json.loads(self.client.request("lych sim headless " + ("on" if enable else "off")))
+
+    def bench_capture(self, cam_id: int, frames: int = 60, mode: str = "lit") -> dict:
+        """Capture once per frame with the headless mode off and on.
+        Args:
+            cam_id (int): ID of the camera.
+            frames (int): Frames measured for each mode.
+            mode (str): lit, depth, seg or normal.
+        Returns:
+            dict: captures_per_sec, frame_ms and capture_ms for headless_off
+                and headless_on, and the speedup.
+        """
+        return json.loads(self.client.request(f"lych sim bench_capture {cam_id} -frames={frames} -mode={mode}"))
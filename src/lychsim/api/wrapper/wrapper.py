@@ -1,9 +1,12 @@
+import json
+
 from ..api import Client
 from .camera_mixin import CameraCommandsMixin
 from .object_mixin import ObjectCommandsMixin
+from .sim_mixin import SimCommandsMixin
 
 
-class LychSim(CameraCommandsMixin, ObjectCommandsMixin):
+class LychSim(CameraCommandsMixin, ObjectCommandsMixin, SimCommandsMixin):
     """LychSim API Wrapper."""
 
     def __init__(
@@ -30,5 +33,69 @@ class LychSim(CameraCommandsMixin, ObjectCommandsMixin):
     def get_status(self) -> str:
         return self.client.request("vget /unrealcv/status")
 
+    def get_request_stats(self, fmt: str = "json") -> dict | str:
+        """Get latency and size histograms of the requests per command.
+        Args:
+            fmt (str): "json" returns a dict, "prometheus" the text format.
+        Returns:
+            dict | str: Per command, count, sum, mean, p50, p90, p99 and max
+                of queue_wait, dispatch, handler, serialize, send (in
+                microseconds), bytes_in and bytes_out.
+        """
+        res = self.client.request(f"vget /unrealcv/stats -format={fmt}")
+        return json.loads(res) if fmt == "json" else res
+
+    def reset_request_stats(self) -> None:
+        self.client.request("vset /unrealcv/stats/reset")
+
+    def set_trace(self, enabled: bool) -> None:
+        """Start or stop recording spans, starting drops the earlier spans."""
+        self.client.request(f"vset /unrealcv/trace {'on' if enabled else 'off'}")
+
+    def dump_trace(self, path: str = None) -> dict | str:
+        """Get the recorded spans as a Chrome trace.
+        Args:
+            path (str): If set, the server saves the trace to this path
+                instead of sending it.
+        Returns:
+            dict | str: The trace, open it in chrome://tracing or
+                ui.perfetto.dev, or the path it was saved to.
+        """
+        if path is not None:
+            return self.client.request(f"vget /unrealcv/trace {path}")
+        return json.loads(self.client.request("vget /unrealcv/trace"))
+
+    def set_request_log(self, verbosity: str = None, rate: float = None, path: str = None) -> None:
+        """Set the structured request log, the unset arguments are kept.
+        Args:
+            verbosity (str): "off", "errors", "summary" or "full".
+            rate (float): Share of the successful requests that are logged,
+                from 0 to 1. Failed requests are always logged.
+            path (str): JSONL file the server appends to.
+        """
+        cmd = "vset /unrealcv/request_log"
+        if verbosity is not None:
+            cmd += f" {verbosity}"
+        if rate is not None:
+            cmd += f" -rate={rate}"
+        if path is not None:
+            cmd += f" -path={path}"
+        self.client.request(cmd)
+
+    def get_request_log(self) -> dict:
+        """Get the settings of the request log and the number of logged and dropped records."""
+        return json.loads(self.client.request("vget /unrealcv/request_log"))
+
+    def start_recording(self, path: str) -> None:
+        """Record the requests to a binary log on the server side, replay it
+        with lychsim.tools.replay."""
+        self.client.request(f"vset /unrealcv/record start {path}")
+
+    def stop_recording(self) -> dict:
+        """Close the log, return its path and the number of recorded requests."""
+        status = json.loads(self.client.request("vget /unrealcv/record"))
+        self.client.request("vset /unrealcv/record stop")
+        return status
+
     def close(self) -> None:
         self.client.disconnect()
@@ -0,0 +1,390 @@
+"""End-to-end benchmarks of the Python API against a LychSim server.
+
+Measures the round trip latency and throughput of representative commands: echo, object get and
+set, ``get_annots -all`` and lit, seg and depth captures in each format at several resolutions.
+Every case runs
+
+* ``single``: one request at a time with ``Client.request``,
+* ``batch``: ``--batch`` requests at a time with ``Client.request_batch``,
+* ``pipelined``: up to ``--window`` requests in flight with ``PipelinedClient``,
+
+over tcp and the unix socket. Against a running editor
+
+    python -m lychsim.bench --port 9000 --json bench.json
+
+or against the mock server of ``ue_plugin/LychSim/Standalone``, which is started and stopped by
+the benchmark, e.g. in CI
+
+    python -m lychsim.bench --mock build/lychsim_mock_server --json bench.json
+
+The JSON has one entry per case, transport and mode, with the throughput and the latency
+percentiles, so runs can be compared over time.
+"""
+
+import argparse
+from dataclasses import asdict, dataclass, field
+import datetime
+import json
+import os
+import platform
+import re
+import socket
+import subprocess
+import time
+from typing import Callable, List, Optional
+
+import numpy as np
+
+from .api.client import Client, connect_socket, recv_message, send_message
+from .api.pipelined_client import PipelinedClient
+from .api.util import imdecode, npy_view, raw_view
+from .tools.replay import percentiles
+
+__all__ = ['BenchCase', 'BenchResult', 'make_cases', 'run_case', 'run_suite']
+
+MODES = ('single', 'batch', 'pipelined')
+
+# Formats a capture can be sent in
+CAPTURE_FORMATS = {'lit': ('png', 'bmp', 'raw'), 'seg': ('png', 'bmp', 'raw'), 'depth': ('npy', 'raw')}
+DECODERS = {'png': imdecode, 'bmp': imdecode, 'npy': npy_view, 'raw': raw_view}
+
+
+@dataclass
+class BenchCase:
+    name: str
+    command: str
+    group: str  # echo, object, annots or capture
+    decode: Optional[Callable[[bytes], object]] = None
+
+
+@dataclass
+class BenchResult:
+    case: str
+    command: str
+    transport: str
+    mode: str
+    requests: int = 0
+    errors: int = 0
+    seconds: float = 0.0
+    requests_per_second: float = 0.0
+    reply_mb_per_second: float = 0.0
+    reply_bytes: int = 0  # Of one reply
+    latency: dict = field(default_factory=dict)
+    first_error: str = ''
+
+
+def make_cases(object_id: str, camera_id: int = 0, resolutions=((320, 240), (640, 480), (1280, 720)),
+               decode: bool = False) -> List[BenchCase]:
+    """The commands of the suite, object_id is an object in the level for the get and set commands."""
+    cases = [
+        BenchCase('echo', 'vget /unrealcv/echo lychsim', 'echo'),
+        BenchCase('obj_get_loc', f'lych obj get_loc {object_id}', 'object'),
+        BenchCase('obj_set_loc', f'lych obj set_loc {object_id} 100 200 300', 'object'),
+        BenchCase('obj_get_loc_all', 'lych obj get_loc -all', 'object'),
+        BenchCase('annots_all', 'lych obj get_annots -all', 'annots'),
+    ]
+    for mode, formats in CAPTURE_FORMATS.items():
+        for fmt in formats:
+            for width, height in resolutions:
+                cases.append(BenchCase(
+                    f'{mode}_{fmt}_{width}x{height}',
+                    f'lych cam get_{mode} {camera_id} {fmt} -size={width}x{height}', 'capture',
+                    decode=DECODERS[fmt] if decode else None))
+    return cases
+
+
+def _as_bytes(reply) -> bytes:
+    if reply is None:
+        return b''
+    return reply if isinstance(reply, (bytes, bytearray)) else reply.encode('utf-8')
+
+
+def _is_error(reply: bytes) -> bool:
+    return reply.startswith(b'error')
+
+
+def _finish(result: BenchResult, latencies, replies, seconds: float) -> BenchResult:
+    result.requests = len(replies)
+    result.seconds = seconds
+    errors = [r for r in replies if _is_error(r)]
+    result.errors = len(errors)
+    if errors:
+        result.first_error = errors[0][:120].decode('utf-8', errors='replace')
+    total_bytes = sum(len(r) for r in replies)
+    result.reply_bytes = len(replies[-1]) if replies else 0
+    result.requests_per_second = len(replies) / seconds if seconds > 0 else 0.0
+    result.reply_mb_per_second = total_bytes / 1e6 / seconds if seconds > 0 else 0.0
+    result.latency = percentiles(latencies)
+    return result
+
+
+def _run_single(client: Client, case: BenchCase, iterations: int, warmup: int):
+    for _ in range(warmup):
+        client.request(case.command)
+    latencies, replies = [], []
+    start = time.perf_counter()
+    for _ in range(iterations):
+        sent = time.perf_counter()
+        reply = _as_bytes(client.request(case.command))
+        if case.decode is not None and not _is_error(reply):
+            case.decode(reply)
+        latencies.append(time.perf_counter() - sent)
+        replies.append(reply)
+    return latencies, replies, time.perf_counter() - start
+
+
+def _run_batch(client: Client, case: BenchCase, iterations: int, warmup: int, batch: int):
+    """The latency of a request is the latency of its batch."""
+    client.request_batch([case.command] * max(warmup, 1))
+    latencies, replies = [], []
+    start = time.perf_counter()
+    for first in range(0, iterations, batch):
+        size = min(batch, iterations - first)
+        sent = time.perf_counter()
+        batch_replies = [_as_bytes(r) for r in client.request_batch([case.command] * size)]
+        if case.decode is not None:
+            for reply in batch_replies:
+                if not _is_error(reply):
+                    case.decode(reply)
+        latency = time.perf_counter() - sent
+        latencies += [latency] * size
+        replies += batch_replies
+    return latencies, replies, time.perf_counter() - start
+
+
+def _run_pipelined(client: PipelinedClient, case: BenchCase, iterations: int, warmup: int):
+    """Up to client.window requests in flight, a request is done when its future is."""
+    for future in [client.submit(case.command) for _ in range(warmup)]:
+        future.result()
+    send_times = [0.0] * iterations
+    done_times = [0.0] * iterations
+
+    def on_done(i):
+        def callback(_):
+            done_times[i] = time.perf_counter()
+        return callback
+
+    start = time.perf_counter()
+    futures = []
+    for i in range(iterations):
+        # After submit, which blocks while the window is full, so the latency is comparable to the
+        # single mode. A reply that is already in runs its callback as it is added, never before
+        future = client.submit(case.command)
+        send_times[i] = time.perf_counter()
+        future.add_done_callback(on_done(i))
+        futures.append(future)
+    replies = []
+    for future in futures:
+        reply = _as_bytes(future.result())
+        if case.decode is not None and not _is_error(reply):
+            case.decode(reply)
+        replies.append(reply)
+    seconds = time.perf_counter() - start
+    return [done - sent for sent, done in zip(send_times, done_times)], replies, seconds
+
+
+def run_case(case: BenchCase, connection, unix: bool, mode: str, iterations: int = 100, warmup: int = 5,
+             batch: int = 16) -> BenchResult:
+    """Run one case, connection is a connected Client for the single and batch modes and a
+    PipelinedClient for the pipelined mode."""
+    result = BenchResult(case=case.name, command=case.command, transport='unix' if unix else 'tcp', mode=mode)
+    if mode == 'single':
+        latencies, replies, seconds = _run_single(connection, case, iterations, warmup)
+    elif mode == 'batch':
+        latencies, replies, seconds = _run_batch(connection, case, iterations, warmup, batch)
+    elif mode == 'pipelined':
+        latencies, replies, seconds = _run_pipelined(connection, case, iterations, warmup)
+    else:
+        raise ValueError(f'Unknown mode {mode}, expect one of {MODES}')
+    return _finish(result, latencies, replies, seconds)
+
+
+def _retry(connect: Callable[[], object], timeout: float = 5.0):
+    """The plugin serves one client at a time and notices a closed one on its next tick."""
+    deadline = time.perf_counter() + timeout
+    while True:
+        try:
+            result = connect()
+        except (ConnectionError, OSError):
+            if time.perf_counter() > deadline:
+                raise
+            result = None
+        if result or time.perf_counter() > deadline:
+            return result
+        time.sleep(0.2)
+
+
+def _iterations_for(case: BenchCase, iterations: int, capture_iterations: int) -> int:
+    return capture_iterations if case.group in ('capture', 'annots') else iterations
+
+
+def run_suite(endpoints, cases: List[BenchCase], modes=MODES, iterations: int = 200,
+              capture_iterations: int = 30, warmup: int = 3, batch: int = 16, window: int = 8,
+              progress: Optional[Callable[[BenchResult], None]] = None) -> List[BenchResult]:
+    """Run every case in every mode on each of endpoints, a list of (endpoint, unix)."""
+    results = []
+
+    def run_modes(connection, unix, case_modes):
+        for case in cases:
+            for mode in case_modes:
+                result = run_case(case, connection, unix, mode,
+                                  iterations=_iterations_for(case, iterations, capture_iterations),
+                                  warmup=warmup, batch=batch)
+                results.append(result)
+                if progress is not None:
+                    progress(result)
+
+    for endpoint, unix in endpoints:
+        # One connection at a time, the plugin rejects a second client
+        client_modes = [m for m in modes if m in ('single', 'batch')]
+        if client_modes:
+            client = Client(endpoint, 'unix' if unix else 'inet')
+            if not client.connect():
+                raise ConnectionError(f'Can not connect to {endpoint}')
+            try:
+                run_modes(client, unix, client_modes)
+            finally:
+                client.disconnect()
+        if 'pipelined' in modes:
+            client = PipelinedClient(endpoint, 'unix' if unix else 'inet', window=window)
+            if not _retry(client.connect):
+                raise ConnectionError(f'Can not connect to {endpoint}')
+            try:
+                run_modes(client, unix, ['pipelined'])
+            finally:
+                client.disconnect()
+    return results
+
+
+def _server_info(endpoint, unix: bool):
+    """The version of the server and the first object in the level, for the get and set commands."""
+    sock = _retry(lambda: connect_socket(endpoint, unix))
+    try:
+        send_message(sock, b'0:vget /unrealcv/version')
+        version = recv_message(sock).partition(b':')[2].decode('utf-8', errors='replace')
+        send_message(sock, b'1:lych obj list')
+        names = recv_message(sock).partition(b':')[2].decode('utf-8', errors='replace').split()
+    finally:
+        sock.close()
+    return version, names[0] if names and names[0] != 'error' else None
+
+
+def _free_port() -> int:
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+class MockServer:
+    """Start the mock server of Standalone/ for the duration of a with block."""
+
+    def __init__(self, binary: str, port: Optional[int] = None, extra_args=()):
+        self.binary = binary
+        self.port = port or _free_port()
+        self.unix_path = f'/tmp/unrealcv_{self.port}.socket'
+        self.extra_args = list(extra_args)
+        self.process = None
+
+    def __enter__(self):
+        self.process = subprocess.Popen(
+            [self.binary, '--port', str(self.port), '--unix'] + self.extra_args,
+            stdout=subprocess.PIPE, text=True)
+        line = self.process.stdout.readline()  # Printed once it listens
+        if 'listening' not in line:
+            self.process.kill()
+            raise RuntimeError(f'The mock server did not start: {line.strip()}')
+        return self
+
+    def __exit__(self, *exc):
+        self.process.terminate()
+        self.process.wait(timeout=10)
+
+
+def _print_result(result: BenchResult) -> None:
+    latency = result.latency
+    status = f' {result.errors} errors, {result.first_error}' if result.errors else ''
+    print(f'{result.case:<24} {result.transport:<5} {result.mode:<10} {result.requests_per_second:>9.1f} req/s '
+          f'{result.reply_mb_per_second:>8.2f} MB/s  p50 {latency.get("p50_ms", 0):>7.2f}ms '
+          f'p99 {latency.get("p99_ms", 0):>7.2f}ms{status}', flush=True)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description='Benchmark the LychSim Python API end to end.')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=9000)
+    parser.add_argument('--unix', default=None,
+                        help='Unix socket path, /tmp/unrealcv_<port>.socket if it exists')
+    parser.add_argument('--transports', default='tcp,unix', help='tcp, unix or both')
+    parser.add_argument('--mock', default=None, metavar='BINARY',
+                        help='Start this lychsim_mock_server on a free port and benchmark it')
+    parser.add_argument('--modes', default=','.join(MODES))
+    parser.add_argument('--cases', default=None, help='Regular expression of the case names to run')
+    parser.add_argument('--resolutions', default='320x240,640x480,1280x720')
+    parser.add_argument('--camera', type=int, default=0)
+    parser.add_argument('--object', default=None, help='Object for get/set, the first of lych obj list by default')
+    parser.add_argument('--iterations', type=int, default=200, help='Requests per case')
+    parser.add_argument('--capture-iterations', type=int, default=30, help='Requests per capture and annotation case')
+    parser.add_argument('--warmup', type=int, default=3)
+    parser.add_argument('--batch', type=int, default=16, help='Requests per batch in the batch mode')
+    parser.add_argument('--window', type=int, default=8, help='Requests in flight in the pipelined mode')
+    parser.add_argument('--decode', action='store_true', help='Also decode the images and arrays')
+    parser.add_argument('--json', default=None, help='Write the results to this file')
+    args = parser.parse_args(argv)
+
+    resolutions = [tuple(int(v) for v in r.split('x')) for r in args.resolutions.split(',') if r]
+    modes = [m for m in args.modes.split(',') if m]
+    transports = [t for t in args.transports.split(',') if t]
+
+    mock = MockServer(args.mock) if args.mock else None
+    if mock is not None:
+        mock.__enter__()
+    try:
+        port = mock.port if mock is not None else args.port
+        host = '127.0.0.1' if mock is not None else args.host
+        unix_path = args.unix or f'/tmp/unrealcv_{port}.socket'
+        endpoints = []
+        if 'tcp' in transports:
+            endpoints.append(((host, port), False))
+        if 'unix' in transports:
+            if os.path.exists(unix_path):
+                endpoints.append((unix_path, True))
+            else:
+                print(f'Skip the unix socket, {unix_path} does not exist')
+        if not endpoints:
+            parser.error('No transport to benchmark')
+
+        version, first_object = _server_info(*endpoints[0])
+        object_id = args.object or first_object
+        if object_id is None:
+            parser.error('The level has no objects, pass --object')
+        cases = make_cases(object_id, args.camera, resolutions, args.decode)
+        if args.cases:
+            cases = [c for c in cases if re.search(args.cases, c.name)]
+
+        start = time.time()
+        results = run_suite(endpoints, cases, modes, iterations=args.iterations,
+                            capture_iterations=args.capture_iterations, warmup=args.warmup,
+                            batch=args.batch, window=args.window, progress=_print_result)
+        report = {
+            'time': datetime.datetime.fromtimestamp(start).isoformat(timespec='seconds'),
+            'seconds': time.time() - start,
+            'server': 'mock' if mock is not None else f'{host}:{port}',
+            'server_version': version,
+            'host': platform.node(),
+            'python': platform.python_version(),
+            'settings': {k: v for k, v in vars(args).items() if k not in ('json', 'mock')},
+            'results': [asdict(r) for r in results],
+        }
+    finally:
+        if mock is not None:
+            mock.__exit__(None, None, None)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(report, f, indent=2)
+    if any(r.errors for r in results):
+        print('Some requests failed, see first_error in the results')
+
+
+if __name__ == '__main__':
+    main()
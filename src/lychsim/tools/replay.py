@@ -0,0 +1,274 @@
+"""Replay requests recorded by the server against a running server.
+
+Record with ``vset /unrealcv/record start <path>`` (or ``-UnrealCVRecord=<path>`` on the command
+line), stop with ``vset /unrealcv/record stop``, then run
+
+    python -m lychsim.tools.replay requests.lrec --port 9000 --speed max
+
+The requests are sent in the recorded order, either at their original pace (``--speed original``
+or a factor such as ``2`` for twice as fast) or as fast as the server replies (``--speed max``,
+with up to ``--window`` requests in flight). The report has the throughput, latency percentiles of
+the recording and of the replay per command, and the replies whose status, size or crc32 differ
+from the recorded ones.
+"""
+
+import argparse
+from collections import defaultdict
+from dataclasses import dataclass
+import json
+import socket
+import struct
+import threading
+import time
+from typing import Dict, List, Optional
+import zlib
+
+import numpy as np
+
+from ..api.client import connect_socket, recv_message, send_message
+
+__all__ = ['RecordedRequest', 'Recording', 'percentiles', 'read_recording', 'replay', 'summarize']
+
+MAGIC = 0x4345524C  # "LREC"
+RECORD_STRING = 1
+RECORD_REQUEST = 2
+
+_REQUEST = struct.Struct('<QIHHBIIII')
+
+
+@dataclass
+class RecordedRequest:
+    offset: float  # Seconds since the recording started
+    request_id: int
+    endpoint: str
+    command: str
+    error: bool
+    reply_size: int
+    reply_crc: int
+    latency: float  # Seconds from receiving the request to sending the reply
+    message: bytes
+
+
+@dataclass
+class Recording:
+    start_time: float  # Unix time
+    requests: List[RecordedRequest]
+
+
+def read_recording(path: str) -> Recording:
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, header_size, start_time = struct.unpack_from('<IHHd', data, 0)
+    if magic != MAGIC:
+        raise ValueError(f'{path} is not a request recording')
+    if version != 1:
+        raise ValueError(f'Unsupported recording version {version}')
+
+    strings: Dict[int, str] = {}
+    requests = []
+    pos = header_size
+    while pos < len(data):
+        record_type = data[pos]
+        pos += 1
+        if record_type == RECORD_STRING:
+            index, size = struct.unpack_from('<HH', data, pos)
+            pos += 4
+            strings[index] = data[pos:pos + size].decode('utf-8', errors='replace')
+            pos += size
+        elif record_type == RECORD_REQUEST:
+            (offset_us, request_id, endpoint, command, status, reply_size, reply_crc,
+             latency_us, size) = _REQUEST.unpack_from(data, pos)
+            pos += _REQUEST.size
+            if pos + size > len(data):
+                break  # Cut off while the server was writing
+            requests.append(RecordedRequest(
+                offset=offset_us * 1e-6, request_id=request_id,
+                endpoint=strings.get(endpoint, ''), command=strings.get(command, '') or 'unknown',
+                error=status != 0, reply_size=reply_size, reply_crc=reply_crc,
+                latency=latency_us * 1e-6, message=data[pos:pos + size]))
+            pos += size
+        else:
+            raise ValueError(f'Unknown record type {record_type} at byte {pos - 1}')
+    return Recording(start_time=start_time, requests=requests)
+
+
+@dataclass
+class ReplayResult:
+    request: RecordedRequest
+    latency: float
+    reply: bytes
+
+
+def replay(recording: Recording, endpoint, unix: bool = False, speed: Optional[float] = 1.0,
+           window: int = 1) -> List[ReplayResult]:
+    """Send the recorded requests and collect the replies in order.
+
+    Args:
+        speed: 1 for the original pace, 2 for twice as fast, None for as fast as possible.
+        window: Requests in flight when speed is None.
+    """
+    # Starting a recording again would overwrite the log being replayed
+    requests = [r for r in recording.requests if b'/unrealcv/record' not in r.message]
+    sock = connect_socket(endpoint, unix)
+    send_times = [0.0] * len(requests)
+    slots = threading.Semaphore(max(window, 1))
+    stop = threading.Event()
+    errors = []
+
+    def abort():
+        # Wake the other side, the sender may wait for a slot and the receiver for a reply
+        stop.set()
+        slots.release()
+        try:
+            sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+    def send_loop():
+        try:
+            start = time.perf_counter()
+            first_offset = requests[0].offset if requests else 0.0
+            for i, r in enumerate(requests):
+                if speed is None:
+                    slots.acquire()
+                else:
+                    delay = start + (r.offset - first_offset) / speed - time.perf_counter()
+                    if delay > 0:
+                        stop.wait(delay)
+                if stop.is_set():
+                    return
+                send_times[i] = time.perf_counter()
+                send_message(sock, b'%d:%s' % (i, r.message))
+        except Exception as e:  # Reported by the receive loop
+            if not stop.is_set():
+                errors.append(e)
+                abort()
+
+    sender = threading.Thread(target=send_loop, daemon=True)
+    sender.start()
+    results = []
+    try:
+        for i, r in enumerate(requests):
+            raw = recv_message(sock)
+            received = time.perf_counter()
+            reply_id, _, reply = raw.partition(b':')
+            if int(reply_id) != i:
+                raise ConnectionError(f'Expect the reply of request {i}, got {int(reply_id)}')
+            results.append(ReplayResult(request=r, latency=received - send_times[i], reply=reply))
+            slots.release()
+    except Exception as e:
+        # A failed send closes the socket under the receive loop, report the cause instead
+        if errors:
+            raise errors[0] from e
+        raise
+    finally:
+        abort()
+        sender.join(timeout=5)
+        sock.close()
+    return results
+
+
+def percentiles(values) -> Dict[str, float]:
+    """p50, p90, p99 and max of latencies in seconds, in milliseconds, empty if there are none."""
+    if len(values) == 0:
+        return {}
+    ms = np.asarray(values) * 1e3
+    return {'p50_ms': float(np.percentile(ms, 50)), 'p90_ms': float(np.percentile(ms, 90)),
+            'p99_ms': float(np.percentile(ms, 99)), 'max_ms': float(ms.max())}
+
+
+def summarize(results: List[ReplayResult], seconds: float, max_examples: int = 5) -> dict:
+    """Throughput, latency percentiles of the recording and the replay, and mismatches per command."""
+    by_command = defaultdict(list)
+    for result in results:
+        by_command[result.request.command].append(result)
+
+    commands = {}
+    mismatches = []
+    for command, items in sorted(by_command.items()):
+        num_mismatch = 0
+        for item in items:
+            error = item.reply.startswith(b'error')
+            reasons = []
+            if error != item.request.error:
+                reasons.append('status')
+            if len(item.reply) != item.request.reply_size:
+                reasons.append('size')
+            elif zlib.crc32(item.reply) != item.request.reply_crc:
+                reasons.append('content')
+            if reasons:
+                num_mismatch += 1
+                if len(mismatches) < max_examples:
+                    mismatches.append({
+                        'request': item.request.message.decode('utf-8', errors='replace'),
+                        'reasons': reasons,
+                        'reply': item.reply[:80].decode('utf-8', errors='replace'),
+                    })
+        commands[command] = {
+            'count': len(items),
+            'mismatches': num_mismatch,
+            'recorded': percentiles([i.request.latency for i in items]),
+            'replayed': percentiles([i.latency for i in items]),
+        }
+
+    reply_bytes = sum(len(r.reply) for r in results)
+    return {
+        'requests': len(results),
+        'seconds': seconds,
+        'requests_per_second': len(results) / seconds if seconds > 0 else 0.0,
+        'reply_mb_per_second': reply_bytes / 1e6 / seconds if seconds > 0 else 0.0,
+        'latency': percentiles([r.latency for r in results]),
+        'mismatches': sum(c['mismatches'] for c in commands.values()),
+        'commands': commands,
+        'mismatch_examples': mismatches,
+    }
+
+
+def _print_report(report: dict) -> None:
+    print(f"{report['requests']} requests in {report['seconds']:.2f}s, "
+          f"{report['requests_per_second']:.1f} req/s, {report['reply_mb_per_second']:.2f} MB/s of replies")
+    latency = report['latency']
+    if latency:
+        print(f"latency p50 {latency['p50_ms']:.2f}ms p90 {latency['p90_ms']:.2f}ms "
+              f"p99 {latency['p99_ms']:.2f}ms max {latency['max_ms']:.2f}ms")
+    print(f"{'command':<40} {'count':>7} {'rec p50':>9} {'rep p50':>9} {'rec p99':>9} {'rep p99':>9} {'mismatch':>9}")
+    for command, stats in report['commands'].items():
+        rec, rep = stats['recorded'], stats['replayed']
+        print(f"{command[:40]:<40} {stats['count']:>7} {rec['p50_ms']:>9.2f} {rep['p50_ms']:>9.2f} "
+              f"{rec['p99_ms']:>9.2f} {rep['p99_ms']:>9.2f} {stats['mismatches']:>9}")
+    for example in report['mismatch_examples']:
+        print(f"mismatch ({', '.join(example['reasons'])}): {example['request']} -> {example['reply']}")
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description='Replay requests recorded by the LychSim server.')
+    parser.add_argument('recording', help='Log written by vset /unrealcv/record')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=9000)
+    parser.add_argument('--unix', default=None, help='Unix socket path, e.g. /tmp/unrealcv_9000.socket')
+    parser.add_argument('--speed', default='original',
+                        help='original, max, or a factor of the original pace such as 2')
+    parser.add_argument('--window', type=int, default=1, help='Requests in flight at max speed')
+    parser.add_argument('--limit', type=int, default=None, help='Replay only the first requests')
+    parser.add_argument('--json', default=None, help='Also write the report to this file')
+    args = parser.parse_args(argv)
+
+    recording = read_recording(args.recording)
+    if args.limit is not None:
+        recording.requests = recording.requests[:args.limit]
+    speed = {'original': 1.0, 'max': None}.get(args.speed)
+    if args.speed not in ('original', 'max'):
+        speed = float(args.speed)
+    endpoint = args.unix if args.unix else (args.host, args.port)
+
+    start = time.perf_counter()
+    results = replay(recording, endpoint, unix=args.unix is not None, speed=speed, window=args.window)
+    report = summarize(results, time.perf_counter() - start)
+    _print_report(report)
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(report, f, indent=2)
+
+
+if __name__ == '__main__':
+    main()
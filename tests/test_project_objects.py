@@ -0,0 +1,52 @@
+"""Decode a lych cam project reply laid out as FLychSimCameraHandler::ProjectObjects writes it."""
+
+import struct
+
+import numpy as np
+
+from lychsim.api.wrapper.camera_mixin import CameraCommandsMixin
+
+
+class _ReplyClient:
+    def __init__(self, reply):
+        self.reply = reply
+
+    def request(self, message):
+        return self.reply
+
+
+def _name(text):
+    data = text.encode("utf-8")
+    return struct.pack("<H", len(data)) + data
+
+
+def _project_reply():
+    # Two actors: 8 aabb corners, then 8 aabb and 8 obb corners with one keypoint and one joint
+    counts = [(8, 0, 0, 0), (8, 8, 1, 1)]
+    num_points = sum(sum(c) for c in counts)
+    uvd = np.arange(num_points * 3, dtype="<f4")
+    reply = struct.pack("<IHHiiIII", 0x4A52504C, 1, 0, 640, 480, len(counts), num_points, 0)
+    reply += uvd.tobytes()
+    offset = 0
+    for c in counts:
+        reply += struct.pack("<I4H", offset, *c)
+        offset += sum(c)
+    reply += _name("Box") + _name("Human") + _name("nose") + _name("pelvis")
+    return bytearray(reply), uvd.reshape(-1, 3)
+
+
+def test_project_objects_decodes_server_layout():
+    reply, uvd = _project_reply()
+    cam = CameraCommandsMixin()
+    cam.client = _ReplyClient(reply)
+    outputs = cam.project_objects(0)
+
+    assert list(outputs) == ["Box", "Human"]
+    np.testing.assert_array_equal(outputs["Box"]["aabb"], uvd[:8])
+    assert outputs["Box"]["obb"].shape == (0, 3)
+    np.testing.assert_array_equal(outputs["Human"]["aabb"], uvd[8:16])
+    np.testing.assert_array_equal(outputs["Human"]["obb"], uvd[16:24])
+    np.testing.assert_array_equal(outputs["Human"]["kp"], uvd[24:25])
+    np.testing.assert_array_equal(outputs["Human"]["joints"], uvd[25:26])
+    assert outputs["Human"]["kp_names"] == ["nose"]
+    assert outputs["Human"]["joint_names"] == ["pelvis"]
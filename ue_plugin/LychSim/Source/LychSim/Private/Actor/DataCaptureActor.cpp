@@ -19,6 +19,9 @@
 #include "BPFunctionLib/JsonObjectBP.h"
 #include "Puppeteer.h"
 #include "FusionCamSensor.h"
+#include "Utils/SkinnedCapture.h"
+#include "Utils/BoneCapture.h"
+#include "Utils/DatasetWriter.h"
 // #include "VertexSensorComponent.h"
 
 // Sets default values
@@ -39,6 +42,9 @@ ADataCaptureActor::ADataCaptureActor()
 	bCaptureSceneInfo = true;
 	bCaptureAnnotationColor = true;
 	bCaptureVertex = false;
+	bVertexNpy = false;
+	bJointNpy = false;
+	VertexLOD = 0;
 	bCapturePuppeteer = true;
 
 	CaptureInterval = 1.0f;
@@ -47,6 +53,8 @@ ADataCaptureActor::ADataCaptureActor()
 	TimeDilation = 1.0f;
 	ImageIdType = EImageId::RecordedFrameId;
 	bAddTimestamp = true;
+	DatasetFormat = EDatasetFormat::Files;
+	ShardSizeMB = 1024;
 	// Set default to dump folder
 
 	FolderStructure = EFolderStructure::Tree;
@@ -115,6 +123,26 @@ void ADataCaptureActor::BeginPlay()
 	}
 }
 
+void ADataCaptureActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Wait for the queued frames, and close the last shard
+	DatasetWriter.Reset();
+	Super::EndPlay(EndPlayReason);
+}
+
+LychSim::FDatasetWriter& ADataCaptureActor::GetDatasetWriter()
+{
+	if (!DatasetWriter.IsValid())
+	{
+		LychSim::FDatasetWriterOptions Options;
+		Options.RootFolder = FinalDataFolder;
+		Options.bTarShards = DatasetFormat == EDatasetFormat::TarShards;
+		Options.MaxShardBytes = (int64)FMath::Max(ShardSizeMB, 1) * 1024 * 1024;
+		DatasetWriter = MakeShared<LychSim::FDatasetWriter>(Options);
+	}
+	return *DatasetWriter;
+}
+
 // Called every frame
 void ADataCaptureActor::Tick(float DeltaTime)
 {
@@ -125,13 +153,20 @@ void ADataCaptureActor::CaptureFrame()
 {
 	// Define the behavior for capturing a frame
 	// CaptureAnnotationColor(); // no need to be per-frame
+	// The capture only reads the data, encoding and writing happen on the writer threads
+	GetDatasetWriter().BeginFrame(GetFrameNumber());
 	CaptureImage();
 	CaptureScene();
 	CaptureJoint();
 	CaptureVertex();
 	CapturePuppeteer();
+	if (DatasetFormat == EDatasetFormat::TarShards)
+	{
+		// In file mode every frame would overwrite the same summary.json
+		CaptureSceneSummary();
+	}
+	GetDatasetWriter().EndFrame();
 	FrameCounter += 1;
-	// CaptureSceneSummary();
 	// CaptureSceneInfo();
 }
 
@@ -248,16 +283,38 @@ void ADataCaptureActor::CaptureScene()
 
 
 	FJsonObjectBP JsonObjectBP(ActorsDataMap);
-	FString StrData = JsonObjectBP.ToString();
 	FString Filename = MakeFilename("", "scene", ".json");
 	// Joint and vertex data are too large, so better save them in a seperate file
-	UVisionBPLib::SaveData(StrData, Filename);
+	GetDatasetWriter().AddText(Filename, JsonObjectBP.ToString());
 }
 
 void ADataCaptureActor::CaptureVertex()
 {
 	if (!bCaptureVertex) return;
 
+	if (bVertexNpy)
+	{
+		TArray<AActor*> ActorList;
+		for (TActorIterator<ASkeletalMeshActor> ActorItr(GetWorld()); ActorItr; ++ActorItr)
+		{
+			ActorList.Add(*ActorItr);
+		}
+		LychSim::FSkinnedVertexCapture Capture;
+		LychSim::CaptureSkinnedVertices(ActorList, VertexLOD, Capture);
+		const int32 NumVertices = Capture.Positions.Num() / 3;
+		GetDatasetWriter().AddNpy(MakeFilename("", "vertex", ".npy"), MoveTemp(Capture.Positions), 3, NumVertices);
+
+		// Rows [Offset, Offset + Count) of the npy belong to each actor
+		TMap<FString, FJsonObjectBP> OffsetMap;
+		for (int32 i = 0; i < Capture.ActorNames.Num(); i++)
+		{
+			TArray<FJsonObjectBP> Range = { FJsonObjectBP((int)Capture.Offsets[i]), FJsonObjectBP((int)Capture.Counts[i]) };
+			OffsetMap.Emplace(Capture.ActorNames[i], FJsonObjectBP(Range));
+		}
+		GetDatasetWriter().AddText(MakeFilename("", "vertex_offsets", ".json"), FJsonObjectBP(OffsetMap).ToString());
+		return;
+	}
+
 	// This is huge to serialize to json, consider a more efficient and compact serialization
 	TMap<FString, FJsonObjectBP> VertexDataMap;
 	for (TActorIterator<ASkeletalMeshActor> ActorItr(GetWorld()); ActorItr; ++ActorItr)
@@ -267,8 +324,7 @@ void ADataCaptureActor::CaptureVertex()
 	}
 
 	FString JsonFilename = MakeFilename("", "vertex", ".json");
-	FString JsonStr = FJsonObjectBP(VertexDataMap).ToString(); 
-	UVisionBPLib::SaveData(JsonStr, JsonFilename);
+	GetDatasetWriter().AddText(JsonFilename, FJsonObjectBP(VertexDataMap).ToString());
 }
 
 void ADataCaptureActor::CapturePuppeteer()
@@ -283,7 +339,7 @@ void ADataCaptureActor::CapturePuppeteer()
 			// Puppeteer can save data by itself, or return a JsonObjectBP
 			FJsonObjectBP JsonObjectBP = Puppeteer->GetState(this);
 			FString Filename = MakeFilename("", "puppeteer", ".json");
-			UVisionBPLib::SaveData(JsonObjectBP.ToString(), Filename);
+			GetDatasetWriter().AddText(Filename, JsonObjectBP.ToString());
 		}
 	}
 }
@@ -307,6 +363,51 @@ void ADataCaptureActor::CaptureJoint()
 		}
 	}
 
+	if (bJointNpy)
+	{
+		LychSim::FBoneCapture Capture;
+		LychSim::CaptureBones(HumanActorList, true, Capture);
+		const int32 NumBones = Capture.Transforms.Num() / 12;
+		GetDatasetWriter().AddNpy(MakeFilename("", "joint", ".npy"), MoveTemp(Capture.Transforms), 12, NumBones);
+
+		// Rows [Offset, Offset + Count) of the npy belong to each actor, named by its skeleton
+		TMap<FString, FJsonObjectBP> IndexMap;
+		for (int32 i = 0; i < Capture.ActorNames.Num(); i++)
+		{
+			const FString& SkeletonPath = Capture.SkeletonPaths[Capture.Skeletons[i]];
+			TMap<FString, FJsonObjectBP> Entry;
+			Entry.Emplace("Offset", FJsonObjectBP((int)Capture.Offsets[i]));
+			Entry.Emplace("Count", FJsonObjectBP((int)Capture.Counts[i]));
+			Entry.Emplace("Skeleton", FJsonObjectBP(SkeletonPath));
+			// Bones skipped by the current LOD keep a stale transform
+			TArray<FJsonObjectBP> StaleBones;
+			for (uint32 Bone = 0; Bone < Capture.Counts[i]; Bone++)
+			{
+				if (!Capture.Valid[Capture.Offsets[i] + Bone])
+				{
+					StaleBones.Add(FJsonObjectBP((int)Bone));
+				}
+			}
+			Entry.Emplace("StaleBones", FJsonObjectBP(StaleBones));
+			IndexMap.Emplace(Capture.ActorNames[i], FJsonObjectBP(Entry));
+		}
+		GetDatasetWriter().AddText(MakeFilename("", "joint_index", ".json"), FJsonObjectBP(IndexMap).ToString());
+
+		// The bone names only change with the skeleton, save them once per session
+		TMap<FString, FJsonObjectBP> SkeletonMap;
+		for (int32 i = 0; i < Capture.SkeletonPaths.Num(); i++)
+		{
+			if (SavedSkeletons.Contains(Capture.SkeletonPaths[i])) continue;
+			SavedSkeletons.Add(Capture.SkeletonPaths[i]);
+			SkeletonMap.Emplace(Capture.SkeletonPaths[i], FJsonObjectBP(Capture.SkeletonBoneNames[i]));
+		}
+		if (SkeletonMap.Num() > 0)
+		{
+			GetDatasetWriter().AddText(MakeFilename("", "joint_skeletons", ".json"), FJsonObjectBP(SkeletonMap).ToString());
+		}
+		return;
+	}
+
 	// Capture 3D human keypoints
 	// Iterate over human in this scene and save data to disk
 	TMap<FString, FJsonObjectBP> JointInfoMap;
@@ -318,14 +419,27 @@ void ADataCaptureActor::CaptureJoint()
 	}
 
 	FString JsonFilename = MakeFilename("", "joint", ".json");
-	FString JsonStr = FJsonObjectBP(JointInfoMap).ToString(); 
-	UVisionBPLib::SaveData(JsonStr, JsonFilename);
+	GetDatasetWriter().AddText(JsonFilename, FJsonObjectBP(JointInfoMap).ToString());
 }
 
 void ADataCaptureActor::CaptureSceneSummary()
 {
 	if (!bCaptureSceneSummary) return;
-	// A summary of the scene in this frame
+	// A summary of the scene in this frame, in shard mode it is stored with the frame's sample
+
+	TArray<FString> SensorNames;
+	for (ACamSensorActor* CameraActor : Sensors)
+	{
+		if (!IsValid(CameraActor)) continue;
+		SensorNames.Append(CameraActor->GetSensorNames());
+	}
+
+	TMap<FString, FJsonObjectBP> Summary;
+	Summary.Emplace("Frame", FJsonObjectBP(GetFrameNumber()));
+	Summary.Emplace("GameFrame", FJsonObjectBP((int)GFrameNumber));
+	Summary.Emplace("GameTime", FJsonObjectBP((float)GetWorld()->GetTimeSeconds()));
+	Summary.Emplace("Sensors", FJsonObjectBP(SensorNames));
+	GetDatasetWriter().AddText(MakeFilename("", "summary", ".json"), FJsonObjectBP(Summary).ToString());
 }
 
 void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSensor* Sensor)
@@ -350,7 +464,7 @@ void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSen
 			Sensor->GetLit(LitData, Width, Height, ELitMode::Lit);
 		}
 		UE_LOG(LogTemp, Display, TEXT("Save lit image to %s"), *LitFilename);
-		UVisionBPLib::SavePng(LitData, Width, Height, LitFilename);
+		GetDatasetWriter().AddPng(LitFilename, MoveTemp(LitData), Width, Height);
 	}
 
 	if (bCaptureSegMask)
@@ -358,7 +472,7 @@ void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSen
 		int Width, Height;
 		TArray<FColor> SegData;
 		Sensor->GetSeg(SegData, Width, Height);
-		UVisionBPLib::SavePng(SegData, Width, Height, SegFilename);
+		GetDatasetWriter().AddPng(SegFilename, MoveTemp(SegData), Width, Height);
 	}
 
 	if (bCaptureDepth)
@@ -366,7 +480,7 @@ void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSen
 		int Width, Height;
 		TArray<float> DepthData;
 		Sensor->GetDepth(DepthData, Width, Height);
-		UVisionBPLib::SaveNpy(DepthData, Width, Height, DepthFilename);
+		GetDatasetWriter().AddNpy(DepthFilename, MoveTemp(DepthData), Width, Height);
 	}
 
 	if (bCaptureNormal)
@@ -374,7 +488,7 @@ void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSen
 		int Width, Height;
 		TArray<FColor> NormalData;
 		Sensor->GetNormal(NormalData, Width, Height);
-		UVisionBPLib::SavePng(NormalData, Width, Height, NormalFilename);
+		GetDatasetWriter().AddPng(NormalFilename, MoveTemp(NormalData), Width, Height);
 	}
 
 	// TArray<float> DepthData;
@@ -404,9 +518,7 @@ void ADataCaptureActor::CaptureImageFromSensor(FString SensorName, UFusionCamSen
 
 	// USerializeBPLib::VectorToJson();
 	FJsonObjectBP JsonObject = USerializeBPLib::TMapToJson(Keys, Values);
-	FString JsonStr = USerializeBPLib::JsonToStr(JsonObject);
-	JsonFilename = FPaths::ConvertRelativePathToFull(DataFolder.Path, JsonFilename);
-	UVisionBPLib::SaveData(JsonStr, JsonFilename);
+	GetDatasetWriter().AddText(JsonFilename, USerializeBPLib::JsonToStr(JsonObject));
 }
 
 void ADataCaptureActor::CaptureImage()
@@ -443,16 +555,28 @@ void ADataCaptureActor::ExitGame() {
 }
 
 
-FString ADataCaptureActor::MakeFilename(FString CameraName, FString DataType, FString FileExtension)
+int ADataCaptureActor::GetFrameNumber()
 {
-	int FrameNumber;
 	switch (ImageIdType)
 	{
-		case EImageId::GameFrameId: FrameNumber = UVisionBPLib::FrameNumber(); break;
-		case EImageId::RecordedFrameId: FrameNumber = FrameCounter; break;
-		default: FrameNumber = UVisionBPLib::FrameNumber();
+		case EImageId::GameFrameId: return UVisionBPLib::FrameNumber();
+		case EImageId::RecordedFrameId: return FrameCounter;
+		default: return UVisionBPLib::FrameNumber();
+	}
+}
+
+FString ADataCaptureActor::MakeFilename(FString CameraName, FString DataType, FString FileExtension)
+{
+	if (DatasetFormat == EDatasetFormat::TarShards)
+	{
+		// The field of the frame's sample, the writer prefixes the frame number as the sample key.
+		// WebDataset splits the key at the first dot, so the names must not contain one
+		FString Field = CameraName.IsEmpty() ? DataType : CameraName.Replace(TEXT("."), TEXT("_")) + TEXT(".") + DataType;
+		return Field + FileExtension;
 	}
 
+	int FrameNumber = GetFrameNumber();
+
 	FString Filename;
 	if (CameraName.IsEmpty())
 	{
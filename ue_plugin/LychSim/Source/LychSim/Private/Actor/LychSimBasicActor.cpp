@@ -16,12 +16,7 @@ void ALychSimBasicActor::InitializeMesh(const FString& MeshPath)
 	UStaticMesh* LoadedMesh = LoadObject<UStaticMesh>(nullptr, *MeshPath);
 	if (LoadedMesh)
 	{
-		Mesh->SetStaticMesh(LoadedMesh);
-
-		Mesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-        Mesh->SetCollisionResponseToAllChannels(ECR_Block);
-        Mesh->SetSimulatePhysics(true);
-        Mesh->SetEnableGravity(true);
+		SetMesh(LoadedMesh);
 	}
 	else
 	{
@@ -29,6 +24,16 @@ void ALychSimBasicActor::InitializeMesh(const FString& MeshPath)
 	}
 }
 
+void ALychSimBasicActor::SetMesh(UStaticMesh* InMesh, bool bSimulatePhysics)
+{
+	Mesh->SetStaticMesh(InMesh);
+
+	Mesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+    Mesh->SetCollisionResponseToAllChannels(ECR_Block);
+    Mesh->SetSimulatePhysics(bSimulatePhysics);
+    Mesh->SetEnableGravity(bSimulatePhysics);
+}
+
 void ALychSimBasicActor::BeginPlay()
 {
     AActor::BeginPlay();
@@ -193,7 +193,7 @@ void UVisionBPLib::GetBoneTransform(
 	BoneSensor.SetBones(IncludedBones);
 
 	TArray<FBoneInfo> BonesInfo = BoneSensor.GetBonesInfo();
-	for (FBoneInfo BoneInfo : BonesInfo)
+	for (const FBoneInfo& BoneInfo : BonesInfo)
 	{
 		BoneNames.Add(BoneInfo.BoneName);
 		if (bWorldSpace)
@@ -184,69 +184,20 @@ LychSim::EFilenameType FCameraHandler::ParseFilenameType(const FString& Filename
 	return LychSim::EFilenameType::Invalid;
 }
 
-/** Serialize data according to filename format */
+/** Serialize data according to filename format, files are written on the writer threads */
 FExecStatus FCameraHandler::SerializeData(const TArray<FColor>& Data, int Width, int Height, const FString& Filename)
 {
-	static FImageUtil ImageUtil;
-	LychSim::EFilenameType FilenameType = ParseFilenameType(Filename);
-
-	TArray<uint8> BinaryData;
-	switch (FilenameType)
-	{
-	case LychSim::EFilenameType::BmpBinary:
-		ImageUtil.ConvertToBmp(Data, Width, Height, BinaryData);
-		return FExecStatus::Binary(BinaryData);
-	case LychSim::EFilenameType::Bmp:
-		ImageUtil.SaveBmpFile(Data, Width, Height, Filename);
-		return FExecStatus::OK(Filename);
-	case LychSim::EFilenameType::PngBinary:
-		ImageUtil.ConvertToPng(Data, Width, Height, BinaryData);
-		return FExecStatus::Binary(BinaryData);
-	case LychSim::EFilenameType::Png:
-		ImageUtil.SavePngFile(Data, Width, Height, Filename);
-		return FExecStatus::OK(Filename);
-	}
-	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
+	return LychSim::SerializeData(Data, Width, Height, Filename);
 }
 
 FExecStatus FCameraHandler::SerializeData(const TArray<FFloat16Color>& Data, int Width, int Height, const FString& Filename)
 {
-	static FImageUtil ImageUtil;
-	LychSim::EFilenameType FilenameType = ParseFilenameType(Filename);
-
-	TArray<uint8> BinaryData;
-	int Channel = Data.Num() / (Width * Height);
-	switch (FilenameType)
-	{
-	case LychSim::EFilenameType::NpyBinary:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		return FExecStatus::Binary(BinaryData);
-	case LychSim::EFilenameType::Npy:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		ImageUtil.SaveFile(BinaryData, Filename);
-		return FExecStatus::OK(Filename);
-	}
-	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
+	return LychSim::SerializeData(Data, Width, Height, Filename);
 }
 
 FExecStatus FCameraHandler::SerializeData(const TArray<float>& Data, int Width, int Height, const FString& Filename)
 {
-	static FImageUtil ImageUtil;
-	LychSim::EFilenameType FilenameType = ParseFilenameType(Filename);
-
-	TArray<uint8> BinaryData;
-	int Channel = Data.Num() / (Width * Height);
-	switch (FilenameType)
-	{
-	case LychSim::EFilenameType::NpyBinary:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		return FExecStatus::Binary(BinaryData);
-	case LychSim::EFilenameType::Npy:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		ImageUtil.SaveFile(BinaryData, Filename);
-		return FExecStatus::OK(Filename);
-	}
-	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
+	return LychSim::SerializeData(Data, Width, Height, Filename);
 }
 
 template<class T>
@@ -5,11 +5,100 @@
 #include "SensorBPLib.h"
 #include "Serialization.h"
 #include "Utils/DataUtil.h"
+#include "Utils/MultiCapture.h"
+#include "Utils/SegStats.h"
+#include "Utils/Projection.h"
+#include "Utils/UObjectUtils.h"
+#include "Controller/ActorController.h"
+#include "KeypointComponent.h"
+#include "BoneSensor.h"
+#include "TextureReader.h"
+#include "VisionBPLib.h"
+#include "Runtime/Engine/Classes/Components/SkeletalMeshComponent.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
 #include "Utils/StrFormatter.h"
 #include "UnrealcvLog.h"
 #include "Editor.h"
 #include "ScopedTransaction.h"
 
+namespace
+{
+	/** The largest -size, the resampled texture and the readback are allocated at this size */
+	constexpr int32 MaxReadbackSize = 8192;
+
+	/** Parse -size=<w>x<h>, -roi=<x>,<y>,<w>,<h> and -filter=bilinear|nearest, the filter defaults to bDefaultBilinear */
+	bool ParseReadbackRegion(const TMap<FString,FString>& Kw, bool bDefaultBilinear, FReadbackRegion& Region, FExecStatus& Status)
+	{
+		Region.bBilinear = bDefaultBilinear;
+		if (const FString* SizeStr = Kw.Find(TEXT("size")))
+		{
+			TArray<FString> Parts;
+			SizeStr->ParseIntoArray(Parts, TEXT("x"));
+			if (Parts.Num() != 2 || FCString::Atoi(*Parts[0]) <= 0 || FCString::Atoi(*Parts[1]) <= 0)
+			{
+				Status = FExecStatus::Error(FString::Printf(TEXT("Invalid size %s, expect <w>x<h>"), **SizeStr));
+				return false;
+			}
+			if (FCString::Atoi(*Parts[0]) > MaxReadbackSize || FCString::Atoi(*Parts[1]) > MaxReadbackSize)
+			{
+				Status = FExecStatus::Error(FString::Printf(TEXT("Invalid size %s, at most %dx%d"), **SizeStr, MaxReadbackSize, MaxReadbackSize));
+				return false;
+			}
+			Region.Size = FIntPoint(FCString::Atoi(*Parts[0]), FCString::Atoi(*Parts[1]));
+		}
+		if (const FString* RoiStr = Kw.Find(TEXT("roi")))
+		{
+			TArray<FString> Parts;
+			RoiStr->ParseIntoArray(Parts, TEXT(","));
+			if (Parts.Num() != 4 || FCString::Atoi(*Parts[2]) <= 0 || FCString::Atoi(*Parts[3]) <= 0)
+			{
+				Status = FExecStatus::Error(FString::Printf(TEXT("Invalid roi %s, expect <x>,<y>,<w>,<h>"), **RoiStr));
+				return false;
+			}
+			const FIntPoint Min(FCString::Atoi(*Parts[0]), FCString::Atoi(*Parts[1]));
+			Region.Roi = FIntRect(Min, Min + FIntPoint(FCString::Atoi(*Parts[2]), FCString::Atoi(*Parts[3])));
+		}
+		if (const FString* Filter = Kw.Find(TEXT("filter")))
+		{
+			if (*Filter != TEXT("bilinear") && *Filter != TEXT("nearest"))
+			{
+				Status = FExecStatus::Error(FString::Printf(TEXT("Invalid filter %s, expect bilinear or nearest"), **Filter));
+				return false;
+			}
+			Region.bBilinear = *Filter == TEXT("bilinear");
+		}
+		return true;
+	}
+
+	/** Whether the -roi of Region overlaps the film of the sensor, the part outside of it is dropped */
+	bool CheckReadbackRegion(const FReadbackRegion& Region, UFusionCamSensor* FusionCamSensor, FExecStatus& Status)
+	{
+		if (Region.Roi.Width() <= 0 || Region.Roi.Height() <= 0)
+		{
+			return true;
+		}
+		const FIntPoint FilmSize((int32)FusionCamSensor->GetFilmWidth(), (int32)FusionCamSensor->GetFilmHeight());
+		const FIntRect Roi = Region.GetRoi(FilmSize);
+		if (Roi.Width() <= 0 || Roi.Height() <= 0)
+		{
+			Status = FExecStatus::Error(FString::Printf(TEXT("Invalid roi %s, it is outside of the %dx%d film"), *Region.Roi.ToString(), FilmSize.X, FilmSize.Y));
+			return false;
+		}
+		return true;
+	}
+
+	/** The frame and the camera pose for the header of raw replies */
+	LychSim::FRawFrameInfo GetRawFrameInfo(UFusionCamSensor* FusionCamSensor)
+	{
+		LychSim::FRawFrameInfo FrameInfo;
+		FrameInfo.FrameId = GFrameCounter;
+		FrameInfo.Location = FusionCamSensor->GetSensorLocation();
+		FrameInfo.Rotation = FusionCamSensor->GetSensorRotation();
+		FrameInfo.Fov = FusionCamSensor->GetSensorFOV();
+		return FrameInfo;
+	}
+}
+
 void FLychSimCameraHandler::RegisterCommands() {
     CommandDispatcher->BindCommand(
         "lych cam get_loc [uint]",
@@ -53,10 +142,16 @@ void FLychSimCameraHandler::RegisterCommands() {
 		"Set Camera Film Size"
 	);
 
-	CommandDispatcher->BindCommand(
-		"lych cam get_lit [uint] [str]",
-		FDispatcherDelegate::CreateRaw(this, &FLychSimCameraHandler::GetCameraLit),
-		"Get png rendering data from lit sensor"
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_lit",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraLit),
+		"Get png, bmp or raw rendering data from lit sensor, -size=<w>x<h> resamples and -roi=<x>,<y>,<w>,<h> crops on the GPU before readback"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_multi",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraMulti),
+		"Capture lit, depth, normal or seg of many sensors with one readback, e.g. get_multi lit 0 1 2 -format=png, -size and -roi apply to all"
 	);
 
 	CommandDispatcher->BindCommand(
@@ -65,10 +160,16 @@ void FLychSimCameraHandler::RegisterCommands() {
 		"Warm up the camera by capturing lit without saving data"
 	);
 
-	CommandDispatcher->BindCommand(
-		"lych cam get_seg [uint] [str]",
-		FDispatcherDelegate::CreateRaw(this, &FLychSimCameraHandler::GetCameraSeg),
-		"Get png segmentation data from annotation sensor"
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_seg",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraSeg),
+		"Get png, bmp or raw segmentation data from annotation sensor, -size=<w>x<h> resamples and -roi=<x>,<y>,<w>,<h> crops on the GPU before readback"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_seg_stats",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraSegStats),
+		"Get per-object pixel counts, 2D boxes and truncation flags as a binary table, -mask=png|bmp|npy appends the mask"
 	);
 
 	CommandDispatcher->BindCommand(
@@ -83,16 +184,16 @@ void FLychSimCameraHandler::RegisterCommands() {
 		"Clear all annotation components"
 	);
 
-	CommandDispatcher->BindCommand(
-		"lych cam get_depth [uint] [str]",
-		FDispatcherDelegate::CreateRaw(this, &FLychSimCameraHandler::GetCameraDepth),
-		"Get depth data from annotation sensor"
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_depth",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraDepth),
+		"Get npy or raw depth data from annotation sensor, -size=<w>x<h> resamples and -roi=<x>,<y>,<w>,<h> crops on the GPU before readback"
 	);
 
-	CommandDispatcher->BindCommand(
-		"lych cam get_normal [uint] [str]",
-		FDispatcherDelegate::CreateRaw(this, &FLychSimCameraHandler::GetCameraNormal),
-		"Get normal data from annotation sensor"
+	CommandDispatcher->BindCommandUE(
+		"lych cam get_normal",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::GetCameraNormal),
+		"Get png, bmp or raw normal data from annotation sensor, -size=<w>x<h> resamples and -roi=<x>,<y>,<w>,<h> crops on the GPU before readback"
 	);
 
 	CommandDispatcher->BindCommand(
@@ -100,6 +201,12 @@ void FLychSimCameraHandler::RegisterCommands() {
 		FDispatcherDelegate::CreateRaw(this, &FLychSimCameraHandler::GetCameraAnnotations),
 		"Get png annotations data from annotation sensor"
 	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych cam project",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimCameraHandler::ProjectObjects),
+		"Project AABB/OBB corners, keypoints and joints of objects (or -all) to pixels, -what=aabb,obb,kp,joints selects the point sets"
+	);
 }
 
 UFusionCamSensor* FLychSimCameraHandler::GetCamera(const TArray<FString>& Args, FExecStatus& Status)
@@ -181,16 +288,21 @@ FExecStatus FLychSimCameraHandler::SetFilmSize(const TArray<FString>& Args)
 	return FExecStatus::OK();
 }
 
-FExecStatus FLychSimCameraHandler::GetCameraLit(const TArray<FString>& Args)
+FExecStatus FLychSimCameraHandler::GetCameraLit(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
 {
 	FExecStatus ExecStatus = FExecStatus::OK();
-	UFusionCamSensor* FusionCamSensor = GetCamera(Args, ExecStatus);
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
 	if (!IsValid(FusionCamSensor)) return ExecStatus;
 
+	FReadbackRegion Region;
+	if (!ParseReadbackRegion(Kw, true, Region, ExecStatus)) return ExecStatus;
+	if (!CheckReadbackRegion(Region, FusionCamSensor, ExecStatus)) return ExecStatus;
+
 	TArray<FColor> Data;
-	int Width, Height;
-	FusionCamSensor->GetLit(Data, Width, Height);
-	LychSim::SaveData(Data, Width, Height, Args, ExecStatus);
+	int Width = 0, Height = 0;
+	FusionCamSensor->GetLitRegion(Data, Width, Height, Region);
+	const LychSim::FRawFrameInfo FrameInfo = GetRawFrameInfo(FusionCamSensor);
+	LychSim::SaveData(Data, Width, Height, Pos, ExecStatus, &FrameInfo);
 	return ExecStatus;
 }
 
@@ -201,17 +313,21 @@ FExecStatus FLychSimCameraHandler::WarmupCamera(const TArray<FString>& Args)
 	if (!IsValid(FusionCamSensor)) return ExecStatus;
 
 	TArray<FColor> Data;
-	int Width, Height;
+	int Width = 0, Height = 0;
 	FusionCamSensor->GetLit(Data, Width, Height);
 	return ExecStatus;
 }
 
-FExecStatus FLychSimCameraHandler::GetCameraSeg(const TArray<FString>& Args)
+FExecStatus FLychSimCameraHandler::GetCameraSeg(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
 {
 	FExecStatus ExecStatus = FExecStatus::OK();
-	UFusionCamSensor* FusionCamSensor = GetCamera(Args, ExecStatus);
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
 	if (!IsValid(FusionCamSensor)) return ExecStatus;
 
+	FReadbackRegion Region;
+	if (!ParseReadbackRegion(Kw, false, Region, ExecStatus)) return ExecStatus;
+	if (!CheckReadbackRegion(Region, FusionCamSensor, ExecStatus)) return ExecStatus;
+
 	TWeakObjectPtr<AUnrealcvWorldController> WorldController = FUnrealcvServer::Get().WorldController;
 	if (WorldController.IsValid())
 	{
@@ -219,13 +335,160 @@ FExecStatus FLychSimCameraHandler::GetCameraSeg(const TArray<FString>& Args)
 	}
 
 	TArray<FColor> Data;
-	int Width, Height;
-	FusionCamSensor->GetSeg(Data, Width, Height);
+	int Width = 0, Height = 0;
+	FusionCamSensor->GetSegRegion(Data, Width, Height, Region);
 
-	LychSim::SaveData(Data, Width, Height, Args, ExecStatus);
+	const LychSim::FRawFrameInfo FrameInfo = GetRawFrameInfo(FusionCamSensor);
+	LychSim::SaveData(Data, Width, Height, Pos, ExecStatus, &FrameInfo);
 	return ExecStatus;
 }
 
+FExecStatus FLychSimCameraHandler::GetCameraMulti(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	if (Pos.Num() < 2)
+	{
+		return FExecStatus::Error(TEXT("Expect a mode and at least one sensor id"));
+	}
+	const FString Mode = Pos[0];
+	if (!LychSim::IsMultiCaptureMode(Mode))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid mode %s, expect lit, depth, normal or seg"), *Mode));
+	}
+	const bool bDepth = Mode == TEXT("depth");
+	const FString* FormatStr = Kw.Find(TEXT("format"));
+	const FString Format = FormatStr ? *FormatStr : (bDepth ? TEXT("npy") : TEXT("png"));
+	const LychSim::EFilenameType FormatType = LychSim::ParseFilenameType(Format);
+	if (FormatType != LychSim::EFilenameType::RawBinary && (bDepth ? FormatType != LychSim::EFilenameType::NpyBinary
+		: FormatType != LychSim::EFilenameType::PngBinary && FormatType != LychSim::EFilenameType::BmpBinary))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid format %s for %s, expect %s"), *Format, *Mode, bDepth ? TEXT("npy or raw") : TEXT("png, bmp or raw")));
+	}
+
+	FExecStatus ExecStatus = FExecStatus::OK();
+	FReadbackRegion Region;
+	if (!ParseReadbackRegion(Kw, Mode == TEXT("lit"), Region, ExecStatus)) return ExecStatus;
+
+	TArray<int32> SensorIds;
+	TArray<UFusionCamSensor*> Sensors;
+	for (int32 i = 1; i < Pos.Num(); i++)
+	{
+		const int32 SensorId = FCString::Atoi(*Pos[i]);
+		UFusionCamSensor* Sensor = USensorBPLib::GetSensorById(SensorId);
+		if (!IsValid(Sensor))
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Invalid sensor id %s"), *Pos[i]));
+		}
+		if (!CheckReadbackRegion(Region, Sensor, ExecStatus)) return ExecStatus;
+		SensorIds.Add(SensorId);
+		Sensors.Add(Sensor);
+	}
+
+	if (Mode == TEXT("seg"))
+	{
+		TWeakObjectPtr<AUnrealcvWorldController> WorldController = FUnrealcvServer::Get().WorldController;
+		if (WorldController.IsValid())
+		{
+			WorldController->EnsureAnnotations();
+		}
+	}
+
+	TArray<LychSim::FMultiCaptureImage> Images;
+	LychSim::CaptureMulti(Sensors, Mode, Region, Images);
+
+	TArray<TArray<uint8>> Parts;
+	for (int32 i = 0; i < Images.Num(); i++)
+	{
+		const LychSim::FMultiCaptureImage& Image = Images[i];
+		if (Image.Width == 0 || Image.Height == 0)
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Captured data of sensor %d is empty"), SensorIds[i]));
+		}
+		const LychSim::FRawFrameInfo FrameInfo = GetRawFrameInfo(Sensors[i]);
+		Parts.Add(bDepth
+			? LychSim::SerializeData(Image.Floats, Image.Width, Image.Height, Format, &FrameInfo).GetData()
+			: LychSim::SerializeData(Image.Colors, Image.Width, Image.Height, Format, &FrameInfo).GetData());
+	}
+
+	TArray<uint8> BinaryData = LychSim::SerializeMultiCapture(SensorIds, Images, Parts);
+	return FExecStatus::Binary(MoveTemp(BinaryData));
+}
+
+FExecStatus FLychSimCameraHandler::GetCameraSegStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	FExecStatus ExecStatus = FExecStatus::OK();
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
+	if (!IsValid(FusionCamSensor)) return ExecStatus;
+
+	TWeakObjectPtr<AUnrealcvWorldController> WorldController = FUnrealcvServer::Get().WorldController;
+	if (!WorldController.IsValid())
+	{
+		return FExecStatus::Error(TEXT("WorldController is not valid"));
+	}
+	WorldController->EnsureAnnotations();
+
+	const FString* MaskFormat = Kw.Find(TEXT("mask"));
+	if (MaskFormat && LychSim::ParseFilenameType(*MaskFormat) != LychSim::EFilenameType::PngBinary
+		&& LychSim::ParseFilenameType(*MaskFormat) != LychSim::EFilenameType::BmpBinary
+		&& LychSim::ParseFilenameType(*MaskFormat) != LychSim::EFilenameType::NpyBinary)
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid mask format %s, expect png, bmp or npy"), **MaskFormat));
+	}
+	const FString* MinPixelsStr = Kw.Find(TEXT("min_pixels"));
+	const uint32 MinPixels = MinPixelsStr ? FMath::Max(FCString::Atoi(**MinPixelsStr), 1) : 1;
+
+	// Objects grouped in object segmentation mode share one color, so they share one row
+	TArray<FColor> InstanceColors;
+	TArray<FString> InstanceNames;
+	TMap<FColor, int32> ColorIndex;
+	for (const TPair<FString, FColor>& Pair : WorldController->ObjectAnnotator.GetAnnotationColors())
+	{
+		FColor Color = Pair.Value;
+		Color.A = 255;
+		if (int32* Index = ColorIndex.Find(Color))
+		{
+			InstanceNames[*Index] += TEXT(",") + Pair.Key;
+			continue;
+		}
+		ColorIndex.Add(Color, InstanceColors.Num());
+		InstanceColors.Add(Color);
+		InstanceNames.Add(Pair.Key);
+	}
+
+	TArray<FColor> Data;
+	int Width = 0, Height = 0;
+	FusionCamSensor->GetSeg(Data, Width, Height);
+	if (Data.Num() == 0)
+	{
+		return FExecStatus::Error(TEXT("Captured data is empty"));
+	}
+
+	TArray<LychSim::FSegInstanceStats> AllStats;
+	LychSim::ComputeSegStats(Data, Width, Height, InstanceColors, AllStats);
+
+	TArray<LychSim::FSegInstanceStats> Stats;
+	TArray<FString> Names;
+	for (int32 i = 0; i < AllStats.Num(); i++)
+	{
+		if (AllStats[i].PixelCount < MinPixels) continue;
+		Stats.Add(AllStats[i]);
+		Names.Add(InstanceNames[i]);
+	}
+
+	TArray<uint8> MaskData;
+	if (MaskFormat)
+	{
+		FExecStatus MaskStatus = LychSim::SerializeData(Data, Width, Height, *MaskFormat);
+		if (MaskStatus != FExecStatusType::OK)
+		{
+			return MaskStatus;
+		}
+		MaskData = MaskStatus.GetData();
+	}
+
+	TArray<uint8> BinaryData = LychSim::SerializeSegStats(Stats, Names, Width, Height, MaskData);
+	return FExecStatus::Binary(BinaryData);
+}
+
 FExecStatus FLychSimCameraHandler::AnnotateNewObjects(const TArray<FString>& Args)
 {
 	TWeakObjectPtr<AUnrealcvWorldController> WorldController = FUnrealcvServer::Get().WorldController;
@@ -254,30 +517,41 @@ FExecStatus FLychSimCameraHandler::ClearAnnotationComponents(const TArray<FStrin
 	}
 }
 
-FExecStatus FLychSimCameraHandler::GetCameraDepth(const TArray<FString>& Args)
+FExecStatus FLychSimCameraHandler::GetCameraDepth(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
 {
 	FExecStatus ExecStatus = FExecStatus::OK();
-	UFusionCamSensor* FusionCamSensor = GetCamera(Args, ExecStatus);
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
 	if (!IsValid(FusionCamSensor)) return ExecStatus;
 
+	FReadbackRegion Region;
+	if (!ParseReadbackRegion(Kw, false, Region, ExecStatus)) return ExecStatus;
+	if (!CheckReadbackRegion(Region, FusionCamSensor, ExecStatus)) return ExecStatus;
+
 	TArray<float> Data;
-	int Width, Height;
-	FusionCamSensor->GetDepth(Data, Width, Height);
+	int Width = 0, Height = 0;
+	FusionCamSensor->GetDepthRegion(Data, Width, Height, Region);
 
-	LychSim::SaveData(Data, Width, Height, Args, ExecStatus);
+	const LychSim::FRawFrameInfo FrameInfo = GetRawFrameInfo(FusionCamSensor);
+	LychSim::SaveData(Data, Width, Height, Pos, ExecStatus, &FrameInfo);
 	return ExecStatus;
 }
 
-FExecStatus FLychSimCameraHandler::GetCameraNormal(const TArray<FString>& Args)
+FExecStatus FLychSimCameraHandler::GetCameraNormal(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
 {
 	FExecStatus ExecStatus = FExecStatus::OK();
-	UFusionCamSensor* FusionCamSensor = GetCamera(Args, ExecStatus);
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
 	if (!IsValid(FusionCamSensor)) return ExecStatus;
 
+	// Nearest by default, averaging normals would shorten them
+	FReadbackRegion Region;
+	if (!ParseReadbackRegion(Kw, false, Region, ExecStatus)) return ExecStatus;
+	if (!CheckReadbackRegion(Region, FusionCamSensor, ExecStatus)) return ExecStatus;
+
 	TArray<FColor> Data;
-	int Width, Height;
-	FusionCamSensor->GetNormal(Data, Width, Height);
-	LychSim::SaveData(Data, Width, Height, Args, ExecStatus);
+	int Width = 0, Height = 0;
+	FusionCamSensor->GetNormalRegion(Data, Width, Height, Region);
+	const LychSim::FRawFrameInfo FrameInfo = GetRawFrameInfo(FusionCamSensor);
+	LychSim::SaveData(Data, Width, Height, Pos, ExecStatus, &FrameInfo);
 	return ExecStatus;
 }
 
@@ -390,3 +664,177 @@ FExecStatus FLychSimCameraHandler::GetCameraAnnotations(const TArray<FString>& A
 	Writer->Close();
 	return FExecStatus::OK(MoveTemp(Out));
 }
+
+namespace
+{
+	/** Points of one actor, in the order aabb corners, obb corners, keypoints, joints */
+	struct FProjectedActor
+	{
+		FString Name;
+		uint32 Offset = 0;
+		uint16 NumAABB = 0;
+		uint16 NumOBB = 0;
+		uint16 NumKeypoints = 0;
+		uint16 NumJoints = 0;
+		TArray<FString> PointNames;
+	};
+
+	/** Same corner order as get_bbox3d in camera_projection_utils.py */
+	void AddBoxCorners(const FVector& Center, const FVector& Extent, const FTransform& Transform, TArray<FVector>& Points)
+	{
+		static const FVector Signs[8] = {
+			FVector(-1, -1, -1), FVector(1, -1, -1), FVector(1, 1, -1), FVector(-1, 1, -1),
+			FVector(-1, -1, 1), FVector(1, -1, 1), FVector(1, 1, 1), FVector(-1, 1, 1),
+		};
+		for (const FVector& Sign : Signs)
+		{
+			Points.Add(Transform.TransformPosition(Center + Sign * Extent));
+		}
+	}
+
+	void WriteName(FBufferArchive& Ar, const FString& Name)
+	{
+		FTCHARToUTF8 Utf8(*Name);
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	}
+}
+
+FExecStatus FLychSimCameraHandler::ProjectObjects(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	FExecStatus ExecStatus = FExecStatus::OK();
+	UFusionCamSensor* FusionCamSensor = GetCamera(Pos, ExecStatus);
+	if (!IsValid(FusionCamSensor)) return ExecStatus;
+
+	TArray<AActor*> ActorList;
+	if (Flags.Contains("all"))
+	{
+		UVisionBPLib::GetActorList(ActorList);
+	}
+	else
+	{
+		for (int32 i = 1; i < Pos.Num(); i++)
+		{
+			ActorList.Add(GetActorById(FUnrealcvServer::Get().GetWorld(), Pos[i]));
+		}
+	}
+
+	TSet<FString> What;
+	const FString* WhatStr = Kw.Find(TEXT("what"));
+	if (WhatStr)
+	{
+		TArray<FString> Parts;
+		WhatStr->ParseIntoArray(Parts, TEXT(","), true);
+		What.Append(Parts);
+	}
+	else
+	{
+		What.Append({ TEXT("aabb"), TEXT("obb"), TEXT("kp"), TEXT("joints") });
+	}
+
+	// Gather world space points on the game thread, the projection itself runs in parallel
+	TArray<FVector> Points;
+	TArray<FProjectedActor> Actors;
+	Actors.Reserve(ActorList.Num());
+	for (int32 i = 0; i < ActorList.Num(); i++)
+	{
+		AActor* Actor = ActorList[i];
+		FProjectedActor& Entry = Actors.AddDefaulted_GetRef();
+		Entry.Offset = Points.Num();
+		if (!IsValid(Actor))
+		{
+			Entry.Name = Flags.Contains("all") ? FString() : Pos[i + 1];
+			continue;
+		}
+		Entry.Name = Actor->GetName();
+
+		if (What.Contains(TEXT("aabb")))
+		{
+			FBox AABB = FActorController(Actor).GetAxisAlignedBoundingBox();
+			if (AABB.IsValid)
+			{
+				AddBoxCorners(AABB.GetCenter(), AABB.GetExtent(), FTransform::Identity, Points);
+				Entry.NumAABB = 8;
+			}
+		}
+
+		if (What.Contains(TEXT("obb")))
+		{
+			FBox LocalBox = Actor->CalculateComponentsBoundingBoxInLocalSpace(false);
+			if (LocalBox.IsValid)
+			{
+				AddBoxCorners(LocalBox.GetCenter(), LocalBox.GetExtent(), Actor->GetActorTransform(), Points);
+				Entry.NumOBB = 8;
+			}
+		}
+
+		if (What.Contains(TEXT("kp")))
+		{
+			TArray<UKeypointComponent*> KeypointComponents;
+			Actor->GetComponents<UKeypointComponent>(KeypointComponents);
+			for (UKeypointComponent* KeypointComponent : KeypointComponents)
+			{
+				TArray<FString> KeypointNames;
+				TArray<FVector> Locations;
+				KeypointComponent->GetKeypoints(KeypointNames, Locations, true);
+				Points.Append(Locations);
+				Entry.PointNames.Append(KeypointNames);
+				Entry.NumKeypoints += Locations.Num();
+			}
+		}
+
+		if (What.Contains(TEXT("joints")))
+		{
+			TArray<USkeletalMeshComponent*> SkeletalMeshComponents;
+			Actor->GetComponents<USkeletalMeshComponent>(SkeletalMeshComponents);
+			for (USkeletalMeshComponent* SkeletalMeshComponent : SkeletalMeshComponents)
+			{
+				if (!IsValid(SkeletalMeshComponent->GetSkeletalMeshAsset())) continue;
+				FBoneSensor BoneSensor(SkeletalMeshComponent);
+				for (const FBoneInfo& BoneInfo : BoneSensor.GetBonesInfo())
+				{
+					Points.Add(BoneInfo.WorldTM.GetLocation());
+					Entry.PointNames.Add(BoneInfo.BoneName);
+					Entry.NumJoints++;
+				}
+			}
+		}
+	}
+
+	FMatrix ViewMatrix, ProjectionMatrix;
+	FusionCamSensor->GetViewProjectionMatrix(ViewMatrix, ProjectionMatrix);
+	int Width = FusionCamSensor->GetFilmWidth();
+	int Height = FusionCamSensor->GetFilmHeight();
+
+	TArray<float> UVD;
+	LychSim::ProjectPoints(ViewMatrix, ProjectionMatrix, Width, Height, Points, UVD);
+
+	// Header (28 bytes), float32 [num_points, 3] of (u, v, depth), actor table, name table
+	FBufferArchive Ar;
+	uint32 Magic = 0x4A52504C; // 'LPRJ'
+	uint16 Version = 1;
+	uint16 bOrtho = FusionCamSensor->GetProjectionType() == ECameraProjectionMode::Orthographic ? 1 : 0;
+	int32 W = Width, H = Height;
+	uint32 NumActors = Actors.Num();
+	uint32 NumPoints = Points.Num();
+	uint32 Reserved = 0;
+	Ar << Magic << Version << bOrtho << W << H << NumActors << NumPoints << Reserved;
+	Ar.Serialize(UVD.GetData(), UVD.Num() * sizeof(float));
+
+	for (FProjectedActor& Entry : Actors)
+	{
+		Ar << Entry.Offset << Entry.NumAABB << Entry.NumOBB << Entry.NumKeypoints << Entry.NumJoints;
+	}
+	for (const FProjectedActor& Entry : Actors)
+	{
+		WriteName(Ar, Entry.Name);
+		for (const FString& PointName : Entry.PointNames)
+		{
+			WriteName(Ar, PointName);
+		}
+	}
+
+	TArray<uint8> BinaryData = MoveTemp(Ar);
+	return FExecStatus::Binary(BinaryData);
+}
@@ -21,12 +21,15 @@ private:
 
     FExecStatus SetFilmSize(const TArray<FString>& Args);
 
-    FExecStatus GetCameraLit(const TArray<FString>& Args);
+    FExecStatus GetCameraLit(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+    FExecStatus GetCameraMulti(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
     FExecStatus WarmupCamera(const TArray<FString>& Args);
-    FExecStatus GetCameraSeg(const TArray<FString>& Args);
-    FExecStatus GetCameraNormal(const TArray<FString>& Args);
+    FExecStatus GetCameraSeg(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+    FExecStatus GetCameraSegStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+    FExecStatus GetCameraNormal(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
     FExecStatus AnnotateNewObjects(const TArray<FString>& Args);
     FExecStatus ClearAnnotationComponents(const TArray<FString>& Args);
-    FExecStatus GetCameraDepth(const TArray<FString>& Args);
+    FExecStatus GetCameraDepth(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
     FExecStatus GetCameraAnnotations(const TArray<FString>& Args);
+    FExecStatus ProjectObjects(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 };
@@ -9,6 +9,8 @@
 #include "Utils/DataUtil.h"
 #include "Utils/StrFormatter.h"
 #include "Utils/UObjectUtils.h"
+#include "Utils/ObjectSnapshot.h"
+#include "Utils/FileWriter.h"
 #include "UnrealcvLog.h"
 #include "Editor.h"
 #include "ScopedTransaction.h"
@@ -28,7 +30,7 @@ void FLychSimDataHandler::RegisterCommands() {
 	CommandDispatcher->BindCommandUE(
 		"lych data info",
 		FDispatcherDelegateUE::CreateRaw(this, &FLychSimDataHandler::CollectInfo),
-		"Get info about selected object."
+		"Get info about selected object, -format=bin returns a packed column snapshot."
 	);
 
 	CommandDispatcher->BindCommandUE(
@@ -36,6 +38,18 @@ void FLychSimDataHandler::RegisterCommands() {
 		FDispatcherDelegateUE::CreateRaw(this, &FLychSimDataHandler::LSDrawDebugLine),
 		"Draw a debug line connecting the center of a list of objects."
 	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych data flush",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimDataHandler::FlushWriter),
+		"Wait until every file queued by the camera commands and the capture actor is written, -timeout=<seconds>."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych data writer_stats",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimDataHandler::GetWriterStats),
+		"Get the queued bytes, encode and write time of the file writer threads, -reset clears the counters."
+	);
 }
 
 FExecStatus FLychSimDataHandler::CollectInfo(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
@@ -63,113 +77,37 @@ FExecStatus FLychSimDataHandler::CollectInfo(const TArray<FString>& Pos, const T
 		return FExecStatus::OK(MoveTemp(Out));
     }
 
-	Writer->WriteValue(TEXT("status"), TEXT("ok"));
-	Writer->WriteArrayStart(TEXT("outputs"));
-
+	TArray<AActor*> ActorList;
 	for (FSelectionIterator It(*SelectedActors); It; ++It)
 	{
 		if (AActor* Actor = Cast<AActor>(*It))
 		{
-			Writer->WriteObjectStart();
-			Writer->WriteValue(TEXT("object_id"), *Actor->GetName());
-
-			Writer->WriteValue(TEXT("status"), TEXT("ok"));
-
-			FGuid Guid = Actor->GetActorGuid();
-			if (Guid.IsValid())
-			{
-				Writer->WriteValue(TEXT("guid"), *Guid.ToString());
-			}
-			else
-			{
-				Writer->WriteValue(TEXT("guid"), TEXT("NO_GUID"));
-			}
-
-			FActorController Controller(Actor);
-
-			FBox AABB = Controller.GetAxisAlignedBoundingBox();
-			Writer->WriteObjectStart(TEXT("aabb"));
-			Writer->WriteArrayStart(TEXT("center"));
-        	Writer->WriteValue(AABB.GetCenter().X);
-        	Writer->WriteValue(AABB.GetCenter().Y);
-        	Writer->WriteValue(AABB.GetCenter().Z);
-        	Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(AABB.GetExtent().X);
-			Writer->WriteValue(AABB.GetExtent().Y);
-			Writer->WriteValue(AABB.GetExtent().Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			FVector Center;
-			FVector Extent;
-			Actor->GetActorBounds(false, Center, Extent);
-			FRotator Rotator = Actor->GetActorRotation();
-			Writer->WriteObjectStart(TEXT("obb"));
-			Writer->WriteArrayStart(TEXT("center"));
-        	Writer->WriteValue(Center.X);
-        	Writer->WriteValue(Center.Y);
-        	Writer->WriteValue(Center.Z);
-        	Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(Extent.X);
-			Writer->WriteValue(Extent.Y);
-			Writer->WriteValue(Extent.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("rotation"));
-			Writer->WriteValue(Rotator.Pitch);
-			Writer->WriteValue(Rotator.Yaw);
-			Writer->WriteValue(Rotator.Roll);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			bool bOnlyCollidingComponents = false;
-			Actor->GetActorBounds(bOnlyCollidingComponents, Center, Extent);
-			Writer->WriteObjectStart(TEXT("bounds"));
-			Writer->WriteArrayStart(TEXT("center"));
-			Writer->WriteValue(Center.X);
-			Writer->WriteValue(Center.Y);
-			Writer->WriteValue(Center.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(Extent.X);
-			Writer->WriteValue(Extent.Y);
-			Writer->WriteValue(Extent.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			FVector Location = Controller.GetLocation();
-			Writer->WriteArrayStart(TEXT("location"));
-			Writer->WriteValue(Location.X); Writer->WriteValue(Location.Y); Writer->WriteValue(Location.Z);
-			Writer->WriteArrayEnd();
-
-			FRotator Rotation = Controller.GetRotation();
-			Writer->WriteArrayStart(TEXT("rotation"));
-			Writer->WriteValue(Rotation.Pitch); Writer->WriteValue(Rotation.Yaw); Writer->WriteValue(Rotation.Roll);
-			Writer->WriteArrayEnd();
-
-			FVector Scale = Actor->GetActorScale3D();
-			Writer->WriteArrayStart(TEXT("scale"));
-			Writer->WriteValue(Scale.X); Writer->WriteValue(Scale.Y); Writer->WriteValue(Scale.Z);
-			Writer->WriteArrayEnd();
+			ActorList.Add(Actor);
+		}
+	}
 
-			FColor AnnotationColor;
-			Controller.GetAnnotationColor(AnnotationColor);
-			Writer->WriteArrayStart(TEXT("color"));
-        	Writer->WriteValue(AnnotationColor.R); Writer->WriteValue(AnnotationColor.G);
-			Writer->WriteValue(AnnotationColor.B); Writer->WriteValue(AnnotationColor.A);
-        	Writer->WriteArrayEnd();
+	TArray<LychSim::FObjectSnapshotRow> Rows;
+	LychSim::GatherObjectSnapshot(ActorList, Rows);
 
-			Writer->WriteObjectEnd();
-		}
+	const FString* Format = Kw.Find(TEXT("format"));
+	if (Format && *Format == TEXT("bin"))
+	{
+		TArray<uint8> BinaryData = LychSim::SerializeObjectSnapshot(Rows);
+		return FExecStatus::Binary(BinaryData);
 	}
 
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteArrayStart(TEXT("outputs"));
+	for (const LychSim::FObjectSnapshotRow& Row : Rows)
+	{
+		LychSim::WriteObjectSnapshotJson(Writer, Row);
+	}
 	Writer->WriteArrayEnd();
 	Writer->WriteObjectEnd();
 	Writer->Close();
 	return FExecStatus::OK(MoveTemp(Out));
 #else
-	Writer->WriteValue(TEXT("status"), TEXT("Running CollectInfo from outside editor"))
+	Writer->WriteValue(TEXT("status"), TEXT("Running CollectInfo from outside editor"));
 	Writer->WriteObjectEnd();
 	Writer->Close();
 	return FExecStatus::OK(MoveTemp(Out));
@@ -257,3 +195,61 @@ FExecStatus FLychSimDataHandler::LSDrawDebugLine(const TArray<FString>& Pos, con
 	return FExecStatus::OK(MoveTemp(Out));
 #endif
 }
+
+FExecStatus FLychSimDataHandler::FlushWriter(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	uint32 WaitTimeMs = MAX_uint32;
+	if (const FString* Timeout = Kw.Find(TEXT("timeout")))
+	{
+		WaitTimeMs = (uint32)FMath::Max(FCString::Atof(**Timeout) * 1000.0f, 0.0f);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const bool bFlushed = LychSim::FFileWriter::Get().Flush(WaitTimeMs);
+	// Failures of the files that were written since the last flush
+	TArray<FString> FailedFiles;
+	const int64 NumFailed = LychSim::FFileWriter::Get().TakeFailures(FailedFiles);
+
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), NumFailed > 0 ? TEXT("failed") : bFlushed ? TEXT("ok") : TEXT("timeout"));
+	Writer->WriteValue(TEXT("waited"), FPlatformTime::Seconds() - StartTime);
+	Writer->WriteValue(TEXT("queued_files"), LychSim::FFileWriter::Get().GetStats().QueuedFiles);
+	Writer->WriteValue(TEXT("failed"), NumFailed);
+	Writer->WriteArrayStart(TEXT("failed_files"));
+	for (const FString& FailedFile : FailedFiles)
+	{
+		Writer->WriteValue(FailedFile);
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FLychSimDataHandler::GetWriterStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	LychSim::FFileWriter& FileWriter = LychSim::FFileWriter::Get();
+	const LychSim::FFileWriterStats Stats = FileWriter.GetStats();
+	if (Flags.Contains(TEXT("reset")))
+	{
+		FileWriter.ResetStats();
+	}
+
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("queued_files"), Stats.QueuedFiles);
+	Writer->WriteValue(TEXT("queued_bytes"), Stats.QueuedBytes);
+	Writer->WriteValue(TEXT("max_queued_bytes"), Stats.MaxQueuedBytes);
+	Writer->WriteValue(TEXT("written"), Stats.NumWritten);
+	Writer->WriteValue(TEXT("failed"), Stats.NumFailed);
+	Writer->WriteValue(TEXT("bytes_written"), Stats.BytesWritten);
+	Writer->WriteValue(TEXT("encode_time"), Stats.EncodeSeconds);
+	Writer->WriteValue(TEXT("write_time"), Stats.WriteSeconds);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
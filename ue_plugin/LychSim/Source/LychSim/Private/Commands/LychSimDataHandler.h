@@ -12,4 +12,8 @@ private:
 	FExecStatus CollectInfo(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 
 	FExecStatus LSDrawDebugLine(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	FExecStatus FlushWriter(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	FExecStatus GetWriterStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 };
@@ -3,6 +3,11 @@
 #include "Controller/ActorController.h"
 #include "Utils/StrFormatter.h"
 #include "Utils/UObjectUtils.h"
+#include "Utils/ObjectSnapshot.h"
+#include "Utils/SpawnQueue.h"
+#include "Utils/MeshExport.h"
+#include "Utils/SkinnedCapture.h"
+#include "Utils/BoneCapture.h"
 #include "UnrealcvLog.h"
 #include "VisionBPLib.h"
 #include "EngineUtils.h"
@@ -16,6 +21,10 @@
 #include "UnrealEdGlobals.h"
 #include "Selection.h"
 #include "GameFramework/Actor.h"
+#include "Engine/ScopedMovementUpdate.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Misc/Base64.h"
+#include "Misc/FileHelper.h"
 
 void FLychSimObjectHandler::RegisterCommands()
 {
@@ -55,6 +64,12 @@ void FLychSimObjectHandler::RegisterCommands()
 		"Update object properties."
 	);
 
+	CommandDispatcher->BindCommandUE(
+		"lych obj update_batch",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::UpdateObjectBatch),
+		"Update transforms of many objects from packed records, -data=<base64> or -file=<path>."
+	);
+
 	CommandDispatcher->BindCommandUE(
 		"lych obj get_aabb",
 		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetObjectAABB),
@@ -76,7 +91,7 @@ void FLychSimObjectHandler::RegisterCommands()
 	CommandDispatcher->BindCommandUE(
 		"lych obj get_annots",
 		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetObjectAnnotations),
-		"Get all object annotations."
+		"Get all object annotations, -format=bin returns a packed column snapshot."
 	);
 
 	CommandDispatcher->BindCommand(
@@ -85,6 +100,36 @@ void FLychSimObjectHandler::RegisterCommands()
 		"Add object to the scene."
 	);
 
+	CommandDispatcher->BindCommandUE(
+		"lych obj spawn_batch",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::SpawnObjects),
+		"Spawn objects from a manifest in the background, -file=<path> or -data=<base64>. Returns a job id."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych obj spawn_status",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetSpawnStatus),
+		"Get the progress of a spawn job, -cancel stops it."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych obj get_mesh",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetObjectMesh),
+		"Get packed float32 vertices of an object, -lod=<n> -space=world|local -normals -indices."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych obj get_skinned_verts",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetSkinnedVertices),
+		"Get packed world space vertices of skinned meshes, <ids> or -all, -lod=<n>, -format=raw for the raw tensor format."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych obj get_bones",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetBones),
+		"Get packed bone transforms [bone, 3x4] of skeletal meshes, <ids> or -all, -space=world|component -names."
+	);
+
 	CommandDispatcher->BindCommandUE(
 		"lych obj get_mesh_extent",
 		FDispatcherDelegateUE::CreateRaw(this, &FLychSimObjectHandler::GetMeshExtent),
@@ -459,6 +504,162 @@ FExecStatus FLychSimObjectHandler::UpdateObject(
 	return FExecStatus::OK(MoveTemp(Out));
 }
 
+namespace
+{
+	/** One record of "lych obj update_batch" */
+	struct FTransformRecord
+	{
+		FString ActorId;
+		uint8 Mask = 0; // bit 0 location, bit 1 rotation, bit 2 scale
+		FVector Location;
+		FRotator Rotation;
+		FVector Scale;
+	};
+
+	/**
+	 * Records are little endian: uint32 magic 'LXFM', uint32 count, then per record
+	 * {uint16 id length, utf8 id, uint8 mask, float32 x, y, z, pitch, yaw, roll, sx, sy, sz}
+	 */
+	bool ParseTransformRecords(const TArray<uint8>& Data, TArray<FTransformRecord>& OutRecords)
+	{
+		const int32 RecordFloats = 9;
+		int32 Offset = 0;
+		auto Read = [&](void* Dst, int32 Size) -> bool
+		{
+			if (Offset + Size > Data.Num()) return false;
+			FMemory::Memcpy(Dst, Data.GetData() + Offset, Size);
+			Offset += Size;
+			return true;
+		};
+
+		uint32 Magic = 0, Count = 0;
+		if (!Read(&Magic, 4) || Magic != 0x4D46584C || !Read(&Count, 4)) return false;
+
+		// The count is untrusted, it can not be more than the records that fit in the payload
+		const int64 MinRecordSize = 2 + 1 + RecordFloats * sizeof(float);
+		if ((int64)Count * MinRecordSize > (int64)(Data.Num() - Offset)) return false;
+
+		OutRecords.Reserve(Count);
+		for (uint32 i = 0; i < Count; i++)
+		{
+			uint16 IdLength = 0;
+			if (!Read(&IdLength, 2) || Offset + IdLength > Data.Num()) return false;
+			FTransformRecord& Record = OutRecords.AddDefaulted_GetRef();
+			Record.ActorId = FString(FUTF8ToTCHAR((const ANSICHAR*)Data.GetData() + Offset, IdLength));
+			Offset += IdLength;
+
+			float Values[RecordFloats];
+			if (!Read(&Record.Mask, 1) || !Read(Values, sizeof(Values))) return false;
+			Record.Location = FVector(Values[0], Values[1], Values[2]);
+			Record.Rotation = FRotator(Values[3], Values[4], Values[5]);
+			Record.Scale = FVector(Values[6], Values[7], Values[8]);
+		}
+		return true;
+	}
+}
+
+FExecStatus FLychSimObjectHandler::UpdateObjectBatch(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	FString Out;
+    TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+
+	TArray<uint8> Data;
+	if (const FString* Base64 = Kw.Find(TEXT("data")))
+	{
+		FBase64::Decode(*Base64, Data);
+	}
+	else if (const FString* Filename = Kw.Find(TEXT("file")))
+	{
+		FFileHelper::LoadFileToArray(Data, **Filename);
+	}
+
+	TArray<FTransformRecord> Records;
+	if (!ParseTransformRecords(Data, Records))
+	{
+		Writer->WriteValue(TEXT("status"), TEXT("Cannot parse transform records"));
+		Writer->WriteObjectEnd();
+		Writer->Close();
+		return FExecStatus::OK(MoveTemp(Out));
+	}
+
+	// One pass over the world instead of one GetActorById walk per record
+	TMap<FString, AActor*> ActorMap;
+	UWorld* World = FUnrealcvServer::Get().GetWorld();
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		ActorMap.Add(It->GetName(), *It);
+	}
+
+	// Status per record, 0 ok, 1 object not found, 2 nothing to update
+	FString Codes;
+	Codes.Reserve(Records.Num());
+	TSet<AActor*> MovableActors;
+	int32 NumUpdated = 0;
+
+	// One deferred movement scope per actor stays open for the whole batch, so an actor moved by
+	// many records updates its components to the world once, when its scope is closed
+	TArray<TUniquePtr<FScopedMovementUpdate>> MovementScopes;
+
+	for (const FTransformRecord& Record : Records)
+	{
+		AActor** Found = ActorMap.Find(Record.ActorId);
+		AActor* Actor = Found ? *Found : nullptr;
+		if (!IsValid(Actor) || !Actor->GetRootComponent())
+		{
+			Codes.AppendChar(TEXT('1'));
+			continue;
+		}
+		if ((Record.Mask & 0x7) == 0)
+		{
+			Codes.AppendChar(TEXT('2'));
+			continue;
+		}
+
+		// Change the mobility once per actor, and only if the root is not movable yet
+		if (!MovableActors.Contains(Actor))
+		{
+			if (Actor->GetRootComponent()->Mobility != EComponentMobility::Movable)
+			{
+				for (UActorComponent* Comp : Actor->GetComponents())
+				{
+					if (USceneComponent* SceneComp = Cast<USceneComponent>(Comp))
+					{
+						SceneComp->SetMobility(EComponentMobility::Movable);
+					}
+				}
+			}
+			MovableActors.Add(Actor);
+			MovementScopes.Add(MakeUnique<FScopedMovementUpdate>(Actor->GetRootComponent(), EScopedUpdate::DeferredUpdates));
+		}
+
+		// Merge the fields into one transform, so child components are updated once, not per field
+		FTransform Transform = Actor->GetActorTransform();
+		if (Record.Mask & 0x1) Transform.SetLocation(Record.Location);
+		if (Record.Mask & 0x2) Transform.SetRotation(Record.Rotation.Quaternion());
+		if (Record.Mask & 0x4) Transform.SetScale3D(Record.Scale);
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		Codes.AppendChar(TEXT('0'));
+		NumUpdated++;
+	}
+
+	// Close the scopes in the reverse order of opening as nested scopes must be, emptying the array would not
+	while (MovementScopes.Num() > 0)
+	{
+		MovementScopes.Pop();
+	}
+
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("num_updated"), NumUpdated);
+	Writer->WriteValue(TEXT("codes"), Codes);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
 FExecStatus FLychSimObjectHandler::GetObjectAABB(
 	const TArray<FString>& Pos,
     const TMap<FString,FString>& Kw,
@@ -627,6 +828,23 @@ FExecStatus FLychSimObjectHandler::GetObjectAnnotations(
 		}
 	}
 
+	TArray<LychSim::FObjectSnapshotRow> Rows;
+	LychSim::GatherObjectSnapshot(ActorList, Rows);
+	if (!Flags.Contains("all"))
+	{
+		for (int32 i = 0; i < Rows.Num(); i++)
+		{
+			Rows[i].ObjectId = Pos[i];
+		}
+	}
+
+	const FString* Format = Kw.Find(TEXT("format"));
+	if (Format && *Format == TEXT("bin"))
+	{
+		TArray<uint8> BinaryData = LychSim::SerializeObjectSnapshot(Rows);
+		return FExecStatus::Binary(BinaryData);
+	}
+
 	FString Out;
     TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
 
@@ -634,109 +852,10 @@ FExecStatus FLychSimObjectHandler::GetObjectAnnotations(
 	Writer->WriteValue(TEXT("status"), TEXT("ok"));
 
 	Writer->WriteArrayStart(TEXT("outputs"));
-
-	for (AActor* Actor : ActorList)
+	for (const LychSim::FObjectSnapshotRow& Row : Rows)
 	{
-		Writer->WriteObjectStart();
-		Writer->WriteValue(TEXT("object_id"), *Actor->GetName());
-
-		if (!Actor)
-        {
-            Writer->WriteValue(TEXT("status"), TEXT("not_found"));
-        }
-		else
-		{
-			Writer->WriteValue(TEXT("status"), TEXT("ok"));
-
-			FGuid Guid = Actor->GetActorGuid();
-			if (Guid.IsValid())
-			{
-				Writer->WriteValue(TEXT("guid"), *Guid.ToString());
-			}
-			else
-			{
-				Writer->WriteValue(TEXT("guid"), TEXT("NO_GUID"));
-			}
-
-			FActorController Controller(Actor);
-
-			FBox AABB = Controller.GetAxisAlignedBoundingBox();
-			Writer->WriteObjectStart(TEXT("aabb"));
-			Writer->WriteArrayStart(TEXT("center"));
-        	Writer->WriteValue(AABB.GetCenter().X);
-        	Writer->WriteValue(AABB.GetCenter().Y);
-        	Writer->WriteValue(AABB.GetCenter().Z);
-        	Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(AABB.GetExtent().X);
-			Writer->WriteValue(AABB.GetExtent().Y);
-			Writer->WriteValue(AABB.GetExtent().Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			FVector Center;
-			FVector Extent;
-			Actor->GetActorBounds(false, Center, Extent);
-			FRotator Rotator = Actor->GetActorRotation();
-			Writer->WriteObjectStart(TEXT("obb"));
-			Writer->WriteArrayStart(TEXT("center"));
-        	Writer->WriteValue(Center.X);
-        	Writer->WriteValue(Center.Y);
-        	Writer->WriteValue(Center.Z);
-        	Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(Extent.X);
-			Writer->WriteValue(Extent.Y);
-			Writer->WriteValue(Extent.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("rotation"));
-			Writer->WriteValue(Rotator.Pitch);
-			Writer->WriteValue(Rotator.Yaw);
-			Writer->WriteValue(Rotator.Roll);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			bool bOnlyCollidingComponents = false;
-			Actor->GetActorBounds(bOnlyCollidingComponents, Center, Extent);
-			Writer->WriteObjectStart(TEXT("bounds"));
-			Writer->WriteArrayStart(TEXT("center"));
-			Writer->WriteValue(Center.X);
-			Writer->WriteValue(Center.Y);
-			Writer->WriteValue(Center.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteArrayStart(TEXT("extent"));
-			Writer->WriteValue(Extent.X);
-			Writer->WriteValue(Extent.Y);
-			Writer->WriteValue(Extent.Z);
-			Writer->WriteArrayEnd();
-			Writer->WriteObjectEnd();
-
-			FVector Location = Controller.GetLocation();
-			Writer->WriteArrayStart(TEXT("location"));
-			Writer->WriteValue(Location.X); Writer->WriteValue(Location.Y); Writer->WriteValue(Location.Z);
-			Writer->WriteArrayEnd();
-
-			FRotator Rotation = Controller.GetRotation();
-			Writer->WriteArrayStart(TEXT("rotation"));
-			Writer->WriteValue(Rotation.Pitch); Writer->WriteValue(Rotation.Yaw); Writer->WriteValue(Rotation.Roll);
-			Writer->WriteArrayEnd();
-
-			FVector Scale = Actor->GetActorScale3D();
-			Writer->WriteArrayStart(TEXT("scale"));
-			Writer->WriteValue(Scale.X); Writer->WriteValue(Scale.Y); Writer->WriteValue(Scale.Z);
-			Writer->WriteArrayEnd();
-
-			FColor AnnotationColor;
-			Controller.GetAnnotationColor(AnnotationColor);
-			Writer->WriteArrayStart(TEXT("color"));
-        	Writer->WriteValue(AnnotationColor.R); Writer->WriteValue(AnnotationColor.G);
-			Writer->WriteValue(AnnotationColor.B); Writer->WriteValue(AnnotationColor.A);
-        	Writer->WriteArrayEnd();
-		}
-
-		Writer->WriteObjectEnd();
+		LychSim::WriteObjectSnapshotJson(Writer, Row);
 	}
-
 	Writer->WriteArrayEnd();
 	Writer->WriteObjectEnd();
 	Writer->Close();
@@ -818,6 +937,210 @@ FExecStatus FLychSimObjectHandler::AddObject(const TArray<FString>& Args)
 	return FExecStatus::OK();
 }
 
+FExecStatus FLychSimObjectHandler::SpawnObjects(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	FString Out;
+    TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+
+	TArray<uint8> Data;
+	if (const FString* Base64 = Kw.Find(TEXT("data")))
+	{
+		FBase64::Decode(*Base64, Data);
+	}
+	else if (const FString* Filename = Kw.Find(TEXT("file")))
+	{
+		FFileHelper::LoadFileToArray(Data, **Filename);
+	}
+
+	LychSim::FSpawnManifest Manifest;
+	FString Error;
+	UWorld* World = GEditor->PlayWorld ? GEditor->PlayWorld : GEditor->GetEditorWorldContext().World();
+	if (!LychSim::ParseSpawnManifest(Data, Manifest, Error))
+	{
+		Writer->WriteValue(TEXT("status"), Error);
+	}
+	else if (!World)
+	{
+		Writer->WriteValue(TEXT("status"), TEXT("Valid world context not found"));
+	}
+	else
+	{
+		FLychSimSpawnQueue::FJobOptions Options;
+		if (const FString* BudgetMs = Kw.Find(TEXT("budget_ms")))
+		{
+			Options.BudgetSeconds = FMath::Max(FCString::Atof(**BudgetMs), 0.1f) / 1000.0;
+		}
+		Options.bSimulatePhysics = !Flags.Contains(TEXT("no_physics"));
+
+		if (!SpawnQueue.IsValid())
+		{
+			SpawnQueue = MakeShared<FLychSimSpawnQueue>();
+		}
+		const int32 Total = Manifest.Entries.Num();
+		const int32 NumAssets = Manifest.AssetPaths.Num();
+		const int32 JobId = SpawnQueue->AddJob(World, MoveTemp(Manifest), Options);
+
+		Writer->WriteValue(TEXT("status"), TEXT("ok"));
+		Writer->WriteValue(TEXT("job"), JobId);
+		Writer->WriteValue(TEXT("total"), Total);
+		Writer->WriteValue(TEXT("assets_total"), NumAssets);
+	}
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FLychSimObjectHandler::GetSpawnStatus(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	if (Pos.Num() != 1)
+	{
+		return FExecStatus::Error("Usage: lych obj spawn_status <job_id> [-cancel]");
+	}
+	const int32 JobId = FCString::Atoi(*Pos[0]);
+
+	FString Out;
+    TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+
+	if (!SpawnQueue.IsValid() || !SpawnQueue->HasJob(JobId))
+	{
+		Writer->WriteValue(TEXT("status"), TEXT("Job not found"));
+	}
+	else
+	{
+		if (Flags.Contains(TEXT("cancel")))
+		{
+			SpawnQueue->CancelJob(JobId);
+		}
+		Writer->WriteValue(TEXT("status"), TEXT("ok"));
+		SpawnQueue->WriteJobStatus(JobId, Writer);
+	}
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FLychSimObjectHandler::GetObjectMesh(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	if (Pos.Num() != 1)
+	{
+		return FExecStatus::Error("Usage: lych obj get_mesh <obj_id> [-lod=0] [-space=world|local] [-normals] [-indices]");
+	}
+	AActor* Actor = GetActorById(FUnrealcvServer::Get().GetWorld(), Pos[0]);
+	if (!Actor)
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Can not find object %s"), *Pos[0]));
+	}
+
+	const FString* LOD = Kw.Find(TEXT("lod"));
+	const FString* Space = Kw.Find(TEXT("space"));
+	uint16 ExportFlags = 0;
+	if (!Space || *Space == TEXT("world")) ExportFlags |= LychSim::MeshExportWorld;
+	else if (*Space != TEXT("local")) return FExecStatus::Error("-space should be world or local");
+	if (Flags.Contains(TEXT("normals"))) ExportFlags |= LychSim::MeshExportNormals;
+	if (Flags.Contains(TEXT("indices"))) ExportFlags |= LychSim::MeshExportIndices;
+
+	TArray<uint8> Data = LychSim::SerializeActorMesh(Actor, LOD ? FCString::Atoi(**LOD) : 0, ExportFlags);
+	return FExecStatus::Binary(Data);
+}
+
+FExecStatus FLychSimObjectHandler::GetSkinnedVertices(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	TArray<AActor*> ActorList;
+	if (Flags.Contains("all"))
+	{
+		TArray<AActor*> AllActors;
+		UVisionBPLib::GetActorList(AllActors);
+		for (AActor* Actor : AllActors)
+		{
+			if (Actor->FindComponentByClass<USkinnedMeshComponent>())
+			{
+				ActorList.Add(Actor);
+			}
+		}
+	}
+	else
+	{
+		for (const FString& ActorId : Pos)
+		{
+			AActor* Actor = GetActorById(FUnrealcvServer::Get().GetWorld(), ActorId);
+			if (!Actor)
+			{
+				return FExecStatus::Error(FString::Printf(TEXT("Can not find object %s"), *ActorId));
+			}
+			ActorList.Add(Actor);
+		}
+	}
+
+	const FString* LOD = Kw.Find(TEXT("lod"));
+	LychSim::FSkinnedVertexCapture Capture;
+	LychSim::CaptureSkinnedVertices(ActorList, LOD ? FCString::Atoi(**LOD) : 0, Capture);
+	const FString* Format = Kw.Find(TEXT("format"));
+	if (Format && *Format == TEXT("raw"))
+	{
+		TArray<uint8> Header, Body;
+		LychSim::SerializeSkinnedVerticesRaw(Capture, GFrameCounter, Header, Body);
+		return FExecStatus::Binary(MoveTemp(Header), MoveTemp(Body));
+	}
+	if (Format && *Format != TEXT("lskv"))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid format %s, expect lskv or raw"), **Format));
+	}
+	TArray<uint8> Data = LychSim::SerializeSkinnedVertices(Capture);
+	return FExecStatus::Binary(MoveTemp(Data));
+}
+
+FExecStatus FLychSimObjectHandler::GetBones(
+	const TArray<FString>& Pos,
+    const TMap<FString,FString>& Kw,
+    const TSet<FString>& Flags)
+{
+	TArray<AActor*> ActorList;
+	if (Flags.Contains("all"))
+	{
+		UVisionBPLib::GetActorList(ActorList);
+	}
+	else
+	{
+		for (const FString& ActorId : Pos)
+		{
+			AActor* Actor = GetActorById(FUnrealcvServer::Get().GetWorld(), ActorId);
+			if (!Actor)
+			{
+				return FExecStatus::Error(FString::Printf(TEXT("Can not find object %s"), *ActorId));
+			}
+			ActorList.Add(Actor);
+		}
+	}
+
+	const FString* Space = Kw.Find(TEXT("space"));
+	if (Space && *Space != TEXT("world") && *Space != TEXT("component"))
+	{
+		return FExecStatus::Error("-space should be world or component");
+	}
+	const bool bWorldSpace = !Space || *Space == TEXT("world");
+
+	LychSim::FBoneCapture Capture;
+	LychSim::CaptureBones(ActorList, bWorldSpace, Capture);
+	TArray<uint8> Data = LychSim::SerializeBoneCapture(Capture, bWorldSpace, Flags.Contains(TEXT("names")));
+	return FExecStatus::Binary(Data);
+}
+
 FExecStatus FLychSimObjectHandler::GetMeshExtent(
 	const TArray<FString>& Pos,
     const TMap<FString,FString>& Kw,
@@ -17,6 +17,7 @@ private:
 	FExecStatus SetObjectLocation(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus SetObjectRotation(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus UpdateObject(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+	FExecStatus UpdateObjectBatch(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus GetObjectAABB(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus GetObjectOBB(const TArray<FString>& Args);
 	FExecStatus GetObjectAnnotationColor(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
@@ -25,8 +26,16 @@ private:
 	FExecStatus GetObjectIDFromSelection(const TArray<FString>& Args);
 
 	FExecStatus AddObject(const TArray<FString>& Args);
+	FExecStatus SpawnObjects(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+	FExecStatus GetSpawnStatus(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+	FExecStatus GetObjectMesh(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+	FExecStatus GetSkinnedVertices(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+	FExecStatus GetBones(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus GetMeshExtent(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
 	FExecStatus DestroyObject(const TArray<FString>& Args);
 
 	FExecStatus SetObjectMaterial(const TArray<FString>& Args);
+
+	/** Created on the first "lych obj spawn_batch", ticks the pending spawn jobs */
+	TSharedPtr<class FLychSimSpawnQueue> SpawnQueue;
 };
@@ -0,0 +1,316 @@
+#include "LychSimSimHandler.h"
+
+#include "Actor/DataCaptureActor.h"
+#include "Sensor/CameraSensor/FusionCamSensor.h"
+#include "SensorBPLib.h"
+#include "Utils/HeadlessMode.h"
+#include "Utils/Lockstep.h"
+#include "UnrealcvServer.h"
+#include "UnrealcvLog.h"
+#include "EngineUtils.h"
+
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+	const float DefaultLockstepDeltaTime = 1.0f / 30;
+
+	/** Frames skipped before each half of the capture bench, the first captures allocate render targets */
+	const int32 BenchWarmupFrames = 5;
+
+	/** One capture per frame with the headless mode off, then the same with it on */
+	struct FCaptureBench
+	{
+		int32 SensorId = 0;
+		FString Mode;
+		int32 NumFrames = 0;
+		bool bWasHeadless = false;
+
+		int32 Phase = 0; // 0 is headless off, 1 is headless on
+		int32 Frame = -BenchWarmupFrames;
+		double StartTime = 0;
+		double Seconds[2] = { 0, 0 };
+		double CaptureSeconds[2] = { 0, 0 };
+	};
+
+	bool CaptureOnce(UFusionCamSensor* Sensor, const FString& Mode)
+	{
+		int Width, Height;
+		if (Mode == TEXT("lit"))
+		{
+			TArray<FColor> Data;
+			Sensor->GetLit(Data, Width, Height);
+		}
+		else if (Mode == TEXT("depth"))
+		{
+			TArray<float> Data;
+			Sensor->GetDepth(Data, Width, Height);
+		}
+		else if (Mode == TEXT("seg"))
+		{
+			TArray<FColor> Data;
+			Sensor->GetSeg(Data, Width, Height);
+		}
+		else if (Mode == TEXT("normal"))
+		{
+			TArray<FColor> Data;
+			Sensor->GetNormal(Data, Width, Height);
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void SetHeadlessMode(bool bHeadless)
+	{
+		if (bHeadless)
+		{
+			UWorld* World = FUnrealcvServer::Get().GetGameWorld();
+			LychSim::FHeadlessMode::Get().Enable(IsValid(World) ? World : FUnrealcvServer::Get().GetWorld());
+		}
+		else
+		{
+			LychSim::FHeadlessMode::Get().Disable();
+		}
+	}
+
+	void WriteBenchPhase(TSharedRef< TJsonWriter<> >& Writer, const TCHAR* Name, const FCaptureBench& Bench, int32 Phase)
+	{
+		Writer->WriteObjectStart(Name);
+		Writer->WriteValue(TEXT("captures_per_sec"), Bench.Seconds[Phase] > 0 ? Bench.NumFrames / Bench.Seconds[Phase] : 0.0);
+		Writer->WriteValue(TEXT("frame_ms"), Bench.Seconds[Phase] * 1000 / Bench.NumFrames);
+		Writer->WriteValue(TEXT("capture_ms"), Bench.CaptureSeconds[Phase] * 1000 / Bench.NumFrames);
+		Writer->WriteObjectEnd();
+	}
+
+	void WriteLockstepState(TSharedRef< TJsonWriter<> >& Writer)
+	{
+		LychSim::FLockstep& Lockstep = LychSim::FLockstep::Get();
+		UWorld* World = Lockstep.GetWorld();
+		Writer->WriteValue(TEXT("lockstep"), Lockstep.IsEnabled());
+		Writer->WriteValue(TEXT("dt"), Lockstep.GetDeltaTime());
+		Writer->WriteValue(TEXT("total_ticks"), Lockstep.GetNumTicks());
+		Writer->WriteValue(TEXT("game_time"), IsValid(World) ? World->GetTimeSeconds() : 0.0);
+	}
+}
+
+void FLychSimSimHandler::RegisterCommands()
+{
+	CommandDispatcher->BindCommandUE(
+		"lych sim lockstep",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimSimHandler::SetLockstep),
+		"Pause the world and only advance it with lych sim step, on|off -dt=<seconds>. Without arguments return the state."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych sim step",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimSimHandler::Step),
+		"Advance the world by N fixed time steps and reply after the last one, -dt=<seconds>, -capture saves a frame with every data capture actor."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych sim headless",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimSimHandler::SetHeadless),
+		"Only render the camera sensors, skip the main viewport, audio, HUD and debug messages, on|off. Without arguments return the state."
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"lych sim bench_capture",
+		FDispatcherDelegateUE::CreateRaw(this, &FLychSimSimHandler::BenchCapture),
+		"Capture from a camera once per frame with the headless mode off and on, report captures per second, -frames=<n> -mode=lit|depth|seg|normal."
+	);
+}
+
+FExecStatus FLychSimSimHandler::SetLockstep(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	LychSim::FLockstep& Lockstep = LychSim::FLockstep::Get();
+	if (Pos.Num() > 0)
+	{
+		if (Pos[0] == TEXT("on"))
+		{
+			const FString* DeltaTimeStr = Kw.Find(TEXT("dt"));
+			float DeltaTime = DeltaTimeStr ? FCString::Atof(**DeltaTimeStr)
+				: (Lockstep.IsEnabled() ? Lockstep.GetDeltaTime() : DefaultLockstepDeltaTime);
+			FExecStatus Status = Lockstep.Enable(FUnrealcvServer::Get().GetGameWorld(), DeltaTime);
+			if (Status != FExecStatusType::OK)
+			{
+				return Status;
+			}
+		}
+		else if (Pos[0] == TEXT("off"))
+		{
+			Lockstep.Disable();
+		}
+		else
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Expect on or off, got %s"), *Pos[0]));
+		}
+	}
+
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	WriteLockstepState(Writer);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FLychSimSimHandler::Step(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	const int32 NumTicks = Pos.Num() > 0 ? FCString::Atoi(*Pos[0]) : 1;
+	const FString* DeltaTimeStr = Kw.Find(TEXT("dt"));
+	const float DeltaTime = DeltaTimeStr ? FCString::Atof(**DeltaTimeStr) : 0;
+	const bool bCapture = Flags.Contains(TEXT("capture"));
+
+	LychSim::FLockstep& Lockstep = LychSim::FLockstep::Get();
+	FExecStatus Status = Lockstep.Step(NumTicks, DeltaTime);
+	if (Status != FExecStatusType::OK)
+	{
+		return Status;
+	}
+
+	// The server holds later requests until this is fulfilled, so they see the stepped world
+	FPromiseDelegate PromiseDelegate = FPromiseDelegate::CreateLambda([NumTicks, bCapture]()
+	{
+		LychSim::FLockstep& Lockstep = LychSim::FLockstep::Get();
+		if (Lockstep.IsStepping())
+		{
+			return FExecStatus::Pending();
+		}
+		UWorld* World = Lockstep.GetWorld();
+		if (!IsValid(World))
+		{
+			return FExecStatus::Error("The world is gone before the step is finished");
+		}
+
+		int32 NumCaptured = 0;
+		if (bCapture)
+		{
+			for (TActorIterator<ADataCaptureActor> It(World); It; ++It)
+			{
+				It->CaptureFrame();
+				NumCaptured++;
+			}
+		}
+
+		FString Out;
+		TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("status"), TEXT("ok"));
+		Writer->WriteValue(TEXT("ticks"), NumTicks);
+		Writer->WriteValue(TEXT("captured"), NumCaptured);
+		WriteLockstepState(Writer);
+		Writer->WriteObjectEnd();
+		Writer->Close();
+		return FExecStatus::OK(MoveTemp(Out));
+	});
+	return FExecStatus::AsyncQuery(FPromise(PromiseDelegate));
+}
+
+FExecStatus FLychSimSimHandler::SetHeadless(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	if (Pos.Num() > 0)
+	{
+		if (Pos[0] != TEXT("on") && Pos[0] != TEXT("off"))
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Expect on or off, got %s"), *Pos[0]));
+		}
+		const bool bHeadless = Pos[0] == TEXT("on");
+		// Also keep it for the worlds started later, e.g. the next PIE session
+		FUnrealcvServer::Get().Config.Headless = bHeadless;
+		SetHeadlessMode(bHeadless);
+	}
+
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("headless"), LychSim::FHeadlessMode::Get().IsEnabled());
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FLychSimSimHandler::BenchCapture(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	if (Pos.Num() < 1)
+	{
+		return FExecStatus::Error("Expect a camera id");
+	}
+	TSharedRef<FCaptureBench> Bench = MakeShared<FCaptureBench>();
+	Bench->SensorId = FCString::Atoi(*Pos[0]);
+	if (!IsValid(USensorBPLib::GetSensorById(Bench->SensorId)))
+	{
+		return FExecStatus::Error("Invalid sensor id");
+	}
+	const FString* FramesStr = Kw.Find(TEXT("frames"));
+	Bench->NumFrames = FMath::Max(FramesStr ? FCString::Atoi(**FramesStr) : 60, 1);
+	const FString* ModeStr = Kw.Find(TEXT("mode"));
+	Bench->Mode = ModeStr ? *ModeStr : TEXT("lit");
+	if (!CaptureOnce(USensorBPLib::GetSensorById(Bench->SensorId), Bench->Mode))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Unknown mode %s"), *Bench->Mode));
+	}
+	Bench->bWasHeadless = LychSim::FHeadlessMode::Get().IsEnabled();
+	SetHeadlessMode(false);
+
+	// The promise is checked once per frame, so every check captures once and the frame time
+	// includes the main viewport unless the headless mode is on
+	FPromiseDelegate PromiseDelegate = FPromiseDelegate::CreateLambda([Bench]()
+	{
+		FCaptureBench& State = *Bench;
+		UFusionCamSensor* Sensor = USensorBPLib::GetSensorById(State.SensorId);
+		if (!IsValid(Sensor))
+		{
+			SetHeadlessMode(State.bWasHeadless);
+			return FExecStatus::Error("The camera is gone during the bench");
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (State.Frame == 0)
+		{
+			State.StartTime = Now;
+		}
+		else if (State.Frame == State.NumFrames)
+		{
+			State.Seconds[State.Phase] = Now - State.StartTime;
+			State.Phase++;
+			State.Frame = -BenchWarmupFrames;
+			if (State.Phase == 1)
+			{
+				SetHeadlessMode(true);
+			}
+		}
+
+		if (State.Phase < 2)
+		{
+			CaptureOnce(Sensor, State.Mode);
+			if (State.Frame >= 0)
+			{
+				State.CaptureSeconds[State.Phase] += FPlatformTime::Seconds() - Now;
+			}
+			State.Frame++;
+			return FExecStatus::Pending();
+		}
+
+		SetHeadlessMode(State.bWasHeadless);
+		FString Out;
+		TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("status"), TEXT("ok"));
+		Writer->WriteValue(TEXT("mode"), State.Mode);
+		Writer->WriteValue(TEXT("frames"), State.NumFrames);
+		WriteBenchPhase(Writer, TEXT("headless_off"), State, 0);
+		WriteBenchPhase(Writer, TEXT("headless_on"), State, 1);
+		Writer->WriteValue(TEXT("speedup"), State.Seconds[1] > 0 ? State.Seconds[0] / State.Seconds[1] : 0.0);
+		Writer->WriteObjectEnd();
+		Writer->Close();
+		return FExecStatus::OK(MoveTemp(Out));
+	});
+	return FExecStatus::AsyncQuery(FPromise(PromiseDelegate));
+}
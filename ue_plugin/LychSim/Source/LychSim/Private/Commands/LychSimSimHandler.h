@@ -0,0 +1,19 @@
+#pragma once
+
+#include "CommandDispatcher.h"
+#include "CommandHandler.h"
+
+class FLychSimSimHandler : public FCommandHandler
+{
+public:
+	void RegisterCommands();
+
+private:
+	FExecStatus SetLockstep(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	FExecStatus Step(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	FExecStatus SetHeadless(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	FExecStatus BenchCapture(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+};
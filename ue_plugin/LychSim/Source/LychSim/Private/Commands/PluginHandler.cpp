@@ -5,6 +5,12 @@
 #include "UnrealcvServer.h"
 #include "UnrealcvShim.h"
 #include "UnrealcvStats.h"
+#include "Utils/RequestLog.h"
+#include "Utils/RequestRecorder.h"
+#include "Utils/RequestStats.h"
+#include "Utils/Trace.h"
+#include "Runtime/Core/Public/Misc/FileHelper.h"
+#include "Serialization/JsonWriter.h"
 
 DECLARE_CYCLE_STAT(TEXT("FPluginHandler::GetUnrealCVStatus"), 
 	STAT_GetUnrealCVStatus, STATGROUP_UnrealCV);
@@ -101,6 +107,131 @@ FExecStatus FPluginHandler::GetLevelName(const TArray<FString>& Args)
 	return FExecStatus::OK(MapName);
 }
 
+FExecStatus FPluginHandler::GetRequestStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	const FString Format = Kw.Contains(TEXT("format")) ? Kw[TEXT("format")] : TEXT("json");
+	if (Format == TEXT("json"))
+	{
+		return FExecStatus::OK(LychSim::FRequestStats::Get().ToJson());
+	}
+	if (Format == TEXT("prometheus"))
+	{
+		return FExecStatus::OK(LychSim::FRequestStats::Get().ToPrometheus());
+	}
+	return FExecStatus::Error(FString::Printf(TEXT("Invalid format %s, expect json or prometheus"), *Format));
+}
+
+FExecStatus FPluginHandler::ResetRequestStats(const TArray<FString>& Args)
+{
+	LychSim::FRequestStats::Get().Reset();
+	return FExecStatus::OK();
+}
+
+FExecStatus FPluginHandler::SetTrace(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	if (Pos.Num() != 1 || (Pos[0] != TEXT("on") && Pos[0] != TEXT("off")))
+	{
+		return FExecStatus::Error(TEXT("Expect on or off"));
+	}
+	if (Pos[0] == TEXT("on"))
+	{
+		LychSim::FTrace::Enable();
+	}
+	else
+	{
+		LychSim::FTrace::Disable();
+	}
+	return FExecStatus::OK();
+}
+
+FExecStatus FPluginHandler::GetTrace(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	FString Trace = LychSim::FTrace::ToChromeTrace();
+	if (Pos.Num() == 0)
+	{
+		return FExecStatus::OK(MoveTemp(Trace));
+	}
+	if (!FFileHelper::SaveStringToFile(Trace, *Pos[0], FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Can not write the trace to %s"), *Pos[0]));
+	}
+	return FExecStatus::OK(Pos[0]);
+}
+
+FExecStatus FPluginHandler::SetRequestLog(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	LychSim::FRequestLog& RequestLog = LychSim::FRequestLog::Get();
+	LychSim::ERequestLogVerbosity Verbosity = RequestLog.GetVerbosity();
+	if (Pos.Num() > 0 && !LychSim::ParseRequestLogVerbosity(Pos[0], Verbosity))
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid verbosity %s, expect off, errors, summary or full"), *Pos[0]));
+	}
+	float SampleRate = RequestLog.GetSampleRate();
+	if (const FString* Rate = Kw.Find(TEXT("rate")))
+	{
+		SampleRate = FCString::Atof(**Rate);
+		if (!Rate->IsNumeric() || SampleRate < 0.0f || SampleRate > 1.0f)
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Invalid rate %s, expect a number from 0 to 1"), **Rate));
+		}
+	}
+	const FString Path = Kw.Contains(TEXT("path")) ? Kw[TEXT("path")] : RequestLog.GetPath();
+	RequestLog.Configure(Verbosity, SampleRate, Path);
+	return FExecStatus::OK();
+}
+
+FExecStatus FPluginHandler::GetRequestLog(const TArray<FString>& Args)
+{
+	LychSim::FRequestLog& RequestLog = LychSim::FRequestLog::Get();
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("verbosity"), LychSim::GetRequestLogVerbosityName(RequestLog.GetVerbosity()));
+	Writer->WriteValue(TEXT("rate"), RequestLog.GetSampleRate());
+	Writer->WriteValue(TEXT("path"), RequestLog.GetPath());
+	Writer->WriteValue(TEXT("logged"), (int64)RequestLog.GetNumLogged());
+	Writer->WriteValue(TEXT("dropped"), (int64)RequestLog.GetNumDropped());
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
+FExecStatus FPluginHandler::SetRecord(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags)
+{
+	LychSim::FRequestRecorder& Recorder = LychSim::FRequestRecorder::Get();
+	if (Pos.Num() == 2 && Pos[0] == TEXT("start"))
+	{
+		if (!Recorder.Start(Pos[1]))
+		{
+			return FExecStatus::Error(FString::Printf(TEXT("Can not open %s"), *Pos[1]));
+		}
+		return FExecStatus::OK();
+	}
+	if (Pos.Num() == 1 && Pos[0] == TEXT("stop"))
+	{
+		Recorder.Stop();
+		return FExecStatus::OK();
+	}
+	return FExecStatus::Error(TEXT("Expect start <path> or stop"));
+}
+
+FExecStatus FPluginHandler::GetRecord(const TArray<FString>& Args)
+{
+	LychSim::FRequestRecorder& Recorder = LychSim::FRequestRecorder::Get();
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("recording"), Recorder.IsRecording());
+	Writer->WriteValue(TEXT("path"), Recorder.GetPath());
+	Writer->WriteValue(TEXT("requests"), Recorder.GetNumRecorded());
+	Writer->WriteValue(TEXT("bytes"), Recorder.GetBytesWritten());
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FExecStatus::OK(MoveTemp(Out));
+}
+
 void FPluginHandler::RegisterCommands()
 {
 	FDispatcherDelegate Cmd;
@@ -131,4 +262,52 @@ void FPluginHandler::RegisterCommands()
 		FDispatcherDelegate::CreateRaw(this, &FPluginHandler::GetLevelName),
 		"Get current level name"
 	);
+
+	CommandDispatcher->BindCommandUE(
+		"vget /unrealcv/stats",
+		FDispatcherDelegateUE::CreateRaw(this, &FPluginHandler::GetRequestStats),
+		"Get latency histograms of queue wait, dispatch, handler, serialization and send, and request/reply sizes per command, -format=json|prometheus"
+	);
+
+	CommandDispatcher->BindCommand(
+		"vset /unrealcv/stats/reset",
+		FDispatcherDelegate::CreateRaw(this, &FPluginHandler::ResetRequestStats),
+		"Clear the request stats"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"vset /unrealcv/trace",
+		FDispatcherDelegateUE::CreateRaw(this, &FPluginHandler::SetTrace),
+		"Start (on) or stop (off) recording spans of requests, captures, readbacks, encoding and sends"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"vget /unrealcv/trace",
+		FDispatcherDelegateUE::CreateRaw(this, &FPluginHandler::GetTrace),
+		"Get the recorded spans as Chrome trace JSON, or save them to the given path"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"vset /unrealcv/request_log",
+		FDispatcherDelegateUE::CreateRaw(this, &FPluginHandler::SetRequestLog),
+		"Set the structured request log, off|errors|summary|full -rate=<share of ok requests> -path=<jsonl file>"
+	);
+
+	CommandDispatcher->BindCommand(
+		"vget /unrealcv/request_log",
+		FDispatcherDelegate::CreateRaw(this, &FPluginHandler::GetRequestLog),
+		"Get the verbosity, sample rate and path of the request log, and the number of logged and dropped records"
+	);
+
+	CommandDispatcher->BindCommandUE(
+		"vset /unrealcv/record",
+		FDispatcherDelegateUE::CreateRaw(this, &FPluginHandler::SetRecord),
+		"Record the requests, reply sizes and latencies to a binary log for lychsim.tools.replay, start <path> or stop"
+	);
+
+	CommandDispatcher->BindCommand(
+		"vget /unrealcv/record",
+		FDispatcherDelegate::CreateRaw(this, &FPluginHandler::GetRecord),
+		"Get whether requests are recorded, the path and the number of recorded requests and bytes"
+	);
 }
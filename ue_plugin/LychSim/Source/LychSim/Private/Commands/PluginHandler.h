@@ -20,4 +20,28 @@ public:
 	FExecStatus GetSceneName(const TArray<FString>& Args);
 
 	FExecStatus GetLevelName(const TArray<FString>& Args);
+
+	/** vget /unrealcv/stats */
+	FExecStatus GetRequestStats(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	/** vset /unrealcv/stats/reset */
+	FExecStatus ResetRequestStats(const TArray<FString>& Args);
+
+	/** vset /unrealcv/trace on|off */
+	FExecStatus SetTrace(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	/** vget /unrealcv/trace [path] */
+	FExecStatus GetTrace(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	/** vset /unrealcv/request_log off|errors|summary|full -rate= -path= */
+	FExecStatus SetRequestLog(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	/** vget /unrealcv/request_log */
+	FExecStatus GetRequestLog(const TArray<FString>& Args);
+
+	/** vset /unrealcv/record start <path> | stop */
+	FExecStatus SetRecord(const TArray<FString>& Pos, const TMap<FString,FString>& Kw, const TSet<FString>& Flags);
+
+	/** vget /unrealcv/record */
+	FExecStatus GetRecord(const TArray<FString>& Args);
 };
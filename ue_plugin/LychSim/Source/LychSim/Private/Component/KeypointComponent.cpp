@@ -6,6 +6,12 @@
 #include "Runtime/Core/Public/Misc/Paths.h"
 #include "Runtime/Json/Public/Serialization/JsonReader.h"
 #include "Runtime/Json/Public/Serialization/JsonSerializer.h"
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Engine/Classes/Components/StaticMeshComponent.h"
+#include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "Runtime/Engine/Public/StaticMeshResources.h"
+#include "Utils/PointKdTree.h"
+#include "Utils/StaticMeshCache.h"
 #include "VisionBPLib.h"
 #include "UnrealcvLog.h"
 
@@ -33,6 +39,52 @@ void UKeypointComponent::BeginPlay()
 	}
 }
 
+void UKeypointComponent::ReloadKeypoints()
+{
+	this->Keypoints = LoadKeypointFromJson();
+
+	if (bMatchNearestVertex)
+	{
+		MatchNearestVertex();
+	}
+}
+
+namespace
+{
+	/** Static meshes are shared by many instances, so their indices are shared too. Game thread only. */
+	LychSim::TStaticMeshCache<TSharedPtr<const LychSim::FPointKdTree>> StaticMeshVertexIndices;
+}
+
+TSharedPtr<const LychSim::FPointKdTree> UKeypointComponent::GetVertexIndex(UMeshComponent* MeshComponent)
+{
+	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(MeshComponent);
+	UStaticMesh* StaticMesh = StaticMeshComponent ? StaticMeshComponent->GetStaticMesh() : nullptr;
+	if (StaticMesh)
+	{
+		// Looked up every time, so that a component picks up a new or rebuilt mesh
+		const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+		if (!RenderData)
+		{
+			return nullptr;
+		}
+		TSharedPtr<const LychSim::FPointKdTree>& Index = StaticMeshVertexIndices.FindOrAdd(StaticMesh, RenderData);
+		if (!Index.IsValid())
+		{
+			Index = MakeShared<LychSim::FPointKdTree>(UVisionBPLib::StaticMeshComponentGetVertexArray(StaticMeshComponent));
+		}
+		return Index;
+	}
+
+	if (TSharedPtr<const LychSim::FPointKdTree>* Found = VertexIndices.Find(MeshComponent))
+	{
+		return *Found;
+	}
+	// Skinned meshes are indexed in the pose they have when first matched
+	TSharedPtr<const LychSim::FPointKdTree> Index = MakeShared<LychSim::FPointKdTree>(UVisionBPLib::GetVertexArrayFromMeshComponent(MeshComponent));
+	VertexIndices.Add(MeshComponent, Index);
+	return Index;
+}
+
 // Support skeletal mesh and actor with many MeshComponents
 void UKeypointComponent::MatchNearestVertex()
 {
@@ -41,42 +93,50 @@ void UKeypointComponent::MatchNearestVertex()
 	{
 		return;
 	}
-	TArray<UActorComponent*> MeshComponents = OwnerActor->K2_GetComponentsByClass(UMeshComponent::StaticClass());
+	TArray<UMeshComponent*> MeshComponents;
+	OwnerActor->GetComponents<UMeshComponent>(MeshComponents);
 	MatchedVertexs.Empty();
-	
+
 	// Note: Match the keypoint in the actor space, not in the component local space
 	// Note: Match in the component space is also doable, but has less value
-	// TODO: Speedup this slow implementation
-	for (FKeypoint& Keypoint : Keypoints)
+	// A vertex is in the actor space at ComponentRotation * Vertex + ComponentLocation - ActorLocation,
+	// so the keypoint is moved into the mesh space instead, which keeps the distances and the index reusable
+	struct FMeshQuery
+	{
+		UMeshComponent* MeshComponent;
+		TSharedPtr<const LychSim::FPointKdTree> Index;
+		FQuat InverseRotation;
+		FVector Origin;
+	};
+	TArray<FMeshQuery> Queries;
+	for (UMeshComponent* MeshComponent : MeshComponents)
+	{
+		TSharedPtr<const LychSim::FPointKdTree> Index = GetVertexIndex(MeshComponent);
+		if (!Index.IsValid() || Index->Num() == 0) continue;
+		Queries.Add({ MeshComponent, Index,
+			MeshComponent->GetComponentQuat().Inverse(),
+			MeshComponent->GetComponentLocation() - OwnerActor->GetActorLocation() });
+	}
+
+	MatchedVertexs.SetNum(Keypoints.Num());
+	ParallelFor(Keypoints.Num(), [&](int32 KeypointIndex)
 	{
+		const FKeypoint& Keypoint = Keypoints[KeypointIndex];
 		FMatchedVertexInfo VertexInfo;
-		for (UActorComponent* Component : MeshComponents)
+		for (const FMeshQuery& Query : Queries)
 		{
-			UMeshComponent* MeshComponent = Cast<UMeshComponent>(Component);
-			TArray<FVector> VertexArray = UVisionBPLib::GetVertexArrayFromMeshComponent(MeshComponent);
-
-			double MinDistance = 10e10;
-			int VertexIndex = -1;
-			for (int i = 0; i < VertexArray.Num(); i++)
-			{
-				FVector Vertex = VertexArray[i];
-				FVector VertexWorld = MeshComponent->GetComponentRotation().RotateVector(Vertex) + MeshComponent->GetComponentLocation() - OwnerActor->GetActorLocation();
-				// Change from component space to world space
-				double Distance = FVector::Distance(VertexWorld, Keypoint.Location);
-				if (Distance < MinDistance)
-				{
-					MinDistance = Distance;
-					VertexIndex = i;
-				}
-			}
-			if (MinDistance < VertexInfo.Distance)
+			const FVector MeshSpaceLocation = Query.InverseRotation.RotateVector(Keypoint.Location - Query.Origin);
+			double DistanceSquared = 0.0;
+			const int32 VertexIndex = Query.Index->FindNearest(MeshSpaceLocation, DistanceSquared);
+			const double Distance = FMath::Sqrt(DistanceSquared);
+			if (VertexIndex != INDEX_NONE && Distance < VertexInfo.Distance)
 			{
-				VertexInfo = FMatchedVertexInfo(MeshComponent, OwnerActor, VertexIndex, 
-					MinDistance, Keypoint.Name);
+				VertexInfo = FMatchedVertexInfo(Query.MeshComponent, OwnerActor, VertexIndex,
+					Distance, Keypoint.Name);
 			}
 		}
-		MatchedVertexs.Add(VertexInfo);
-	}
+		MatchedVertexs[KeypointIndex] = VertexInfo;
+	});
 }
 
 TArray<FKeypoint> UKeypointComponent::LoadKeypointFromJson()
@@ -205,7 +265,7 @@ void UKeypointComponent::GetKeypoints(
 		for (FKeypoint& Keypoint : Keypoints)
 		{
 			KeypointNames.Add(Keypoint.Name);
-			if (bWorldSpace == false)
+			if (bWorldSpace)
 			{
 				FVector WorldPointLocation = this->GetComponentRotation().RotateVector(Keypoint.Location) + this->GetComponentLocation(); // in world space
 				Locations.Add(WorldPointLocation);
@@ -219,6 +279,8 @@ void UKeypointComponent::GetKeypoints(
 	
 	if (bMatchNearestVertex)
 	{
+		// Read each mesh once, not once per keypoint
+		TMap<UMeshComponent*, TArray<FVector>> VertexArrays;
 		for (FMatchedVertexInfo& VertexInfo : this->MatchedVertexs)
 		{
 			if (!IsValid(VertexInfo.Actor) || !IsValid(VertexInfo.MeshComponent))
@@ -227,7 +289,12 @@ void UKeypointComponent::GetKeypoints(
 			}
 
 			UMeshComponent* MeshComponent = VertexInfo.MeshComponent;
-			TArray<FVector> VertexArray = UVisionBPLib::GetVertexArrayFromMeshComponent(MeshComponent);
+			TArray<FVector>* CachedArray = VertexArrays.Find(MeshComponent);
+			if (!CachedArray)
+			{
+				CachedArray = &VertexArrays.Add(MeshComponent, UVisionBPLib::GetVertexArrayFromMeshComponent(MeshComponent));
+			}
+			const TArray<FVector>& VertexArray = *CachedArray;
 			if (VertexInfo.VertexIndex < 0 || VertexInfo.VertexIndex >= VertexArray.Num())
 			{
 				UE_LOG(LogUnrealCV, Warning, TEXT("Unexpected error in the MatchedVertexInfo"));
@@ -10,6 +10,7 @@
 #include "VisionBPLib.h"
 #include "UnrealcvServer.h"
 #include "PlayerViewMode.h"
+#include "Utils/HeadlessMode.h"
 #include "UnrealcvLog.h"
 
 AUnrealcvWorldController::AUnrealcvWorldController(const FObjectInitializer& ObjectInitializer)
@@ -74,6 +75,11 @@ void AUnrealcvWorldController::InitWorld()
 
 	this->AttachPawnSensor();
 
+	if (UnrealcvServer.Config.Headless)
+	{
+		LychSim::FHeadlessMode::Get().Enable(GetWorld());
+	}
+
 	// TODO: remove legacy code
 	// Update camera FOV
 
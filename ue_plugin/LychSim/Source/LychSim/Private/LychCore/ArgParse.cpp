@@ -0,0 +1,126 @@
+#include "LychCore/ArgParse.h"
+
+namespace
+{
+	bool IsSpaceChar(char C)
+	{
+		return C == ' ' || C == '\t' || C == '\n' || C == '\r' || C == '\v' || C == '\f';
+	}
+
+	bool IsDigitChar(char C)
+	{
+		return C >= '0' && C <= '9';
+	}
+
+	std::string_view TrimSpaces(std::string_view Str)
+	{
+		while (!Str.empty() && IsSpaceChar(Str.front()))
+		{
+			Str.remove_prefix(1);
+		}
+		while (!Str.empty() && IsSpaceChar(Str.back()))
+		{
+			Str.remove_suffix(1);
+		}
+		return Str;
+	}
+}
+
+const std::string* LychSim::Core::FParsedArgs::Find(std::string_view Key) const
+{
+	for (auto It = Kwargs.rbegin(); It != Kwargs.rend(); ++It)
+	{
+		if (It->first == Key)
+		{
+			return &It->second;
+		}
+	}
+	return nullptr;
+}
+
+bool LychSim::Core::FParsedArgs::HasFlag(std::string_view Flag) const
+{
+	for (const std::string& Item : Flags)
+	{
+		if (Item == Flag)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void LychSim::Core::FParsedArgs::Reset()
+{
+	Positionals.clear();
+	Kwargs.clear();
+	Flags.clear();
+}
+
+bool LychSim::Core::NextToken(std::string_view& Str, std::string& OutToken)
+{
+	OutToken.clear();
+	size_t Pos = 0;
+	while (Pos < Str.size() && IsSpaceChar(Str[Pos]))
+	{
+		Pos++;
+	}
+
+	if (Pos < Str.size() && Str[Pos] == '"')
+	{
+		const size_t Begin = Pos + 1;
+		size_t End = Str.find('"', Begin);
+		if (End == std::string_view::npos)
+		{
+			End = Str.size();
+		}
+		OutToken.assign(Str.substr(Begin, End - Begin));
+		Pos = End < Str.size() ? End + 1 : End;
+	}
+	else
+	{
+		const size_t Begin = Pos;
+		bool bInQuote = false;
+		while (Pos < Str.size() && (bInQuote || !IsSpaceChar(Str[Pos])))
+		{
+			if (Str[Pos] == '"')
+			{
+				bInQuote = !bInQuote;
+			}
+			Pos++;
+		}
+		OutToken.assign(Str.substr(Begin, Pos - Begin));
+	}
+	Str.remove_prefix(Pos);
+	return !OutToken.empty();
+}
+
+void LychSim::Core::ParseArgs(std::string_view Tail, FParsedArgs& Out)
+{
+	Out.Reset();
+	std::string Token;
+	while (NextToken(Tail, Token))
+	{
+		// -.5 -0.5 -1
+		if (Token[0] != '-' || Token.size() < 2 || IsDigitChar(Token[1]) || Token[1] == '.')
+		{
+			Out.Positionals.push_back(std::move(Token));
+			continue;
+		}
+
+		const std::string_view Switch = std::string_view(Token).substr(1);
+		const size_t Equal = Switch.find('=');
+		if (Equal != std::string_view::npos)
+		{
+			Out.Kwargs.emplace_back(std::string(TrimSpaces(Switch.substr(0, Equal))), std::string(TrimSpaces(Switch.substr(Equal + 1))));
+		}
+		else
+		{
+			const std::string_view Flag = TrimSpaces(Switch);
+			if (!Flag.empty())
+			{
+				Out.Flags.emplace_back(Flag);
+			}
+		}
+	}
+}
@@ -0,0 +1,289 @@
+#include "LychCore/CommandRouter.h"
+
+namespace
+{
+	/** \s of the regular expressions the templates used to be */
+	bool IsRouteSpace(char C)
+	{
+		return C == ' ' || C == '\t' || C == '\n' || C == '\r' || C == '\v' || C == '\f';
+	}
+
+	bool IsRouteDigit(char C)
+	{
+		return C >= '0' && C <= '9';
+	}
+
+	/** [-+]?\d*[.]?\d+ */
+	bool IsFloatText(std::string_view Text)
+	{
+		size_t Pos = 0;
+		if (Pos < Text.size() && (Text[Pos] == '-' || Text[Pos] == '+'))
+		{
+			Pos++;
+		}
+		const size_t IntBegin = Pos;
+		while (Pos < Text.size() && IsRouteDigit(Text[Pos]))
+		{
+			Pos++;
+		}
+		if (Pos < Text.size() && Text[Pos] == '.')
+		{
+			Pos++;
+			const size_t FracBegin = Pos;
+			while (Pos < Text.size() && IsRouteDigit(Text[Pos]))
+			{
+				Pos++;
+			}
+			return Pos == Text.size() && Pos > FracBegin;
+		}
+		return Pos == Text.size() && Pos > IntBegin;
+	}
+
+	/** Only spaces are left, the end may be a line break */
+	bool IsRouteEnd(std::string_view Request, size_t& Pos)
+	{
+		while (Pos < Request.size() && Request[Pos] == ' ')
+		{
+			Pos++;
+		}
+		const std::string_view Rest = Request.substr(Pos);
+		return Rest.empty() || Rest == "\n" || Rest == "\r\n";
+	}
+
+	/** The first word of a request, up to whitespace */
+	std::string_view FirstWord(std::string_view Request)
+	{
+		size_t End = 0;
+		while (End < Request.size() && !IsRouteSpace(Request[End]))
+		{
+			End++;
+		}
+		return Request.substr(0, End);
+	}
+}
+
+int32_t LychSim::Core::FCommandRouter::Add(std::string_view Template, bool bTail, std::string* OutError)
+{
+	auto Fail = [OutError](std::string Message)
+	{
+		if (OutError)
+		{
+			*OutError = std::move(Message);
+		}
+		return -1;
+	};
+
+	FRoute Route;
+	Route.bTail = bTail;
+	bool bInType = false;
+	std::string Text;
+	for (size_t Index = 0; Index < Template.size(); Index++)
+	{
+		const char C = Template[Index];
+		if (!bInType)
+		{
+			if (C == '[')
+			{
+				if (!Text.empty())
+				{
+					Route.Segments.push_back({ ESegment::Literal, std::move(Text) });
+					Text.clear();
+				}
+				bInType = true;
+			}
+			else if (C == ']')
+			{
+				return Fail("Unexpected ] at " + std::to_string(Index));
+			}
+			else
+			{
+				Text += C;
+			}
+			continue;
+		}
+
+		if (C == '[')
+		{
+			return Fail("Unexpected [ at " + std::to_string(Index));
+		}
+		if (C != ']')
+		{
+			Text += C;
+			continue;
+		}
+		bInType = false;
+		ESegment Type;
+		if (Text == "str") Type = ESegment::Str;
+		else if (Text == "uint") Type = ESegment::UInt;
+		else if (Text == "float") Type = ESegment::Float;
+		else if (Text == "str+") Type = ESegment::StrTail;
+		else return Fail("Unknown type specifier [" + Text + "]");
+		Route.Segments.push_back({ Type, std::string() });
+		Text.clear();
+	}
+	if (bInType)
+	{
+		return Fail("Not all [ are closed by ]");
+	}
+	if (!Text.empty())
+	{
+		Route.Segments.push_back({ ESegment::Literal, std::move(Text) });
+	}
+
+	const int32_t Id = (int32_t)Routes.size();
+	// The first word is known if the leading text has a space, or is all of the template
+	std::string_view Word;
+	if (!Route.Segments.empty() && Route.Segments[0].Type == ESegment::Literal)
+	{
+		const std::string& Leading = Route.Segments[0].Literal;
+		const size_t Space = Leading.find(' ');
+		if (Space != std::string::npos)
+		{
+			Word = std::string_view(Leading).substr(0, Space);
+		}
+		else if (Route.Segments.size() == 1)
+		{
+			Word = Leading;
+		}
+	}
+	std::vector<int32_t>& Bucket = Word.empty() ? WildcardRoutes : RoutesByWord[std::string(Word)];
+	Bucket.insert(Bucket.begin(), Id);
+	Routes.push_back(std::move(Route));
+	return Id;
+}
+
+int32_t LychSim::Core::FCommandRouter::Match(std::string_view Request, size_t& OutArgsBegin) const
+{
+	size_t Start = 0;
+	while (Start < Request.size() && Request[Start] == ' ')
+	{
+		Start++;
+	}
+
+	static const std::vector<int32_t> NoRoutes;
+	const auto Found = RoutesByWord.find(std::string(FirstWord(Request.substr(Start))));
+	const std::vector<int32_t>& Bucket = Found != RoutesByWord.end() ? Found->second : NoRoutes;
+
+	// Both lists are newest first, merge them to keep the newest match
+	size_t BucketIndex = 0, WildcardIndex = 0;
+	while (BucketIndex < Bucket.size() || WildcardIndex < WildcardRoutes.size())
+	{
+		int32_t Id;
+		if (WildcardIndex >= WildcardRoutes.size() || (BucketIndex < Bucket.size() && Bucket[BucketIndex] > WildcardRoutes[WildcardIndex]))
+		{
+			Id = Bucket[BucketIndex++];
+		}
+		else
+		{
+			Id = WildcardRoutes[WildcardIndex++];
+		}
+
+		const FRoute& Route = Routes[Id];
+		// Most templates differ in their leading text, compare it before anything else
+		if (!Route.Segments.empty() && Route.Segments[0].Type == ESegment::Literal
+			&& Request.compare(Start, Route.Segments[0].Literal.size(), Route.Segments[0].Literal) != 0)
+		{
+			continue;
+		}
+		OutArgsBegin = std::string_view::npos;
+		if (MatchFrom(Route, 0, Request, Start, OutArgsBegin))
+		{
+			return Id;
+		}
+	}
+	return -1;
+}
+
+bool LychSim::Core::FCommandRouter::MatchFrom(const FRoute& Route, size_t Index, std::string_view Request, size_t Pos, size_t& OutArgsBegin) const
+{
+	if (Index == Route.Segments.size())
+	{
+		return MatchEnd(Route, Request, Pos, OutArgsBegin);
+	}
+
+	const FSegment& Segment = Route.Segments[Index];
+	if (Segment.Type == ESegment::Literal)
+	{
+		return Request.compare(Pos, Segment.Literal.size(), Segment.Literal) == 0
+			&& MatchFrom(Route, Index + 1, Request, Pos + Segment.Literal.size(), OutArgsBegin);
+	}
+
+	// The arguments start at the first typed segment, which is always at the same position
+	if (OutArgsBegin == std::string_view::npos)
+	{
+		OutArgsBegin = Pos;
+	}
+
+	size_t Max = Pos;
+	while (Max < Request.size())
+	{
+		const char C = Request[Max];
+		const bool bAllowed =
+			Segment.Type == ESegment::Str ? C != ' ' :
+			Segment.Type == ESegment::UInt ? IsRouteDigit(C) :
+			Segment.Type == ESegment::Float ? IsRouteDigit(C) || C == '.' || C == '-' || C == '+' :
+			true;
+		if (!bAllowed)
+		{
+			break;
+		}
+		Max++;
+	}
+
+	// Longest first, as the greedy regular expressions did
+	for (size_t End = Max + 1; End-- > Pos;)
+	{
+		const std::string_view Text = Request.substr(Pos, End - Pos);
+		if (Segment.Type == ESegment::Float && !IsFloatText(Text))
+		{
+			continue;
+		}
+		if (Segment.Type == ESegment::StrTail && (Text.empty() || IsRouteSpace(Text.front()) || IsRouteSpace(Text.back())))
+		{
+			continue;
+		}
+		if (MatchFrom(Route, Index + 1, Request, End, OutArgsBegin))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LychSim::Core::FCommandRouter::MatchEnd(const FRoute& Route, std::string_view Request, size_t Pos, size_t& OutArgsBegin) const
+{
+	if (Route.bTail && Pos < Request.size() && IsRouteSpace(Request[Pos]))
+	{
+		// Whitespace, then words up to the last one, then spaces
+		size_t TailBegin = Pos;
+		while (TailBegin < Request.size() && IsRouteSpace(Request[TailBegin]))
+		{
+			TailBegin++;
+		}
+		size_t TailEnd = Request.size();
+		while (TailEnd > TailBegin && IsRouteSpace(Request[TailEnd - 1]))
+		{
+			TailEnd--;
+		}
+		size_t End = TailEnd;
+		if (TailEnd > TailBegin && IsRouteEnd(Request, End))
+		{
+			if (OutArgsBegin == std::string_view::npos)
+			{
+				OutArgsBegin = TailBegin;
+			}
+			return true;
+		}
+	}
+
+	size_t End = Pos;
+	if (!IsRouteEnd(Request, End))
+	{
+		return false;
+	}
+	if (OutArgsBegin == std::string_view::npos)
+	{
+		OutArgsBegin = End;
+	}
+	return true;
+}
@@ -0,0 +1,90 @@
+#include "LychCore/Framing.h"
+
+#include <cstring>
+
+namespace
+{
+	void WriteUint32LE(uint8_t* Dest, uint32_t Value)
+	{
+		Dest[0] = (uint8_t)(Value);
+		Dest[1] = (uint8_t)(Value >> 8);
+		Dest[2] = (uint8_t)(Value >> 16);
+		Dest[3] = (uint8_t)(Value >> 24);
+	}
+
+	uint32_t ReadUint32LE(const uint8_t* Src)
+	{
+		return (uint32_t)Src[0] | ((uint32_t)Src[1] << 8) | ((uint32_t)Src[2] << 16) | ((uint32_t)Src[3] << 24);
+	}
+}
+
+const char* LychSim::Core::GetFrameErrorName(EFrameError Error)
+{
+	switch (Error)
+	{
+	case EFrameError::None: return "none";
+	case EFrameError::BadMagic: return "bad magic";
+	case EFrameError::EmptyPayload: return "empty payload";
+	}
+	return "unknown";
+}
+
+void LychSim::Core::WriteFrameHeader(uint8_t* Dest, uint32_t PayloadSize)
+{
+	WriteUint32LE(Dest, FrameMagic);
+	WriteUint32LE(Dest + 4, PayloadSize);
+}
+
+LychSim::Core::EFrameError LychSim::Core::ReadFrameHeader(const uint8_t* Src, uint32_t& OutPayloadSize)
+{
+	if (ReadUint32LE(Src) != FrameMagic)
+	{
+		return EFrameError::BadMagic;
+	}
+	OutPayloadSize = ReadUint32LE(Src + 4);
+	return OutPayloadSize == 0 ? EFrameError::EmptyPayload : EFrameError::None;
+}
+
+void LychSim::Core::AppendFrame(std::vector<uint8_t>& Out, const void* Payload, size_t Size)
+{
+	const size_t Start = Out.size();
+	Out.resize(Start + FrameHeaderSize + Size);
+	WriteFrameHeader(Out.data() + Start, (uint32_t)Size);
+	if (Size > 0)
+	{
+		std::memcpy(Out.data() + Start + FrameHeaderSize, Payload, Size);
+	}
+}
+
+void LychSim::Core::FFrameReader::Append(const uint8_t* Data, size_t Size)
+{
+	// Drop the returned frames before growing, so the buffer stays about as large as one frame
+	if (Offset > 0 && Offset * 2 >= Buffer.size())
+	{
+		Buffer.erase(Buffer.begin(), Buffer.begin() + (std::ptrdiff_t)Offset);
+		Offset = 0;
+	}
+	Buffer.insert(Buffer.end(), Data, Data + Size);
+}
+
+bool LychSim::Core::FFrameReader::Next(const uint8_t*& OutPayload, uint32_t& OutSize)
+{
+	if (Error != EFrameError::None || Buffer.size() - Offset < FrameHeaderSize)
+	{
+		return false;
+	}
+	uint32_t PayloadSize = 0;
+	Error = ReadFrameHeader(Buffer.data() + Offset, PayloadSize);
+	if (Error != EFrameError::None)
+	{
+		return false;
+	}
+	if (Buffer.size() - Offset - FrameHeaderSize < PayloadSize)
+	{
+		return false;
+	}
+	OutPayload = Buffer.data() + Offset + FrameHeaderSize;
+	OutSize = PayloadSize;
+	Offset += FrameHeaderSize + PayloadSize;
+	return true;
+}
@@ -0,0 +1,51 @@
+#include "LychCore/Npy.h"
+
+#include <cstring>
+#include "libs/cnpy.h"
+
+namespace
+{
+	std::vector<int> ImageShape(int Width, int Height, int Channel)
+	{
+		std::vector<int> Shape = { Height, Width };
+		if (Channel != 1)
+		{
+			Shape.push_back(Channel);
+		}
+		return Shape;
+	}
+
+	template<typename T>
+	void AppendNpyImpl(std::vector<uint8_t>& Out, const T* Data, int Width, int Height, int Channel)
+	{
+		const std::vector<char> Header = cnpy::create_npy_header(Data, ImageShape(Width, Height, Channel));
+		const size_t NumBytes = (size_t)Width * Height * Channel * sizeof(T);
+		const size_t Start = Out.size();
+		Out.resize(Start + Header.size() + NumBytes);
+		std::memcpy(Out.data() + Start, Header.data(), Header.size());
+		if (NumBytes > 0)
+		{
+			std::memcpy(Out.data() + Start + Header.size(), Data, NumBytes);
+		}
+	}
+}
+
+std::vector<char> LychSim::Core::MakeNpyHeader(const float* TypeTag, int Width, int Height, int Channel)
+{
+	return cnpy::create_npy_header(TypeTag, ImageShape(Width, Height, Channel));
+}
+
+std::vector<char> LychSim::Core::MakeNpyHeader(const uint8_t* TypeTag, int Width, int Height, int Channel)
+{
+	return cnpy::create_npy_header(TypeTag, ImageShape(Width, Height, Channel));
+}
+
+void LychSim::Core::AppendNpy(std::vector<uint8_t>& Out, const float* Data, int Width, int Height, int Channel)
+{
+	AppendNpyImpl(Out, Data, Width, Height, Channel);
+}
+
+void LychSim::Core::AppendNpy(std::vector<uint8_t>& Out, const uint8_t* Data, int Width, int Height, int Channel)
+{
+	AppendNpyImpl(Out, Data, Width, Height, Channel);
+}
@@ -0,0 +1,120 @@
+#include "LychCore/RawTensor.h"
+
+#include <cstring>
+
+namespace
+{
+	template<typename T>
+	void WriteLE(uint8_t* Dest, T Value)
+	{
+		uint64_t Bits = 0;
+		std::memcpy(&Bits, &Value, sizeof(T));
+		for (size_t Index = 0; Index < sizeof(T); Index++)
+		{
+			Dest[Index] = (uint8_t)(Bits >> (8 * Index));
+		}
+	}
+
+	template<typename T>
+	T ReadLE(const uint8_t* Src)
+	{
+		uint64_t Bits = 0;
+		for (size_t Index = 0; Index < sizeof(T); Index++)
+		{
+			Bits |= (uint64_t)Src[Index] << (8 * Index);
+		}
+		T Value;
+		std::memcpy(&Value, &Bits, sizeof(T));
+		return Value;
+	}
+}
+
+size_t LychSim::Core::GetRawDTypeSize(ERawDType DType)
+{
+	switch (DType)
+	{
+	case ERawDType::UInt8: return 1;
+	case ERawDType::Float16: return 2;
+	case ERawDType::Float32: return 4;
+	}
+	return 0;
+}
+
+LychSim::Core::FRawTensorHeader LychSim::Core::MakeRawImageHeader(ERawDType DType, int Width, int Height, int Channel, const char* ChannelOrder)
+{
+	FRawTensorHeader Header;
+	Header.DType = DType;
+	Header.NumDims = Channel == 1 ? 2 : 3;
+	Header.Shape[0] = (uint32_t)Height;
+	Header.Shape[1] = (uint32_t)Width;
+	Header.Shape[2] = Channel == 1 ? 0 : (uint32_t)Channel;
+	Header.RowStride = (uint32_t)(Width * Channel * GetRawDTypeSize(DType));
+	for (size_t Index = 0; Index < sizeof(Header.ChannelOrder) && ChannelOrder[Index]; Index++)
+	{
+		Header.ChannelOrder[Index] = ChannelOrder[Index];
+	}
+	return Header;
+}
+
+size_t LychSim::Core::GetRawTensorSize(const FRawTensorHeader& Header)
+{
+	if (Header.NumDims == 0)
+	{
+		return 0;
+	}
+	size_t NumElements = 1;
+	for (uint8_t Dim = 0; Dim < Header.NumDims && Dim < 4; Dim++)
+	{
+		NumElements *= Header.Shape[Dim];
+	}
+	return NumElements * GetRawDTypeSize(Header.DType);
+}
+
+void LychSim::Core::WriteRawTensorHeader(uint8_t* Dest, const FRawTensorHeader& Header)
+{
+	std::memset(Dest, 0, RawTensorHeaderSize);
+	WriteLE<uint32_t>(Dest, RawTensorMagic);
+	WriteLE<uint16_t>(Dest + 4, RawTensorVersion);
+	WriteLE<uint16_t>(Dest + 6, (uint16_t)RawTensorHeaderSize);
+	Dest[8] = (uint8_t)Header.DType;
+	Dest[9] = Header.NumDims;
+	std::memcpy(Dest + 10, Header.ChannelOrder, sizeof(Header.ChannelOrder));
+	for (int Dim = 0; Dim < 4; Dim++)
+	{
+		WriteLE<uint32_t>(Dest + 16 + 4 * Dim, Header.Shape[Dim]);
+	}
+	WriteLE<uint32_t>(Dest + 32, Header.RowStride);
+	WriteLE<uint32_t>(Dest + 36, Header.TrailerSize);
+	WriteLE<uint64_t>(Dest + 40, Header.FrameId);
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		WriteLE<double>(Dest + 48 + 8 * Axis, Header.Location[Axis]);
+		WriteLE<double>(Dest + 72 + 8 * Axis, Header.Rotation[Axis]);
+	}
+	WriteLE<float>(Dest + 96, Header.Fov);
+}
+
+bool LychSim::Core::ReadRawTensorHeader(const uint8_t* Src, size_t Size, FRawTensorHeader& OutHeader)
+{
+	if (Size < RawTensorHeaderSize || ReadLE<uint32_t>(Src) != RawTensorMagic || ReadLE<uint16_t>(Src + 4) != RawTensorVersion)
+	{
+		return false;
+	}
+	OutHeader.DType = (ERawDType)Src[8];
+	OutHeader.NumDims = Src[9];
+	std::memcpy(OutHeader.ChannelOrder, Src + 10, sizeof(OutHeader.ChannelOrder));
+	for (int Dim = 0; Dim < 4; Dim++)
+	{
+		OutHeader.Shape[Dim] = ReadLE<uint32_t>(Src + 16 + 4 * Dim);
+	}
+	OutHeader.RowStride = ReadLE<uint32_t>(Src + 32);
+	OutHeader.TrailerSize = ReadLE<uint32_t>(Src + 36);
+	OutHeader.FrameId = ReadLE<uint64_t>(Src + 40);
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		OutHeader.Location[Axis] = ReadLE<double>(Src + 48 + 8 * Axis);
+		OutHeader.Rotation[Axis] = ReadLE<double>(Src + 72 + 8 * Axis);
+	}
+	OutHeader.Fov = ReadLE<float>(Src + 96);
+	return true;
+}
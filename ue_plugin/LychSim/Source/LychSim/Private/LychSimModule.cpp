@@ -5,6 +5,11 @@
 #include "Modules/ModuleManager.h"
 
 #include "UnrealcvServer.h"
+#include "Utils/FileWriter.h"
+#include "Utils/HeadlessMode.h"
+#include "Utils/Lockstep.h"
+#include "Utils/RequestLog.h"
+#include "Utils/RequestRecorder.h"
 #include "UnrealcvLog.h"
 
 DEFINE_LOG_CATEGORY(LogUnrealCV);
@@ -81,6 +86,33 @@ void FLychSimModule::StartupModule()
 		Server.Config.ExitOnFailure = OverrideExitOnFailure;
 	}
 
+	bool OverrideHeadless = Server.Config.Headless;
+	if (FParse::Bool(FCommandLine::Get(), TEXT("UnrealCVHeadless"), OverrideHeadless)) {
+		if (OverrideHeadless)
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("Overriding Headless to true"));
+		}
+		else
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("Overriding Headless to false"));
+		}
+		Server.Config.Headless = OverrideHeadless;
+	}
+
+	LychSim::ERequestLogVerbosity RequestLogVerbosity = LychSim::ERequestLogVerbosity::Errors;
+	if (!LychSim::ParseRequestLogVerbosity(Server.Config.RequestLogVerbosity, RequestLogVerbosity))
+	{
+		UE_LOG(LogUnrealCV, Warning, TEXT("Invalid RequestLogVerbosity %s, only errors are logged"), *Server.Config.RequestLogVerbosity);
+	}
+	LychSim::FRequestLog::Get().Configure(RequestLogVerbosity, Server.Config.RequestLogSampleRate, Server.Config.RequestLogPath);
+
+	FString RecordPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("UnrealCVRecord="), RecordPath))
+	{
+		UE_LOG(LogUnrealCV, Warning, TEXT("Recording the requests to %s"), *RecordPath);
+		LychSim::FRequestRecorder::Get().Start(RecordPath);
+	}
+
 	bool StartSuccess = Server.TcpServer->Start(Server.Config.Port);
 	if (!StartSuccess)
 	{
@@ -97,4 +129,10 @@ void FLychSimModule::StartupModule()
 
 void FLychSimModule::ShutdownModule()
 {
+	// Finish the queued files while the engine is still up
+	LychSim::FFileWriter::ReleaseShared();
+	LychSim::FLockstep::Get().Disable();
+	LychSim::FHeadlessMode::Get().Disable();
+	LychSim::FRequestLog::Get().Shutdown();
+	LychSim::FRequestRecorder::Get().Stop();
 }
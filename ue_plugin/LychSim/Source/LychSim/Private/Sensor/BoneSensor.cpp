@@ -21,7 +21,7 @@ TArray<FBoneInfo> FBoneSensor::GetBonesInfo()
 	const TArray<FBoneIndexType>& RequiredBones = Component->RequiredBones;
 	const USkeletalMesh* SkeletalMesh = Component->GetSkeletalMeshAsset();
 	const FTransformArrayA2& ComponentSpaceTransforms = Component->GetComponentSpaceTransforms();
-	const TArray<FTransform> BoneSpaceTransforms = Component->GetBoneSpaceTransforms();
+	const TArray<FTransform>& BoneSpaceTransforms = Component->GetBoneSpaceTransforms();
 	const FTransform& ComponentToWorld = Component->GetComponentToWorld();
 
 	bool bIncludeAll = false;
@@ -113,14 +113,34 @@ void UAnnotationCamSensor::GetAnnotationComponents(UWorld* World, TArray<TWeakOb
 	}
 }
 
-void UAnnotationCamSensor::CaptureSeg(TArray<FColor>& ImageData, int& Width, int& Height)
+void UAnnotationCamSensor::GetAnnotationComponents(UWorld* World, TArray<TWeakObjectPtr<UPrimitiveComponent> >& ComponentList, FBatchCaptureShared* Shared)
+{
+	if (!Shared)
+	{
+		GetAnnotationComponents(World, ComponentList);
+		return;
+	}
+	if (!Shared->bHasAnnotationComponents)
+	{
+		GetAnnotationComponents(World, Shared->AnnotationComponents);
+		Shared->bHasAnnotationComponents = true;
+	}
+	ComponentList = Shared->AnnotationComponents;
+}
+
+bool UAnnotationCamSensor::BeginCapture(FBatchCaptureShared* Shared)
 {
 	TArray<TWeakObjectPtr<UPrimitiveComponent> > ComponentList;
-	GetAnnotationComponents(this->GetWorld(), ComponentList);
+	GetAnnotationComponents(this->GetWorld(), ComponentList, Shared);
 
-	this->ShowOnlyComponents = ComponentList;
+	this->ShowOnlyComponents = MoveTemp(ComponentList);
 
-	Capture(ImageData, Width, Height);
+	return Super::BeginCapture(Shared);
+}
+
+void UAnnotationCamSensor::CaptureSeg(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region)
+{
+	Capture(ImageData, Width, Height, Region);
 
     if (ImageData.Num() != 0)
     {
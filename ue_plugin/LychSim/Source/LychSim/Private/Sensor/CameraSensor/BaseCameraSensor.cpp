@@ -3,18 +3,21 @@
 #include "Runtime/Engine/Classes/Components/StaticMeshComponent.h"
 #include "Runtime/Engine/Classes/Engine/CollisionProfile.h"
 #include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "Runtime/Core/Public/Math/PerspectiveMatrix.h"
+#include "Runtime/Core/Public/Math/OrthoMatrix.h"
+#include "Runtime/Core/Public/Math/InverseRotationMatrix.h"
 #include "TextureReader.h"
 #include "UnrealcvServer.h"
 #include "UnrealcvStats.h"
+#include "Utils/Trace.h"
 #include "UnrealcvLog.h"
 #include "ImageUtil.h"
+#include "TextureResource.h"
 
 DECLARE_CYCLE_STAT(TEXT("ReadBuffer"), STAT_ReadBuffer, STATGROUP_UnrealCV);
 DECLARE_CYCLE_STAT(TEXT("ReadBufferFast"), STAT_ReadBufferFast, STATGROUP_UnrealCV);
 // DECLARE_CYCLE_STAT(TEXT("ReadPixels"), STAT_ReadPixels, STATGROUP_UnrealCV);
 
-// FImageWorker UBaseCameraSensor::ImageWorker;
-
 UBaseCameraSensor::UBaseCameraSensor(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	// static ConstructorHelpers::FObjectFinder<UStaticMesh> EditorCameraMesh(TEXT("/Engine/EditorMeshes/MatineeCam_SM"));
@@ -111,14 +114,59 @@ bool UBaseCameraSensor::CheckTextureTarget()
 	return true;
 }
 
-void UBaseCameraSensor::Capture(TArray<FColor>& ImageData, int& Width, int& Height)
+void UBaseCameraSensor::Capture(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region)
 {
 	SCOPE_CYCLE_COUNTER(STAT_ReadBuffer);
 
-	if (!CheckTextureTarget()) return;
+	Width = Height = 0;
+	if (!BeginCapture()) return;
+
+	ReadTextureTarget(ImageData, Width, Height, Region);
+}
+
+bool UBaseCameraSensor::BeginCapture(FBatchCaptureShared* Shared)
+{
+	if (!CheckTextureTarget()) return false;
+	LYCHSIM_TRACE_SCOPE("CaptureScene");
 	this->CaptureScene();
+	return true;
+}
 
-	ReadTextureRenderTarget(TextureTarget, ImageData, Width, Height);
+bool UBaseCameraSensor::EnqueueRead(TArray<FColor>& ImageData, FIntPoint& Size, const FReadbackRegion* Region)
+{
+	if (!CheckTextureTarget()) return false;
+	return EnqueueReadTexture(TextureTarget, Region, ImageData, Size);
+}
+
+bool UBaseCameraSensor::EnqueueRead(TArray<FFloat16Color>& ImageData, FIntPoint& Size, const FReadbackRegion* Region)
+{
+	if (!CheckTextureTarget()) return false;
+	return EnqueueReadTexture(TextureTarget, Region, ImageData, Size);
+}
+
+bool UBaseCameraSensor::ReadTextureTarget(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region)
+{
+	LYCHSIM_TRACE_SCOPE("Readback");
+	const FIntPoint FilmSize(TextureTarget->SizeX, TextureTarget->SizeY);
+	if (Region && !Region->IsFullFrame(FilmSize))
+	{
+		return ResampleReadTexture(TextureTarget, *Region, ImageData, Width, Height);
+	}
+	return ReadTextureRenderTarget(TextureTarget, ImageData, Width, Height);
+}
+
+bool UBaseCameraSensor::ReadTextureTarget(TArray<FFloat16Color>& ImageData, int& Width, int& Height, const FReadbackRegion* Region)
+{
+	LYCHSIM_TRACE_SCOPE("Readback");
+	const FIntPoint FilmSize(TextureTarget->SizeX, TextureTarget->SizeY);
+	if (Region && !Region->IsFullFrame(FilmSize))
+	{
+		return ResampleReadTexture(TextureTarget, *Region, ImageData, Width, Height);
+	}
+	Width = FilmSize.X;
+	Height = FilmSize.Y;
+	TextureTarget->GameThread_GetRenderTargetResource()->ReadFloat16Pixels(ImageData);
+	return true;
 }
 
 void UBaseCameraSensor::SetPostProcessMaterial(UMaterial* PostProcessMaterial)
@@ -148,3 +196,39 @@ void UBaseCameraSensor::GetCameraView(float DeltaTime, FMinimalViewInfo& Desired
 	}
 
 }
+
+// Mirrors BuildProjectionMatrix in SceneCaptureRendering.cpp, so projected points match the captured pixels
+void UBaseCameraSensor::GetViewProjectionMatrix(FMatrix& ViewMatrix, FMatrix& ProjectionMatrix)
+{
+	const FVector ViewLocation = GetComponentLocation();
+	const FRotator ViewRotation = GetComponentRotation();
+	// Swap axis, UE is x forward, z up, the view space is z forward, y up
+	const FMatrix ViewRotationMatrix = FInverseRotationMatrix(ViewRotation) * FMatrix(
+		FPlane(0, 0, 1, 0),
+		FPlane(1, 0, 0, 0),
+		FPlane(0, 1, 0, 0),
+		FPlane(0, 0, 0, 1));
+	ViewMatrix = FTranslationMatrix(-ViewLocation) * ViewRotationMatrix;
+
+	const float Width = FMath::Max(FilmWidth, 1);
+	const float Height = FMath::Max(FilmHeight, 1);
+	const float XAxisMultiplier = 1.0f;
+	const float YAxisMultiplier = Width / Height;
+
+	if (ProjectionType == ECameraProjectionMode::Orthographic)
+	{
+		const float HalfOrthoWidth = OrthoWidth / 2.0f;
+		const float HalfOrthoHeight = OrthoWidth / 2.0f * XAxisMultiplier / YAxisMultiplier;
+		const float NearPlane = 0;
+		const float FarPlane = UE_FLOAT_HUGE_DISTANCE / 4.0f;
+		ProjectionMatrix = FReversedZOrthoMatrix(HalfOrthoWidth, HalfOrthoHeight,
+			1.0f / (FarPlane - NearPlane), -NearPlane);
+	}
+	else
+	{
+		const float HalfFOV = FMath::Max(0.001f, FOVAngle) * (float)PI / 360.0f;
+		const float NearClip = bOverride_CustomNearClippingPlane ? CustomNearClippingPlane : GNearClippingPlane;
+		ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFOV, HalfFOV,
+			XAxisMultiplier, YAxisMultiplier, NearClip, NearClip);
+	}
+}
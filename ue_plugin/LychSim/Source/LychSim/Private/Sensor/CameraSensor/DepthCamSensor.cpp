@@ -2,6 +2,7 @@
 #include "DepthCamSensor.h"
 #include "AnnotationCamSensor.h"
 #include "TextureResource.h"
+#include "Utils/Trace.h"
 #include "Runtime/Core/Public/Async/ParallelFor.h"
 
 UDepthCamSensor::UDepthCamSensor(const FObjectInitializer& ObjectInitializer) :
@@ -19,42 +20,47 @@ void UDepthCamSensor::InitTextureTarget(int filmWidth, int filmHeight)
  	TextureTarget->InitCustomFormat(filmWidth, filmHeight, EPixelFormat::PF_FloatRGBA, bUseLinearGamma);
 }
 
-void UDepthCamSensor::CaptureDepth(TArray<float>& DepthData, int& Width, int& Height)
+bool UDepthCamSensor::BeginCapture(FBatchCaptureShared* Shared)
 {
-	if (!bIgnoreTransparentObjects)
+	if (!CheckTextureTarget()) return false;
+	LYCHSIM_TRACE_SCOPE("CaptureScene");
+	if (bIgnoreTransparentObjects)
 	{
-		auto PrevMode = this->PrimitiveRenderMode;
-		FEngineShowFlags PrevFlags = this->ShowFlags;
-		TArray<TWeakObjectPtr<UPrimitiveComponent>> PrevShowOnly = this->ShowOnlyComponents;
+		this->CaptureScene();
+		return true;
+	}
 
-		TArray<TWeakObjectPtr<UPrimitiveComponent>> ComponentList;
-		UAnnotationCamSensor::GetAnnotationComponents(this->GetWorld(), ComponentList);
-		this->ShowOnlyComponents = ComponentList;
-		this->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
-		this->ShowFlags.SetMaterials(false); // This will make annotation component visible
+	// The settings are copied when the capture is sent, so they can be restored right after
+	auto PrevMode = this->PrimitiveRenderMode;
+	FEngineShowFlags PrevFlags = this->ShowFlags;
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> PrevShowOnly = this->ShowOnlyComponents;
 
-		if (CheckTextureTarget())
-		{
-			this->CaptureScene();
-			FlushRenderingCommands();
-		}
-		
-		this->ShowOnlyComponents = MoveTemp(PrevShowOnly);
-		this->PrimitiveRenderMode = PrevMode;
-		this->ShowFlags = PrevFlags;
-	}
-	else
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> ComponentList;
+	UAnnotationCamSensor::GetAnnotationComponents(this->GetWorld(), ComponentList, Shared);
+	this->ShowOnlyComponents = MoveTemp(ComponentList);
+	this->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
+	this->ShowFlags.SetMaterials(false); // This will make annotation component visible
+
+	this->CaptureScene();
+
+	this->ShowOnlyComponents = MoveTemp(PrevShowOnly);
+	this->PrimitiveRenderMode = PrevMode;
+	this->ShowFlags = PrevFlags;
+	return true;
+}
+
+void UDepthCamSensor::CaptureDepth(TArray<float>& DepthData, int& Width, int& Height, const FReadbackRegion* Region)
+{
+	Width = Height = 0;
+	if (!BeginCapture()) return;
+
+	TArray<FFloat16Color> FloatColorDepthData;
+	if (!ReadTextureTarget(FloatColorDepthData, Width, Height, Region))
 	{
-		if (!CheckTextureTarget()) return;
-		this->CaptureScene();
-		FlushRenderingCommands();
+		// Empty depth, the command handlers reply with an error
+		return;
 	}
-
-	Width = this->TextureTarget->SizeX, Height = TextureTarget->SizeY;
 	DepthData.AddZeroed(Width * Height); // or AddUninitialized(FloatColorDepthData.Num());
-	FTextureRenderTargetResource* RenderTargetResource = this->TextureTarget->GameThread_GetRenderTargetResource();
-	TArray<FFloat16Color> FloatColorDepthData;
-	RenderTargetResource->ReadFloat16Pixels(FloatColorDepthData);
 
     ParallelFor(FloatColorDepthData.Num(), [&](int32 i)
     {
@@ -130,6 +130,35 @@ void UFusionCamSensor::GetSeg(TArray<FColor>& ObjMaskData, int& Width, int& Heig
 	this->AnnotationCamSensor->CaptureSeg(ObjMaskData, Width, Height);
 }
 
+void UFusionCamSensor::GetLitRegion(TArray<FColor>& LitData, int& Width, int& Height, const FReadbackRegion& Region)
+{
+	this->LitCamSensor->CaptureLit(LitData, Width, Height, &Region);
+}
+
+void UFusionCamSensor::GetDepthRegion(TArray<float>& DepthData, int& Width, int& Height, const FReadbackRegion& Region)
+{
+	this->DepthCamSensor->CaptureDepth(DepthData, Width, Height, &Region);
+}
+
+void UFusionCamSensor::GetNormalRegion(TArray<FColor>& NormalData, int& Width, int& Height, const FReadbackRegion& Region)
+{
+	this->NormalCamSensor->Capture(NormalData, Width, Height, &Region);
+}
+
+void UFusionCamSensor::GetSegRegion(TArray<FColor>& ObjMaskData, int& Width, int& Height, const FReadbackRegion& Region)
+{
+	this->AnnotationCamSensor->CaptureSeg(ObjMaskData, Width, Height, &Region);
+}
+
+UBaseCameraSensor* UFusionCamSensor::GetModeSensor(const FString& Mode)
+{
+	if (Mode == TEXT("lit")) return this->LitCamSensor;
+	if (Mode == TEXT("depth")) return this->DepthCamSensor;
+	if (Mode == TEXT("normal")) return this->NormalCamSensor;
+	if (Mode == TEXT("seg")) return this->AnnotationCamSensor;
+	return nullptr;
+}
+
 FVector UFusionCamSensor::GetSensorLocation()
 {
 	return this->GetComponentLocation(); // World space
@@ -248,6 +277,11 @@ void UFusionCamSensor::SetProjectionType(ECameraProjectionMode::Type ProjectionT
 	}
 }
 
+ECameraProjectionMode::Type UFusionCamSensor::GetProjectionType()
+{
+	return this->LitCamSensor->ProjectionType;
+}
+
 void UFusionCamSensor::SetOrthoWidth(float OrthoWidth)
 {
 	for (int i = 0; i < FusionSensors.Num(); i++)
@@ -262,6 +296,11 @@ void UFusionCamSensor::SetOrthoWidth(float OrthoWidth)
 	}
 }
 
+void UFusionCamSensor::GetViewProjectionMatrix(FMatrix& ViewMatrix, FMatrix& ProjectionMatrix)
+{
+	this->LitCamSensor->GetViewProjectionMatrix(ViewMatrix, ProjectionMatrix);
+}
+
 void UFusionCamSensor::SetLitCaptureSource(ESceneCaptureSource CaptureSource)
 {
     this->LitCamSensor->CaptureSource = CaptureSource;
@@ -2,6 +2,8 @@
 #include "LitCamSensor.h"
 #include "UnrealcvLog.h"
 #include "UnrealcvStats.h"
+#include "TextureReader.h"
+#include "Utils/Trace.h"
 
 #include "Runtime/Engine/Classes/Engine/Engine.h"
 #include "TextureResource.h"
@@ -33,16 +35,15 @@ void ULitCamSensor::InitTextureTarget(int filmWidth, int filmHeight)
 	TextureTarget->TargetGamma = GEngine->GetDisplayGamma();
 }
 
-void ULitCamSensor::CaptureLit(TArray<FColor>& Image, int& Width, int& Height)
+bool ULitCamSensor::BeginCapture(FBatchCaptureShared* Shared)
 {
-	SCOPE_CYCLE_COUNTER(STAT_CaptureLit);
 	if (!CheckTextureTarget())
 	{
 		InitTextureTarget(this->FilmWidth, this->FilmHeight);
 		if (!CheckTextureTarget())
 		{
 			UE_LOG(LogUnrealCV, Error, TEXT("Failed to initialize TextureTarget."));
-			return;
+			return false;
 		}
 	}
 	this->bCaptureEveryFrame = true;
@@ -55,7 +56,23 @@ void ULitCamSensor::CaptureLit(TArray<FColor>& Image, int& Width, int& Height)
 	this->PostProcessSettings.bOverride_ReflectionMethod = true;
 	this->PostProcessSettings.ReflectionMethod = EReflectionMethod::Lumen;
 
+	LYCHSIM_TRACE_SCOPE("CaptureScene");
 	this->CaptureScene();
+	return true;
+}
+
+void ULitCamSensor::CaptureLit(TArray<FColor>& Image, int& Width, int& Height, const FReadbackRegion* Region)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CaptureLit);
+	Width = Height = 0;
+	if (!BeginCapture()) return;
+
+	if (Region && !Region->IsFullFrame(FIntPoint(GetFilmWidth(), GetFilmHeight())))
+	{
+		ReadTextureTarget(Image, Width, Height, Region);
+		return;
+	}
+	LYCHSIM_TRACE_SCOPE("Readback");
 	FReadSurfaceDataFlags ReadSurfaceDataFlags;
 	ReadSurfaceDataFlags.SetLinearToGamma(false);
 	// TextureTarget->GetRenderTargetResource()->ReadPixels(Image, ReadSurfaceDataFlags);
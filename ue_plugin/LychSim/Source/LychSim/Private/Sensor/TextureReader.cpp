@@ -1,12 +1,17 @@
 #include "TextureReader.h"
 #include "Runtime/Engine/Classes/Engine/TextureRenderTarget2D.h"
-// #include "Runtime/ShaderCore/Public/StaticBoundShaderState.h"
-// #include "Runtime/ShaderCore/Public/GlobalShader.h"
 #include "Runtime/Engine/Public/ScreenRendering.h"
 #include "Runtime/Core/Public/Modules/ModuleManager.h"
+#include "CommonRenderResources.h"
+#include "GlobalShader.h"
+#include "PipelineStateCache.h"
+#include "RendererInterface.h"
+#include "RHIStaticStates.h"
+#include "ShaderParameterUtils.h"
 
 #include "UnrealcvStats.h"
 #include "UnrealcvLog.h"
+#include "Utils/Trace.h"
 #include "TextureResource.h"
 
 DECLARE_CYCLE_STAT(TEXT("ResizeReadBufferFast"), STAT_ResizeReadBufferFast, STATGROUP_UnrealCV);
@@ -43,118 +48,243 @@ bool ReadTextureRenderTarget(UTextureRenderTarget2D* RenderTarget, TArray<FColor
 }
 
 
-// bool ResizeFastReadTexture2DAsync(FTexture2DRHIRef Texture2D, int TargetWidth, int TargetHeight, TFunction<void(FColor*, int32, int32)> Callback)
-// {
-// 	auto RenderCommand = [=](FRHICommandListImmediate& RHICmdList, FTexture2DRHIRef SrcTexture)
-// 	{
-// 		// RHICmdList.ImmediateFlush(EImmediateFlushType::FlushRHIThread);
-
-// 		SCOPE_CYCLE_COUNTER(STAT_ResizeReadBufferFast);
-
-// 		FIntPoint TargetSize(TargetWidth, TargetHeight);
-// 		FPooledRenderTargetDesc OutputDesc(FPooledRenderTargetDesc::Create2DDesc(
-// 			TargetSize,
-// 			SrcTexture->GetFormat(),
-// 			FClearValueBinding::None,
-// 			TexCreate_None,
-// 			TexCreate_RenderTargetable, // This texture can be used as a RenderTarget
-// 			false));
-
-// 		const auto FeatureLevel = GMaxRHIFeatureLevel;
-// 		TRefCountPtr<IPooledRenderTarget> ResampleTexturePooledRenderTarget;
-
-// 		static const FName RendererModuleName("Renderer");
-// 		IRendererModule* RendererModule = &FModuleManager::GetModuleChecked<IRendererModule>(RendererModuleName);
-
-// 		// IRendererModule RendererModule;
-// 		// RendererModule->RenderTargetPoolFindFreeElement(RHICmdList, OutputDesc, ResampleTexturePooledRenderTarget, TEXT("ResampleTexture")); // FIXME:
-// 		if (!ResampleTexturePooledRenderTarget)
-// 		{
-// 			UE_LOG(LogUnrealCV, Warning, TEXT("ResampleTexturePooledRenderTarget is invalid"));
-// 			return;
-// 		}
-
-// 		const FSceneRenderTargetItem& DestRenderTarget = ResampleTexturePooledRenderTarget->GetRenderTargetItem();
-
-// 		// SetRenderTarget(RHICmdList, DestRenderTarget.TargetableTexture, FTextureRHIRef());
-// 		RHICmdList.SetViewport(0, 0, 0.0f, TargetWidth, TargetHeight, 1.0f);
-
-// 		// TODO: check these APIs
-// 		// RHICmdList.SetBlendState(TStaticBlendState<>::GetRHI());
-// 		// RHICmdList.SetRasterizerState(TStaticRasterizerState<>::GetRHI());
-// 		// RHICmdList.SetDepthStencilState(TStaticDepthStencilState<false, CF_Always>::GetRHI());
-
-// 		auto ShaderMap = GetGlobalShaderMap(FeatureLevel);
-// 		TShaderMapRef<FScreenVS> VertexShader(ShaderMap);
-// 		TShaderMapRef<FScreenPS> PixelShader(ShaderMap);
-
-// 		static FGlobalBoundShaderState BoundShaderState;
-// 		// SetGlobalBoundShaderState(RHICmdList, FeatureLevel, BoundShaderState, RendererModule->GetFilterVertexDeclaration().VertexDeclarationRHI, *VertexShader, *PixelShader);
-
-// 		if (TargetSize != FIntPoint(SrcTexture->GetSizeX(), SrcTexture->GetSizeY()))
-// 		{
-// 			// We're scaling down the window, so use bilinear filtering
-// 			PixelShader->SetParameters(RHICmdList, TStaticSamplerState<SF_Bilinear>::GetRHI(), SrcTexture);
-// 		}
-// 		else
-// 		{
-// 			// Drawing 1:1, so no filtering needed
-// 			PixelShader->SetParameters(RHICmdList, TStaticSamplerState<SF_Point>::GetRHI(), SrcTexture);
-// 		}
-// 		{
-// 			RendererModule->DrawRectangle(
-// 				RHICmdList,
-// 				0, 0,		// Dest X, Y
-// 				TargetWidth, TargetHeight,	// Dest Width, Height
-// 				0, 0,		// Source U, V
-// 				1, 1,		// Source USize, VSize
-// 				TargetSize,		// Target buffer size
-// 				FIntPoint(1, 1),		// Source texture size
-// 				*VertexShader,
-// 				EDRF_Default);
-// 		}
-
-// 		FRHIResourceCreateInfo CreateInfo;
-// 		FTexture2DRHIRef ReadbackTexture = RHICreateTexture2D(
-// 			TargetWidth,
-// 			TargetHeight,
-// 			SrcTexture->GetFormat(),
-// 			1, 1,
-// 			// TexCreate_CPUReadback | TexCreate_ResolveTargetable,
-// 			TexCreate_CPUReadback,
-// 			CreateInfo
-// 		);
-
-// 		if (ReadbackTexture->GetFormat() != DestRenderTarget.TargetableTexture->GetFormat())
-// 		{
-// 			UE_LOG(LogUnrealCV, Warning, TEXT("ReadbackTexture and DestRenderTarget have different formats"));
-// 			return;
-// 		}
-// 		// Need to be the same for the copy operation, otherwise it will fail silently
-
-// 		FResolveParams ResolveParams;
-// 		RHICmdList.CopyToResolveTarget(
-// 			DestRenderTarget.TargetableTexture,
-// 			ReadbackTexture,
-// 			FResolveParams());
-
-// 		void* ColorDataBuffer = nullptr;
-// 		int32 Width = 0, Height = 0;
-// 		RHICmdList.MapStagingSurface(ReadbackTexture, ColorDataBuffer, Width, Height);
-
-// 		FColor* ColorBuffer = reinterpret_cast<FColor*>(ColorDataBuffer);
-// 		Callback(ColorBuffer, Width, Height);
-// 		// The ColorDataBuffer maps to the memory location
-
-// 		RHICmdList.UnmapStagingSurface(ReadbackTexture);
-// 	};
-
-// 	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
-// 		FastReadBufferResize,
-// 		TFunction<void(FRHICommandListImmediate&, FTexture2DRHIRef)>, InRenderCommand, RenderCommand,
-// 		FTexture2DRHIRef, InTexture2D, Texture2D,
-// 	{
-// 		InRenderCommand(RHICmdList, InTexture2D);
-// 	});
-// 	return true;
-// }
+FIntRect FReadbackRegion::GetRoi(FIntPoint FilmSize) const
+{
+	if (Roi.Width() <= 0 || Roi.Height() <= 0)
+	{
+		return FIntRect(FIntPoint::ZeroValue, FilmSize);
+	}
+	FIntRect Clamped = Roi;
+	Clamped.Clip(FIntRect(FIntPoint::ZeroValue, FilmSize));
+	return Clamped;
+}
+
+FIntPoint FReadbackRegion::GetSize(FIntPoint FilmSize) const
+{
+	if (Size.X > 0 && Size.Y > 0)
+	{
+		return Size;
+	}
+	return GetRoi(FilmSize).Size();
+}
+
+bool FReadbackRegion::IsFullFrame(FIntPoint FilmSize) const
+{
+	return GetRoi(FilmSize) == FIntRect(FIntPoint::ZeroValue, FilmSize) && GetSize(FilmSize) == FilmSize;
+}
+
+namespace
+{
+	/** The output texture of the resampling of one render target, only touched on the render thread */
+	struct FResampleTarget
+	{
+		FTextureRHIRef Texture;
+	};
+	using FResampleTargetPtr = TSharedPtr<FResampleTarget, ESPMode::ThreadSafe>;
+
+	/** One per render target, so per sensor. Game thread only */
+	TMap<TWeakObjectPtr<UTextureRenderTarget2D>, FResampleTargetPtr> ResampleTargets;
+
+	FResampleTargetPtr GetResampleTarget(UTextureRenderTarget2D* RenderTarget)
+	{
+		check(IsInGameThread());
+		if (const FResampleTargetPtr* Found = ResampleTargets.Find(RenderTarget))
+		{
+			return *Found;
+		}
+		// Release the textures of destroyed sensors, a render command still using one holds a reference
+		for (auto It = ResampleTargets.CreateIterator(); It; ++It)
+		{
+			if (!It->Key.IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		return ResampleTargets.Add(RenderTarget, MakeShared<FResampleTarget, ESPMode::ThreadSafe>());
+	}
+
+	/**
+	 * Draw the crop of SrcTexture into the texture of Target, return it ready to be copied. The texture is
+	 * only created again when the output size, the format or the sRGB flag change
+	 */
+	FRHITexture* ResampleTexture(FRHICommandListImmediate& RHICmdList, FResampleTarget& Target, FRHITexture* SrcTexture, const FIntRect& Roi, FIntPoint OutputSize, bool bBilinear)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ResizeReadBufferFast);
+
+		// Keep the format and the sRGB flag, so the pixels are encoded as in the source
+		const ETextureCreateFlags SRGBFlag = SrcTexture->GetFlags() & ETextureCreateFlags::SRGB;
+		FTextureRHIRef& DestTexture = Target.Texture;
+		if (DestTexture.IsValid()
+			&& DestTexture->GetSizeXY() == OutputSize
+			&& DestTexture->GetFormat() == SrcTexture->GetFormat()
+			&& (DestTexture->GetFlags() & ETextureCreateFlags::SRGB) == SRGBFlag)
+		{
+			// Left as a copy source by the last readback
+			RHICmdList.Transition(FRHITransitionInfo(DestTexture, ERHIAccess::CopySrc, ERHIAccess::RTV));
+		}
+		else
+		{
+			const FRHITextureCreateDesc Desc = FRHITextureCreateDesc::Create2D(TEXT("LychSimResampledTexture"), OutputSize.X, OutputSize.Y, SrcTexture->GetFormat())
+				.SetFlags(ETextureCreateFlags::RenderTargetable | ETextureCreateFlags::ShaderResource | SRGBFlag)
+				.SetInitialState(ERHIAccess::RTV);
+			DestTexture = RHICreateTexture(Desc);
+		}
+
+		RHICmdList.Transition(FRHITransitionInfo(SrcTexture, ERHIAccess::Unknown, ERHIAccess::SRVGraphics));
+		FRHIRenderPassInfo RenderPassInfo(DestTexture, ERenderTargetActions::DontLoad_Store);
+		RHICmdList.BeginRenderPass(RenderPassInfo, TEXT("LychSimResample"));
+		{
+			RHICmdList.SetViewport(0, 0, 0.0f, OutputSize.X, OutputSize.Y, 1.0f);
+
+			FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(GMaxRHIFeatureLevel);
+			TShaderMapRef<FScreenVS> VertexShader(ShaderMap);
+			TShaderMapRef<FScreenPS> PixelShader(ShaderMap);
+
+			FGraphicsPipelineStateInitializer GraphicsPSOInit;
+			RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+			GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+			GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+			GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+			GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GFilterVertexDeclaration.VertexDeclarationRHI;
+			GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+			GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+			GraphicsPSOInit.PrimitiveType = PT_TriangleList;
+			SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+			// A point sampler picks the nearest source texel, so no new label value is made up
+			FRHISamplerState* SamplerState = bBilinear
+				? TStaticSamplerState<SF_Bilinear>::GetRHI()
+				: TStaticSamplerState<SF_Point>::GetRHI();
+			SetShaderParametersLegacyPS(RHICmdList, PixelShader, SamplerState, SrcTexture);
+
+			static const FName RendererModuleName("Renderer");
+			IRendererModule& RendererModule = FModuleManager::GetModuleChecked<IRendererModule>(RendererModuleName);
+			const FIntPoint SrcSize(SrcTexture->GetSizeX(), SrcTexture->GetSizeY());
+			RendererModule.DrawRectangle(
+				RHICmdList,
+				0, 0,                                   // Dest X, Y
+				OutputSize.X, OutputSize.Y,             // Dest width, height
+				Roi.Min.X, Roi.Min.Y,                   // Source U, V in texels
+				Roi.Width(), Roi.Height(),              // Source size in texels
+				OutputSize,                             // Target buffer size
+				SrcSize,                                // Source texture size
+				VertexShader,
+				EDRF_Default);
+		}
+		RHICmdList.EndRenderPass();
+		RHICmdList.Transition(FRHITransitionInfo(DestTexture, ERHIAccess::RTV, ERHIAccess::CopySrc));
+		return DestTexture.GetReference();
+	}
+
+	template<typename TPixel, typename TReadFunction>
+	bool EnqueueRead(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion* Region, TArray<TPixel>& ImageData, FIntPoint& OutSize, TReadFunction ReadFunction)
+	{
+		if (RenderTarget == nullptr)
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("The RenderTarget is nullptr"));
+			return false;
+		}
+		FTextureRenderTargetResource* Resource = RenderTarget->GameThread_GetRenderTargetResource();
+		const FIntPoint FilmSize(RenderTarget->SizeX, RenderTarget->SizeY);
+		const FIntRect Roi = Region ? Region->GetRoi(FilmSize) : FIntRect(FIntPoint::ZeroValue, FilmSize);
+		const FIntPoint OutputSize = Region ? Region->GetSize(FilmSize) : FilmSize;
+		if (Resource == nullptr || Roi.Width() <= 0 || Roi.Height() <= 0 || OutputSize.X <= 0 || OutputSize.Y <= 0)
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("Invalid readback region %s -> %dx%d"), *Roi.ToString(), OutputSize.X, OutputSize.Y);
+			return false;
+		}
+
+		// A crop that is not scaled is read straight from the render target
+		const bool bResample = Roi.Size() != OutputSize;
+		const bool bBilinear = Region && Region->bBilinear;
+		FResampleTargetPtr Target = bResample ? GetResampleTarget(RenderTarget) : nullptr;
+		TArray<TPixel>* OutData = &ImageData;
+		ENQUEUE_RENDER_COMMAND(LychSimEnqueueRead)(
+			[Resource, Roi, OutputSize, bResample, bBilinear, Target, OutData, ReadFunction](FRHICommandListImmediate& RHICmdList)
+		{
+			if (bResample)
+			{
+				FRHITexture* DestTexture = ResampleTexture(RHICmdList, *Target, Resource->GetRenderTargetTexture(), Roi, OutputSize, bBilinear);
+				ReadFunction(RHICmdList, DestTexture, FIntRect(FIntPoint::ZeroValue, OutputSize), *OutData);
+			}
+			else
+			{
+				ReadFunction(RHICmdList, Resource->GetRenderTargetTexture(), Roi, *OutData);
+			}
+		});
+		OutSize = OutputSize;
+		return true;
+	}
+
+	void ReadColors(FRHICommandListImmediate& RHICmdList, FRHITexture* Texture, FIntRect Rect, TArray<FColor>& OutData)
+	{
+		FReadSurfaceDataFlags ReadSurfaceDataFlags(RCM_UNorm);
+		ReadSurfaceDataFlags.SetLinearToGamma(false);
+		RHICmdList.ReadSurfaceData(Texture, Rect, OutData, ReadSurfaceDataFlags);
+	}
+
+	void ReadHalfColors(FRHICommandListImmediate& RHICmdList, FRHITexture* Texture, FIntRect Rect, TArray<FFloat16Color>& OutData)
+	{
+		RHICmdList.ReadSurfaceFloatData(Texture, Rect, OutData, CubeFace_PosX, 0, 0);
+	}
+}
+
+bool EnqueueReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion* Region, TArray<FColor>& ImageData, FIntPoint& OutSize)
+{
+	return EnqueueRead(RenderTarget, Region, ImageData, OutSize, &ReadColors);
+}
+
+bool EnqueueReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion* Region, TArray<FFloat16Color>& ImageData, FIntPoint& OutSize)
+{
+	return EnqueueRead(RenderTarget, Region, ImageData, OutSize, &ReadHalfColors);
+}
+
+bool ResampleReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion& Region, TArray<FColor>& ImageData, int& Width, int& Height)
+{
+	FIntPoint Size;
+	if (!EnqueueReadTexture(RenderTarget, &Region, ImageData, Size))
+	{
+		ImageData.Reset();
+		Width = Height = 0;
+		return false;
+	}
+	{
+		LYCHSIM_TRACE_SCOPE("FlushRenderingCommands");
+		FlushRenderingCommands();
+	}
+
+	Width = Size.X;
+	Height = Size.Y;
+	if (ImageData.Num() != Width * Height)
+	{
+		ImageData.Reset();
+		Width = Height = 0;
+		return false;
+	}
+	return true;
+}
+
+bool ResampleReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion& Region, TArray<FFloat16Color>& ImageData, int& Width, int& Height)
+{
+	FIntPoint Size;
+	if (!EnqueueReadTexture(RenderTarget, &Region, ImageData, Size))
+	{
+		ImageData.Reset();
+		Width = Height = 0;
+		return false;
+	}
+	{
+		LYCHSIM_TRACE_SCOPE("FlushRenderingCommands");
+		FlushRenderingCommands();
+	}
+
+	Width = Size.X;
+	Height = Size.Y;
+	if (ImageData.Num() != Width * Height)
+	{
+		ImageData.Reset();
+		Width = Height = 0;
+		return false;
+	}
+	return true;
+}
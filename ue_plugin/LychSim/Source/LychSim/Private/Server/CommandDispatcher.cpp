@@ -4,27 +4,17 @@
 #include "Runtime/Core/Public/HAL/RunnableThread.h"
 #include "Runtime/Core/Public/Async/Async.h"
 #include "Runtime/Core/Public/Containers/Queue.h"
-#include "Runtime/Core/Public/Internationalization/Regex.h"
 #include "UnrealcvStats.h"
 #include "UnrealcvLog.h"
 #include "Utils/argparse.h"
 
-// CommandDispatcher->BindCommand("vset /mode/(?<ViewMode>.*)", SetViewMode); // Better to check the correctness at compile time
-// The regular expression for float number is from here, http://stackoverflow.com/questions/12643009/regular-expression-for-floating-point-numbers
-// Use ICU regexp to define URI, See http://userguide.icu-project.org/strings/regexp
+// The templates are matched by LychSim::Core::FCommandRouter, see CommandRouter.h for the argument types
+// The float type follows http://stackoverflow.com/questions/12643009/regular-expression-for-floating-point-numbers
 
 DECLARE_CYCLE_STAT(TEXT("FCommandDispatcher::Exec"), STAT_Exec, STATGROUP_UnrealCV);
 
 FCommandDispatcher::FCommandDispatcher()
 {
-	FString Str = "([^ ]*)", UInt = "(\\d*)", Float = "([-+]?\\d*[.]?\\d+)"; // Each type will be considered as a group
-	TypeRegexp.Emplace("str", Str);
-	TypeRegexp.Emplace("uint", UInt);
-	TypeRegexp.Emplace("float", Float);
-
-	FString StrTail = "(\\S+(?:\\s+\\S+)*)";
-	TypeRegexp.Emplace("str+", StrTail);
-
 	FDispatcherDelegate Cmd = FDispatcherDelegate::CreateRaw(this, &FCommandDispatcher::AliasHelper);
 	FString Uri = FString::Printf(TEXT("vrun [str]"));
 	BindCommand(Uri, Cmd, "Run an alias for Unreal CV plugin");
@@ -34,113 +24,55 @@ FCommandDispatcher::~FCommandDispatcher()
 {
 }
 
-bool FCommandDispatcher::FormatUri(const FString& RawUri, FString& UriRexexp)
+bool FCommandDispatcher::AddRoute(const FString& UriTemplate, bool bUEStyle)
 {
-	FString Uri = "";
-	bool IsTypeSpecifier = false;
-	FString TypeSpecifier = "";
-
-	// Implement a simple state-machine to parse input string
-	for (int32 Index = 0; Index < RawUri.Len(); Index++)
+	FTCHARToUTF8 Utf8(*UriTemplate);
+	std::string Error;
+	const int32 RouteId = Router.Add(std::string_view(Utf8.Get(), Utf8.Length()), bUEStyle, &Error);
+	if (RouteId < 0)
 	{
-		TCHAR Ch = RawUri[Index];
-		if (!IsTypeSpecifier)
-		{
-			if (Ch == '[')
-			{
-				IsTypeSpecifier = true;
-				continue;
-			}
-			if (Ch == ']')
-			{
-				UE_LOG(LogUnrealCV, Error, TEXT("Unexpected ] in %d"), Index);
-				// check(false);
-				return false;
-			}
-			// else
-			Uri += Ch;
-			continue;
-		}
-		if (IsTypeSpecifier)
-		{
-			if (Ch == '[')
-			{
-				UE_LOG(LogUnrealCV, Error, TEXT("Unexpected [ in %d"), Index);
-				// check(false);
-				return false;
-			}
-			if (Ch == ']')
-			{
-				IsTypeSpecifier = false;
-				if (TypeRegexp.Contains(TypeSpecifier))
-				{
-					Uri += TypeRegexp[TypeSpecifier];
-					TypeSpecifier = "";
-					continue;
-				}
-				else
-				{
-					UE_LOG(LogUnrealCV, Error, TEXT("Unknown type specifier "));
-					// check(false);
-					return false;
-				}
-			}
-			// else
-			TypeSpecifier += Ch;
-			continue;
-		}
-	}
-
-	if (TypeSpecifier != "")
-	{
-		UE_LOG(LogUnrealCV, Error, TEXT("Not all [ are closed by ]"));
-		// check(false);
+		UE_LOG(LogUnrealCV, Error, TEXT("The UriTemplate %s is malformat, %hs"), *UriTemplate, Error.c_str());
 		return false;
 	}
-	UriRexexp = Uri + "[ ]*$"; // Make sure no more parameters
+	check(RouteId == RouteUris.Num());
+	RouteUris.Add(UriTemplate);
+	RouteIsUE.Add(bUEStyle);
 	return true;
 }
 
 /** Bind command to a function, the command on the bottom will overwrite the command on the top */
 bool FCommandDispatcher::BindCommand(const FString& ReadableUriTemplate, const FDispatcherDelegate& Command, const FString& Description) // Parse URI
 {
-	// TODO: Build a tree structure to boost performance
-	// TODO: The order should matter
-
-	FString UriTemplate;
-	if (!FormatUri(ReadableUriTemplate, UriTemplate))
+	if (UriMapping.Contains(ReadableUriTemplate))
 	{
-		UE_LOG(LogUnrealCV, Error, TEXT("The UriTemplate %s is malformat"), *ReadableUriTemplate);
+		UE_LOG(LogUnrealCV, Warning, TEXT("The UriTemplate %s already exist, overwrited."), *ReadableUriTemplate);
 		return false;
 	}
-
-	if (UriMapping.Contains(UriTemplate))
+	if (!AddRoute(ReadableUriTemplate, false))
 	{
-		UE_LOG(LogUnrealCV, Warning, TEXT("The UriTemplate %s already exist, overwrited."), *UriTemplate);
 		return false;
 	}
 
-	UriMapping.Emplace(UriTemplate, Command);
+	UriMapping.Emplace(ReadableUriTemplate, Command);
 	UriDescription.Emplace(ReadableUriTemplate, Description);
-	UriRegexPattern.Emplace(UriTemplate, FRegexPattern(UriTemplate));
-	UriList.AddUnique(UriTemplate);
 	return true;
 }
 
+/** The arguments after the template are parsed as positionals, -key=value and -flags */
 bool FCommandDispatcher::BindCommandUE(const FString& ReadableUriTemplate, const FDispatcherDelegateUE& Command, const FString& Description) // Parse URI
 {
-	FString UriTemplate = ReadableUriTemplate + TEXT("(?:\\s+(\\S+(?:\\s+\\S+)*))?[ ]*$");
-
-	if (UriMappingUE.Contains(UriTemplate))
+	if (UriMappingUE.Contains(ReadableUriTemplate))
+	{
+		UE_LOG(LogUnrealCV, Warning, TEXT("The UriTemplate %s already exist, overwrited."), *ReadableUriTemplate);
+		return false;
+	}
+	if (!AddRoute(ReadableUriTemplate, true))
 	{
-		UE_LOG(LogUnrealCV, Warning, TEXT("The UriTemplate %s already exist, overwrited."), *UriTemplate);
 		return false;
 	}
 
-	UriMappingUE.Emplace(UriTemplate, Command);
+	UriMappingUE.Emplace(ReadableUriTemplate, Command);
 	UriDescription.Emplace(ReadableUriTemplate, Description);
-	UriRegexPattern.Emplace(UriTemplate, FRegexPattern(UriTemplate));
-	UriList.AddUnique(UriTemplate);
 	return true;
 }
 
@@ -193,58 +125,65 @@ const TMap<FString, FString>& FCommandDispatcher::GetUriDescription()
 	return this->UriDescription;
 }
 
-FExecStatus FCommandDispatcher::Exec(const FString Uri)
+FExecStatus FCommandDispatcher::Exec(const FString Uri, FExecInfo* OutInfo)
 {
 	SCOPE_CYCLE_COUNTER(STAT_Exec);
+	const double StartTime = FPlatformTime::Seconds();
 	if (!IsInGameThread())
 	{
 		UE_LOG(LogUnrealCV, Error, TEXT("Command execution is not in the game thread."));
 		return FExecStatus::Error("Command execution is not in the game thread.");
 	}
-	TArray<FString> Args; // Get args from URI
 
-	// The newly added command should overwrite previous one.
-	// for (auto& Elem : UriMapping)
-	/*UE_LOG(LogUnrealCV, Warning, TEXT("Number of mach list: %d"), UriList.Num());
-	UE_LOG(LogUnrealCV, Warning, TEXT("Uri need to be matched : %s"), *Uri);*/
-
-	// Iterate the UriList in the reverse order
-	for (int UriIndex = UriList.Num() - 1; UriIndex >= 0; UriIndex--)
+	FTCHARToUTF8 Utf8(*Uri);
+	const std::string_view Request(Utf8.Get(), Utf8.Length());
+	size_t ArgsBegin = 0;
+	const int32 RouteId = Router.Match(Request, ArgsBegin);
+	if (RouteId < 0)
 	{
-		// FRegexPattern Pattern = FRegexPattern(Elem.Key);
-		FString Key = UriList[UriIndex];
-		//UE_LOG(LogUnrealCV, Warning, TEXT("match list item : %s"), *Key);
-		FRegexPattern Pattern = UriRegexPattern[Key];
-
-		FRegexMatcher Matcher(Pattern, Uri);
-		if (Matcher.FindNext())
+		if (OutInfo)
 		{
-			int32 TailStart = Matcher.GetCaptureGroupBeginning(1);
-			if (TailStart < 0) TailStart = Matcher.GetMatchEnding();
-
-			FString Tail = Uri.Mid(TailStart);
-			Tail.TrimStartAndEndInline();
-
-			LychSim::FParsedCmd P = LychSim::ParseTailWithFParse(Tail);
+			OutInfo->DispatchSeconds = FPlatformTime::Seconds() - StartTime;
+		}
+		return FExecStatus::Error(FString::Printf(TEXT("Can not find a handler for URI '%s'"), *Uri));
+	}
 
-			UE_LOG(LogUnrealCV, Warning, TEXT("Parsed command: %s"), *LychSim::ParsedCmdToString(P));
+	LychSim::Core::FParsedArgs Args;
+	LychSim::Core::ParseArgs(Request.substr(ArgsBegin), Args);
+	LychSim::FParsedCmd P = LychSim::ToParsedCmd(Args);
 
-			if (FDispatcherDelegateUE* CmdUE = UriMappingUE.Find(Key))
-			{
-				if (CmdUE->IsBound())
-					return CmdUE->Execute(P.Positionals, P.Kwargs, P.Flags);
-			}
-
-			if (FDispatcherDelegate* Cmd = UriMapping.Find(Key))
-				if (Cmd->IsBound()) return Cmd->Execute(P.Positionals);
+	const FString Key = RouteUris[RouteId]; // A handler may bind more commands
+	const double HandlerStartTime = FPlatformTime::Seconds();
+	auto SetInfo = [&]()
+	{
+		if (!OutInfo) return;
+		OutInfo->Command = Key;
+		OutInfo->DispatchSeconds = HandlerStartTime - StartTime;
+		OutInfo->HandlerSeconds = FPlatformTime::Seconds() - HandlerStartTime;
+	};
 
-			FString ErrorMsg = TEXT("Command delegate is not bound.");
-			UE_LOG(LogUnrealCV, Warning, TEXT("%s"), *ErrorMsg);
-			return FExecStatus::Error(ErrorMsg);
+	if (RouteIsUE[RouteId])
+	{
+		FDispatcherDelegateUE* CmdUE = UriMappingUE.Find(Key);
+		if (CmdUE && CmdUE->IsBound())
+		{
+			FExecStatus ExecStatus = CmdUE->Execute(P.Positionals, P.Kwargs, P.Flags);
+			SetInfo();
+			return ExecStatus;
 		}
-
-		// TODO: Regular expression mapping is slow, need to implement in a more efficient way.
-		// FRegexMatcher()
 	}
-	return FExecStatus::Error(FString::Printf(TEXT("Can not find a handler for URI '%s'"), *Uri));
+	else
+	{
+		FDispatcherDelegate* Cmd = UriMapping.Find(Key);
+		if (Cmd && Cmd->IsBound())
+		{
+			FExecStatus ExecStatus = Cmd->Execute(P.Positionals);
+			SetInfo();
+			return ExecStatus;
+		}
+	}
+
+	FString ErrorMsg = TEXT("Command delegate is not bound.");
+	UE_LOG(LogUnrealCV, Warning, TEXT("%s"), *ErrorMsg);
+	return FExecStatus::Error(ErrorMsg);
 }
@@ -31,6 +31,7 @@ bool operator!=(const FExecStatus& ExecStatus, const FExecStatusType& ExecStatus
 
 FExecStatus& FExecStatus::operator+=(const FExecStatus& Src)
 {
+	this->BinaryData += Src.BinaryHeader;
 	this->BinaryData += Src.BinaryData;
 	this->MessageBody += "\n" + Src.MessageBody;
 	return *this;
@@ -48,6 +49,16 @@ FExecStatus FExecStatus::Error(FString ErrorMessage)
 	return FExecStatus(FExecStatusType::ErrorMsg, ErrorMessage);
 }
 
+FExecStatus FExecStatus::AsyncQuery(FPromise InPromise)
+{
+	return FExecStatus(FExecStatusType::Pending, InPromise);
+}
+
+FExecStatus FExecStatus::Pending(FString Message)
+{
+	return FExecStatus(FExecStatusType::Pending, Message);
+}
+
 FString FExecStatus::GetMessage() const // Define how to format the reply string
 {
 	FString TypeName;
@@ -60,6 +71,8 @@ FString FExecStatus::GetMessage() const // Define how to format the reply string
 			return MessageBody;
 	case FExecStatusType::ErrorMsg:
 		TypeName = "error"; break;
+	case FExecStatusType::Pending:
+		TypeName = "pending"; break;
 	default:
 		TypeName = "unknown FExecStatus Type";
 	}
@@ -94,11 +107,34 @@ FExecStatus::FExecStatus(FExecStatusType InExecStatusType, TArray<uint8>& InBina
 	BinaryData = InBinaryData;
 }
 
+FExecStatus FExecStatus::Binary(TArray<uint8>&& InBinaryData)
+{
+	FExecStatus Status(FExecStatusType::OK, FString());
+	Status.BinaryData = MoveTemp(InBinaryData);
+	return Status;
+}
+
+FExecStatus FExecStatus::Binary(TArray<uint8>&& InBinaryHeader, TArray<uint8>&& InBinaryData)
+{
+	FExecStatus Status(FExecStatusType::OK, FString());
+	Status.BinaryHeader = MoveTemp(InBinaryHeader);
+	Status.BinaryData = MoveTemp(InBinaryData);
+	return Status;
+}
+
 TArray<uint8> FExecStatus::GetData() const // Define how to format the reply string
 {
 	if (this->BinaryData.Num() != 0)
 	{
-		return BinaryData;
+		if (BinaryHeader.Num() == 0)
+		{
+			return BinaryData;
+		}
+		TArray<uint8> Joined;
+		Joined.Reserve(BinaryHeader.Num() + BinaryData.Num());
+		Joined.Append(BinaryHeader);
+		Joined.Append(BinaryData);
+		return Joined;
 	}
 	FString TypeName;
 	FString Message;
@@ -111,6 +147,8 @@ TArray<uint8> FExecStatus::GetData() const // Define how to format the reply str
 			Message = MessageBody;
 	case FExecStatusType::ErrorMsg:
 		TypeName = "error"; break;
+	case FExecStatusType::Pending:
+		TypeName = "pending"; break;
 	default:
 		TypeName = "unknown FExecStatus Type";
 	}
@@ -25,6 +25,12 @@ FServerConfig::FServerConfig()
 	EnableInput = true;
 	ExitOnFailure = false;
 	EnableRightEye = false;
+	WriterThreads = 4;
+	WriterQueueMB = 512;
+	Headless = false;
+	RequestLogVerbosity = TEXT("errors");
+	RequestLogSampleRate = 0.01f;
+	RequestLogPath = TEXT("");
 
 	SupportedModes.Add(TEXT("lit"));
 	SupportedModes.Add(TEXT("depth"));
@@ -110,6 +116,12 @@ FString FServerConfig::ToString() {
 	Msg += FString::Printf(TEXT("FOV: %f\n"), this->FOV);
 	Msg += FString::Printf(TEXT("EnableInput: %s\n"), *BoolToString(this->EnableInput));
 	Msg += FString::Printf(TEXT("EnableRightEye: %s\n"), *BoolToString(this->EnableRightEye));
+	Msg += FString::Printf(TEXT("WriterThreads: %d\n"), this->WriterThreads);
+	Msg += FString::Printf(TEXT("WriterQueueMB: %d\n"), this->WriterQueueMB);
+	Msg += FString::Printf(TEXT("Headless: %s\n"), *BoolToString(this->Headless));
+	Msg += FString::Printf(TEXT("RequestLogVerbosity: %s\n"), *this->RequestLogVerbosity);
+	Msg += FString::Printf(TEXT("RequestLogSampleRate: %f\n"), this->RequestLogSampleRate);
+	Msg += FString::Printf(TEXT("RequestLogPath: %s\n"), *this->RequestLogPath);
 	return Msg;
 }
 
@@ -125,6 +137,12 @@ bool FServerConfig::Load() {
 	GConfig->GetFloat(*CoreSection, TEXT("FOV"), this->FOV, this->ConfigFile);
 	GConfig->GetBool(*CoreSection, TEXT("EnableInput"), this->EnableInput, this->ConfigFile);
 	GConfig->GetBool(*CoreSection, TEXT("EnableRightEye"), this->EnableRightEye, this->ConfigFile);
+	GConfig->GetInt(*CoreSection, TEXT("WriterThreads"), this->WriterThreads, this->ConfigFile);
+	GConfig->GetInt(*CoreSection, TEXT("WriterQueueMB"), this->WriterQueueMB, this->ConfigFile);
+	GConfig->GetBool(*CoreSection, TEXT("Headless"), this->Headless, this->ConfigFile);
+	GConfig->GetString(*CoreSection, TEXT("RequestLogVerbosity"), this->RequestLogVerbosity, this->ConfigFile);
+	GConfig->GetFloat(*CoreSection, TEXT("RequestLogSampleRate"), this->RequestLogSampleRate, this->ConfigFile);
+	GConfig->GetString(*CoreSection, TEXT("RequestLogPath"), this->RequestLogPath, this->ConfigFile);
 
 
 	return true;
@@ -141,6 +159,12 @@ bool FServerConfig::Save()
 	GConfig->SetFloat(*CoreSection, TEXT("FOV"), this->FOV, this->ConfigFile);
 	GConfig->SetBool(*CoreSection, TEXT("EnableInput"), this->EnableInput, this->ConfigFile);
 	GConfig->SetBool(*CoreSection, TEXT("EnableRightEye"), this->EnableRightEye, this->ConfigFile);
+	GConfig->SetInt(*CoreSection, TEXT("WriterThreads"), this->WriterThreads, this->ConfigFile);
+	GConfig->SetInt(*CoreSection, TEXT("WriterQueueMB"), this->WriterQueueMB, this->ConfigFile);
+	GConfig->SetBool(*CoreSection, TEXT("Headless"), this->Headless, this->ConfigFile);
+	GConfig->SetString(*CoreSection, TEXT("RequestLogVerbosity"), *this->RequestLogVerbosity, this->ConfigFile);
+	GConfig->SetFloat(*CoreSection, TEXT("RequestLogSampleRate"), this->RequestLogSampleRate, this->ConfigFile);
+	GConfig->SetString(*CoreSection, TEXT("RequestLogPath"), *this->RequestLogPath, this->ConfigFile);
 
 	bool Read = false;
 	GConfig->Flush(Read, this->ConfigFile);
@@ -1,21 +1,51 @@
 // Weichao Qiu @ 2016, modified by Hai Ci @ 2022
 #include "UnixTcpServer.h"
-#include "Runtime/Core/Public/Serialization/BufferArchive.h"
-#include "Runtime/Core/Public/Serialization/MemoryReader.h"
+#include "LychCore/Framing.h"
 #include <string>
 #include "UnrealcvLog.h"
 #include "UnrealcvShim.h"
+#include "Utils/Trace.h"
 
-uint32 FUnixSocketMessageHeader::DefaultMagic = 0x9E2B83C1;
+uint32 FUnixSocketMessageHeader::DefaultMagic = LychSim::Core::FrameMagic;
+
+static const TArray<uint8> NoTail;
+
+/** The header, the payload and the tail in one buffer */
+static void FramePayload(const TArray<uint8>& Payload, const TArray<uint8>& Tail, TArray<uint8>& Ar)
+{
+	Ar.SetNumUninitialized((int32)LychSim::Core::FrameHeaderSize + Payload.Num() + Tail.Num());
+	LychSim::Core::WriteFrameHeader(Ar.GetData(), Payload.Num() + Tail.Num());
+	FMemory::Memcpy(Ar.GetData() + LychSim::Core::FrameHeaderSize, Payload.GetData(), Payload.Num());
+	FMemory::Memcpy(Ar.GetData() + LychSim::Core::FrameHeaderSize + Payload.Num(), Tail.GetData(), Tail.Num());
+}
+
+/** Log why a header is rejected, return false if it is */
+static bool ReadPayloadSize(const TArray<uint8>& HeaderBytes, uint32& PayloadSize)
+{
+	const LychSim::Core::EFrameError Error = LychSim::Core::ReadFrameHeader(HeaderBytes.GetData(), PayloadSize);
+	if (Error == LychSim::Core::EFrameError::BadMagic)
+	{
+		UE_LOG(LogUnrealCV, Error, TEXT("Bad network header magic"));
+		return false;
+	}
+	if (Error == LychSim::Core::EFrameError::EmptyPayload)
+	{
+		UE_LOG(LogUnrealCV, Error, TEXT("Empty payload"));
+		return false;
+	}
+	return true;
+}
 
 bool FUnixSocketMessageHeader::WrapAndSendPayload(const TArray<uint8>& Payload, FSocket* Socket)
 {
-	FUnixSocketMessageHeader Header(Payload);
+	return WrapAndSendPayload(Payload, NoTail, Socket);
+}
 
-	FBufferArchive Ar;
-	Ar << Header.Magic;
-	Ar << Header.PayloadSize;
-	Ar.Append(Payload);
+bool FUnixSocketMessageHeader::WrapAndSendPayload(const TArray<uint8>& Payload, const TArray<uint8>& Tail, FSocket* Socket)
+{
+	// FSocket has no gather send, join them
+	TArray<uint8> Ar;
+	FramePayload(Payload, Tail, Ar);
 
 	int32 TotalAmountSent = 0; // How many bytes have been sent
 	int32 AmountToSend = Ar.Num();
@@ -125,7 +155,7 @@ bool FUnixSocketMessageHeader::ReceivePayload(FArrayReader& OutPayload, FSocket*
 		UE_LOG(LogUnrealCV, Error, TEXT("Trying to read message from an unconnected socket."));
 	}
 	TArray<uint8> HeaderBytes;
-	int32 Size = sizeof(FUnixSocketMessageHeader);
+	int32 Size = (int32)LychSim::Core::FrameHeaderSize;
 	HeaderBytes.AddZeroed(Size);
 
 	if (!UnixSocketReceiveAll(Socket, HeaderBytes.GetData(), Size))
@@ -136,21 +166,9 @@ bool FUnixSocketMessageHeader::ReceivePayload(FArrayReader& OutPayload, FSocket*
 		return false;
 	}
 
-	FMemoryReader Reader(HeaderBytes);
-	uint32 Magic;
-	Reader << Magic;
-
-	if (Magic != FUnixSocketMessageHeader::DefaultMagic)
+	uint32 PayloadSize = 0;
+	if (!ReadPayloadSize(HeaderBytes, PayloadSize))
 	{
-		UE_LOG(LogUnrealCV, Error, TEXT("Bad network header magic"));
-		return false;
-	}
-
-	uint32 PayloadSize;
-	Reader << PayloadSize;
-	if (0 == PayloadSize)
-	{
-		UE_LOG(LogUnrealCV, Error, TEXT("Empty payload"));
 		return false;
 	}
 
@@ -169,25 +187,27 @@ bool FUnixSocketMessageHeader::ReceivePayload(FArrayReader& OutPayload, FSocket*
 
 bool FUnixSocketMessageHeader::WrapAndSendPayloadUDS(const TArray<uint8>& Payload, int fd)
 {
-	#if PLATFORM_LINUX
-	FUnixSocketMessageHeader Header(Payload);
-
-	FBufferArchive Ar;
-	Ar << Header.Magic;
-	Ar << Header.PayloadSize;
-	Ar.Append(Payload);
+	return WrapAndSendPayloadUDS(Payload, NoTail, fd);
+}
 
-	int32 AmountAlreadySent = 0; // How many bytes have been sent
-	int32 AmountToSend = Ar.Num();
-	int AmountActuallySent = 0;
+bool FUnixSocketMessageHeader::WrapAndSendPayloadUDS(const TArray<uint8>& Payload, const TArray<uint8>& Tail, int fd)
+{
+	#if PLATFORM_LINUX
+	// The header, the payload and the tail are written from where they are with writev
+	uint8 Header[LychSim::Core::FrameHeaderSize];
+	LychSim::Core::WriteFrameHeader(Header, Payload.Num() + Tail.Num());
+	iovec Parts[3] = {
+		{ Header, sizeof(Header) },
+		{ const_cast<uint8*>(Payload.GetData()), (size_t)Payload.Num() },
+		{ const_cast<uint8*>(Tail.GetData()), (size_t)Tail.Num() },
+	};
+	const int64 Total = sizeof(Header) + Payload.Num() + Tail.Num();
+	int64 AmountAlreadySent = 0; // How many bytes have been sent
+	int First = 0; // The first part not sent completely
 	int NumTrial = 1000; // Only try a limited amount of times
-	while (AmountToSend > 0)
+	while (AmountAlreadySent < Total)
 	{
-		
-		// GetData returns a uint8 pointer
-		AmountActuallySent = write(fd, Ar.GetData() + AmountAlreadySent, AmountToSend);
-
-		//Socket->Send(Ar.GetData() + TotalAmountSent, Ar.Num() - TotalAmountSent, AmountSent);
+		const ssize_t AmountActuallySent = writev(fd, Parts + First, 3 - First);
 		NumTrial--;
 
 		if (AmountActuallySent == -1)
@@ -198,16 +218,25 @@ bool FUnixSocketMessageHeader::WrapAndSendPayloadUDS(const TArray<uint8>& Payloa
 		}
 		if (NumTrial < 0)
 		{
-			UE_LOG(LogUnrealCV, Error, TEXT("Unable to send(try 1000 times). Expect to send %d, sent %d"), Ar.Num(), AmountAlreadySent);
+			UE_LOG(LogUnrealCV, Error, TEXT("Unable to send(try 1000 times). Expect to send %lld, sent %lld"), Total, AmountAlreadySent);
 			close(fd);
 			return false;
 		}
 
-		UE_LOG(LogUnrealCV, Verbose, TEXT("Already sent bytes %d/%d, new send %d"), AmountAlreadySent, Ar.Num(), AmountActuallySent);
-		AmountToSend -= AmountActuallySent;
+		UE_LOG(LogUnrealCV, Verbose, TEXT("Already sent bytes %lld/%lld, new send %lld"), AmountAlreadySent, Total, (int64)AmountActuallySent);
 		AmountAlreadySent += AmountActuallySent;
+		size_t Left = (size_t)AmountActuallySent;
+		while (First < 3 && Left >= Parts[First].iov_len)
+		{
+			Left -= Parts[First].iov_len;
+			First++;
+		}
+		if (First < 3)
+		{
+			Parts[First].iov_base = static_cast<uint8*>(Parts[First].iov_base) + Left;
+			Parts[First].iov_len -= Left;
+		}
 	}
-	check(AmountToSend == 0);
 	#endif // PLATFORM_LINUX
 	return true;
 }
@@ -306,7 +335,7 @@ bool FUnixSocketMessageHeader::ReceivePayloadUDS(FArrayReader& OutPayload, int f
 
 
 	TArray<uint8> HeaderBytes;
-	int32 Size = sizeof(FUnixSocketMessageHeader);
+	int32 Size = (int32)LychSim::Core::FrameHeaderSize;
 	HeaderBytes.AddZeroed(Size);
 
 	if (!UnixSocketReceiveAllUDS(fd, HeaderBytes.GetData(), Size))
@@ -317,21 +346,9 @@ bool FUnixSocketMessageHeader::ReceivePayloadUDS(FArrayReader& OutPayload, int f
 		return false;
 	}
 
-	FMemoryReader Reader(HeaderBytes);
-	uint32 Magic;
-	Reader << Magic;
-
-	if (Magic != FUnixSocketMessageHeader::DefaultMagic)
+	uint32 PayloadSize = 0;
+	if (!ReadPayloadSize(HeaderBytes, PayloadSize))
 	{
-		UE_LOG(LogUnrealCV, Error, TEXT("Bad network header magic"));
-		return false;
-	}
-
-	uint32 PayloadSize;
-	Reader << PayloadSize;
-	if (0 == PayloadSize)
-	{
-		UE_LOG(LogUnrealCV, Error, TEXT("Empty payload"));
 		return false;
 	}
 
@@ -620,6 +637,7 @@ bool UUnixTcpServer::StartMessageServiceUDS()
 				break;
 			}
 
+			LYCHSIM_TRACE_SCOPE("NetReceive");
 			FString Message = UnixStringFromBinaryArray(ArrayReader);
 
 			/*TSharedRef<FInternetAddr> EndpointAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
@@ -692,6 +710,7 @@ bool UUnixTcpServer::StartMessageServiceINet(FSocket* ClientSocket, const FIPv4E
 			return false; // false will release the ClientSocket
 		}
 
+		LYCHSIM_TRACE_SCOPE("NetReceive");
 		FString Message = UnixStringFromBinaryArray(ArrayReader);
 
 		TSharedRef<FInternetAddr> EndpointAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
@@ -796,18 +815,23 @@ bool UUnixTcpServer::SendMessage(const FString& Message)
 }
 
 bool UUnixTcpServer::SendData(const TArray<uint8>& Payload)
+{
+	return SendData(Payload, NoTail);
+}
+
+bool UUnixTcpServer::SendData(const TArray<uint8>& Payload, const TArray<uint8>& Tail)
 {
 #if PLATFORM_LINUX
 	if (bIsUDS)
 	{
-		return SendDataUDS(Payload);
+		return SendDataUDS(Payload, Tail);
 	}
 	else
 	{
-		return SendDataINet(Payload);
+		return SendDataINet(Payload, Tail);
 	}
 #else
-	return SendDataINet(Payload);
+	return SendDataINet(Payload, Tail);
 #endif
 }
 
@@ -825,12 +849,12 @@ bool UUnixTcpServer::SendMessageINet(const FString& Message)
 	return false;
 }
 
-bool UUnixTcpServer::SendDataINet(const TArray<uint8>& Payload)
+bool UUnixTcpServer::SendDataINet(const TArray<uint8>& Payload, const TArray<uint8>& Tail)
 {
 	if (ConnectionSocket)
 	{
-		UE_LOG(LogUnrealCV, Verbose, TEXT("Send binary payload with size %d"), Payload.Num());
-		FUnixSocketMessageHeader::WrapAndSendPayload(Payload, ConnectionSocket);
+		UE_LOG(LogUnrealCV, Verbose, TEXT("Send binary payload with size %d"), Payload.Num() + Tail.Num());
+		FUnixSocketMessageHeader::WrapAndSendPayload(Payload, Tail, ConnectionSocket);
 		UE_LOG(LogUnrealCV, Verbose, TEXT("Payload sent"), Payload.Num());
 		return true;
 	}
@@ -859,14 +883,14 @@ bool UUnixTcpServer::SendMessageUDS(const FString& Message)
 	return false;
 }
 
-bool UUnixTcpServer::SendDataUDS(const TArray<uint8>& Payload)
+bool UUnixTcpServer::SendDataUDS(const TArray<uint8>& Payload, const TArray<uint8>& Tail)
 {
 	// The interface between UnrealcvServer and TCPServer
 	// Send data get from unreal engine to the client who requests.
 	if (UDS_connfd != -1)
 	{
-		UE_LOG(LogUnrealCV, Verbose, TEXT("Send binary payload with size %d"), Payload.Num());
-		if (FUnixSocketMessageHeader::WrapAndSendPayloadUDS(Payload, UDS_connfd))
+		UE_LOG(LogUnrealCV, Verbose, TEXT("Send binary payload with size %d"), Payload.Num() + Tail.Num());
+		if (FUnixSocketMessageHeader::WrapAndSendPayloadUDS(Payload, Tail, UDS_connfd))
 		{
 			UE_LOG(LogUnrealCV, Verbose, TEXT("Payload sent"));
 			return true;
@@ -16,11 +16,16 @@
 #include "WorldController.h"
 #include "UnrealcvLog.h"
 #include "UnrealcvStats.h"
+#include "Utils/RequestLog.h"
+#include "Utils/RequestRecorder.h"
+#include "Utils/RequestStats.h"
+#include "Utils/Trace.h"
 #include "Commands/LychSimObjectHandler.h"
 #include "Commands/LychSimDataHandler.h"
 #include "Commands/LychSimUtilsHandler.h"
 #include "Commands/SegmentationHandler.h"
 #include "Commands/LychSimCameraHandler.h"
+#include "Commands/LychSimSimHandler.h"
 
 DECLARE_CYCLE_STAT(TEXT("FUnrealcvServer::Tick"), STAT_Tick, STATGROUP_UnrealCV);
 DECLARE_CYCLE_STAT(TEXT("FUnrealcvServer::ProcessRequest"), STAT_ProcessRequest, STATGROUP_UnrealCV);
@@ -31,6 +36,7 @@ void FUnrealcvServer::Tick(float DeltaTime)
 	// Spawn a AUnrealcvWorldController, which is responsible for modifying the world to add UnrealCV functions.
 	// TODO: Check whether stopping the game will reset this ptr?
 	SCOPE_CYCLE_COUNTER(STAT_Tick);
+	LYCHSIM_TRACE_SCOPE("FUnrealcvServer::Tick");
 	InitWorldController();
 	ProcessPendingRequest();
 }
@@ -117,6 +123,7 @@ void FUnrealcvServer::RegisterCommandHandlers()
 	CommandHandlers.Add(new FLychSimUtilsHandler());
 	CommandHandlers.Add(new FLychSimCameraHandler());
 	CommandHandlers.Add(new FSegmentationHandler());
+	CommandHandlers.Add(new FLychSimSimHandler());
 	for (FCommandHandler* Handler : CommandHandlers)
 	{
 		Handler->CommandDispatcher = CommandDispatcher;
@@ -292,23 +299,150 @@ bool FUnrealcvServer::InitWorld()
 void FUnrealcvServer::ProcessRequest(FRequest& Request)
 {
 	SCOPE_CYCLE_COUNTER(STAT_ProcessRequest);
-	FExecStatus ExecStatus = CommandDispatcher->Exec(Request.Message);
+	Request.ExecStartTime = FPlatformTime::Seconds();
+	FExecStatus ExecStatus = FExecStatus::OK();
+	{
+		LYCHSIM_TRACE_SCOPE_REQUEST("FCommandDispatcher::Exec", Request.RequestId);
+		ExecStatus = CommandDispatcher->Exec(Request.Message, &Request.ExecInfo);
+	}
+	Request.ExecEndTime = FPlatformTime::Seconds();
+	LychSim::FRequestStats::Get().Record(Request.ExecInfo.Command, LychSim::ERequestStage::QueueWait, Request.ExecStartTime - Request.ReceiveTime);
 
 	// This can be removed for better performance
 	//UE_LOG(LogUnrealCV, Warning, TEXT("Response: %s"), *ExecStatus.GetMessage());
-	UE_LOG(LogUnrealCV, Warning, TEXT("Response id: %d"), Request.RequestId);
+	if (ExecStatus == FExecStatusType::Pending)
+	{
+		// Reply in a later tick, once the promise is fulfilled
+		InFlightRequest = Request;
+		InFlightPromise = ExecStatus.GetPromise();
+		return;
+	}
+	SendReply(Request, ExecStatus);
+}
 
-	FString Header = FString::Printf(TEXT("%d:"), Request.RequestId);
+void FUnrealcvServer::SendReply(const FRequest& Request, const FExecStatus& ExecStatus)
+{
+	const double StartTime = FPlatformTime::Seconds();
 	TArray<uint8> ReplyData;
-	FExecStatus::BinaryArrayFromString(Header, ReplyData);
+	int32 HeaderSize = 0;
+	// A binary body is sent after the id and its header as it is, without copying it into ReplyData
+	const TArray<uint8>& Body = ExecStatus.GetBinaryData();
+	{
+		LYCHSIM_TRACE_SCOPE_REQUEST("SerializeReply", Request.RequestId);
+		FString Header = FString::Printf(TEXT("%d:"), Request.RequestId);
+		FExecStatus::BinaryArrayFromString(Header, ReplyData);
+		HeaderSize = ReplyData.Num();
+		if (Body.Num() != 0)
+		{
+			ReplyData += ExecStatus.GetBinaryHeader();
+		}
+		else
+		{
+			ReplyData += ExecStatus.GetData();
+		}
+	}
+	const double SerializeEndTime = FPlatformTime::Seconds();
+	{
+		LYCHSIM_TRACE_SCOPE_REQUEST("SendReply", Request.RequestId);
+		TcpServer->SendData(ReplyData, Body);
+	}
+	const int32 ReplySize = ReplyData.Num() + Body.Num();
+
+	LychSim::FCommandStats& Stats = LychSim::FRequestStats::Get().FindOrAdd(Request.ExecInfo.Command);
+	Stats.Stages[(int32)LychSim::ERequestStage::Dispatch].Record((uint64)(Request.ExecInfo.DispatchSeconds * 1e6));
+	Stats.Stages[(int32)LychSim::ERequestStage::Handler].Record((uint64)(Request.ExecInfo.HandlerSeconds * 1e6));
+	Stats.Stages[(int32)LychSim::ERequestStage::Serialize].Record((uint64)((SerializeEndTime - StartTime) * 1e6));
+	Stats.Stages[(int32)LychSim::ERequestStage::Send].Record((uint64)((FPlatformTime::Seconds() - SerializeEndTime) * 1e6));
+	Stats.BytesIn.Record(Request.Message.Len());
+	Stats.BytesOut.Record(ReplySize);
+
+	LychSim::FRequestLogEntry LogEntry;
+	LogEntry.RequestId = Request.RequestId;
+	LogEntry.ReceiveTime = Request.ReceiveTime;
+	LogEntry.Command = &Request.ExecInfo.Command;
+	LogEntry.Message = &Request.Message;
+	FString ErrorMessage;
+	if (ExecStatus == FExecStatusType::ErrorMsg)
+	{
+		ErrorMessage = ExecStatus.GetMessage();
+		LogEntry.Error = &ErrorMessage;
+	}
+	if (Request.ExecStartTime > 0)
+	{
+		LogEntry.StageSeconds[(int32)LychSim::ERequestStage::QueueWait] = Request.ExecStartTime - Request.ReceiveTime;
+	}
+	LogEntry.StageSeconds[(int32)LychSim::ERequestStage::Dispatch] = Request.ExecInfo.DispatchSeconds;
+	LogEntry.StageSeconds[(int32)LychSim::ERequestStage::Handler] = Request.ExecInfo.HandlerSeconds;
+	LogEntry.StageSeconds[(int32)LychSim::ERequestStage::Serialize] = SerializeEndTime - StartTime;
+	LogEntry.StageSeconds[(int32)LychSim::ERequestStage::Send] = FPlatformTime::Seconds() - SerializeEndTime;
+	LogEntry.BytesIn = Request.Message.Len();
+	LogEntry.BytesOut = ReplySize;
+	LychSim::FRequestLog::Get().Add(LogEntry);
+
+	LychSim::FRequestRecorder& Recorder = LychSim::FRequestRecorder::Get();
+	if (Recorder.IsRecording())
+	{
+		LychSim::FRecordedRequest Recorded;
+		Recorded.ReceiveTime = Request.ReceiveTime;
+		Recorded.RequestId = Request.RequestId;
+		Recorded.Endpoint = &Request.Endpoint;
+		Recorded.Command = &Request.ExecInfo.Command;
+		Recorded.Message = &Request.Message;
+		Recorded.bError = LogEntry.Error != nullptr;
+		// The checksum is over the whole reply, join it only when recording
+		if (Body.Num() != 0)
+		{
+			ReplyData += Body;
+		}
+		Recorded.Reply = ReplyData.GetData() + HeaderSize;
+		Recorded.ReplySize = ReplyData.Num() - HeaderSize;
+		Recorded.LatencySeconds = FPlatformTime::Seconds() - Request.ReceiveTime;
+		Recorder.Add(Recorded);
+	}
+}
 
-	ReplyData += ExecStatus.GetData();
-	TcpServer->SendData(ReplyData);
+bool FUnrealcvServer::ProcessInFlightRequest()
+{
+	if (!InFlightPromise.bIsValid)
+	{
+		return true;
+	}
+	FExecStatus ExecStatus = InFlightPromise.CheckStatus();
+	if (ExecStatus == FExecStatusType::Pending)
+	{
+		return false;
+	}
+	InFlightPromise = FPromise();
+	InFlightRequest.ExecInfo.HandlerSeconds += FPlatformTime::Seconds() - InFlightRequest.ExecEndTime;
+	SendReply(InFlightRequest, ExecStatus);
+	return true;
+}
+
+bool FUnrealcvServer::ProcessReadyRequests()
+{
+	while (ReadyRequests.Num() > 0)
+	{
+		FRequest RequestToRun = ReadyRequests[0];
+		ReadyRequests.RemoveAt(0);
+		ProcessRequest(RequestToRun);
+		if (InFlightPromise.bIsValid)
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 // Each tick of GameThread.
 void FUnrealcvServer::ProcessPendingRequest()
 {
+	LYCHSIM_TRACE_SCOPE("ProcessPendingRequest");
+	// Commands run in the order they are received, so nothing runs while an async command is in flight
+	if (!ProcessInFlightRequest() || !ProcessReadyRequests())
+	{
+		return;
+	}
+
 	// Process all requests collected in this frame
 	while (!PendingRequest.IsEmpty())
 	{
@@ -331,11 +465,8 @@ void FUnrealcvServer::ProcessPendingRequest()
 			{
 				UE_LOG(LogUnrealCV, Warning, TEXT("Can not handle batch smaller than 1"));
 			}
-			FString Header = FString::Printf(TEXT("%d:"), Request.RequestId);
-			TArray<uint8> ReplyData;
-			FExecStatus::BinaryArrayFromString(Header, ReplyData);
-			ReplyData += FExecStatus::OK().GetData();
-			TcpServer->SendData(ReplyData); // return a fake ok for vbatch
+			Request.ExecInfo.Command = TEXT("vbatch");
+			SendReply(Request, FExecStatus::OK()); // return a fake ok for vbatch
 			continue;
 		}
 		else
@@ -354,11 +485,12 @@ void FUnrealcvServer::ProcessPendingRequest()
 		if (BatchNum == 0) // The batch is ready
 		{
 			// Otherwise hold the batch request until all commands are received.
-			for (FRequest RequestToRun : Batch)
+			ReadyRequests = MoveTemp(Batch);
+			Batch.Empty();
+			if (!ProcessReadyRequests())
 			{
-				ProcessRequest(RequestToRun);
+				return;
 			}
-			Batch.Empty();
 		}
 	}
 }
@@ -366,7 +498,6 @@ void FUnrealcvServer::ProcessPendingRequest()
 /** Message handler for server */
 void FUnrealcvServer::HandleRawMessage(const FString& Endpoint, const FString& InRawMessage)
 {
-	UE_LOG(LogUnrealCV, Warning, TEXT("Request: %s"), *InRawMessage);
 	// Parse Raw Message
 	// FString MessageFormat = "(\\d{1,}):(.*)";
 	// TODO: 8 digits might not be enough if running for a very long time.
@@ -382,6 +513,7 @@ void FUnrealcvServer::HandleRawMessage(const FString& Endpoint, const FString& I
 		FString Message = Matcher.GetCaptureGroup(2);
 
 		uint32 RequestId = FCString::Atoi(*StrRequestId);
+		LYCHSIM_TRACE_SCOPE_REQUEST("HandleRawMessage", RequestId);
 		FRequest Request(Endpoint, Message, RequestId);
 		this->PendingRequest.Enqueue(Request);
 	}
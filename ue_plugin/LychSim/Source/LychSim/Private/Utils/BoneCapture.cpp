@@ -0,0 +1,138 @@
+#include "Utils/BoneCapture.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "Runtime/Engine/Classes/Engine/SkeletalMesh.h"
+#include "Runtime/Engine/Classes/Components/SkeletalMeshComponent.h"
+#include "GameFramework/Actor.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::CaptureBones"), STAT_CaptureBones, STATGROUP_UnrealCV);
+
+void LychSim::CaptureBones(const TArray<AActor*>& Actors, bool bWorldSpace, FBoneCapture& Out)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CaptureBones);
+
+	Out = FBoneCapture();
+	TArray<USkeletalMeshComponent*> Components;
+	TMap<const USkeletalMesh*, uint32> SkeletonIndices;
+	uint32 NumBones = 0;
+
+	for (AActor* Actor : Actors)
+	{
+		if (!IsValid(Actor)) continue;
+		// Same component as ReadJointInfo in DataCaptureActor.cpp
+		USkeletalMeshComponent* Component = Actor->FindComponentByClass<USkeletalMeshComponent>();
+		if (!IsValid(Component)) continue;
+		const USkeletalMesh* SkeletalMesh = Component->GetSkeletalMeshAsset();
+		if (!SkeletalMesh) continue;
+
+		// Every bone of the reference skeleton, so the layout does not change with the LOD
+		const uint32 Count = Component->GetComponentSpaceTransforms().Num();
+		if (Count == 0) continue;
+
+		uint32* SkeletonIndex = SkeletonIndices.Find(SkeletalMesh);
+		if (!SkeletonIndex)
+		{
+			SkeletonIndex = &SkeletonIndices.Add(SkeletalMesh, Out.SkeletonPaths.Num());
+			Out.SkeletonPaths.Add(SkeletalMesh->GetPathName());
+			TArray<FString>& BoneNames = Out.SkeletonBoneNames.AddDefaulted_GetRef();
+			const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+			for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); BoneIndex++)
+			{
+				BoneNames.Add(RefSkeleton.GetBoneName(BoneIndex).ToString());
+			}
+		}
+
+		Components.Add(Component);
+		Out.ActorNames.Add(Actor->GetName());
+		Out.Offsets.Add(NumBones);
+		Out.Counts.Add(Count);
+		Out.Skeletons.Add(*SkeletonIndex);
+		NumBones += Count;
+	}
+
+	Out.Transforms.SetNumUninitialized(NumBones * 12);
+	Out.Valid.SetNumZeroed(NumBones);
+
+	// The game thread waits here, so the pose buffers are not swapped while workers read them
+	ParallelFor(Components.Num(), [&](int32 ComponentIndex)
+	{
+		USkeletalMeshComponent* Component = Components[ComponentIndex];
+		const auto& ComponentSpaceTransforms = Component->GetComponentSpaceTransforms();
+		const FTransform& ComponentToWorld = Component->GetComponentToWorld();
+		float* Dst = Out.Transforms.GetData() + Out.Offsets[ComponentIndex] * 12;
+
+		// Only the required bones are evaluated, the others keep the pose of the last LOD that had them
+		uint8* Valid = Out.Valid.GetData() + Out.Offsets[ComponentIndex];
+		for (FBoneIndexType BoneIndex : Component->RequiredBones)
+		{
+			if (BoneIndex < Out.Counts[ComponentIndex])
+			{
+				Valid[BoneIndex] = 1;
+			}
+		}
+
+		for (uint32 BoneIndex = 0; BoneIndex < Out.Counts[ComponentIndex]; BoneIndex++)
+		{
+			const FTransform Transform = bWorldSpace
+				? ComponentSpaceTransforms[BoneIndex] * ComponentToWorld
+				: ComponentSpaceTransforms[BoneIndex];
+			// FMatrix transforms row vectors, write it transposed as [R | t] for column vectors
+			const FMatrix Matrix = Transform.ToMatrixWithScale();
+			for (int32 Row = 0; Row < 3; Row++)
+			{
+				for (int32 Col = 0; Col < 4; Col++)
+				{
+					*Dst++ = (float)Matrix.M[Col][Row];
+				}
+			}
+		}
+	});
+}
+
+TArray<uint8> LychSim::SerializeBoneCapture(const FBoneCapture& Capture, bool bWorldSpace, bool bBoneNames)
+{
+	auto WriteString = [](FBufferArchive& Ar, const FString& Str)
+	{
+		FTCHARToUTF8 Utf8(*Str);
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	};
+
+	FBufferArchive Ar;
+	uint32 Magic = 0x4E4F424C; // 'LBON'
+	uint16 Version = 2;
+	uint16 Flags = (bWorldSpace ? 1 : 0) | (bBoneNames ? 2 : 0);
+	uint32 NumActors = Capture.ActorNames.Num();
+	uint32 NumSkeletons = Capture.SkeletonPaths.Num();
+	uint32 NumBones = Capture.Transforms.Num() / 12;
+	Ar << Magic << Version << Flags << NumActors << NumSkeletons << NumBones;
+	for (uint32 i = 0; i < NumActors; i++)
+	{
+		uint32 Offset = Capture.Offsets[i], Count = Capture.Counts[i], Skeleton = Capture.Skeletons[i];
+		Ar << Offset << Count << Skeleton;
+	}
+	Ar.Serialize((void*)Capture.Transforms.GetData(), Capture.Transforms.Num() * sizeof(float));
+	Ar.Serialize((void*)Capture.Valid.GetData(), Capture.Valid.Num());
+
+	for (uint32 i = 0; i < NumSkeletons; i++)
+	{
+		WriteString(Ar, Capture.SkeletonPaths[i]);
+		uint32 NumNames = bBoneNames ? Capture.SkeletonBoneNames[i].Num() : 0;
+		Ar << NumNames;
+		if (bBoneNames)
+		{
+			for (const FString& BoneName : Capture.SkeletonBoneNames[i])
+			{
+				WriteString(Ar, BoneName);
+			}
+		}
+	}
+	for (const FString& Name : Capture.ActorNames)
+	{
+		WriteString(Ar, Name);
+	}
+	return MoveTemp(Ar);
+}
@@ -1,10 +1,52 @@
 #include "Utils/DataUtil.h"
 
 #include "ImageUtil.h"
+#include "LychCore/RawTensor.h"
 #include "Serialization.h"
+#include "Utils/FileWriter.h"
+#include "Utils/Trace.h"
 
 using namespace LychSim;
 
+namespace
+{
+	/** Queue the file on the writer threads, "lych data flush" waits until it is on the disk */
+	FExecStatus WriteFile(FFrameBuffer&& Frame, int Width, int Height, const FString& Filename)
+	{
+		Frame.Width = Width;
+		Frame.Height = Height;
+		FFileWriter::Get().Write(Filename, FPaths::GetExtension(Filename).ToLower(), MoveTemp(Frame));
+		return FExecStatus::OK(Filename);
+	}
+
+	/** The raw header and the pixels as they were read back, the header is sent separately */
+	template<typename T>
+	FExecStatus RawReply(const TArray<T>& Data, int Width, int Height, int Channel, LychSim::Core::ERawDType DType,
+		const char* ChannelOrder, const FRawFrameInfo* FrameInfo)
+	{
+		LychSim::Core::FRawTensorHeader Header = LychSim::Core::MakeRawImageHeader(DType, Width, Height, Channel, ChannelOrder);
+		if (FrameInfo)
+		{
+			Header.FrameId = FrameInfo->FrameId;
+			Header.Location[0] = FrameInfo->Location.X;
+			Header.Location[1] = FrameInfo->Location.Y;
+			Header.Location[2] = FrameInfo->Location.Z;
+			Header.Rotation[0] = FrameInfo->Rotation.Pitch;
+			Header.Rotation[1] = FrameInfo->Rotation.Yaw;
+			Header.Rotation[2] = FrameInfo->Rotation.Roll;
+			Header.Fov = FrameInfo->Fov;
+		}
+		TArray<uint8> HeaderBytes;
+		HeaderBytes.SetNumUninitialized(LychSim::Core::RawTensorHeaderSize);
+		LychSim::Core::WriteRawTensorHeader(HeaderBytes.GetData(), Header);
+
+		TArray<uint8> Pixels;
+		Pixels.SetNumUninitialized(Data.Num() * sizeof(T));
+		FMemory::Memcpy(Pixels.GetData(), Data.GetData(), Pixels.Num());
+		return FExecStatus::Binary(MoveTemp(HeaderBytes), MoveTemp(Pixels));
+	}
+}
+
 EFilenameType LychSim::ParseFilenameType(const FString& Filename)
 {
 	bool bIncludeDot = false;
@@ -20,6 +62,7 @@ EFilenameType LychSim::ParseFilenameType(const FString& Filename)
 		if (FileExtension == TEXT("png")) return EFilenameType::PngBinary;
 		if (FileExtension == TEXT("bmp")) return EFilenameType::BmpBinary;
 		if (FileExtension == TEXT("npy")) return EFilenameType::NpyBinary;
+		if (FileExtension == TEXT("raw")) return EFilenameType::RawBinary;
 	}
 	else
 	{
@@ -31,8 +74,9 @@ EFilenameType LychSim::ParseFilenameType(const FString& Filename)
 	return EFilenameType::Invalid;
 }
 
-FExecStatus LychSim::SerializeData(const TArray<FColor>& Data, int Width, int Height, const FString& Filename)
+FExecStatus LychSim::SerializeData(const TArray<FColor>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo)
 {
+	LYCHSIM_TRACE_SCOPE("Encode");
 	static FImageUtil ImageUtil;
 	EFilenameType FilenameType = ParseFilenameType(Filename);
 
@@ -41,23 +85,30 @@ FExecStatus LychSim::SerializeData(const TArray<FColor>& Data, int Width, int He
 	{
 	case EFilenameType::BmpBinary:
 		ImageUtil.ConvertToBmp(Data, Width, Height, BinaryData);
-		return FExecStatus::Binary(BinaryData);
-	case EFilenameType::Bmp:
-		ImageUtil.SaveBmpFile(Data, Width, Height, Filename);
-		return FExecStatus::OK(Filename);
+		return FExecStatus::Binary(MoveTemp(BinaryData));
 	case EFilenameType::PngBinary:
 		ImageUtil.ConvertToPng(Data, Width, Height, BinaryData);
-		return FExecStatus::Binary(BinaryData);
+		return FExecStatus::Binary(MoveTemp(BinaryData));
+	case EFilenameType::NpyBinary:
+		// uint8 [Height, Width, 4], BGRA
+		BinaryData = FSerializationUtils::Image2Npy(Data, Width, Height, 4);
+		return FExecStatus::Binary(MoveTemp(BinaryData));
+	case EFilenameType::RawBinary:
+		return RawReply(Data, Width, Height, 4, Core::ERawDType::UInt8, "BGRA", FrameInfo);
+	case EFilenameType::Bmp:
 	case EFilenameType::Png:
-		ImageUtil.SavePngFile(Data, Width, Height, Filename);
-		return FExecStatus::OK(Filename);
+	{
+		FFrameBuffer Frame;
+		Frame.Colors = Data;
+		return WriteFile(MoveTemp(Frame), Width, Height, Filename);
+	}
 	}
 	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
 }
 
-FExecStatus LychSim::SerializeData(const TArray<FFloat16Color>& Data, int Width, int Height, const FString& Filename)
+FExecStatus LychSim::SerializeData(const TArray<FFloat16Color>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo)
 {
-	static FImageUtil ImageUtil;
+	LYCHSIM_TRACE_SCOPE("Encode");
 	EFilenameType FilenameType = ParseFilenameType(Filename);
 
 	TArray<uint8> BinaryData;
@@ -66,18 +117,23 @@ FExecStatus LychSim::SerializeData(const TArray<FFloat16Color>& Data, int Width,
 	{
 	case EFilenameType::NpyBinary:
 		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		return FExecStatus::Binary(BinaryData);
+		return FExecStatus::Binary(MoveTemp(BinaryData));
+	case EFilenameType::RawBinary:
+		return RawReply(Data, Width, Height, 4, Core::ERawDType::Float16, "RGBA", FrameInfo);
 	case EFilenameType::Npy:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		ImageUtil.SaveFile(BinaryData, Filename);
-		return FExecStatus::OK(Filename);
+	case EFilenameType::Exr:
+	{
+		FFrameBuffer Frame;
+		Frame.HalfColors = Data;
+		return WriteFile(MoveTemp(Frame), Width, Height, Filename);
+	}
 	}
 	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
 }
 
-FExecStatus LychSim::SerializeData(const TArray<float>& Data, int Width, int Height, const FString& Filename)
+FExecStatus LychSim::SerializeData(const TArray<float>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo)
 {
-	static FImageUtil ImageUtil;
+	LYCHSIM_TRACE_SCOPE("Encode");
 	EFilenameType FilenameType = ParseFilenameType(Filename);
 
 	TArray<uint8> BinaryData;
@@ -86,11 +142,16 @@ FExecStatus LychSim::SerializeData(const TArray<float>& Data, int Width, int Hei
 	{
 	case EFilenameType::NpyBinary:
 		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		return FExecStatus::Binary(BinaryData);
+		return FExecStatus::Binary(MoveTemp(BinaryData));
+	case EFilenameType::RawBinary:
+		return RawReply(Data, Width, Height, Channel, Core::ERawDType::Float32, Channel == 1 ? "D" : "XYZ", FrameInfo);
 	case EFilenameType::Npy:
-		BinaryData = FSerializationUtils::Array2Npy(Data, Width, Height, Channel);
-		ImageUtil.SaveFile(BinaryData, Filename);
-		return FExecStatus::OK(Filename);
+	case EFilenameType::Exr:
+	{
+		FFrameBuffer Frame;
+		Frame.Floats = Data;
+		return WriteFile(MoveTemp(Frame), Width, Height, Filename);
+	}
 	}
 	return FExecStatus::Error(FString::Printf(TEXT("Invalid filename type, filename %s"), *Filename));
 }
@@ -0,0 +1,315 @@
+#include "Utils/DatasetWriter.h"
+
+#include "Runtime/Core/Public/GenericPlatform/GenericPlatformFile.h"
+#include "Runtime/Core/Public/HAL/FileManager.h"
+#include "Runtime/Core/Public/HAL/PlatformFileManager.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+#include "Runtime/Core/Public/Misc/ScopeLock.h"
+#include "UnrealcvStats.h"
+#include "UnrealcvLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FDatasetWriter::AppendFrame"), STAT_DatasetWriterAppendFrame, STATGROUP_UnrealCV);
+
+namespace
+{
+	const int32 TarBlockSize = 512;
+
+	const int32 TarNameSize = 100;
+	const int32 TarPrefixOffset = 345;
+	const int32 TarPrefixSize = 155;
+
+	/**
+	 * Fill a ustar header, return false if the name does not fit.
+	 * A name longer than the name field is split at a '/' into the prefix field.
+	 */
+	bool MakeTarHeader(uint8 (&Header)[TarBlockSize], const FString& Name, int64 Size, int64 ModifiedTime)
+	{
+		FMemory::Memzero(Header, TarBlockSize);
+		FTCHARToUTF8 Utf8(*Name);
+		const ANSICHAR* Chars = Utf8.Get();
+		const int32 Length = Utf8.Length();
+		if (Length <= TarNameSize)
+		{
+			FMemory::Memcpy(Header, Chars, Length);
+		}
+		else
+		{
+			// Prefer the shortest prefix, so that the name field keeps as much as possible
+			int32 Split = INDEX_NONE;
+			for (int32 i = 0; i < Length && i <= TarPrefixSize; i++)
+			{
+				if (Chars[i] == '/' && Length - i - 1 <= TarNameSize)
+				{
+					Split = i;
+					break;
+				}
+			}
+			if (Split <= 0)
+			{
+				return false;
+			}
+			FMemory::Memcpy(Header + TarPrefixOffset, Chars, Split);
+			FMemory::Memcpy(Header, Chars + Split + 1, Length - Split - 1);
+		}
+
+		auto WriteOctal = [&Header](int32 Offset, int32 Digits, uint64 Value)
+		{
+			for (int32 i = Digits - 1; i >= 0; i--)
+			{
+				Header[Offset + i] = '0' + (Value & 7);
+				Value >>= 3;
+			}
+		};
+		WriteOctal(100, 7, 0644); // mode
+		WriteOctal(108, 7, 0);    // uid
+		WriteOctal(116, 7, 0);    // gid
+		WriteOctal(124, 11, Size);
+		WriteOctal(136, 11, ModifiedTime);
+		Header[156] = '0';        // Regular file
+		FMemory::Memcpy(Header + 257, "ustar", 6);
+		Header[263] = '0';
+		Header[264] = '0';
+
+		// The checksum is summed with its own field set to spaces
+		FMemory::Memset(Header + 148, ' ', 8);
+		uint32 Checksum = 0;
+		for (int32 i = 0; i < TarBlockSize; i++)
+		{
+			Checksum += Header[i];
+		}
+		WriteOctal(148, 6, Checksum);
+		Header[154] = 0;
+		return true;
+	}
+}
+
+LychSim::FDatasetWriter::FDatasetWriter(const FDatasetWriterOptions& InOptions)
+	: Options(InOptions)
+{
+	if (!Options.bTarShards)
+	{
+		return;
+	}
+	// Continue after the shards of a previous session, OpenWrite would truncate them
+	TArray<FString> ShardFiles;
+	IFileManager::Get().FindFiles(ShardFiles, *FPaths::Combine(Options.RootFolder, TEXT("shard-*.tar")), true, false);
+	for (const FString& ShardFile : ShardFiles)
+	{
+		const FString Number = FPaths::GetBaseFilename(ShardFile).RightChop(6);
+		if (!Number.IsEmpty() && Number.IsNumeric())
+		{
+			ShardIndex = FMath::Max(ShardIndex, FCString::Atoi(*Number) + 1);
+		}
+	}
+	if (ShardIndex > 0)
+	{
+		UE_LOG(LogUnrealCV, Log, TEXT("%s has %d shards, start from shard-%06d.tar"), *Options.RootFolder, ShardFiles.Num(), ShardIndex);
+	}
+}
+
+LychSim::FDatasetWriter::~FDatasetWriter()
+{
+	if (CurrentFrame.IsValid())
+	{
+		EndFrame();
+	}
+	// The queued records point to this writer
+	FFileWriter::Get().Flush();
+
+	FScopeLock ScopeLock(&ShardLock);
+	CloseShard();
+}
+
+void LychSim::FDatasetWriter::BeginFrame(int32 FrameNumber)
+{
+	if (CurrentFrame.IsValid())
+	{
+		EndFrame();
+	}
+	if (Options.bTarShards)
+	{
+		CurrentFrame = MakeShared<FFrame>();
+		CurrentFrame->FrameNumber = FrameNumber;
+	}
+}
+
+void LychSim::FDatasetWriter::EndFrame()
+{
+	TSharedPtr<FFrame> Frame = MoveTemp(CurrentFrame);
+	if (!Frame.IsValid())
+	{
+		return;
+	}
+
+	bool bReady;
+	{
+		FScopeLock ScopeLock(&FrameLock);
+		Frame->bEnded = true;
+		bReady = Frame->NumPending == 0;
+	}
+	// Otherwise the writer that encodes the last record appends the frame
+	if (bReady)
+	{
+		FFileWriter::Get().Enqueue([this, Frame]() { AppendFrame(*Frame); });
+	}
+}
+
+void LychSim::FDatasetWriter::AddPng(const FString& Name, TArray<FColor>&& Pixels, int32 Width, int32 Height, bool bKeepAlpha)
+{
+	FFrameBuffer Frame;
+	Frame.Colors = MoveTemp(Pixels);
+	Frame.Width = Width;
+	Frame.Height = Height;
+	Frame.bOpaque = !bKeepAlpha;
+	Add(Name, TEXT("png"), MoveTemp(Frame));
+}
+
+void LychSim::FDatasetWriter::AddNpy(const FString& Name, TArray<float>&& Data, int32 Width, int32 Height)
+{
+	FFrameBuffer Frame;
+	Frame.Floats = MoveTemp(Data);
+	Frame.Width = Width;
+	Frame.Height = Height;
+	Add(Name, TEXT("npy"), MoveTemp(Frame));
+}
+
+void LychSim::FDatasetWriter::AddText(const FString& Name, FString&& Text)
+{
+	FTCHARToUTF8 Utf8(*Text);
+	FFrameBuffer Frame;
+	Frame.Bytes.Append((const uint8*)Utf8.Get(), Utf8.Length());
+	Add(Name, TEXT("raw"), MoveTemp(Frame));
+}
+
+void LychSim::FDatasetWriter::Add(const FString& Name, const FString& Format, FFrameBuffer&& Frame)
+{
+	if (!Options.bTarShards)
+	{
+		FFileWriter::Get().Write(Name, Format, MoveTemp(Frame));
+		return;
+	}
+
+	TSharedPtr<FFrame> Sample = CurrentFrame;
+	if (!Sample.IsValid())
+	{
+		UE_LOG(LogUnrealCV, Warning, TEXT("%s is added outside of a frame, it is not saved"), *Name);
+		return;
+	}
+
+	int32 Slot;
+	{
+		FScopeLock ScopeLock(&FrameLock);
+		Slot = Sample->Names.Add(Name);
+		Sample->Members.AddDefaulted();
+		Sample->NumPending++;
+	}
+
+	FFileWriter::Get().Encode(Format, MoveTemp(Frame), [this, Sample, Slot](TArray<uint8>&& Bytes)
+	{
+		bool bReady;
+		{
+			FScopeLock ScopeLock(&FrameLock);
+			Sample->Members[Slot] = MoveTemp(Bytes);
+			Sample->NumPending--;
+			bReady = Sample->bEnded && Sample->NumPending == 0;
+		}
+		// The writer that encodes the last record of an ended frame appends it
+		if (bReady)
+		{
+			AppendFrame(*Sample);
+		}
+	});
+}
+
+void LychSim::FDatasetWriter::Flush()
+{
+	FFileWriter::Get().Flush();
+
+	FScopeLock ScopeLock(&ShardLock);
+	if (Shard)
+	{
+		Shard->Flush();
+	}
+}
+
+void LychSim::FDatasetWriter::AppendFrame(FFrame& Frame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DatasetWriterAppendFrame);
+
+	FScopeLock ScopeLock(&ShardLock);
+	if (!Shard)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*Options.RootFolder);
+		FString ShardFilename = FPaths::Combine(Options.RootFolder, FString::Printf(TEXT("shard-%06d.tar"), ShardIndex));
+		Shard = PlatformFile.OpenWrite(*ShardFilename);
+		if (!Shard)
+		{
+			UE_LOG(LogUnrealCV, Error, TEXT("Can not open shard %s, frame %d is lost"), *ShardFilename, Frame.FrameNumber);
+			FFileWriter::Get().AddFailure(ShardFilename);
+			return;
+		}
+	}
+
+	static const uint8 Padding[TarBlockSize] = { 0 };
+	const FString Key = FString::Printf(TEXT("%08d"), Frame.FrameNumber);
+	const int64 ModifiedTime = FDateTime::UtcNow().ToUnixTimestamp();
+	for (int32 i = 0; i < Frame.Names.Num(); i++)
+	{
+		const TArray<uint8>& Bytes = Frame.Members[i];
+		const FString MemberName = Key + TEXT(".") + Frame.Names[i];
+		uint8 Header[TarBlockSize];
+		if (Bytes.Num() == 0)
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("Can not save %s to the shard, it could not be encoded"), *MemberName);
+			FFileWriter::Get().AddFailure(MemberName);
+			continue;
+		}
+		if (!MakeTarHeader(Header, MemberName, Bytes.Num(), ModifiedTime))
+		{
+			UE_LOG(LogUnrealCV, Error, TEXT("Can not save %s to the shard, the name does not fit in a ustar header"), *MemberName);
+			FFileWriter::Get().AddFailure(MemberName);
+			continue;
+		}
+		const int32 PaddingSize = (TarBlockSize - Bytes.Num() % TarBlockSize) % TarBlockSize;
+		const int64 MemberStart = Shard->Tell();
+		if (!Shard->Write(Header, TarBlockSize) || !Shard->Write(Bytes.GetData(), Bytes.Num()) || !Shard->Write(Padding, PaddingSize))
+		{
+			// A partial member breaks every later member of the tar stream, so cut it off and end the shard here.
+			// The rest of the frame is lost, the next frame starts a new shard
+			UE_LOG(LogUnrealCV, Error, TEXT("Can not write %s to the shard, the shard is closed"), *MemberName);
+			for (int32 Lost = i; Lost < Frame.Names.Num(); Lost++)
+			{
+				FFileWriter::Get().AddFailure(Key + TEXT(".") + Frame.Names[Lost]);
+			}
+			if (!Shard->Seek(MemberStart) || !Shard->Truncate(MemberStart))
+			{
+				UE_LOG(LogUnrealCV, Error, TEXT("Can not cut off the partial member, the end of shard-%06d.tar is unreadable"), ShardIndex);
+			}
+			CloseShard();
+			break;
+		}
+		ShardBytes += TarBlockSize + Bytes.Num() + PaddingSize;
+	}
+	Frame.Members.Empty();
+
+	if (ShardBytes >= Options.MaxShardBytes)
+	{
+		CloseShard();
+	}
+}
+
+void LychSim::FDatasetWriter::CloseShard()
+{
+	if (!Shard)
+	{
+		return;
+	}
+	// A tar archive ends with two empty blocks
+	static const uint8 EndOfArchive[TarBlockSize * 2] = { 0 };
+	Shard->Write(EndOfArchive, sizeof(EndOfArchive));
+	delete Shard;
+	Shard = nullptr;
+	ShardIndex++;
+	ShardBytes = 0;
+}
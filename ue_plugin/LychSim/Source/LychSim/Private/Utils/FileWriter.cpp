@@ -0,0 +1,330 @@
+#include "Utils/FileWriter.h"
+
+#include "Runtime/Core/Public/Misc/FileHelper.h"
+#include "Runtime/Core/Public/Misc/ScopeLock.h"
+#include "Runtime/Core/Public/Modules/ModuleManager.h"
+#include "Runtime/ImageWrapper/Public/IImageWrapper.h"
+#include "Runtime/ImageWrapper/Public/IImageWrapperModule.h"
+#include "LychCore/Npy.h"
+#include "Utils/ImageUtil.h"
+#include "Utils/Serialization.h"
+#include "Utils/Trace.h"
+#include "Utils/WriterPool.h"
+#include "UnrealcvServer.h"
+#include "UnrealcvStats.h"
+#include "UnrealcvLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FFileWriter::Encode"), STAT_FileWriterEncode, STATGROUP_UnrealCV);
+DECLARE_CYCLE_STAT(TEXT("LychSim::FFileWriter::Write"), STAT_FileWriterWrite, STATGROUP_UnrealCV);
+
+using namespace LychSim;
+
+namespace
+{
+	/** Enough to tell which folder or format fails, the count covers the rest */
+	const int32 MaxFailedFilenames = 32;
+
+	void Append64(TArray<uint8>& OutBytes, const TArray64<uint8>& Compressed)
+	{
+		OutBytes.Append(Compressed.GetData(), (int32)Compressed.Num());
+	}
+
+	class FPngEncoder : public IFrameEncoder
+	{
+	public:
+		explicit FPngEncoder(IImageWrapperModule& InModule) : Module(InModule) {}
+
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const override
+		{
+			if (Frame.Colors.Num() == 0 || Frame.Colors.Num() != Frame.Width * Frame.Height) return false;
+			if (Frame.bOpaque)
+			{
+				for (FColor& Pixel : Frame.Colors)
+				{
+					Pixel.A = 255;
+				}
+			}
+			// A wrapper holds the image, so every call creates its own
+			TSharedPtr<IImageWrapper> ImageWrapper = Module.CreateImageWrapper(EImageFormat::PNG);
+			ImageWrapper->SetRaw(Frame.Colors.GetData(), Frame.Colors.GetAllocatedSize(), Frame.Width, Frame.Height, ERGBFormat::BGRA, 8);
+			Append64(OutBytes, ImageWrapper->GetCompressed());
+			return OutBytes.Num() > 0;
+		}
+
+	private:
+		IImageWrapperModule& Module;
+	};
+
+	class FExrEncoder : public IFrameEncoder
+	{
+	public:
+		explicit FExrEncoder(IImageWrapperModule& InModule) : Module(InModule) {}
+
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const override
+		{
+			const int32 NumPixels = Frame.Width * Frame.Height;
+			TSharedPtr<IImageWrapper> ImageWrapper = Module.CreateImageWrapper(EImageFormat::EXR);
+			if (Frame.HalfColors.Num() > 0 && Frame.HalfColors.Num() == NumPixels)
+			{
+				ImageWrapper->SetRaw(Frame.HalfColors.GetData(), Frame.HalfColors.GetAllocatedSize(), Frame.Width, Frame.Height, ERGBFormat::RGBAF, 16);
+			}
+			else if (Frame.Floats.Num() > 0 && Frame.Floats.Num() == NumPixels)
+			{
+				ImageWrapper->SetRaw(Frame.Floats.GetData(), Frame.Floats.GetAllocatedSize(), Frame.Width, Frame.Height, ERGBFormat::GrayF, 32);
+			}
+			else
+			{
+				return false;
+			}
+			Append64(OutBytes, ImageWrapper->GetCompressed());
+			return OutBytes.Num() > 0;
+		}
+
+	private:
+		IImageWrapperModule& Module;
+	};
+
+	class FBmpEncoder : public IFrameEncoder
+	{
+	public:
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const override
+		{
+			// ConvertToBmp does not touch the image wrappers of FImageUtil, so it can be shared
+			return ImageUtil.ConvertToBmp(Frame.Colors, Frame.Width, Frame.Height, OutBytes);
+		}
+
+	private:
+		mutable FImageUtil ImageUtil;
+	};
+
+	class FNpyEncoder : public IFrameEncoder
+	{
+	public:
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const override
+		{
+			const int32 NumPixels = Frame.Width * Frame.Height;
+			if (NumPixels == 0) return false;
+			if (Frame.Floats.Num() > 0)
+			{
+				OutBytes = FSerializationUtils::Array2Npy(Frame.Floats, Frame.Width, Frame.Height, Frame.Floats.Num() / NumPixels);
+			}
+			else if (Frame.HalfColors.Num() > 0)
+			{
+				OutBytes = FSerializationUtils::Array2Npy(Frame.HalfColors, Frame.Width, Frame.Height, Frame.HalfColors.Num() / NumPixels);
+			}
+			else if (Frame.Colors.Num() == NumPixels)
+			{
+				// uint8 [Height, Width, 3] in RGB order
+				const uint8* TypePointer = nullptr;
+				std::vector<char> NpyHeader = LychSim::Core::MakeNpyHeader(TypePointer, Frame.Width, Frame.Height, 3);
+				OutBytes.Reserve(NpyHeader.size() + NumPixels * 3);
+				OutBytes.Append(reinterpret_cast<const uint8*>(NpyHeader.data()), NpyHeader.size());
+				for (const FColor& Pixel : Frame.Colors)
+				{
+					OutBytes.Add(Pixel.R);
+					OutBytes.Add(Pixel.G);
+					OutBytes.Add(Pixel.B);
+				}
+			}
+			return OutBytes.Num() > 0;
+		}
+	};
+
+	class FRawEncoder : public IFrameEncoder
+	{
+	public:
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const override
+		{
+			if (Frame.Bytes.Num() > 0) OutBytes = MoveTemp(Frame.Bytes);
+			else if (Frame.Colors.Num() > 0) OutBytes.Append((const uint8*)Frame.Colors.GetData(), Frame.Colors.Num() * sizeof(FColor));
+			else if (Frame.HalfColors.Num() > 0) OutBytes.Append((const uint8*)Frame.HalfColors.GetData(), Frame.HalfColors.Num() * sizeof(FFloat16Color));
+			else if (Frame.Floats.Num() > 0) OutBytes.Append((const uint8*)Frame.Floats.GetData(), Frame.Floats.Num() * sizeof(float));
+			return OutBytes.Num() > 0;
+		}
+	};
+}
+
+namespace
+{
+	TUniquePtr<LychSim::FFileWriter> SharedFileWriter;
+}
+
+LychSim::FFileWriter& LychSim::FFileWriter::Get()
+{
+	if (!SharedFileWriter.IsValid())
+	{
+		const FServerConfig& Config = FUnrealcvServer::Get().Config;
+		SharedFileWriter = MakeUnique<FFileWriter>(Config.WriterThreads, (int64)Config.WriterQueueMB * 1024 * 1024);
+	}
+	return *SharedFileWriter;
+}
+
+void LychSim::FFileWriter::ReleaseShared()
+{
+	SharedFileWriter.Reset();
+}
+
+LychSim::FFileWriter::FFileWriter(int32 NumThreads, int64 InMaxQueuedBytes)
+	: MaxQueuedBytes(InMaxQueuedBytes)
+{
+	// Load on the game thread, the writer threads only create image wrappers from it
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	RegisterEncoder(TEXT("png"), MakeShared<FPngEncoder>(ImageWrapperModule));
+	RegisterEncoder(TEXT("exr"), MakeShared<FExrEncoder>(ImageWrapperModule));
+	RegisterEncoder(TEXT("bmp"), MakeShared<FBmpEncoder>());
+	RegisterEncoder(TEXT("npy"), MakeShared<FNpyEncoder>());
+	RegisterEncoder(TEXT("raw"), MakeShared<FRawEncoder>());
+
+	// The memory cap is what bounds the queue, the task limit only guards against tiny records
+	Pool = MakeUnique<FWriterPool>(TEXT("LychSimFileWriter"), NumThreads, 4096, MaxQueuedBytes);
+}
+
+LychSim::FFileWriter::~FFileWriter()
+{
+	Shutdown();
+}
+
+void LychSim::FFileWriter::RegisterEncoder(const FString& Format, TSharedRef<IFrameEncoder> Encoder)
+{
+	FScopeLock ScopeLock(&EncodersLock);
+	Encoders.Add(Format.ToLower(), Encoder);
+}
+
+bool LychSim::FFileWriter::HasEncoder(const FString& Format) const
+{
+	FScopeLock ScopeLock(&EncodersLock);
+	return Encoders.Contains(Format.ToLower());
+}
+
+bool LychSim::FFileWriter::EncodeFrame(const FString& Format, FFrameBuffer& Frame, TArray<uint8>& OutBytes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FileWriterEncode);
+	LYCHSIM_TRACE_SCOPE("Encode");
+
+	TSharedPtr<IFrameEncoder> Encoder;
+	{
+		FScopeLock ScopeLock(&EncodersLock);
+		if (const TSharedRef<IFrameEncoder>* Found = Encoders.Find(Format.ToLower()))
+		{
+			Encoder = *Found;
+		}
+	}
+	if (!Encoder.IsValid())
+	{
+		UE_LOG(LogUnrealCV, Warning, TEXT("No encoder for format %s"), *Format);
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const bool bEncoded = Encoder->Encode(Frame, OutBytes);
+	const double EncodeTime = FPlatformTime::Seconds() - StartTime;
+
+	FScopeLock ScopeLock(&StatsLock);
+	Stats.EncodeSeconds += EncodeTime;
+	return bEncoded;
+}
+
+void LychSim::FFileWriter::Write(const FString& Filename, const FString& Format, FFrameBuffer&& Frame)
+{
+	const int64 Bytes = Frame.GetAllocatedSize();
+	Enqueue([this, Filename, Format, Frame = MoveTemp(Frame)]() mutable
+	{
+		TArray<uint8> Encoded;
+		bool bWritten = false;
+		double WriteTime = 0;
+		if (EncodeFrame(Format, Frame, Encoded))
+		{
+			SCOPE_CYCLE_COUNTER(STAT_FileWriterWrite);
+			const double StartTime = FPlatformTime::Seconds();
+			bWritten = FFileHelper::SaveArrayToFile(Encoded, *Filename);
+			WriteTime = FPlatformTime::Seconds() - StartTime;
+		}
+		if (!bWritten)
+		{
+			UE_LOG(LogUnrealCV, Warning, TEXT("Can not save to file %s"), *Filename);
+			AddFailure(Filename);
+		}
+
+		FScopeLock ScopeLock(&StatsLock);
+		Stats.WriteSeconds += WriteTime;
+		Stats.NumWritten += bWritten ? 1 : 0;
+		Stats.BytesWritten += bWritten ? Encoded.Num() : 0;
+	}, Bytes);
+}
+
+void LychSim::FFileWriter::Encode(const FString& Format, FFrameBuffer&& Frame, TUniqueFunction<void(TArray<uint8>&&)>&& OnEncoded)
+{
+	const int64 Bytes = Frame.GetAllocatedSize();
+	Enqueue([this, Format, Frame = MoveTemp(Frame), OnEncoded = MoveTemp(OnEncoded)]() mutable
+	{
+		TArray<uint8> Encoded;
+		if (!EncodeFrame(Format, Frame, Encoded))
+		{
+			Encoded.Empty();
+		}
+		OnEncoded(MoveTemp(Encoded));
+	}, Bytes);
+}
+
+void LychSim::FFileWriter::Enqueue(TUniqueFunction<void()>&& Task, int64 Bytes)
+{
+	if (Pool.IsValid())
+	{
+		Pool->Enqueue(MoveTemp(Task), Bytes);
+	}
+	else
+	{
+		Task();
+	}
+}
+
+bool LychSim::FFileWriter::Flush(uint32 WaitTimeMs)
+{
+	return Pool.IsValid() ? Pool->Flush(WaitTimeMs) : true;
+}
+
+void LychSim::FFileWriter::Shutdown()
+{
+	// The pool finishes the queued tasks before its threads stop
+	Pool.Reset();
+}
+
+void LychSim::FFileWriter::AddFailure(const FString& Filename)
+{
+	FScopeLock ScopeLock(&StatsLock);
+	Stats.NumFailed++;
+	NumRecentFailures++;
+	if (RecentFailedFilenames.Num() < MaxFailedFilenames)
+	{
+		RecentFailedFilenames.Add(Filename);
+	}
+}
+
+int64 LychSim::FFileWriter::TakeFailures(TArray<FString>& OutFilenames)
+{
+	FScopeLock ScopeLock(&StatsLock);
+	OutFilenames = MoveTemp(RecentFailedFilenames);
+	RecentFailedFilenames.Reset();
+	const int64 NumFailures = NumRecentFailures;
+	NumRecentFailures = 0;
+	return NumFailures;
+}
+
+LychSim::FFileWriterStats LychSim::FFileWriter::GetStats() const
+{
+	FFileWriterStats Result;
+	{
+		FScopeLock ScopeLock(&StatsLock);
+		Result = Stats;
+	}
+	Result.QueuedFiles = Pool.IsValid() ? Pool->NumPending() : 0;
+	Result.QueuedBytes = Pool.IsValid() ? Pool->PendingBytes() : 0;
+	Result.MaxQueuedBytes = MaxQueuedBytes;
+	return Result;
+}
+
+void LychSim::FFileWriter::ResetStats()
+{
+	FScopeLock ScopeLock(&StatsLock);
+	Stats = FFileWriterStats();
+}
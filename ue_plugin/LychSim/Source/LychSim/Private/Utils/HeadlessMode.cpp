@@ -0,0 +1,163 @@
+#include "Utils/HeadlessMode.h"
+
+#include "Runtime/Engine/Classes/Engine/Engine.h"
+#include "Runtime/Engine/Classes/Engine/GameViewportClient.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Engine/Classes/GameFramework/HUD.h"
+#include "Runtime/Engine/Classes/GameFramework/PlayerController.h"
+#include "Runtime/Engine/Public/AudioDevice.h"
+#include "UnrealcvLog.h"
+
+#if WITH_EDITOR
+#include "Editor.h"
+#include "LevelEditorViewport.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "LychSimHeadlessMode"
+
+namespace
+{
+	void SetAudioMuted(UWorld* World, bool bMuted)
+	{
+		FAudioDeviceHandle AudioDevice = World->GetAudioDevice();
+		if (AudioDevice)
+		{
+			AudioDevice->SetDeviceMuted(bMuted);
+		}
+	}
+
+#if WITH_EDITOR
+	void SetEditorViewportsRealtime(bool bRealtime)
+	{
+		if (!GEditor)
+		{
+			return;
+		}
+		const FText SystemName = LOCTEXT("HeadlessMode", "LychSim headless mode");
+		for (FLevelEditorViewportClient* ViewportClient : GEditor->GetLevelViewportClients())
+		{
+			if (!ViewportClient)
+			{
+				continue;
+			}
+			if (bRealtime)
+			{
+				ViewportClient->RemoveRealtimeOverride(SystemName, false);
+			}
+			else
+			{
+				ViewportClient->AddRealtimeOverride(false, SystemName);
+			}
+		}
+	}
+#endif
+}
+
+LychSim::FHeadlessMode& LychSim::FHeadlessMode::Get()
+{
+	static FHeadlessMode HeadlessMode;
+	return HeadlessMode;
+}
+
+void LychSim::FHeadlessMode::Enable(UWorld* InWorld)
+{
+	if (!IsValid(InWorld))
+	{
+		return;
+	}
+	if (bEnabled)
+	{
+		if (World.Get() == InWorld)
+		{
+			return;
+		}
+		// A new PIE session, the settings of the old world are gone with it
+		Disable();
+	}
+	bEnabled = true;
+	World = InWorld;
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this, &FHeadlessMode::OnWorldCleanup);
+
+	if (UGameViewportClient* Viewport = InWorld->GetGameViewport())
+	{
+		bSavedDisableWorldRendering = Viewport->bDisableWorldRendering;
+		Viewport->bDisableWorldRendering = true;
+	}
+#if WITH_EDITOR
+	SetEditorViewportsRealtime(false);
+#endif
+
+	bSavedAllowAudioPlayback = InWorld->bAllowAudioPlayback;
+	InWorld->bAllowAudioPlayback = false;
+	SetAudioMuted(InWorld, true);
+
+	SavedShowHUD.Empty();
+	for (FConstPlayerControllerIterator It = InWorld->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		AHUD* HUD = IsValid(PlayerController) ? PlayerController->GetHUD() : nullptr;
+		if (IsValid(HUD))
+		{
+			SavedShowHUD.Emplace(HUD, HUD->bShowHUD);
+			HUD->bShowHUD = false;
+		}
+	}
+
+	if (GEngine)
+	{
+		bSavedOnScreenDebugMessages = GEngine->bEnableOnScreenDebugMessages;
+		GEngine->bEnableOnScreenDebugMessages = false;
+		GEngine->ClearOnScreenDebugMessages();
+	}
+	UE_LOG(LogUnrealCV, Display, TEXT("Headless mode is enabled, only camera sensors are rendered"));
+}
+
+void LychSim::FHeadlessMode::Disable()
+{
+	if (!bEnabled)
+	{
+		return;
+	}
+	bEnabled = false;
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	WorldCleanupHandle.Reset();
+
+	if (UWorld* OldWorld = World.Get())
+	{
+		if (UGameViewportClient* Viewport = OldWorld->GetGameViewport())
+		{
+			Viewport->bDisableWorldRendering = bSavedDisableWorldRendering;
+		}
+		OldWorld->bAllowAudioPlayback = bSavedAllowAudioPlayback;
+		SetAudioMuted(OldWorld, false);
+	}
+#if WITH_EDITOR
+	SetEditorViewportsRealtime(true);
+#endif
+
+	for (const TPair<TWeakObjectPtr<AHUD>, bool>& Saved : SavedShowHUD)
+	{
+		if (AHUD* HUD = Saved.Key.Get())
+		{
+			HUD->bShowHUD = Saved.Value;
+		}
+	}
+	SavedShowHUD.Empty();
+
+	if (GEngine)
+	{
+		GEngine->bEnableOnScreenDebugMessages = bSavedOnScreenDebugMessages;
+	}
+	World = nullptr;
+	UE_LOG(LogUnrealCV, Display, TEXT("Headless mode is disabled"));
+}
+
+void LychSim::FHeadlessMode::OnWorldCleanup(UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources)
+{
+	if (CleanedWorld == World.Get())
+	{
+		Disable();
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
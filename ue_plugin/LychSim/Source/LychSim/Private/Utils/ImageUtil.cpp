@@ -80,18 +80,21 @@ bool FImageUtil::ConvertToBmp(const TArray<FColor>& ImageData, int Width, int He
 	BitmapInfoHeader.biClrImportant = 0; // No color plate
 
 	FBufferArchive Writer;
+	const int32 NumBytes = Width * Height * 4;
+	Writer.Reserve(sizeof(FBitmapFileHeader) + sizeof(FBitmapInfoHeader) + sizeof(int32) + NumBytes);
 	Writer << BitmapFileHeader << BitmapInfoHeader;
 
-	TArray<uint8> Bytes;
-	Bytes.AddUninitialized(Width * Height * 4);
 	{
 		SCOPE_CYCLE_COUNTER(STAT_SerializeBmp);
 		// Writer << ImageData; // Slow
 		// ImageData.BulkSerialize(Writer); // Slow
-		FMemory::Memcpy(Bytes.GetData(), ImageData.GetData(), Bytes.Num());
-		Writer << Bytes;
+		// The count written before the pixels by Writer << TArray<uint8>, which clients skip
+		int32 Count = NumBytes;
+		Writer << Count;
+		const int32 Offset = Writer.AddUninitialized(NumBytes);
+		FMemory::Memcpy(Writer.GetData() + Offset, ImageData.GetData(), NumBytes);
 	}
-	BmpData = Writer;
+	BmpData = MoveTemp(Writer);
 	// Writer << BitmapInfoHeader;
 	// Writer << ImageData;
 
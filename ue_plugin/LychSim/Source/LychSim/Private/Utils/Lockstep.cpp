@@ -0,0 +1,153 @@
+#include "Utils/Lockstep.h"
+
+#include "Runtime/Core/Public/HAL/IConsoleManager.h"
+#include "Runtime/Core/Public/Misc/App.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
+#include "UnrealcvLog.h"
+
+namespace
+{
+	IConsoleVariable* GetMaxFPSVariable()
+	{
+		return IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"));
+	}
+}
+
+LychSim::FLockstep& LychSim::FLockstep::Get()
+{
+	static FLockstep Lockstep;
+	return Lockstep;
+}
+
+FExecStatus LychSim::FLockstep::Enable(UWorld* InWorld, float InDeltaTime)
+{
+	if (!IsValid(InWorld))
+	{
+		return FExecStatus::Error("Lockstep needs a game world");
+	}
+	if (InDeltaTime <= 0)
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Invalid delta time %f"), InDeltaTime));
+	}
+	if (IsEnabled() && World.Get() != InWorld)
+	{
+		Disable();
+	}
+
+	// Pause first, a world without a game mode can not be paused
+	if (!UGameplayStatics::SetGamePaused(InWorld, true))
+	{
+		return FExecStatus::Error("Can not pause the world, lockstep needs a game or PIE session");
+	}
+
+	if (!IsEnabled())
+	{
+		bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+		SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+		IConsoleVariable* MaxFPS = GetMaxFPSVariable();
+		SavedMaxFPS = MaxFPS ? MaxFPS->GetFloat() : 0;
+		if (MaxFPS)
+		{
+			// A fixed time step does not wait for the wall clock, the frame rate cap still would
+			MaxFPS->Set(0.0f, ECVF_SetByCode);
+		}
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FLockstep::OnWorldPostActorTick);
+		WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this, &FLockstep::OnWorldCleanup);
+		NumTicks = 0;
+		UE_LOG(LogUnrealCV, Display, TEXT("Lockstep mode is enabled, dt=%f"), InDeltaTime);
+	}
+
+	World = InWorld;
+	DeltaTime = InDeltaTime;
+	TicksLeft = 0;
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(DeltaTime);
+	return FExecStatus::OK();
+}
+
+void LychSim::FLockstep::Disable()
+{
+	if (!PostActorTickHandle.IsValid())
+	{
+		return;
+	}
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	PostActorTickHandle.Reset();
+	WorldCleanupHandle.Reset();
+
+	FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+	if (IConsoleVariable* MaxFPS = GetMaxFPSVariable())
+	{
+		MaxFPS->Set(SavedMaxFPS, ECVF_SetByCode);
+	}
+
+	if (World.IsValid())
+	{
+		UGameplayStatics::SetGamePaused(World.Get(), false);
+	}
+	World = nullptr;
+	TicksLeft = 0;
+	UE_LOG(LogUnrealCV, Display, TEXT("Lockstep mode is disabled after %lld ticks"), NumTicks);
+}
+
+bool LychSim::FLockstep::IsEnabled() const
+{
+	return PostActorTickHandle.IsValid();
+}
+
+FExecStatus LychSim::FLockstep::Step(int32 InNumTicks, float InDeltaTime)
+{
+	if (!IsEnabled() || !World.IsValid())
+	{
+		return FExecStatus::Error("Lockstep mode is off, enable it with lych sim lockstep on");
+	}
+	if (IsStepping())
+	{
+		return FExecStatus::Error("The last step is still running");
+	}
+	if (InNumTicks < 1)
+	{
+		return FExecStatus::Error(FString::Printf(TEXT("Can not step %d ticks"), InNumTicks));
+	}
+	if (InDeltaTime > 0 && InDeltaTime != DeltaTime)
+	{
+		DeltaTime = InDeltaTime;
+		FApp::SetFixedDeltaTime(DeltaTime);
+	}
+
+	TicksLeft = InNumTicks;
+	UGameplayStatics::SetGamePaused(World.Get(), false);
+	return FExecStatus::OK();
+}
+
+bool LychSim::FLockstep::IsStepping() const
+{
+	return TicksLeft > 0 && World.IsValid();
+}
+
+void LychSim::FLockstep::OnWorldPostActorTick(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	// Frames of a paused world or of other worlds, e.g. the editor world during PIE, do not count
+	if (TicksLeft <= 0 || TickedWorld != World.Get() || TickType != LEVELTICK_All || TickedWorld->IsPaused())
+	{
+		return;
+	}
+	TicksLeft--;
+	NumTicks++;
+	if (TicksLeft == 0)
+	{
+		// Pausing here keeps the rest of this frame, e.g. the commands in the server tick, at the same game time
+		UGameplayStatics::SetGamePaused(TickedWorld, true);
+	}
+}
+
+void LychSim::FLockstep::OnWorldCleanup(UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources)
+{
+	if (CleanedWorld == World.Get())
+	{
+		Disable();
+	}
+}
@@ -0,0 +1,256 @@
+#include "Utils/MeshExport.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "Runtime/Engine/Classes/Components/StaticMeshComponent.h"
+#include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
+#include "Runtime/Engine/Public/StaticMeshResources.h"
+#include "Runtime/Engine/Public/Rendering/SkeletalMeshLODRenderData.h"
+#include "Runtime/Engine/Public/Rendering/SkeletalMeshRenderData.h"
+#include "Runtime/Engine/Public/SkeletalRenderPublic.h"
+#include "Utils/StaticMeshCache.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::GetStaticMeshBuffers"), STAT_GetStaticMeshBuffers, STATGROUP_UnrealCV);
+DECLARE_CYCLE_STAT(TEXT("LychSim::SerializeActorMesh"), STAT_SerializeActorMesh, STATGROUP_UnrealCV);
+
+namespace
+{
+	const uint32 MeshExportMagic = 0x48534D4C; // 'LMSH'
+	const uint16 MeshExportVersion = 1;
+
+	/** The buffers of each LOD read so far, only touched from the game thread */
+	LychSim::TStaticMeshCache<TMap<int32, TSharedPtr<const LychSim::FMeshBuffers>>> StaticMeshCache;
+
+	TSharedPtr<const LychSim::FMeshBuffers> ReadStaticMeshLOD(const FStaticMeshLODResources& LODModel, int32 LODIndex)
+	{
+		TSharedPtr<LychSim::FMeshBuffers> Buffers = MakeShared<LychSim::FMeshBuffers>();
+		Buffers->LODIndex = LODIndex;
+
+		const FPositionVertexBuffer& PositionVertexBuffer = LODModel.VertexBuffers.PositionVertexBuffer;
+		const uint32 NumVertices = PositionVertexBuffer.GetNumVertices();
+		Buffers->Positions.SetNumUninitialized(NumVertices);
+		for (uint32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+		{
+			Buffers->Positions[VertexIndex] = PositionVertexBuffer.VertexPosition(VertexIndex);
+		}
+
+		const FStaticMeshVertexBuffer& StaticMeshVertexBuffer = LODModel.VertexBuffers.StaticMeshVertexBuffer;
+		if (StaticMeshVertexBuffer.GetNumVertices() == NumVertices)
+		{
+			Buffers->Normals.SetNumUninitialized(NumVertices);
+			for (uint32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+			{
+				Buffers->Normals[VertexIndex] = FVector3f(StaticMeshVertexBuffer.VertexTangentZ(VertexIndex));
+			}
+		}
+
+		// Requires CPU access in packaged games, like the vertex positions
+		FIndexArrayView IndexArrayView = LODModel.IndexBuffer.GetArrayView();
+		Buffers->Indices.SetNumUninitialized(IndexArrayView.Num());
+		for (int32 i = 0; i < IndexArrayView.Num(); i++)
+		{
+			Buffers->Indices[i] = IndexArrayView[i];
+		}
+		return Buffers;
+	}
+
+	TSharedPtr<const LychSim::FMeshBuffers> ReadSkinnedMesh(USkinnedMeshComponent* Component, int32 LODIndex)
+	{
+		if (!IsValid(Component) || Component->MeshObject == nullptr)
+		{
+			return nullptr;
+		}
+		const FSkeletalMeshRenderData& RenderData = Component->MeshObject->GetSkeletalMeshRenderData();
+		if (RenderData.LODRenderData.Num() == 0)
+		{
+			return nullptr;
+		}
+		LODIndex = FMath::Clamp(LODIndex, 0, RenderData.LODRenderData.Num() - 1);
+		const FSkeletalMeshLODRenderData& LODData = RenderData.LODRenderData[LODIndex];
+		FSkinWeightVertexBuffer* SkinWeightBuffer = Component->GetSkinWeightBuffer(LODIndex);
+		if (!SkinWeightBuffer)
+		{
+			return nullptr;
+		}
+
+		TSharedPtr<LychSim::FMeshBuffers> Buffers = MakeShared<LychSim::FMeshBuffers>();
+		Buffers->LODIndex = LODIndex;
+
+		// Same as UVisionBPLib::SkinnedMeshComponentGetVertexArray, for the requested LOD
+		TArray<FMatrix44f> RefToLocals;
+		Component->CacheRefToLocalMatrices(RefToLocals);
+		USkinnedMeshComponent::ComputeSkinnedPositions(Component, Buffers->Positions, RefToLocals, LODData, *SkinWeightBuffer);
+
+		if (LODData.MultiSizeIndexContainer.IsIndexBufferValid())
+		{
+			LODData.MultiSizeIndexContainer.GetIndexBuffer(Buffers->Indices);
+		}
+		return Buffers;
+	}
+}
+
+TSharedPtr<const LychSim::FMeshBuffers> LychSim::GetStaticMeshBuffers(UStaticMesh* StaticMesh, int32 LODIndex)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GetStaticMeshBuffers);
+	check(IsInGameThread());
+
+	if (!IsValid(StaticMesh))
+	{
+		return nullptr;
+	}
+	const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+	if (!RenderData || RenderData->LODResources.Num() == 0)
+	{
+		return nullptr;
+	}
+	LODIndex = FMath::Clamp(LODIndex, 0, RenderData->LODResources.Num() - 1);
+
+	TSharedPtr<const FMeshBuffers>& Buffers = StaticMeshCache.FindOrAdd(StaticMesh, RenderData).FindOrAdd(LODIndex);
+	if (!Buffers.IsValid())
+	{
+		Buffers = ReadStaticMeshLOD(RenderData->LODResources[LODIndex], LODIndex);
+	}
+	return Buffers;
+}
+
+TSharedPtr<const LychSim::FMeshBuffers> LychSim::GetMeshComponentBuffers(UMeshComponent* MeshComponent, int32 LODIndex)
+{
+	if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(MeshComponent))
+	{
+		return GetStaticMeshBuffers(StaticMeshComponent->GetStaticMesh(), LODIndex);
+	}
+	if (USkinnedMeshComponent* SkinnedMeshComponent = Cast<USkinnedMeshComponent>(MeshComponent))
+	{
+		return ReadSkinnedMesh(SkinnedMeshComponent, LODIndex);
+	}
+	return nullptr;
+}
+
+TArray<uint8> LychSim::SerializeActorMesh(const AActor* Actor, int32 LODIndex, uint16 Flags)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SerializeActorMesh);
+
+	struct FSection
+	{
+		FString Name;
+		TSharedPtr<const FMeshBuffers> Buffers;
+		FMatrix44f PositionMatrix;
+		FMatrix44f NormalMatrix;
+		uint32 VertexOffset = 0;
+		uint32 IndexOffset = 0;
+	};
+
+	TArray<FSection> Sections;
+	uint32 NumVertices = 0, NumIndices = 0;
+	if (IsValid(Actor))
+	{
+		TArray<UMeshComponent*> MeshComponents;
+		Actor->GetComponents<UMeshComponent>(MeshComponents);
+		const FTransform ActorTransform = Actor->GetActorTransform();
+		for (UMeshComponent* MeshComponent : MeshComponents)
+		{
+			TSharedPtr<const FMeshBuffers> Buffers = GetMeshComponentBuffers(MeshComponent, LODIndex);
+			if (!Buffers.IsValid()) continue;
+
+			const FTransform Transform = (Flags & MeshExportWorld)
+				? MeshComponent->GetComponentTransform()
+				: MeshComponent->GetComponentTransform().GetRelativeTransform(ActorTransform);
+			const FMatrix Matrix = Transform.ToMatrixWithScale();
+
+			FSection& Section = Sections.AddDefaulted_GetRef();
+			Section.Name = MeshComponent->GetName();
+			Section.Buffers = Buffers;
+			Section.PositionMatrix = FMatrix44f(Matrix);
+			Section.NormalMatrix = FMatrix44f(Matrix.Inverse().GetTransposed());
+			Section.VertexOffset = NumVertices;
+			Section.IndexOffset = NumIndices;
+			NumVertices += Buffers->Positions.Num();
+			NumIndices += (Flags & MeshExportIndices) ? Buffers->Indices.Num() : 0;
+		}
+	}
+
+	FBufferArchive Ar;
+	uint32 Magic = MeshExportMagic;
+	uint16 Version = MeshExportVersion;
+	uint16 Flags16 = Flags;
+	uint32 NumSections = Sections.Num();
+	Ar << Magic << Version << Flags16 << NumVertices << NumIndices << NumSections;
+	for (const FSection& Section : Sections)
+	{
+		uint32 VertexOffset = Section.VertexOffset, VertexCount = Section.Buffers->Positions.Num();
+		uint32 IndexOffset = Section.IndexOffset;
+		uint32 IndexCount = (Flags & MeshExportIndices) ? Section.Buffers->Indices.Num() : 0;
+		int32 SectionLOD = Section.Buffers->LODIndex;
+		Ar << VertexOffset << VertexCount << IndexOffset << IndexCount << SectionLOD;
+	}
+
+	const bool bNormals = (Flags & MeshExportNormals) != 0;
+	const int32 PositionOffset = Ar.Num();
+	const int32 NormalOffset = PositionOffset + NumVertices * 3 * sizeof(float);
+	const int32 IndexOffset = NormalOffset + (bNormals ? NumVertices * 3 * sizeof(float) : 0);
+	Ar.AddZeroed(IndexOffset + NumIndices * sizeof(uint32) - PositionOffset);
+	FVector3f* Positions = reinterpret_cast<FVector3f*>(Ar.GetData() + PositionOffset);
+	FVector3f* Normals = reinterpret_cast<FVector3f*>(Ar.GetData() + NormalOffset);
+	uint32* Indices = reinterpret_cast<uint32*>(Ar.GetData() + IndexOffset);
+
+	// Only the transform is applied per request, split into blocks so large meshes use all workers
+	struct FTask
+	{
+		int32 SectionIndex;
+		int32 Begin;
+		int32 End;
+	};
+	const int32 VerticesPerTask = 4096;
+	TArray<FTask> Tasks;
+	for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); SectionIndex++)
+	{
+		const int32 Count = Sections[SectionIndex].Buffers->Positions.Num();
+		for (int32 Begin = 0; Begin < Count; Begin += VerticesPerTask)
+		{
+			Tasks.Add({ SectionIndex, Begin, FMath::Min(Begin + VerticesPerTask, Count) });
+		}
+	}
+
+	ParallelFor(Tasks.Num(), [&](int32 TaskIndex)
+	{
+		const FTask& Task = Tasks[TaskIndex];
+		const FSection& Section = Sections[Task.SectionIndex];
+		const FMeshBuffers& Buffers = *Section.Buffers;
+		for (int32 i = Task.Begin; i < Task.End; i++)
+		{
+			Positions[Section.VertexOffset + i] = Section.PositionMatrix.TransformPosition(Buffers.Positions[i]);
+		}
+		if (bNormals && Buffers.Normals.Num() == Buffers.Positions.Num())
+		{
+			for (int32 i = Task.Begin; i < Task.End; i++)
+			{
+				Normals[Section.VertexOffset + i] = Section.NormalMatrix.TransformVector(Buffers.Normals[i]).GetSafeNormal();
+			}
+		}
+	});
+
+	if (Flags & MeshExportIndices)
+	{
+		for (const FSection& Section : Sections)
+		{
+			uint32* Dst = Indices + Section.IndexOffset;
+			for (uint32 Index : Section.Buffers->Indices)
+			{
+				*Dst++ = Index + Section.VertexOffset;
+			}
+		}
+	}
+
+	// FBufferArchive appends at its write position, move it past the vertex data
+	Ar.Seek(Ar.Num());
+	for (const FSection& Section : Sections)
+	{
+		FTCHARToUTF8 Utf8(*Section.Name);
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	}
+	return MoveTemp(Ar);
+}
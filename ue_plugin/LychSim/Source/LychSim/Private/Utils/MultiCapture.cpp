@@ -0,0 +1,144 @@
+#include "Utils/MultiCapture.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "Actor/StereoCameraActor.h"
+#include "BaseCameraSensor.h"
+#include "FusionCamSensor.h"
+#include "TextureReader.h"
+#include "UnrealcvStats.h"
+#include "Utils/Trace.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::CaptureMulti"), STAT_CaptureMulti, STATGROUP_UnrealCV);
+DECLARE_CYCLE_STAT(TEXT("LychSim::CaptureMulti::Flush"), STAT_CaptureMultiFlush, STATGROUP_UnrealCV);
+
+bool LychSim::IsMultiCaptureMode(const FString& Mode)
+{
+	return Mode == TEXT("lit") || Mode == TEXT("depth") || Mode == TEXT("normal") || Mode == TEXT("seg");
+}
+
+bool LychSim::CaptureMulti(const TArray<UFusionCamSensor*>& Sensors, const FString& Mode, const FReadbackRegion& Region, TArray<FMultiCaptureImage>& OutImages)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CaptureMulti);
+
+	if (!IsMultiCaptureMode(Mode)) return false;
+	const int32 Num = Sensors.Num();
+	const bool bDepth = Mode == TEXT("depth");
+
+	// Sized before any readback is queued, the rendering thread writes into these arrays
+	OutImages.Reset();
+	OutImages.SetNum(Num);
+	TArray<TArray<FFloat16Color>> HalfColors;
+	HalfColors.SetNum(bDepth ? Num : 0);
+	TArray<FIntPoint> Sizes;
+	Sizes.SetNumZeroed(Num);
+
+	// Keep the request order, but pull the other sensors of a stereo rig right behind the first one
+	TArray<int32> Order;
+	TSet<AActor*> StereoRigs;
+	for (int32 i = 0; i < Num; i++)
+	{
+		AActor* Owner = IsValid(Sensors[i]) ? Sensors[i]->GetOwner() : nullptr;
+		if (!Owner || !Owner->IsA<AStereoCameraActor>())
+		{
+			Order.Add(i);
+			continue;
+		}
+		if (StereoRigs.Contains(Owner)) continue;
+		StereoRigs.Add(Owner);
+		for (int32 j = i; j < Num; j++)
+		{
+			if (IsValid(Sensors[j]) && Sensors[j]->GetOwner() == Owner)
+			{
+				Order.Add(j);
+			}
+		}
+	}
+
+	FBatchCaptureShared Shared;
+	TArray<UBaseCameraSensor*> Captured;
+	Captured.SetNumZeroed(Num);
+	for (int32 Index : Order)
+	{
+		UBaseCameraSensor* Sensor = IsValid(Sensors[Index]) ? Sensors[Index]->GetModeSensor(Mode) : nullptr;
+		if (IsValid(Sensor) && Sensor->BeginCapture(&Shared))
+		{
+			Captured[Index] = Sensor;
+		}
+	}
+
+	// Queued after all captures, so the GPU renders every view before the first copy blocks
+	for (int32 Index : Order)
+	{
+		if (!Captured[Index]) continue;
+		const bool bQueued = bDepth
+			? Captured[Index]->EnqueueRead(HalfColors[Index], Sizes[Index], &Region)
+			: Captured[Index]->EnqueueRead(OutImages[Index].Colors, Sizes[Index], &Region);
+		if (!bQueued)
+		{
+			Sizes[Index] = FIntPoint::ZeroValue;
+		}
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CaptureMultiFlush);
+		LYCHSIM_TRACE_SCOPE("FlushRenderingCommands");
+		FlushRenderingCommands();
+	}
+
+	const bool bSeg = Mode == TEXT("seg");
+	ParallelFor(Num, [&](int32 Index)
+	{
+		FMultiCaptureImage& Image = OutImages[Index];
+		const int32 NumPixels = Sizes[Index].X * Sizes[Index].Y;
+		if (bDepth)
+		{
+			const TArray<FFloat16Color>& Half = HalfColors[Index];
+			if (NumPixels == 0 || Half.Num() != NumPixels) return;
+			Image.Floats.SetNumUninitialized(NumPixels);
+			for (int32 i = 0; i < NumPixels; i++)
+			{
+				Image.Floats[i] = Half[i].R;
+			}
+		}
+		else
+		{
+			if (NumPixels == 0 || Image.Colors.Num() != NumPixels)
+			{
+				Image.Colors.Empty();
+				return;
+			}
+			// Same as CaptureSeg, the annotation pass leaves the alpha undefined
+			if (bSeg)
+			{
+				for (FColor& Color : Image.Colors)
+				{
+					Color.A = 255;
+				}
+			}
+		}
+		Image.Width = Sizes[Index].X;
+		Image.Height = Sizes[Index].Y;
+	});
+	return true;
+}
+
+TArray<uint8> LychSim::SerializeMultiCapture(const TArray<int32>& SensorIds, const TArray<FMultiCaptureImage>& Images, const TArray<TArray<uint8>>& Parts)
+{
+	FBufferArchive Ar;
+	uint32 Magic = 0x50434D4C; // 'LMCP'
+	uint16 Version = 1;
+	uint16 NumParts = (uint16)Parts.Num();
+	Ar << Magic << Version << NumParts;
+	for (int32 i = 0; i < Parts.Num(); i++)
+	{
+		int32 SensorId = SensorIds[i];
+		uint32 Width = Images[i].Width, Height = Images[i].Height;
+		uint32 NumBytes = Parts[i].Num();
+		Ar << SensorId << Width << Height << NumBytes;
+	}
+	for (const TArray<uint8>& Part : Parts)
+	{
+		Ar.Serialize((void*)Part.GetData(), Part.Num());
+	}
+	return MoveTemp(Ar);
+}
@@ -0,0 +1,202 @@
+#include "Utils/ObjectSnapshot.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "GameFramework/Actor.h"
+#include "AnnotationComponent.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::GatherObjectSnapshot"), STAT_GatherObjectSnapshot, STATGROUP_UnrealCV);
+DECLARE_CYCLE_STAT(TEXT("LychSim::SerializeObjectSnapshot"), STAT_SerializeObjectSnapshot, STATGROUP_UnrealCV);
+
+void LychSim::GatherObjectSnapshot(const TArray<AActor*>& Actors, TArray<FObjectSnapshotRow>& OutRows)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GatherObjectSnapshot);
+
+	OutRows.SetNum(Actors.Num());
+	for (int32 i = 0; i < Actors.Num(); i++)
+	{
+		AActor* Actor = Actors[i];
+		FObjectSnapshotRow& Row = OutRows[i];
+		if (!IsValid(Actor)) continue;
+
+		Row.bValid = true;
+		Row.ObjectId = Actor->GetName();
+		FGuid Guid = Actor->GetActorGuid();
+		Row.Guid = Guid.IsValid() ? Guid.ToString() : TEXT("NO_GUID");
+		Row.AABB = Actor->GetComponentsBoundingBox(true);
+		Actor->GetActorBounds(false, Row.BoundsCenter, Row.BoundsExtent);
+		Row.Transform = Actor->GetActorTransform();
+
+		// Same result as FObjectAnnotator::GetAnnotationColor, without enumerating the components twice
+		if (UAnnotationComponent* AnnotationComponent = Actor->FindComponentByClass<UAnnotationComponent>())
+		{
+			Row.Color = AnnotationComponent->GetAnnotationColor();
+		}
+	}
+}
+
+void LychSim::WriteObjectSnapshotJson(const TSharedRef<TJsonWriter<>>& Writer, const FObjectSnapshotRow& Row)
+{
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("object_id"), Row.ObjectId);
+
+	if (!Row.bValid)
+	{
+		Writer->WriteValue(TEXT("status"), TEXT("not_found"));
+		Writer->WriteObjectEnd();
+		return;
+	}
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("guid"), Row.Guid);
+
+	auto WriteVector = [&Writer](const TCHAR* Name, const FVector& Vec)
+	{
+		Writer->WriteArrayStart(Name);
+		Writer->WriteValue(Vec.X); Writer->WriteValue(Vec.Y); Writer->WriteValue(Vec.Z);
+		Writer->WriteArrayEnd();
+	};
+	auto WriteRotator = [&Writer](const TCHAR* Name, const FRotator& Rot)
+	{
+		Writer->WriteArrayStart(Name);
+		Writer->WriteValue(Rot.Pitch); Writer->WriteValue(Rot.Yaw); Writer->WriteValue(Rot.Roll);
+		Writer->WriteArrayEnd();
+	};
+
+	const FRotator Rotation = Row.Transform.Rotator();
+
+	Writer->WriteObjectStart(TEXT("aabb"));
+	WriteVector(TEXT("center"), Row.AABB.GetCenter());
+	WriteVector(TEXT("extent"), Row.AABB.GetExtent());
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectStart(TEXT("obb"));
+	WriteVector(TEXT("center"), Row.BoundsCenter);
+	WriteVector(TEXT("extent"), Row.BoundsExtent);
+	WriteRotator(TEXT("rotation"), Rotation);
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectStart(TEXT("bounds"));
+	WriteVector(TEXT("center"), Row.BoundsCenter);
+	WriteVector(TEXT("extent"), Row.BoundsExtent);
+	Writer->WriteObjectEnd();
+
+	WriteVector(TEXT("location"), Row.Transform.GetLocation());
+	WriteRotator(TEXT("rotation"), Rotation);
+	WriteVector(TEXT("scale"), Row.Transform.GetScale3D());
+
+	Writer->WriteArrayStart(TEXT("color"));
+	Writer->WriteValue(Row.Color.R); Writer->WriteValue(Row.Color.G);
+	Writer->WriteValue(Row.Color.B); Writer->WriteValue(Row.Color.A);
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+}
+
+namespace
+{
+	struct FSnapshotColumn
+	{
+		const char* Name;
+		uint8 Width;
+	};
+
+	// Keep in sync with the fill lambda in SerializeObjectSnapshot
+	const FSnapshotColumn SnapshotColumns[] = {
+		{ "valid", 1 },
+		{ "aabb_center", 3 },
+		{ "aabb_extent", 3 },
+		{ "bounds_center", 3 },
+		{ "bounds_extent", 3 },
+		{ "location", 3 },
+		{ "rotation", 3 },
+		{ "scale", 3 },
+		{ "color", 4 },
+	};
+}
+
+TArray<uint8> LychSim::SerializeObjectSnapshot(const TArray<FObjectSnapshotRow>& Rows)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SerializeObjectSnapshot);
+
+	const int32 NumRows = Rows.Num();
+	const int32 NumColumns = UE_ARRAY_COUNT(SnapshotColumns);
+
+	FBufferArchive Ar;
+	uint32 Magic = 0x4A424F4C; // 'LOBJ'
+	uint16 Version = 1;
+	uint16 NumColumns16 = NumColumns;
+	uint32 NumRows32 = NumRows;
+	Ar << Magic << Version << NumColumns16 << NumRows32;
+
+	TArray<int32> ColumnOffsets; // In floats, relative to the start of the column data
+	int32 TotalFloats = 0;
+	for (const FSnapshotColumn& Column : SnapshotColumns)
+	{
+		uint8 NameLength = (uint8)FCStringAnsi::Strlen(Column.Name);
+		uint8 Width = Column.Width;
+		Ar << NameLength;
+		Ar.Serialize((void*)Column.Name, NameLength);
+		Ar << Width;
+		ColumnOffsets.Add(TotalFloats);
+		TotalFloats += NumRows * Column.Width;
+	}
+	uint8 Zero = 0;
+	while (Ar.Num() % 4 != 0)
+	{
+		Ar << Zero;
+	}
+
+	const int32 DataOffset = Ar.Num();
+	Ar.AddZeroed(TotalFloats * sizeof(float));
+	float* Data = reinterpret_cast<float*>(Ar.GetData() + DataOffset);
+
+	ParallelFor(NumRows, [&](int32 RowIndex)
+	{
+		const FObjectSnapshotRow& Row = Rows[RowIndex];
+		int32 ColumnIndex = 0;
+		auto Put = [&](std::initializer_list<double> Values)
+		{
+			float* Dst = Data + ColumnOffsets[ColumnIndex] + RowIndex * SnapshotColumns[ColumnIndex].Width;
+			for (double Value : Values)
+			{
+				*Dst++ = (float)Value;
+			}
+			ColumnIndex++;
+		};
+
+		if (!Row.bValid)
+		{
+			return; // All columns stay zero, including "valid"
+		}
+		const FVector AABBCenter = Row.AABB.GetCenter();
+		const FVector AABBExtent = Row.AABB.GetExtent();
+		const FVector Location = Row.Transform.GetLocation();
+		const FRotator Rotation = Row.Transform.Rotator();
+		const FVector Scale = Row.Transform.GetScale3D();
+
+		Put({ 1.0 });
+		Put({ AABBCenter.X, AABBCenter.Y, AABBCenter.Z });
+		Put({ AABBExtent.X, AABBExtent.Y, AABBExtent.Z });
+		Put({ Row.BoundsCenter.X, Row.BoundsCenter.Y, Row.BoundsCenter.Z });
+		Put({ Row.BoundsExtent.X, Row.BoundsExtent.Y, Row.BoundsExtent.Z });
+		Put({ Location.X, Location.Y, Location.Z });
+		Put({ Rotation.Pitch, Rotation.Yaw, Rotation.Roll });
+		Put({ Scale.X, Scale.Y, Scale.Z });
+		Put({ (double)Row.Color.R, (double)Row.Color.G, (double)Row.Color.B, (double)Row.Color.A });
+	});
+
+	// FBufferArchive appends at its write position, move it past the column data
+	Ar.Seek(Ar.Num());
+	for (const FObjectSnapshotRow& Row : Rows)
+	{
+		for (const FString* Str : { &Row.ObjectId, &Row.Guid })
+		{
+			FTCHARToUTF8 Utf8(**Str);
+			uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+			Ar << Length;
+			Ar.Serialize((void*)Utf8.Get(), Length);
+		}
+	}
+	return MoveTemp(Ar);
+}
@@ -0,0 +1,84 @@
+#include "Utils/PointKdTree.h"
+
+#include <algorithm>
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FPointKdTree::Build"), STAT_PointKdTreeBuild, STATGROUP_UnrealCV);
+
+LychSim::FPointKdTree::FPointKdTree(const TArray<FVector>& InPoints)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PointKdTreeBuild);
+
+	const int32 NumPoints = InPoints.Num();
+	Entries.SetNumUninitialized(NumPoints);
+	SplitAxes.SetNumZeroed(NumPoints);
+	for (int32 i = 0; i < NumPoints; i++)
+	{
+		Entries[i].Point = FVector3f(InPoints[i]);
+		Entries[i].SourceIndex = i;
+	}
+	Build(0, NumPoints);
+}
+
+void LychSim::FPointKdTree::Build(int32 Begin, int32 End)
+{
+	if (End - Begin <= 1)
+	{
+		return;
+	}
+
+	FBox3f Bounds(ForceInit);
+	for (int32 i = Begin; i < End; i++)
+	{
+		Bounds += Entries[i].Point;
+	}
+	const FVector3f Size = Bounds.GetSize();
+	const uint8 Axis = (Size.X >= Size.Y && Size.X >= Size.Z) ? 0 : (Size.Y >= Size.Z ? 1 : 2);
+
+	// Partition the range in place around its median
+	const int32 Mid = Begin + (End - Begin) / 2;
+	FEntry* Data = Entries.GetData();
+	std::nth_element(Data + Begin, Data + Mid, Data + End,
+		[Axis](const FEntry& A, const FEntry& B) { return A.Point[Axis] < B.Point[Axis]; });
+
+	SplitAxes[Mid] = Axis;
+	Build(Begin, Mid);
+	Build(Mid + 1, End);
+}
+
+int32 LychSim::FPointKdTree::FindNearest(const FVector& Query, double& OutDistanceSquared) const
+{
+	int32 BestNode = INDEX_NONE;
+	float BestDistanceSquared = MAX_flt;
+	Search(0, Entries.Num(), FVector3f(Query), BestNode, BestDistanceSquared);
+	OutDistanceSquared = BestDistanceSquared;
+	return BestNode == INDEX_NONE ? INDEX_NONE : Entries[BestNode].SourceIndex;
+}
+
+void LychSim::FPointKdTree::Search(int32 Begin, int32 End, const FVector3f& Query, int32& BestNode, float& BestDistanceSquared) const
+{
+	if (Begin >= End)
+	{
+		return;
+	}
+	const int32 Mid = Begin + (End - Begin) / 2;
+	const float DistanceSquared = FVector3f::DistSquared(Entries[Mid].Point, Query);
+	if (DistanceSquared < BestDistanceSquared)
+	{
+		BestDistanceSquared = DistanceSquared;
+		BestNode = Mid;
+	}
+
+	const uint8 Axis = SplitAxes[Mid];
+	const float Diff = Query[Axis] - Entries[Mid].Point[Axis];
+	if (Diff < 0)
+	{
+		Search(Begin, Mid, Query, BestNode, BestDistanceSquared);
+		if (Diff * Diff < BestDistanceSquared) Search(Mid + 1, End, Query, BestNode, BestDistanceSquared);
+	}
+	else
+	{
+		Search(Mid + 1, End, Query, BestNode, BestDistanceSquared);
+		if (Diff * Diff < BestDistanceSquared) Search(Begin, Mid, Query, BestNode, BestDistanceSquared);
+	}
+}
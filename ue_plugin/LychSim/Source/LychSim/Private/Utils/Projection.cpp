@@ -0,0 +1,43 @@
+#include "Utils/Projection.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::ProjectPoints"), STAT_ProjectPoints, STATGROUP_UnrealCV);
+
+void LychSim::ProjectPoints(const FMatrix& ViewMatrix, const FMatrix& ProjectionMatrix,
+	int Width, int Height, const TArray<FVector>& Points, TArray<float>& OutUVD)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectPoints);
+
+	const int32 NumPoints = Points.Num();
+	OutUVD.SetNumUninitialized(NumPoints * 3);
+	if (NumPoints == 0) return;
+
+	const FMatrix ViewProjectionMatrix = ViewMatrix * ProjectionMatrix;
+	const int32 PointsPerTask = 1024;
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumPoints, PointsPerTask);
+
+	ParallelFor(NumTasks, [&](int32 TaskIndex)
+	{
+		const int32 Begin = TaskIndex * PointsPerTask;
+		const int32 End = FMath::Min(Begin + PointsPerTask, NumPoints);
+		for (int32 i = Begin; i < End; i++)
+		{
+			const FVector4 Clip = ViewProjectionMatrix.TransformFVector4(FVector4(Points[i], 1.0));
+			const double Depth = ViewMatrix.TransformPosition(Points[i]).Z;
+			float* Out = OutUVD.GetData() + i * 3;
+			if (FMath::Abs(Clip.W) < UE_SMALL_NUMBER)
+			{
+				Out[0] = Out[1] = -1.0f;
+				Out[2] = (float)Depth;
+				continue;
+			}
+			const double NdcX = Clip.X / Clip.W;
+			const double NdcY = Clip.Y / Clip.W;
+			Out[0] = (float)((NdcX + 1.0) * 0.5 * Width);
+			Out[1] = (float)((1.0 - NdcY) * 0.5 * Height);
+			Out[2] = (float)Depth;
+		}
+	});
+}
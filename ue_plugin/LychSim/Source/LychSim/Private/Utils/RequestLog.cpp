@@ -0,0 +1,278 @@
+#include "Utils/RequestLog.h"
+
+#include "Runtime/Core/Public/GenericPlatform/GenericPlatformFile.h"
+#include "Runtime/Core/Public/HAL/Event.h"
+#include "Runtime/Core/Public/HAL/PlatformFileManager.h"
+#include "Runtime/Core/Public/HAL/RunnableThread.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+#include "Runtime/Core/Public/Misc/ScopeLock.h"
+#include "UnrealcvStats.h"
+#include "UnrealcvLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FRequestLog::Flush"), STAT_RequestLogFlush, STATGROUP_UnrealCV);
+
+namespace
+{
+	/** Copy the start of Text, characters outside of ascii are replaced by ? */
+	uint8 CopyText(ANSICHAR* Dest, int32 MaxLen, const FString& Text)
+	{
+		const int32 Len = FMath::Min(Text.Len(), MaxLen);
+		const TCHAR* Src = *Text;
+		for (int32 i = 0; i < Len; i++)
+		{
+			Dest[i] = Src[i] < 128 ? (ANSICHAR)Src[i] : '?';
+		}
+		return (uint8)Len;
+	}
+
+	void AppendJsonString(FString& Out, const ANSICHAR* Text, int32 Len)
+	{
+		Out += TEXT("\"");
+		for (int32 i = 0; i < Len; i++)
+		{
+			const ANSICHAR C = Text[i];
+			if (C == '"' || C == '\\')
+			{
+				Out.AppendChar(TEXT('\\'));
+				Out.AppendChar((TCHAR)C);
+			}
+			else if ((uint8)C < 0x20)
+			{
+				Out += FString::Printf(TEXT("\\u%04x"), (uint32)(uint8)C);
+			}
+			else
+			{
+				Out.AppendChar((TCHAR)C);
+			}
+		}
+		Out += TEXT("\"");
+	}
+}
+
+const TCHAR* LychSim::GetRequestLogVerbosityName(ERequestLogVerbosity Verbosity)
+{
+	switch (Verbosity)
+	{
+	case ERequestLogVerbosity::Off: return TEXT("off");
+	case ERequestLogVerbosity::Errors: return TEXT("errors");
+	case ERequestLogVerbosity::Summary: return TEXT("summary");
+	case ERequestLogVerbosity::Full: return TEXT("full");
+	}
+	return TEXT("unknown");
+}
+
+bool LychSim::ParseRequestLogVerbosity(const FString& Name, ERequestLogVerbosity& OutVerbosity)
+{
+	for (ERequestLogVerbosity Verbosity : { ERequestLogVerbosity::Off, ERequestLogVerbosity::Errors, ERequestLogVerbosity::Summary, ERequestLogVerbosity::Full })
+	{
+		if (Name == GetRequestLogVerbosityName(Verbosity))
+		{
+			OutVerbosity = Verbosity;
+			return true;
+		}
+	}
+	return false;
+}
+
+LychSim::FRequestLog& LychSim::FRequestLog::Get()
+{
+	static FRequestLog RequestLog;
+	return RequestLog;
+}
+
+LychSim::FRequestLog::FRequestLog()
+	: Flusher(*this)
+{
+	Records.SetNumUninitialized(Capacity);
+	UnixTimeOffset = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalSeconds() - FPlatformTime::Seconds();
+}
+
+void LychSim::FRequestLog::Configure(ERequestLogVerbosity InVerbosity, float InSampleRate, const FString& InPath)
+{
+	SampleRate = FMath::Clamp(InSampleRate, 0.0f, 1.0f);
+	SampleCredit = 0.0f;
+	{
+		const FString NewPath = InPath.IsEmpty() ? FPaths::Combine(FPaths::ProjectLogDir(), TEXT("LychSimRequests.jsonl")) : InPath;
+		FScopeLock ScopeLock(&FileLock);
+		if (NewPath != Path)
+		{
+			delete File;
+			File = nullptr;
+			Path = NewPath;
+		}
+	}
+
+	// The flusher is started on the first use and kept, it sleeps while nothing is logged
+	if (InVerbosity != ERequestLogVerbosity::Off && !Thread && !bStopping)
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(&Flusher, TEXT("LychSimRequestLog"), 0, TPri_Lowest);
+	}
+	Verbosity.store(InVerbosity, std::memory_order_relaxed);
+}
+
+FString LychSim::FRequestLog::GetPath() const
+{
+	FScopeLock ScopeLock(&FileLock);
+	return Path;
+}
+
+bool LychSim::FRequestLog::ShouldLog(bool bError)
+{
+	switch (GetVerbosity())
+	{
+	case ERequestLogVerbosity::Off:
+		return false;
+	case ERequestLogVerbosity::Errors:
+		return bError;
+	default:
+		break;
+	}
+	if (bError)
+	{
+		return true;
+	}
+	// Every 1 / SampleRate request is logged, evenly spaced instead of random
+	SampleCredit += SampleRate;
+	if (SampleCredit >= 1.0f)
+	{
+		SampleCredit -= 1.0f;
+		return true;
+	}
+	return false;
+}
+
+void LychSim::FRequestLog::Add(const FRequestLogEntry& Entry)
+{
+	if (!ShouldLog(Entry.Error != nullptr) || !Thread)
+	{
+		return;
+	}
+
+	const uint64 WriteIndex = Head.load(std::memory_order_relaxed);
+	const uint64 Used = WriteIndex - Tail.load(std::memory_order_acquire);
+	if (Used >= Capacity)
+	{
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	FRecord& Record = Records[WriteIndex % Capacity];
+	Record.ReceiveTime = Entry.ReceiveTime;
+	Record.RequestId = Entry.RequestId;
+	for (int32 i = 0; i < (int32)ERequestStage::Num; i++)
+	{
+		Record.StageMicroseconds[i] = (uint32)FMath::Clamp(Entry.StageSeconds[i] * 1e6, 0.0, (double)MAX_uint32);
+	}
+	Record.BytesIn = Entry.BytesIn;
+	Record.BytesOut = Entry.BytesOut;
+	Record.bError = Entry.Error != nullptr;
+	Record.CommandLen = Entry.Command ? CopyText(Record.Command, MaxCommandLen, *Entry.Command) : 0;
+	Record.RequestLen = Entry.Message && GetVerbosity() == ERequestLogVerbosity::Full ? CopyText(Record.Request, MaxTextLen, *Entry.Message) : 0;
+	Record.ErrorLen = Entry.Error ? CopyText(Record.Error, MaxTextLen, *Entry.Error) : 0;
+	Head.store(WriteIndex + 1, std::memory_order_release);
+
+	// The flusher wakes up on its own a few times per second, only hurry it when the ring fills up
+	if (Used + 1 == Capacity / 2)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void LychSim::FRequestLog::Flush()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RequestLogFlush);
+	const uint64 End = Head.load(std::memory_order_acquire);
+	const uint64 Begin = Tail.load(std::memory_order_relaxed);
+	const uint64 Dropped = NumDropped.load(std::memory_order_relaxed);
+	if (Begin == End && Dropped == NumDroppedReported)
+	{
+		return;
+	}
+
+	FString Lines;
+	for (uint64 Index = Begin; Index < End; Index++)
+	{
+		const FRecord& Record = Records[Index % Capacity];
+		uint64 TotalMicroseconds = 0;
+		for (uint32 Microseconds : Record.StageMicroseconds)
+		{
+			TotalMicroseconds += Microseconds;
+		}
+		Lines += FString::Printf(TEXT("{\"time\":%.6f,\"id\":%u,\"command\":"), Record.ReceiveTime + UnixTimeOffset, Record.RequestId);
+		AppendJsonString(Lines, Record.Command, Record.CommandLen);
+		Lines += FString::Printf(TEXT(",\"status\":\"%s\",\"bytes_in\":%d,\"bytes_out\":%d,\"total_us\":%llu"),
+			Record.bError ? TEXT("error") : TEXT("ok"), Record.BytesIn, Record.BytesOut, TotalMicroseconds);
+		for (int32 i = 0; i < (int32)ERequestStage::Num; i++)
+		{
+			Lines += FString::Printf(TEXT(",\"%s_us\":%u"), GetRequestStageName((ERequestStage)i), Record.StageMicroseconds[i]);
+		}
+		if (Record.RequestLen > 0)
+		{
+			Lines += TEXT(",\"request\":");
+			AppendJsonString(Lines, Record.Request, Record.RequestLen);
+		}
+		if (Record.bError)
+		{
+			Lines += TEXT(",\"error\":");
+			AppendJsonString(Lines, Record.Error, Record.ErrorLen);
+		}
+		Lines += TEXT("}\n");
+	}
+	// The records are copied out, the game thread may reuse their slots
+	Tail.store(End, std::memory_order_release);
+	NumWritten.fetch_add(End - Begin, std::memory_order_relaxed);
+
+	if (Dropped != NumDroppedReported)
+	{
+		Lines += FString::Printf(TEXT("{\"dropped\":%llu}\n"), Dropped - NumDroppedReported);
+		NumDroppedReported = Dropped;
+	}
+
+	FScopeLock ScopeLock(&FileLock);
+	if (!File)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+		File = PlatformFile.OpenWrite(*Path, true);
+		if (!File)
+		{
+			UE_LOG(LogUnrealCV, Error, TEXT("Can not open the request log %s, %llu records are lost"), *Path, End - Begin);
+			return;
+		}
+	}
+	FTCHARToUTF8 Utf8(*Lines);
+	File->Write((const uint8*)Utf8.Get(), Utf8.Length());
+	File->Flush();
+}
+
+void LychSim::FRequestLog::Shutdown()
+{
+	if (Thread)
+	{
+		bStopping = true;
+		WakeEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+	Verbosity.store(ERequestLogVerbosity::Off, std::memory_order_relaxed);
+
+	FScopeLock ScopeLock(&FileLock);
+	delete File;
+	File = nullptr;
+}
+
+uint32 LychSim::FRequestLog::FFlusher::Run()
+{
+	while (!Log.bStopping)
+	{
+		Log.WakeEvent->Wait(200);
+		Log.Flush();
+	}
+	// The records added before Shutdown
+	Log.Flush();
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include "Utils/RequestRecorder.h"
+
+#include "Runtime/Core/Public/GenericPlatform/GenericPlatformFile.h"
+#include "Runtime/Core/Public/HAL/PlatformFileManager.h"
+#include "Runtime/Core/Public/Misc/Crc.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+#include "UnrealcvStats.h"
+#include "UnrealcvLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FRequestRecorder::Add"), STAT_RequestRecorderAdd, STATGROUP_UnrealCV);
+
+namespace
+{
+	enum ERecordType : uint8
+	{
+		RecordString = 1,
+		RecordRequest = 2,
+	};
+
+	/** Write the buffer once it is larger than this */
+	const int32 BlockSize = 256 * 1024;
+
+	/** String index of a value that did not fit into the table */
+	const uint16 NoString = MAX_uint16;
+
+	template<typename T>
+	void AppendValue(TArray<uint8>& Buffer, T Value)
+	{
+		Buffer.Append((const uint8*)&Value, sizeof(T));
+	}
+
+	/** Append size and utf8 bytes, at most MaxSize bytes */
+	template<typename TSize>
+	void AppendString(TArray<uint8>& Buffer, const FString& Value, int32 MaxSize)
+	{
+		FTCHARToUTF8 Utf8(*Value);
+		const int32 Size = FMath::Min(Utf8.Length(), MaxSize);
+		AppendValue<TSize>(Buffer, (TSize)Size);
+		Buffer.Append((const uint8*)Utf8.Get(), Size);
+	}
+}
+
+LychSim::FRequestRecorder& LychSim::FRequestRecorder::Get()
+{
+	static FRequestRecorder Recorder;
+	return Recorder;
+}
+
+LychSim::FRequestRecorder::~FRequestRecorder()
+{
+	Stop();
+}
+
+bool LychSim::FRequestRecorder::Start(const FString& InPath)
+{
+	Stop();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InPath));
+	File = PlatformFile.OpenWrite(*InPath);
+	if (!File)
+	{
+		UE_LOG(LogUnrealCV, Error, TEXT("Can not open %s to record the requests"), *InPath);
+		return false;
+	}
+	Path = InPath;
+	StartTime = FPlatformTime::Seconds();
+	NumRecorded = 0;
+	BytesWritten = 0;
+
+	AppendValue<uint32>(Buffer, Magic);
+	AppendValue<uint16>(Buffer, Version);
+	AppendValue<uint16>(Buffer, 16);
+	AppendValue<double>(Buffer, (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalSeconds());
+	return true;
+}
+
+void LychSim::FRequestRecorder::Stop()
+{
+	if (!File)
+	{
+		return;
+	}
+	WriteBuffer();
+	delete File;
+	File = nullptr;
+	Strings.Empty();
+	UE_LOG(LogUnrealCV, Display, TEXT("Recorded %lld requests to %s"), NumRecorded, *Path);
+}
+
+void LychSim::FRequestRecorder::Add(const FRecordedRequest& Request)
+{
+	if (!File)
+	{
+		return;
+	}
+	SCOPE_CYCLE_COUNTER(STAT_RequestRecorderAdd);
+
+	// Strings are written before the request that uses them
+	const uint16 Endpoint = Request.Endpoint ? FindOrAddString(*Request.Endpoint) : NoString;
+	const uint16 Command = Request.Command ? FindOrAddString(*Request.Command) : NoString;
+
+	AppendValue<uint8>(Buffer, RecordRequest);
+	AppendValue<uint64>(Buffer, (uint64)(FMath::Max(Request.ReceiveTime - StartTime, 0.0) * 1e6));
+	AppendValue<uint32>(Buffer, Request.RequestId);
+	AppendValue<uint16>(Buffer, Endpoint);
+	AppendValue<uint16>(Buffer, Command);
+	AppendValue<uint8>(Buffer, Request.bError ? 1 : 0);
+	AppendValue<uint32>(Buffer, (uint32)Request.ReplySize);
+	AppendValue<uint32>(Buffer, Request.Reply ? FCrc::MemCrc32(Request.Reply, Request.ReplySize) : 0);
+	AppendValue<uint32>(Buffer, (uint32)FMath::Clamp(Request.LatencySeconds * 1e6, 0.0, (double)MAX_uint32));
+	AppendString<uint32>(Buffer, Request.Message ? *Request.Message : FString(), MAX_int32);
+	NumRecorded++;
+
+	if (Buffer.Num() >= BlockSize)
+	{
+		WriteBuffer();
+	}
+}
+
+uint16 LychSim::FRequestRecorder::FindOrAddString(const FString& Value)
+{
+	if (const uint16* Index = Strings.Find(Value))
+	{
+		return *Index;
+	}
+	if (Strings.Num() >= NoString)
+	{
+		return NoString;
+	}
+	const uint16 Index = (uint16)Strings.Num();
+	Strings.Add(Value, Index);
+	AppendValue<uint8>(Buffer, RecordString);
+	AppendValue<uint16>(Buffer, Index);
+	AppendString<uint16>(Buffer, Value, MAX_uint16);
+	return Index;
+}
+
+void LychSim::FRequestRecorder::WriteBuffer()
+{
+	if (File && Buffer.Num() > 0)
+	{
+		File->Write(Buffer.GetData(), Buffer.Num());
+		BytesWritten += Buffer.Num();
+	}
+	Buffer.Reset();
+}
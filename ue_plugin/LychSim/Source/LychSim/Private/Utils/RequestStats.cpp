@@ -0,0 +1,216 @@
+#include "Utils/RequestStats.h"
+
+#include "Runtime/Core/Public/HAL/PlatformTime.h"
+#include "Serialization/JsonWriter.h"
+
+LychSim::FLatencyHistogram::FLatencyHistogram()
+{
+	Reset();
+}
+
+int32 LychSim::FLatencyHistogram::GetBucketIndex(uint64 Value)
+{
+	// Values below two sub bucket ranges get one bucket each, above that the top SubBucketBits + 1 bits pick the bucket
+	if (Value < 2 * SubBucketCount)
+	{
+		return (int32)Value;
+	}
+	const int32 Shift = (int32)FPlatformMath::FloorLog2_64(Value) - SubBucketBits;
+	const int32 Index = (Shift + 1) * SubBucketCount + (int32)((Value >> Shift) - SubBucketCount);
+	return FMath::Min(Index, NumBuckets - 1);
+}
+
+uint64 LychSim::FLatencyHistogram::GetBucketUpperBound(int32 Index)
+{
+	if (Index < 2 * SubBucketCount)
+	{
+		return Index;
+	}
+	const int32 Shift = Index / SubBucketCount - 1;
+	const uint64 Mantissa = Index % SubBucketCount + SubBucketCount;
+	return ((Mantissa + 1) << Shift) - 1;
+}
+
+void LychSim::FLatencyHistogram::Record(uint64 Value)
+{
+	Buckets[GetBucketIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+	Count.fetch_add(1, std::memory_order_relaxed);
+	Sum.fetch_add(Value, std::memory_order_relaxed);
+	uint64 PrevMax = Max.load(std::memory_order_relaxed);
+	while (Value > PrevMax && !Max.compare_exchange_weak(PrevMax, Value, std::memory_order_relaxed))
+	{
+	}
+}
+
+void LychSim::FLatencyHistogram::Reset()
+{
+	for (std::atomic<uint64>& Bucket : Buckets)
+	{
+		Bucket.store(0, std::memory_order_relaxed);
+	}
+	Count.store(0, std::memory_order_relaxed);
+	Sum.store(0, std::memory_order_relaxed);
+	Max.store(0, std::memory_order_relaxed);
+}
+
+uint64 LychSim::FLatencyHistogram::GetPercentile(double Percentile) const
+{
+	// Read the buckets once, a concurrent Record may make them disagree with Count
+	uint64 Total = 0;
+	for (const std::atomic<uint64>& Bucket : Buckets)
+	{
+		Total += Bucket.load(std::memory_order_relaxed);
+	}
+	if (Total == 0)
+	{
+		return 0;
+	}
+	const uint64 Rank = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0, 100.0) / 100.0 * Total));
+	uint64 Seen = 0;
+	for (int32 i = 0; i < NumBuckets; i++)
+	{
+		Seen += Buckets[i].load(std::memory_order_relaxed);
+		if (Seen >= Rank)
+		{
+			return FMath::Min(GetBucketUpperBound(i), GetMax());
+		}
+	}
+	return GetMax();
+}
+
+const TCHAR* LychSim::GetRequestStageName(ERequestStage Stage)
+{
+	switch (Stage)
+	{
+	case ERequestStage::QueueWait: return TEXT("queue_wait");
+	case ERequestStage::Dispatch: return TEXT("dispatch");
+	case ERequestStage::Handler: return TEXT("handler");
+	case ERequestStage::Serialize: return TEXT("serialize");
+	case ERequestStage::Send: return TEXT("send");
+	}
+	return TEXT("unknown");
+}
+
+LychSim::FRequestStats& LychSim::FRequestStats::Get()
+{
+	static FRequestStats Stats;
+	return Stats;
+}
+
+LychSim::FCommandStats& LychSim::FRequestStats::FindOrAdd(const FString& Command)
+{
+	check(IsInGameThread());
+	// Requests that match no template share one entry
+	static const FString Unknown = TEXT("unknown");
+	const FString& Key = Command.IsEmpty() ? Unknown : Command;
+	if (TUniquePtr<FCommandStats>* Found = Commands.Find(Key))
+	{
+		return **Found;
+	}
+	return *Commands.Add(Key, MakeUnique<FCommandStats>());
+}
+
+void LychSim::FRequestStats::Record(const FString& Command, ERequestStage Stage, double Seconds)
+{
+	FindOrAdd(Command).Stages[(int32)Stage].Record((uint64)FMath::Max(Seconds * 1e6, 0.0));
+}
+
+void LychSim::FRequestStats::Reset()
+{
+	for (TPair<FString, TUniquePtr<FCommandStats>>& Pair : Commands)
+	{
+		for (FLatencyHistogram& Stage : Pair.Value->Stages)
+		{
+			Stage.Reset();
+		}
+		Pair.Value->BytesIn.Reset();
+		Pair.Value->BytesOut.Reset();
+	}
+	ResetTime = FPlatformTime::Seconds();
+}
+
+namespace
+{
+	void WriteHistogram(TJsonWriter<>& Writer, const FString& Name, const LychSim::FLatencyHistogram& Histogram)
+	{
+		const uint64 Count = Histogram.GetCount();
+		Writer.WriteObjectStart(Name);
+		Writer.WriteValue(TEXT("count"), (double)Count);
+		Writer.WriteValue(TEXT("sum"), (double)Histogram.GetSum());
+		Writer.WriteValue(TEXT("mean"), Count > 0 ? (double)Histogram.GetSum() / Count : 0.0);
+		Writer.WriteValue(TEXT("p50"), (double)Histogram.GetPercentile(50));
+		Writer.WriteValue(TEXT("p90"), (double)Histogram.GetPercentile(90));
+		Writer.WriteValue(TEXT("p99"), (double)Histogram.GetPercentile(99));
+		Writer.WriteValue(TEXT("max"), (double)Histogram.GetMax());
+		Writer.WriteObjectEnd();
+	}
+
+	/** Quote a label value of the Prometheus text format */
+	FString EscapeLabel(const FString& Value)
+	{
+		return Value.Replace(TEXT("\\"), TEXT("\\\\")).Replace(TEXT("\""), TEXT("\\\"")).Replace(TEXT("\n"), TEXT("\\n"));
+	}
+
+	void WriteSummary(FString& Out, const TCHAR* Metric, const FString& Labels, const LychSim::FLatencyHistogram& Histogram, double Scale)
+	{
+		static const double Quantiles[] = { 0.5, 0.9, 0.99 };
+		for (double Quantile : Quantiles)
+		{
+			Out += FString::Printf(TEXT("%s{%s,quantile=\"%g\"} %.9g\n"), Metric, *Labels, Quantile, Histogram.GetPercentile(Quantile * 100) * Scale);
+		}
+		Out += FString::Printf(TEXT("%s_sum{%s} %.9g\n"), Metric, *Labels, Histogram.GetSum() * Scale);
+		Out += FString::Printf(TEXT("%s_count{%s} %llu\n"), Metric, *Labels, Histogram.GetCount());
+	}
+}
+
+FString LychSim::FRequestStats::ToJson() const
+{
+	FString Out;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Out);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("status"), TEXT("ok"));
+	Writer->WriteValue(TEXT("seconds"), FPlatformTime::Seconds() - ResetTime);
+	Writer->WriteValue(TEXT("unit"), TEXT("us"));
+	Writer->WriteObjectStart(TEXT("commands"));
+	for (const TPair<FString, TUniquePtr<FCommandStats>>& Pair : Commands)
+	{
+		const FCommandStats& Stats = *Pair.Value;
+		Writer->WriteObjectStart(Pair.Key);
+		for (int32 i = 0; i < (int32)ERequestStage::Num; i++)
+		{
+			WriteHistogram(*Writer, GetRequestStageName((ERequestStage)i), Stats.Stages[i]);
+		}
+		WriteHistogram(*Writer, TEXT("bytes_in"), Stats.BytesIn);
+		WriteHistogram(*Writer, TEXT("bytes_out"), Stats.BytesOut);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteObjectEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return Out;
+}
+
+FString LychSim::FRequestStats::ToPrometheus() const
+{
+	FString Out;
+	Out += TEXT("# HELP lychsim_request_stage_seconds Time spent in each stage of a request.\n");
+	Out += TEXT("# TYPE lychsim_request_stage_seconds summary\n");
+	for (const TPair<FString, TUniquePtr<FCommandStats>>& Pair : Commands)
+	{
+		const FString Command = EscapeLabel(Pair.Key);
+		for (int32 i = 0; i < (int32)ERequestStage::Num; i++)
+		{
+			const FString Labels = FString::Printf(TEXT("command=\"%s\",stage=\"%s\""), *Command, GetRequestStageName((ERequestStage)i));
+			WriteSummary(Out, TEXT("lychsim_request_stage_seconds"), Labels, Pair.Value->Stages[i], 1e-6);
+		}
+	}
+	Out += TEXT("# HELP lychsim_request_bytes Size of the requests and the replies.\n");
+	Out += TEXT("# TYPE lychsim_request_bytes summary\n");
+	for (const TPair<FString, TUniquePtr<FCommandStats>>& Pair : Commands)
+	{
+		const FString Command = EscapeLabel(Pair.Key);
+		WriteSummary(Out, TEXT("lychsim_request_bytes"), FString::Printf(TEXT("command=\"%s\",direction=\"in\""), *Command), Pair.Value->BytesIn, 1);
+		WriteSummary(Out, TEXT("lychsim_request_bytes"), FString::Printf(TEXT("command=\"%s\",direction=\"out\""), *Command), Pair.Value->BytesOut, 1);
+	}
+	return Out;
+}
@@ -0,0 +1,149 @@
+#include "Utils/SegStats.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Async/TaskGraphInterfaces.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::ComputeSegStats"), STAT_ComputeSegStats, STATGROUP_UnrealCV);
+
+namespace
+{
+	const uint32 SegStatsMagic = 0x4745534C; // 'LSEG'
+	const uint16 SegStatsVersion = 1;
+	const uint16 SegStatsRowSize = 24;
+
+	FORCEINLINE uint32 PackRGB(const FColor& Color)
+	{
+		return (uint32(Color.R) << 16) | (uint32(Color.G) << 8) | uint32(Color.B);
+	}
+}
+
+void LychSim::ComputeSegStats(const TArray<FColor>& SegData, int Width, int Height,
+	const TArray<FColor>& InstanceColors, TArray<FSegInstanceStats>& OutStats)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ComputeSegStats);
+
+	const int32 NumInstances = InstanceColors.Num();
+	OutStats.SetNum(NumInstances);
+	for (int32 i = 0; i < NumInstances; i++)
+	{
+		OutStats[i] = FSegInstanceStats();
+		OutStats[i].Color = InstanceColors[i];
+	}
+	if (NumInstances == 0 || Width <= 0 || Height <= 0 || SegData.Num() != Width * Height)
+	{
+		return;
+	}
+
+	TMap<uint32, int32> ColorToIndex;
+	ColorToIndex.Reserve(NumInstances);
+	for (int32 i = 0; i < NumInstances; i++)
+	{
+		ColorToIndex.Add(PackRGB(InstanceColors[i]), i);
+	}
+
+	// Each chunk of rows accumulates into its own table, merged afterwards without locking
+	const int32 NumChunks = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, Height);
+	const int32 RowsPerChunk = FMath::DivideAndRoundUp(Height, NumChunks);
+	TArray<TArray<FSegInstanceStats>> ChunkStats;
+	ChunkStats.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		TArray<FSegInstanceStats>& Local = ChunkStats[ChunkIndex];
+		Local.SetNum(NumInstances);
+
+		const int32 RowBegin = ChunkIndex * RowsPerChunk;
+		const int32 RowEnd = FMath::Min(RowBegin + RowsPerChunk, Height);
+
+		// Segmentation masks are made of long runs, so remember the last lookup
+		uint32 LastKey = MAX_uint32;
+		int32 LastIndex = INDEX_NONE;
+		for (int32 Y = RowBegin; Y < RowEnd; Y++)
+		{
+			const FColor* Row = SegData.GetData() + Y * Width;
+			for (int32 X = 0; X < Width; X++)
+			{
+				const uint32 Key = PackRGB(Row[X]);
+				if (Key != LastKey)
+				{
+					const int32* Found = ColorToIndex.Find(Key);
+					LastKey = Key;
+					LastIndex = Found ? *Found : INDEX_NONE;
+				}
+				if (LastIndex == INDEX_NONE) continue;
+
+				FSegInstanceStats& Stats = Local[LastIndex];
+				Stats.PixelCount++;
+				Stats.XMin = FMath::Min(Stats.XMin, X);
+				Stats.XMax = FMath::Max(Stats.XMax, X);
+				Stats.YMin = FMath::Min(Stats.YMin, Y);
+				Stats.YMax = FMath::Max(Stats.YMax, Y);
+			}
+		}
+	});
+
+	for (const TArray<FSegInstanceStats>& Local : ChunkStats)
+	{
+		for (int32 i = 0; i < NumInstances; i++)
+		{
+			if (Local[i].PixelCount == 0) continue;
+			FSegInstanceStats& Stats = OutStats[i];
+			Stats.PixelCount += Local[i].PixelCount;
+			Stats.XMin = FMath::Min(Stats.XMin, Local[i].XMin);
+			Stats.XMax = FMath::Max(Stats.XMax, Local[i].XMax);
+			Stats.YMin = FMath::Min(Stats.YMin, Local[i].YMin);
+			Stats.YMax = FMath::Max(Stats.YMax, Local[i].YMax);
+		}
+	}
+
+	for (FSegInstanceStats& Stats : OutStats)
+	{
+		if (Stats.PixelCount == 0)
+		{
+			Stats.XMin = Stats.YMin = Stats.XMax = Stats.YMax = -1;
+			continue;
+		}
+		if (Stats.XMin == 0) Stats.Truncation |= SegTruncLeft;
+		if (Stats.YMin == 0) Stats.Truncation |= SegTruncTop;
+		if (Stats.XMax == Width - 1) Stats.Truncation |= SegTruncRight;
+		if (Stats.YMax == Height - 1) Stats.Truncation |= SegTruncBottom;
+	}
+}
+
+TArray<uint8> LychSim::SerializeSegStats(const TArray<FSegInstanceStats>& Stats,
+	const TArray<FString>& Names, int Width, int Height, const TArray<uint8>& MaskData)
+{
+	FBufferArchive Ar;
+
+	uint32 Magic = SegStatsMagic;
+	uint16 Version = SegStatsVersion;
+	uint16 RowSize = SegStatsRowSize;
+	int32 W = Width, H = Height;
+	uint32 NumRows = Stats.Num();
+	uint32 MaskBytes = MaskData.Num();
+	Ar << Magic << Version << RowSize << W << H << NumRows << MaskBytes;
+
+	for (const FSegInstanceStats& Row : Stats)
+	{
+		uint8 R = Row.Color.R, G = Row.Color.G, B = Row.Color.B, Truncation = Row.Truncation;
+		uint32 PixelCount = Row.PixelCount;
+		int32 XMin = Row.XMin, YMin = Row.YMin, XMax = Row.XMax, YMax = Row.YMax;
+		Ar << R << G << B << Truncation << PixelCount << XMin << YMin << XMax << YMax;
+	}
+
+	for (int32 i = 0; i < Stats.Num(); i++)
+	{
+		FTCHARToUTF8 Utf8(Names.IsValidIndex(i) ? *Names[i] : TEXT(""));
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	}
+
+	if (MaskData.Num() > 0)
+	{
+		Ar.Serialize((void*)MaskData.GetData(), MaskData.Num());
+	}
+	return MoveTemp(Ar);
+}
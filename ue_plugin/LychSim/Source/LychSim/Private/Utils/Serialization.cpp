@@ -4,7 +4,7 @@
 #include "Runtime/ImageWrapper/Public/IImageWrapper.h"
 #include "Runtime/ImageWrapper/Public/IImageWrapperModule.h"
 
-#include "libs/cnpy.h"
+#include "LychCore/Npy.h"
 #include "UnrealcvLog.h"
 
 TArray<uint8> FSerializationUtils::Array2Npy(const TArray<float>& ImageData, int32 Width, int32 Height, int32 Channel)
@@ -17,32 +17,33 @@ TArray<uint8> FSerializationUtils::Array2Npy(const TArray<float>& ImageData, int
 	}
 	float *TypePointer = nullptr; // Only used for determing the type
 
-	std::vector<int> Shape;
-	Shape.push_back(Height);
-	Shape.push_back(Width);
-	if (Channel != 1) Shape.push_back(Channel);
+	std::vector<char> NpyHeader = LychSim::Core::MakeNpyHeader(TypePointer, Width, Height, Channel);
 
-	std::vector<char> NpyHeader = cnpy::create_npy_header(TypePointer, Shape);
-	std::vector<float> FloatData;
+	// The float data is already laid out as npy expects, copy it in one go
+	const int32 NumBytes = ImageData.Num() * sizeof(float);
+	BinaryData.Reserve(NpyHeader.size() + NumBytes);
+	BinaryData.Append(reinterpret_cast<const uint8*>(NpyHeader.data()), NpyHeader.size());
+	BinaryData.Append(reinterpret_cast<const uint8*>(ImageData.GetData()), NumBytes);
+	return BinaryData;
+}
 
-	for (int i = 0; i < ImageData.Num(); i++)
+TArray<uint8> FSerializationUtils::Image2Npy(const TArray<FColor>& ImageData, int32 Width, int32 Height, int32 Channel)
+{
+	TArray<uint8> BinaryData;
+	if (Channel != 4 || ImageData.Num() != Width * Height)
 	{
-		// TODO: a faster conversion
-		float v = ImageData[i];
-		FloatData.push_back(v);
+		UE_LOG(LogUnrealCV, Warning, TEXT("The input argument to Image2Npy is not correct, expect Width * Height colors and 4 channels"));
+		return BinaryData;
 	}
+	uint8 *TypePointer = nullptr; // Only used for determing the type
 
-	// Convert to binary array
-	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&FloatData[0]);
-	std::vector<unsigned char> NpyData(bytes, bytes + sizeof(float) * FloatData.size());
-
-	NpyHeader.insert(NpyHeader.end(), NpyData.begin(), NpyData.end());
+	std::vector<char> NpyHeader = LychSim::Core::MakeNpyHeader(TypePointer, Width, Height, Channel);
 
-	// FIXME: Find a more efficient implementation
-	for (char Element : NpyHeader)
-	{
-		BinaryData.Add(Element);
-	}
+	// FColor is BGRA in memory, the array is [Height, Width, 4] in that order
+	const int32 NumBytes = ImageData.Num() * sizeof(FColor);
+	BinaryData.Reserve(NpyHeader.size() + NumBytes);
+	BinaryData.Append(reinterpret_cast<const uint8*>(NpyHeader.data()), NpyHeader.size());
+	BinaryData.Append(reinterpret_cast<const uint8*>(ImageData.GetData()), NumBytes);
 	return BinaryData;
 }
 
@@ -50,12 +51,7 @@ TArray<uint8> FSerializationUtils::Array2Npy(const TArray<FFloat16Color>& ImageD
 {
 	float *TypePointer = nullptr; // Only used for determing the type
 
-	std::vector<int> Shape;
-	Shape.push_back(Height);
-	Shape.push_back(Width);
-	if (Channel != 1) Shape.push_back(Channel);
-
-	std::vector<char> NpyHeader = cnpy::create_npy_header(TypePointer, Shape);
+	std::vector<char> NpyHeader = LychSim::Core::MakeNpyHeader(TypePointer, Width, Height, Channel);
 
 	// Append the actual data
 	// FIXME: A slow implementation to convert TArray<FFloat16Color> to binary.
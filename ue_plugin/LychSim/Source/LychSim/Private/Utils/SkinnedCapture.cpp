@@ -0,0 +1,141 @@
+#include "Utils/SkinnedCapture.h"
+
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+#include "Runtime/Core/Public/Serialization/BufferArchive.h"
+#include "Runtime/Engine/Classes/Components/SkinnedMeshComponent.h"
+#include "Runtime/Engine/Public/Rendering/SkeletalMeshLODRenderData.h"
+#include "Runtime/Engine/Public/Rendering/SkeletalMeshRenderData.h"
+#include "Runtime/Engine/Public/SkeletalRenderPublic.h"
+#include "GameFramework/Actor.h"
+#include "LychCore/RawTensor.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::CaptureSkinnedVertices"), STAT_CaptureSkinnedVertices, STATGROUP_UnrealCV);
+
+namespace
+{
+	/** Everything a worker needs to skin one component, gathered on the game thread */
+	struct FSkinningJob
+	{
+		USkinnedMeshComponent* Component = nullptr;
+		const FSkeletalMeshLODRenderData* LODData = nullptr;
+		const FSkinWeightVertexBuffer* SkinWeightBuffer = nullptr;
+		TArray<FMatrix44f> RefToLocals;
+		FMatrix44f ComponentToWorld;
+		uint32 VertexOffset = 0;
+		uint32 NumVertices = 0;
+	};
+}
+
+void LychSim::CaptureSkinnedVertices(const TArray<AActor*>& Actors, int32 LODIndex, FSkinnedVertexCapture& Out)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CaptureSkinnedVertices);
+
+	Out = FSkinnedVertexCapture();
+	TArray<FSkinningJob> Jobs;
+	uint32 NumVertices = 0;
+
+	for (AActor* Actor : Actors)
+	{
+		if (!IsValid(Actor)) continue;
+
+		Out.ActorNames.Add(Actor->GetName());
+		Out.Offsets.Add(NumVertices);
+
+		TArray<USkinnedMeshComponent*> Components;
+		Actor->GetComponents<USkinnedMeshComponent>(Components);
+		for (USkinnedMeshComponent* Component : Components)
+		{
+			if (!IsValid(Component) || Component->MeshObject == nullptr) continue;
+
+			const FSkeletalMeshRenderData& RenderData = Component->MeshObject->GetSkeletalMeshRenderData();
+			if (RenderData.LODRenderData.Num() == 0) continue;
+			const int32 ComponentLOD = FMath::Clamp(LODIndex, 0, RenderData.LODRenderData.Num() - 1);
+			const FSkinWeightVertexBuffer* SkinWeightBuffer = Component->GetSkinWeightBuffer(ComponentLOD);
+			if (!SkinWeightBuffer) continue;
+
+			FSkinningJob& Job = Jobs.AddDefaulted_GetRef();
+			Job.Component = Component;
+			Job.LODData = &RenderData.LODRenderData[ComponentLOD];
+			Job.SkinWeightBuffer = SkinWeightBuffer;
+			Job.ComponentToWorld = FMatrix44f(Component->GetComponentTransform().ToMatrixWithScale());
+			Job.VertexOffset = NumVertices;
+			Job.NumVertices = Job.LODData->GetNumVertices();
+			// The bone pose is read here, the workers only see this snapshot
+			Component->CacheRefToLocalMatrices(Job.RefToLocals);
+			NumVertices += Job.NumVertices;
+		}
+		Out.Counts.Add(NumVertices - Out.Offsets.Last());
+	}
+
+	Out.Positions.SetNumZeroed(NumVertices * 3);
+
+	// The game thread waits here, so the components and render data stay untouched while workers read them
+	ParallelFor(Jobs.Num(), [&](int32 JobIndex)
+	{
+		FSkinningJob& Job = Jobs[JobIndex];
+		TArray<FVector3f> SkinnedPositions;
+		USkinnedMeshComponent::ComputeSkinnedPositions(Job.Component, SkinnedPositions, Job.RefToLocals, *Job.LODData, *Job.SkinWeightBuffer);
+
+		const uint32 Count = FMath::Min((uint32)SkinnedPositions.Num(), Job.NumVertices);
+		FVector3f* Dst = reinterpret_cast<FVector3f*>(Out.Positions.GetData()) + Job.VertexOffset;
+		for (uint32 i = 0; i < Count; i++)
+		{
+			Dst[i] = Job.ComponentToWorld.TransformPosition(SkinnedPositions[i]);
+		}
+	});
+}
+
+TArray<uint8> LychSim::SerializeSkinnedVertices(const FSkinnedVertexCapture& Capture)
+{
+	FBufferArchive Ar;
+	uint32 Magic = 0x564B534C; // 'LSKV'
+	uint16 Version = 1;
+	uint16 Reserved = 0;
+	uint32 NumActors = Capture.ActorNames.Num();
+	uint32 NumVertices = Capture.Positions.Num() / 3;
+	Ar << Magic << Version << Reserved << NumActors << NumVertices;
+	for (uint32 i = 0; i < NumActors; i++)
+	{
+		uint32 Offset = Capture.Offsets[i], Count = Capture.Counts[i];
+		Ar << Offset << Count;
+	}
+	Ar.Serialize((void*)Capture.Positions.GetData(), Capture.Positions.Num() * sizeof(float));
+	for (const FString& Name : Capture.ActorNames)
+	{
+		FTCHARToUTF8 Utf8(*Name);
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	}
+	return MoveTemp(Ar);
+}
+
+void LychSim::SerializeSkinnedVerticesRaw(const FSkinnedVertexCapture& Capture, uint64 FrameId,
+	TArray<uint8>& OutHeader, TArray<uint8>& OutBody)
+{
+	FBufferArchive Ar;
+	Ar.Serialize((void*)Capture.Positions.GetData(), Capture.Positions.Num() * sizeof(float));
+	const int32 TensorSize = Ar.Num();
+	uint32 NumActors = Capture.ActorNames.Num();
+	Ar << NumActors;
+	for (uint32 i = 0; i < NumActors; i++)
+	{
+		uint32 Offset = Capture.Offsets[i], Count = Capture.Counts[i];
+		Ar << Offset << Count;
+	}
+	for (const FString& Name : Capture.ActorNames)
+	{
+		FTCHARToUTF8 Utf8(*Name);
+		uint16 Length = (uint16)FMath::Min(Utf8.Length(), (int32)MAX_uint16);
+		Ar << Length;
+		Ar.Serialize((void*)Utf8.Get(), Length);
+	}
+
+	Core::FRawTensorHeader Header = Core::MakeRawImageHeader(Core::ERawDType::Float32, 3, Capture.Positions.Num() / 3, 1, "XYZ");
+	Header.TrailerSize = Ar.Num() - TensorSize;
+	Header.FrameId = FrameId;
+	OutHeader.SetNumUninitialized(Core::RawTensorHeaderSize);
+	Core::WriteRawTensorHeader(OutHeader.GetData(), Header);
+	OutBody = MoveTemp(Ar);
+}
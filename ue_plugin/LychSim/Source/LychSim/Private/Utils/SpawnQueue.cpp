@@ -0,0 +1,407 @@
+#include "Utils/SpawnQueue.h"
+
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Actor/LychSimBasicActor.h"
+#include "UnrealcvServer.h"
+#include "WorldController.h"
+#include "UnrealcvLog.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("FLychSimSpawnQueue::Tick"), STAT_SpawnQueueTick, STATGROUP_UnrealCV);
+
+namespace
+{
+	const uint32 SpawnManifestMagic = 0x4E50534C; // 'LSPN'
+	const int32 MaxReportedErrors = 32;
+	const int32 MaxFinishedJobs = 64;
+
+	/** LoadObject accepts "/Game/Dir/Mesh", the streamable manager needs the full "/Game/Dir/Mesh.Mesh" */
+	FString NormalizeAssetPath(const FString& Path)
+	{
+		if (Path.Contains(TEXT(".")))
+		{
+			return Path;
+		}
+		return Path + TEXT(".") + FPackageName::GetShortName(Path);
+	}
+
+	bool ParseBinaryManifest(const TArray<uint8>& Data, LychSim::FSpawnManifest& OutManifest)
+	{
+		int32 Offset = 0;
+		auto Read = [&](void* Dst, int32 Size) -> bool
+		{
+			if (Offset + Size > Data.Num()) return false;
+			FMemory::Memcpy(Dst, Data.GetData() + Offset, Size);
+			Offset += Size;
+			return true;
+		};
+		auto ReadString = [&](FString& Out) -> bool
+		{
+			uint16 Length = 0;
+			if (!Read(&Length, 2) || Offset + Length > Data.Num()) return false;
+			Out = FString(FUTF8ToTCHAR((const ANSICHAR*)Data.GetData() + Offset, Length));
+			Offset += Length;
+			return true;
+		};
+		// The counts are untrusted, they can not be more than the smallest items that fit in the rest
+		auto Fits = [&](uint32 Count, int64 MinItemSize) -> bool
+		{
+			return (int64)Count * MinItemSize <= (int64)(Data.Num() - Offset);
+		};
+
+		uint32 Magic = 0, NumAssets = 0, NumEntries = 0;
+		if (!Read(&Magic, 4) || Magic != SpawnManifestMagic || !Read(&NumAssets, 4)) return false;
+
+		// A path is at least its uint16 length
+		if (!Fits(NumAssets, 2)) return false;
+		OutManifest.AssetPaths.Reserve(NumAssets);
+		for (uint32 i = 0; i < NumAssets; i++)
+		{
+			if (!ReadString(OutManifest.AssetPaths.AddDefaulted_GetRef())) return false;
+		}
+
+		// An entry is at least the name length, the asset index and 9 floats
+		if (!Read(&NumEntries, 4) || !Fits(NumEntries, 2 + 4 + 9 * sizeof(float))) return false;
+		OutManifest.Entries.Reserve(NumEntries);
+		for (uint32 i = 0; i < NumEntries; i++)
+		{
+			LychSim::FSpawnEntry& Entry = OutManifest.Entries.AddDefaulted_GetRef();
+			uint32 AssetIndex = 0;
+			float Values[9];
+			if (!ReadString(Entry.Name) || !Read(&AssetIndex, 4) || !Read(Values, sizeof(Values))) return false;
+			if (AssetIndex >= NumAssets) return false;
+			Entry.AssetIndex = AssetIndex;
+			Entry.Transform = FTransform(
+				FRotator(Values[3], Values[4], Values[5]),
+				FVector(Values[0], Values[1], Values[2]),
+				FVector(Values[6], Values[7], Values[8]));
+		}
+		return true;
+	}
+
+	bool ParseJsonManifest(const TArray<uint8>& Data, LychSim::FSpawnManifest& OutManifest, FString& OutError)
+	{
+		FString Text(FUTF8ToTCHAR((const ANSICHAR*)Data.GetData(), Data.Num()));
+		TSharedPtr<FJsonValue> Root;
+		if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid())
+		{
+			OutError = TEXT("Cannot parse manifest");
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* Objects = nullptr;
+		if (Root->Type == EJson::Object)
+		{
+			Root->AsObject()->TryGetArrayField(TEXT("objects"), Objects);
+		}
+		else
+		{
+			Root->TryGetArray(Objects);
+		}
+		if (!Objects)
+		{
+			OutError = TEXT("Manifest should be a list of objects");
+			return false;
+		}
+
+		auto GetVector = [](const TSharedPtr<FJsonObject>& Object, const TCHAR* Field, const FVector& Default) -> FVector
+		{
+			const TArray<TSharedPtr<FJsonValue>>* Values = nullptr;
+			if (!Object->TryGetArrayField(Field, Values) || Values->Num() != 3)
+			{
+				return Default;
+			}
+			return FVector((*Values)[0]->AsNumber(), (*Values)[1]->AsNumber(), (*Values)[2]->AsNumber());
+		};
+
+		TMap<FString, int32> AssetIndices;
+		OutManifest.Entries.Reserve(Objects->Num());
+		for (const TSharedPtr<FJsonValue>& Value : *Objects)
+		{
+			const TSharedPtr<FJsonObject>* Object = nullptr;
+			FString Path;
+			if (!Value->TryGetObject(Object) || !(*Object)->TryGetStringField(TEXT("path"), Path))
+			{
+				OutError = TEXT("Every object needs a path");
+				return false;
+			}
+
+			LychSim::FSpawnEntry& Entry = OutManifest.Entries.AddDefaulted_GetRef();
+			(*Object)->TryGetStringField(TEXT("name"), Entry.Name);
+			if (const int32* Found = AssetIndices.Find(Path))
+			{
+				Entry.AssetIndex = *Found;
+			}
+			else
+			{
+				Entry.AssetIndex = OutManifest.AssetPaths.Add(Path);
+				AssetIndices.Add(Path, Entry.AssetIndex);
+			}
+
+			const FVector Rotation = GetVector(*Object, TEXT("rot"), FVector::ZeroVector);
+			Entry.Transform = FTransform(
+				FRotator(Rotation.X, Rotation.Y, Rotation.Z),
+				GetVector(*Object, TEXT("loc"), FVector::ZeroVector),
+				GetVector(*Object, TEXT("scale"), FVector::OneVector));
+		}
+		return true;
+	}
+}
+
+bool LychSim::ParseSpawnManifest(const TArray<uint8>& Data, FSpawnManifest& OutManifest, FString& OutError)
+{
+	uint32 Magic = 0;
+	if (Data.Num() >= 4)
+	{
+		FMemory::Memcpy(&Magic, Data.GetData(), 4);
+	}
+	if (Magic == SpawnManifestMagic)
+	{
+		if (!ParseBinaryManifest(Data, OutManifest))
+		{
+			OutError = TEXT("Cannot parse binary manifest");
+			return false;
+		}
+		return true;
+	}
+	return ParseJsonManifest(Data, OutManifest, OutError);
+}
+
+int32 FLychSimSpawnQueue::AddJob(UWorld* World, LychSim::FSpawnManifest&& Manifest, const FJobOptions& Options)
+{
+	PruneFinishedJobs();
+
+	const int32 JobId = NextJobId++;
+	FJob& Job = Jobs.Add(JobId);
+	Job.Id = JobId;
+	Job.Options = Options;
+	Job.World = World;
+	Job.Manifest = MoveTemp(Manifest);
+	Job.Total = Job.Manifest.Entries.Num();
+	Job.NumAssets = Job.Manifest.AssetPaths.Num();
+	Job.StartTime = FPlatformTime::Seconds();
+
+	// Only the unique meshes are requested, the manifest usually repeats a few assets many times
+	TArray<FSoftObjectPath> AssetPaths;
+	AssetPaths.Reserve(Job.Manifest.AssetPaths.Num());
+	for (const FString& Path : Job.Manifest.AssetPaths)
+	{
+		AssetPaths.Add(FSoftObjectPath(NormalizeAssetPath(Path)));
+	}
+	if (AssetPaths.Num() > 0)
+	{
+		Job.Handle = StreamableManager.RequestAsyncLoad(AssetPaths, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+	}
+	NumActiveJobs++;
+	return JobId;
+}
+
+bool FLychSimSpawnQueue::CancelJob(int32 JobId)
+{
+	FJob* Job = Jobs.Find(JobId);
+	if (!Job)
+	{
+		return false;
+	}
+	if (Job->State == EJobState::Loading || Job->State == EJobState::Spawning)
+	{
+		if (Job->Handle.IsValid())
+		{
+			Job->Handle->CancelHandle();
+		}
+		FinishJob(*Job, EJobState::Cancelled);
+	}
+	return true;
+}
+
+void FLychSimSpawnQueue::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpawnQueueTick);
+
+	for (TPair<int32, FJob>& Item : Jobs)
+	{
+		FJob& Job = Item.Value;
+		if (Job.State == EJobState::Loading)
+		{
+			if (Job.Handle.IsValid() && !Job.Handle->HasLoadCompleted() && !Job.Handle->WasCanceled())
+			{
+				int32 RequestedCount = 0;
+				Job.Handle->GetLoadedCount(Job.NumAssetsLoaded, RequestedCount);
+				continue;
+			}
+
+			Job.Meshes.SetNum(Job.Manifest.AssetPaths.Num());
+			Job.NumAssetsLoaded = 0;
+			for (int32 i = 0; i < Job.Meshes.Num(); i++)
+			{
+				Job.Meshes[i] = Cast<UStaticMesh>(FSoftObjectPath(NormalizeAssetPath(Job.Manifest.AssetPaths[i])).ResolveObject());
+				if (Job.Meshes[i])
+				{
+					Job.NumAssetsLoaded++;
+				}
+				else
+				{
+					AddError(Job, FString::Printf(TEXT("Failed to load mesh from path: %s"), *Job.Manifest.AssetPaths[i]));
+				}
+			}
+			Job.LoadTime = FPlatformTime::Seconds();
+			Job.State = EJobState::Spawning;
+		}
+
+		if (Job.State == EJobState::Spawning && SpawnSome(Job))
+		{
+			FinishJob(Job, EJobState::Done);
+		}
+	}
+}
+
+bool FLychSimSpawnQueue::SpawnSome(FJob& Job)
+{
+	UWorld* World = Job.World.Get();
+	if (!IsValid(World))
+	{
+		AddError(Job, TEXT("The world of the job is gone"));
+		Job.NumFailed += Job.Total - Job.NextEntry;
+		Job.NextEntry = Job.Total;
+		return true;
+	}
+
+	const double Deadline = FPlatformTime::Seconds() + Job.Options.BudgetSeconds;
+	while (Job.NextEntry < Job.Total)
+	{
+		const LychSim::FSpawnEntry& Entry = Job.Manifest.Entries[Job.NextEntry++];
+		UStaticMesh* Mesh = Job.Meshes[Entry.AssetIndex];
+		const FName Name = Entry.Name.IsEmpty() ? NAME_None : FName(*Entry.Name);
+
+		// Hash lookup in the level the actor is spawned into, instead of iterating all actors
+		if (Name != NAME_None && FindObjectFast<AActor>(World->PersistentLevel, Name))
+		{
+			AddError(Job, FString::Printf(TEXT("Object with the same name already exists: %s"), *Entry.Name));
+			Job.NumFailed++;
+		}
+		else if (!Mesh)
+		{
+			Job.NumFailed++;
+		}
+		else
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.Name = Name;
+			ALychSimBasicActor* NewActor = World->SpawnActor<ALychSimBasicActor>(
+				ALychSimBasicActor::StaticClass(), Entry.Transform, SpawnParams);
+			if (NewActor)
+			{
+				NewActor->SetMesh(Mesh, Job.Options.bSimulatePhysics);
+				Job.NumSpawned++;
+			}
+			else
+			{
+				AddError(Job, FString::Printf(TEXT("Failed to spawn actor: %s"), *Entry.Name));
+				Job.NumFailed++;
+			}
+		}
+
+		if (FPlatformTime::Seconds() > Deadline)
+		{
+			break;
+		}
+	}
+	return Job.NextEntry >= Job.Total;
+}
+
+void FLychSimSpawnQueue::FinishJob(FJob& Job, EJobState State)
+{
+	Job.State = State;
+	Job.EndTime = FPlatformTime::Seconds();
+	NumActiveJobs--;
+
+	// Only the counters are reported from now on
+	Job.Handle.Reset();
+	Job.Meshes.Empty();
+	Job.Manifest = LychSim::FSpawnManifest();
+
+	if (Job.NumSpawned > 0)
+	{
+		TWeakObjectPtr<AUnrealcvWorldController> WorldController = FUnrealcvServer::Get().WorldController;
+		if (WorldController.IsValid() && WorldController->IsAnnotationsReady())
+		{
+			WorldController->AnnotateNewObjects();
+		}
+	}
+	UE_LOG(LogUnrealCV, Display, TEXT("Spawn job %d finished, %d spawned, %d failed in %.3fs"),
+		Job.Id, Job.NumSpawned, Job.NumFailed, Job.EndTime - Job.StartTime);
+}
+
+void FLychSimSpawnQueue::AddError(FJob& Job, const FString& Error)
+{
+	if (Job.Errors.Num() < MaxReportedErrors)
+	{
+		Job.Errors.Add(Error);
+	}
+}
+
+void FLychSimSpawnQueue::PruneFinishedJobs()
+{
+	TArray<int32> FinishedIds;
+	for (const TPair<int32, FJob>& Item : Jobs)
+	{
+		if (Item.Value.State == EJobState::Done || Item.Value.State == EJobState::Cancelled)
+		{
+			FinishedIds.Add(Item.Key);
+		}
+	}
+	if (FinishedIds.Num() <= MaxFinishedJobs)
+	{
+		return;
+	}
+	// Ids increase with every job, the lowest are the oldest
+	FinishedIds.Sort();
+	for (int32 i = 0; i < FinishedIds.Num() - MaxFinishedJobs; i++)
+	{
+		Jobs.Remove(FinishedIds[i]);
+	}
+}
+
+bool FLychSimSpawnQueue::WriteJobStatus(int32 JobId, const TSharedRef<TJsonWriter<>>& Writer)
+{
+	const FJob* Job = Jobs.Find(JobId);
+	if (!Job)
+	{
+		return false;
+	}
+
+	const TCHAR* StateNames[] = { TEXT("loading"), TEXT("spawning"), TEXT("done"), TEXT("cancelled") };
+	const bool bFinished = Job->State == EJobState::Done || Job->State == EJobState::Cancelled;
+	const double Now = bFinished ? Job->EndTime : FPlatformTime::Seconds();
+
+	Writer->WriteValue(TEXT("job"), Job->Id);
+	Writer->WriteValue(TEXT("state"), StateNames[(int32)Job->State]);
+	Writer->WriteValue(TEXT("done"), bFinished);
+	Writer->WriteValue(TEXT("total"), Job->Total);
+	Writer->WriteValue(TEXT("spawned"), Job->NumSpawned);
+	Writer->WriteValue(TEXT("failed"), Job->NumFailed);
+	Writer->WriteValue(TEXT("assets_loaded"), Job->NumAssetsLoaded);
+	Writer->WriteValue(TEXT("assets_total"), Job->NumAssets);
+	Writer->WriteValue(TEXT("elapsed"), Now - Job->StartTime);
+	if (Job->LoadTime > 0.0)
+	{
+		Writer->WriteValue(TEXT("load_time"), Job->LoadTime - Job->StartTime);
+	}
+	Writer->WriteArrayStart(TEXT("errors"));
+	for (const FString& Error : Job->Errors)
+	{
+		Writer->WriteValue(Error);
+	}
+	Writer->WriteArrayEnd();
+
+	// The final status has been reported, a later query gets "Job not found"
+	if (bFinished)
+	{
+		Jobs.Remove(JobId);
+	}
+	return true;
+}
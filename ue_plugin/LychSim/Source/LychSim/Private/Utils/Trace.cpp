@@ -0,0 +1,148 @@
+#include "Utils/Trace.h"
+
+#include "Runtime/Core/Public/HAL/PlatformTLS.h"
+#include "Runtime/Core/Public/HAL/ThreadManager.h"
+#include "Runtime/Core/Public/Misc/ScopeLock.h"
+
+std::atomic<bool> LychSim::FTrace::bEnabled(false);
+
+namespace
+{
+	struct FTraceEvent
+	{
+		const TCHAR* Name;
+		uint64 StartCycles;
+		uint64 EndCycles;
+		uint32 RequestId;
+	};
+
+	/** Written by its thread only, NumWritten is published after the event */
+	struct FThreadBuffer
+	{
+		uint32 ThreadId = 0;
+		FString ThreadName;
+		TArray<FTraceEvent> Events;
+		std::atomic<uint64> NumWritten{ 0 };
+	};
+
+	/** Buffers live until the module is unloaded, a thread keeps a raw pointer to its own */
+	FCriticalSection BuffersLock;
+	TArray<TUniquePtr<FThreadBuffer>> Buffers;
+	uint64 SessionStartCycles = 0;
+	thread_local FThreadBuffer* ThreadBuffer = nullptr;
+
+	FThreadBuffer& GetThreadBuffer()
+	{
+		if (ThreadBuffer == nullptr)
+		{
+			TUniquePtr<FThreadBuffer> Buffer = MakeUnique<FThreadBuffer>();
+			Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+			Buffer->ThreadName = IsInGameThread() ? TEXT("GameThread") : FThreadManager::Get().GetThreadName(Buffer->ThreadId);
+			if (Buffer->ThreadName.IsEmpty())
+			{
+				Buffer->ThreadName = FString::Printf(TEXT("Thread %u"), Buffer->ThreadId);
+			}
+			Buffer->Events.SetNumUninitialized(LychSim::FTrace::EventsPerThread);
+			ThreadBuffer = Buffer.Get();
+
+			FScopeLock ScopeLock(&BuffersLock);
+			Buffers.Add(MoveTemp(Buffer));
+		}
+		return *ThreadBuffer;
+	}
+
+	double CyclesToMicroseconds(uint64 Cycles)
+	{
+		return FPlatformTime::ToSeconds64(Cycles - SessionStartCycles) * 1e6;
+	}
+}
+
+void LychSim::FTrace::Enable()
+{
+	{
+		FScopeLock ScopeLock(&BuffersLock);
+		for (TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+		{
+			Buffer->NumWritten.store(0, std::memory_order_relaxed);
+		}
+		SessionStartCycles = FPlatformTime::Cycles64();
+	}
+	bEnabled.store(true, std::memory_order_release);
+}
+
+void LychSim::FTrace::Disable()
+{
+	bEnabled.store(false, std::memory_order_release);
+}
+
+void LychSim::FTrace::AddSpan(const TCHAR* Name, uint64 StartCycles, uint64 EndCycles, uint32 RequestId)
+{
+	FThreadBuffer& Buffer = GetThreadBuffer();
+	const uint64 Index = Buffer.NumWritten.load(std::memory_order_relaxed);
+	Buffer.Events[Index % EventsPerThread] = FTraceEvent{ Name, StartCycles, EndCycles, RequestId };
+	Buffer.NumWritten.store(Index + 1, std::memory_order_release);
+}
+
+FString LychSim::FTrace::ToChromeTrace()
+{
+	struct FFlowPoint
+	{
+		double Time;
+		uint32 ThreadId;
+	};
+	TMap<uint32, TArray<FFlowPoint>> Flows;
+
+	FString Out = TEXT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	bool bFirst = true;
+	auto Append = [&Out, &bFirst](const FString& Event)
+	{
+		if (!bFirst) Out += TEXT(",");
+		Out += Event;
+		bFirst = false;
+	};
+
+	const uint32 ProcessId = FPlatformProcess::GetCurrentProcessId();
+	FScopeLock ScopeLock(&BuffersLock);
+	for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+	{
+		const uint64 NumWritten = Buffer->NumWritten.load(std::memory_order_acquire);
+		if (NumWritten == 0) continue;
+
+		Append(FString::Printf(TEXT("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"),
+			ProcessId, Buffer->ThreadId, *Buffer->ThreadName.ReplaceCharWithEscapedChar()));
+
+		// Skip the slot the thread may be overwriting right now
+		const uint64 First = NumWritten > EventsPerThread ? NumWritten - EventsPerThread + 1 : 0;
+		for (uint64 i = First; i < NumWritten; i++)
+		{
+			const FTraceEvent& Event = Buffer->Events[i % EventsPerThread];
+			if (Event.StartCycles < SessionStartCycles) continue;
+			const double Start = CyclesToMicroseconds(Event.StartCycles);
+			const double Duration = FPlatformTime::ToSeconds64(Event.EndCycles - Event.StartCycles) * 1e6;
+			FString Args;
+			if (Event.RequestId != 0)
+			{
+				Args = FString::Printf(TEXT(",\"args\":{\"request_id\":%u}"), Event.RequestId);
+				Flows.FindOrAdd(Event.RequestId).Add(FFlowPoint{ Start, Buffer->ThreadId });
+			}
+			Append(FString::Printf(TEXT("{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"lychsim\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f%s}"),
+				Event.Name, ProcessId, Buffer->ThreadId, Start, Duration, *Args));
+		}
+	}
+
+	// One arrow per request from its first span to its last, through every span in between
+	for (TPair<uint32, TArray<FFlowPoint>>& Flow : Flows)
+	{
+		TArray<FFlowPoint>& Points = Flow.Value;
+		if (Points.Num() < 2) continue;
+		Points.Sort([](const FFlowPoint& A, const FFlowPoint& B) { return A.Time < B.Time; });
+		for (int32 i = 0; i < Points.Num(); i++)
+		{
+			const TCHAR* Phase = i == 0 ? TEXT("s") : (i == Points.Num() - 1 ? TEXT("f") : TEXT("t"));
+			Append(FString::Printf(TEXT("{\"ph\":\"%s\",\"name\":\"request\",\"cat\":\"request\",\"id\":%u,\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"bp\":\"e\"}"),
+				Phase, Flow.Key, ProcessId, Points[i].ThreadId, Points[i].Time));
+		}
+	}
+	Out += TEXT("]}");
+	return Out;
+}
@@ -0,0 +1,144 @@
+#include "Utils/WriterPool.h"
+
+#include "Runtime/Core/Public/HAL/Event.h"
+#include "Runtime/Core/Public/HAL/RunnableThread.h"
+#include "Runtime/Core/Public/Misc/ScopeLock.h"
+#include "UnrealcvStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("LychSim::FWriterPool::RunTask"), STAT_WriterPoolRunTask, STATGROUP_UnrealCV);
+
+LychSim::FWriterPool::FWriterPool(const TCHAR* InName, int32 NumThreads, int32 InMaxQueuedTasks, int64 InMaxPendingBytes)
+	: MaxQueuedTasks(FMath::Max(InMaxQueuedTasks, 1))
+	, MaxPendingBytes(FMath::Max(InMaxPendingBytes, (int64)0))
+{
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	SpaceEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	IdleEvent = FPlatformProcess::GetSynchEventFromPool(true);
+	IdleEvent->Trigger();
+
+	for (int32 i = 0; i < FMath::Max(NumThreads, 1); i++)
+	{
+		FWorker* Worker = Workers.Add_GetRef(MakeUnique<FWorker>(*this)).Get();
+		FString ThreadName = FString::Printf(TEXT("%s%d"), InName, i);
+		Threads.Add(FRunnableThread::Create(Worker, *ThreadName, 0, TPri_BelowNormal));
+	}
+}
+
+LychSim::FWriterPool::~FWriterPool()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		bStopping = true;
+	}
+	WorkEvent->Trigger();
+	for (FRunnableThread* Thread : Threads)
+	{
+		if (Thread)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+	}
+	Threads.Empty();
+	Workers.Empty();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+	FPlatformProcess::ReturnSynchEventToPool(IdleEvent);
+}
+
+void LychSim::FWriterPool::Enqueue(TUniqueFunction<void()>&& Task, int64 Bytes)
+{
+	while (true)
+	{
+		{
+			FScopeLock ScopeLock(&Lock);
+			const bool bIdle = NumQueued == 0 && NumRunning == 0;
+			const bool bOverMemory = MaxPendingBytes > 0 && NumPendingBytes + Bytes > MaxPendingBytes;
+			if (bIdle || (NumQueued < MaxQueuedTasks && !bOverMemory))
+			{
+				Tasks.Enqueue(FTask{ MoveTemp(Task), Bytes });
+				NumQueued++;
+				NumPendingBytes += Bytes;
+				IdleEvent->Reset();
+				break;
+			}
+		}
+		// Backpressure, the writers are behind
+		SpaceEvent->Wait();
+	}
+	WorkEvent->Trigger();
+}
+
+bool LychSim::FWriterPool::Flush(uint32 WaitTimeMs)
+{
+	return IdleEvent->Wait(WaitTimeMs);
+}
+
+int32 LychSim::FWriterPool::NumPending() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return NumQueued + NumRunning;
+}
+
+int64 LychSim::FWriterPool::PendingBytes() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return NumPendingBytes;
+}
+
+bool LychSim::FWriterPool::Dequeue(FTask& OutTask)
+{
+	while (true)
+	{
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Tasks.Dequeue(OutTask))
+			{
+				NumQueued--;
+				NumRunning++;
+				// An auto reset event wakes one thread, pass the wake up on while work is left
+				if (NumQueued > 0) WorkEvent->Trigger();
+				SpaceEvent->Trigger();
+				return true;
+			}
+			if (bStopping)
+			{
+				WorkEvent->Trigger();
+				return false;
+			}
+		}
+		WorkEvent->Wait();
+	}
+}
+
+void LychSim::FWriterPool::FinishTask(int64 Bytes)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		NumRunning--;
+		NumPendingBytes -= Bytes;
+		if (NumQueued == 0 && NumRunning == 0)
+		{
+			IdleEvent->Trigger();
+		}
+	}
+	// The memory of the task is released, a producer over the cap may go on
+	SpaceEvent->Trigger();
+}
+
+uint32 LychSim::FWriterPool::FWorker::Run()
+{
+	FTask Task;
+	while (Pool.Dequeue(Task))
+	{
+		{
+			SCOPE_CYCLE_COUNTER(STAT_WriterPoolRunTask);
+			Task.Function();
+		}
+		// Free the captured data before the bytes are released
+		Task.Function.Reset();
+		Pool.FinishTask(Task.Bytes);
+	}
+	return 0;
+}
@@ -1,6 +1,4 @@
 #include "Utils/argparse.h"
-#include "Misc/Parse.h"
-#include "Misc/CommandLine.h"
 
 static FString JoinArray(const TArray<FString>& A)
 {
@@ -32,48 +30,31 @@ static FString JoinSet(const TSet<FString>& S)
 namespace LychSim
 {
 	FParsedCmd ParseTailWithFParse(const FString& Tail)
-    {
-        FParsedCmd Out;
-
-        const TCHAR* Cmd = *Tail;
-        FString Tok;
-
-        while (FParse::Token(Cmd, Tok, /*UseEscape*/ false))
-        {
-			if (!Tok.StartsWith(TEXT("-")) || Tok.Len() < 2)
-			{
-                Out.Positionals.Add(MoveTemp(Tok));
-                continue;
-            }
-
-			// -.5 -0.5 -1
-			const TCHAR NextChar = Tok[1];
-            if (Tok.StartsWith(TEXT("-")) && (FChar::IsDigit(NextChar) || NextChar == TEXT('.')))
-            {
-                Out.Positionals.Add(MoveTemp(Tok));
-                continue;
-            }
-
-            FString Sw = Tok.Mid(1);
-            FString K, V;
-            if (Sw.Split(TEXT("="), &K, &V))
-			{
-				K.TrimStartAndEndInline();
-				V.TrimStartAndEndInline();
-				Out.Kwargs.Add(MoveTemp(K), MoveTemp(V));
-			}
-            else
-			{
-				Sw.TrimStartAndEndInline();
-				if (!Sw.IsEmpty())
-				{
-					Out.Flags.Add(MoveTemp(Sw));
-				}
-			}
-        }
+	{
+		FTCHARToUTF8 Utf8(*Tail);
+		Core::FParsedArgs Args;
+		Core::ParseArgs(std::string_view(Utf8.Get(), Utf8.Length()), Args);
+		return ToParsedCmd(Args);
+	}
 
-        return Out;
-    }
+	FParsedCmd ToParsedCmd(const Core::FParsedArgs& Args)
+	{
+		FParsedCmd Out;
+		Out.Positionals.Reserve(Args.Positionals.size());
+		for (const std::string& Positional : Args.Positionals)
+		{
+			Out.Positionals.Add(UTF8_TO_TCHAR(Positional.c_str()));
+		}
+		for (const auto& Kwarg : Args.Kwargs)
+		{
+			Out.Kwargs.Add(UTF8_TO_TCHAR(Kwarg.first.c_str()), UTF8_TO_TCHAR(Kwarg.second.c_str()));
+		}
+		for (const std::string& Flag : Args.Flags)
+		{
+			Out.Flags.Add(UTF8_TO_TCHAR(Flag.c_str()));
+		}
+		return Out;
+	}
 
     FString ParsedCmdToString(const FParsedCmd& Cmd)
     {
@@ -2,6 +2,8 @@
 // Released under MIT License
 // Simplied by Weichao Qiu (qiuwch@gmail.com) from https://github.com/rogersce/cnpy
 #include "cnpy.h"
+#include <cstring>
+#include <sstream>
 #include <vector>
 #include <complex>
 
@@ -9,11 +11,6 @@ using byte = unsigned char;
 
 namespace cnpy {
 
-template 
-std::vector<char> create_npy_header<unsigned char>(const unsigned char* data, const std::vector<int> shape);
-template 
-std::vector<char> create_npy_header<float>(const float* data, const std::vector<int> shape);
-
 /** from: http://www.cplusplus.com/forum/beginner/155821/ */
 // template< typename T > std::vector<byte>  to_bytes(const T& object)
 // {
@@ -116,7 +113,7 @@ std::vector<char> create_npy_header(const T* data, const std::vector<int> shape)
 	dict += tostring(shape[0]);
 
 	size_t ndims = shape.size();
-	for (int i = 1; i < ndims; i++) {
+	for (size_t i = 1; i < ndims; i++) {
 		dict += ", ";
 		dict += tostring(shape[i]);
 	}
@@ -137,4 +134,10 @@ std::vector<char> create_npy_header(const T* data, const std::vector<int> shape)
 
 	return header;
 }
+
+// After the definition, so they are instantiated
+template
+std::vector<char> create_npy_header<unsigned char>(const unsigned char* data, const std::vector<int> shape);
+template
+std::vector<char> create_npy_header<float>(const float* data, const std::vector<int> shape);
 }
@@ -6,6 +6,8 @@
 #include "JsonObjectBP.h"
 #include "DataCaptureActor.generated.h"
 
+namespace LychSim { class FDatasetWriter; }
+
 
 UENUM()
 enum class EFolderStructure
@@ -14,6 +16,13 @@ enum class EFolderStructure
 	Tree, // Organize by folders
 };
 
+UENUM()
+enum class EDatasetFormat
+{
+	Files, // One file per record
+	TarShards, // One WebDataset sample per frame, packed into tar shards
+};
+
 UENUM()
 enum class EImageId
 {
@@ -72,6 +81,13 @@ public:
 	UPROPERTY(EditInstanceOnly, Category = "DataCapture")
 	EImageId ImageIdType;
 
+	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Output Setting")
+	EDatasetFormat DatasetFormat;
+
+	/** Start a new shard after this size, a frame is never split across shards */
+	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Output Setting", meta=(EditCondition="DatasetFormat==EDatasetFormat::TarShards"))
+	int32 ShardSizeMB;
+
 	/** How many frames have been saved in this session */
 	int FrameCounter;
 
@@ -114,6 +130,7 @@ public:
 	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Scene Setting")
 	bool bOnlyFirstFrame;
 
+	/** Only used with TarShards, where the summary is stored with the sample of each frame */
 	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Scene Setting")
 	bool bCaptureSceneSummary;
 
@@ -132,11 +149,24 @@ public:
 	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Joint Setting", meta=(DisplayName="Capture 3D Joint"))
 	bool bCaptureJoint;
 
+	/** Save the world space joints of all skeletal meshes as one float32 .npy [num bones, 12] (3x4 row-major)
+	 * with an offset table, and the bone names once per skeleton, instead of json */
+	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Joint Setting")
+	bool bJointNpy;
+
 	void CaptureJoint();
 
 	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Vertex Setting", meta=(DisplayName="Capture 3D Vertex"))
 	bool bCaptureVertex;
 
+	/** Save the skinned vertices as one float32 .npy [num vertices, 3] with an offset table, instead of json */
+	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Vertex Setting")
+	bool bVertexNpy;
+
+	/** LOD used to skin the vertices in the .npy format */
+	UPROPERTY(EditInstanceOnly, Category = "DataCapture| Vertex Setting", meta=(EditCondition="bVertexNpy"))
+	int32 VertexLOD;
+
 	void CaptureVertex();
 
 	void CapturePuppeteer();
@@ -157,6 +187,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 	// UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UPROPERTY()
@@ -167,4 +199,14 @@ private:
 	class UMaterialBillboardComponent* Billboard;
 
 	UClass* SearchCommonClass(UClass* Class);
+
+	/** Skeletal meshes whose bone names are already saved in this session */
+	TSet<FString> SavedSkeletons;
+
+	int GetFrameNumber();
+
+	/** Encodes and writes the captured data off the game thread */
+	TSharedPtr<LychSim::FDatasetWriter> DatasetWriter;
+
+	LychSim::FDatasetWriter& GetDatasetWriter();
 };
@@ -21,6 +21,9 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LychSim")
     void InitializeMesh(const FString& MeshPath);
 
+    /** Set an already loaded mesh, used by bulk spawning to skip the synchronous load */
+    void SetMesh(UStaticMesh* InMesh, bool bSimulatePhysics = true);
+
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
     UStaticMeshComponent* Mesh;
 };
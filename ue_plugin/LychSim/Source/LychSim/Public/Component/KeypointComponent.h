@@ -5,6 +5,8 @@
 #include "SerializeBPLib.h"
 #include "KeypointComponent.generated.h"
 
+namespace LychSim { class FPointKdTree; }
+
 struct FMatchedVertexInfo
 {
 	UMeshComponent* MeshComponent;
@@ -13,7 +15,7 @@ struct FMatchedVertexInfo
 	double Distance;
 	FString KeypointName;
 
-	FMatchedVertexInfo() : Distance(10e10)
+	FMatchedVertexInfo() : MeshComponent(nullptr), Actor(nullptr), VertexIndex(-1), Distance(10e10)
 	{
 	}
 
@@ -79,10 +81,20 @@ public:
 
 	void MatchNearestVertex();
 
+	/** Read the json file again and rematch, the vertex indices of the meshes are reused */
+	UFUNCTION(BlueprintCallable, Category = "unrealcv")
+	void ReloadKeypoints();
+
 private:
 	TArray<FMatchedVertexInfo> MatchedVertexs;
 
 	TArray<FKeypoint> Keypoints;
 
 	TArray<FKeypoint> LoadKeypointFromJson();
+
+	/** Nearest vertex index of a mesh component, built once and kept for later matches */
+	TSharedPtr<const LychSim::FPointKdTree> GetVertexIndex(UMeshComponent* MeshComponent);
+
+	/** Indices of the skinned mesh components, static meshes share a cache keyed on the mesh */
+	TMap<TWeakObjectPtr<UMeshComponent>, TSharedPtr<const LychSim::FPointKdTree>> VertexIndices;
 };
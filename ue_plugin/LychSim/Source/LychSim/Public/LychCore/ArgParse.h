@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef LYCHSIM_API
+#define LYCHSIM_API
+#endif
+
+namespace LychSim::Core
+{
+	/** The arguments after a command, see ParseArgs */
+	struct LYCHSIM_API FParsedArgs
+	{
+		std::vector<std::string> Positionals;
+		std::vector<std::pair<std::string, std::string>> Kwargs; // In the order given, a later key wins
+		std::vector<std::string> Flags;
+
+		/** The value of -Key=..., or nullptr */
+		const std::string* Find(std::string_view Key) const;
+
+		bool HasFlag(std::string_view Flag) const;
+
+		void Reset();
+	};
+
+	/**
+	 * Read the next token from Str and advance it, as FParse::Token without escapes: leading
+	 * whitespace is skipped, a token starting with " ends at the next " and loses the quotes,
+	 * other tokens end at whitespace outside of quotes and keep them. False if nothing is left.
+	 */
+	LYCHSIM_API bool NextToken(std::string_view& Str, std::string& OutToken);
+
+	/**
+	 * Split the arguments of a command into positionals, -key=value pairs and -flags. A token that
+	 * starts with - followed by a digit or . is a negative number and stays positional.
+	 */
+	LYCHSIM_API void ParseArgs(std::string_view Tail, FParsedArgs& Out);
+}
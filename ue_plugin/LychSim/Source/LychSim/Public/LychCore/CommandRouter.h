@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifndef LYCHSIM_API
+#define LYCHSIM_API
+#endif
+
+namespace LychSim::Core
+{
+	/**
+	 * Find the command template a request is for. A template is literal text with typed arguments,
+	 *
+	 *   [str]   anything but a space, can be empty
+	 *   [uint]  digits, can be empty
+	 *   [float] a decimal number with an optional sign
+	 *   [str+]  the rest of the words
+	 *
+	 * e.g. "vset /camera/[uint]/location [float] [float] [float]", and the whole request has to be
+	 * used. A template added with bTail, e.g. "lych cam get_lit", is followed by any arguments.
+	 *
+	 * This is the matcher the dispatcher used to build with regular expressions, written out so
+	 * a request is only compared with the templates that start with the same word.
+	 */
+	class LYCHSIM_API FCommandRouter
+	{
+	public:
+		/** Return the route id, counting from 0 in the order of adding, or -1 with OutError set if the template is malformed */
+		int32_t Add(std::string_view Template, bool bTail, std::string* OutError = nullptr);
+
+		/**
+		 * Return the id of the route added last among the ones that match Request, or -1. OutArgsBegin
+		 * is where the arguments start, at the first typed argument or the tail, or the end of the match.
+		 */
+		int32_t Match(std::string_view Request, size_t& OutArgsBegin) const;
+
+		size_t Num() const { return Routes.size(); }
+
+	private:
+		enum class ESegment : uint8_t
+		{
+			Literal,
+			Str,
+			UInt,
+			Float,
+			StrTail,
+		};
+
+		struct FSegment
+		{
+			ESegment Type;
+			std::string Literal;
+		};
+
+		struct FRoute
+		{
+			std::vector<FSegment> Segments;
+			bool bTail = false;
+		};
+
+		/** Match the segments from Index on against Request from Pos, backtracking over the typed ones */
+		bool MatchFrom(const FRoute& Route, size_t Index, std::string_view Request, size_t Pos, size_t& OutArgsBegin) const;
+
+		bool MatchEnd(const FRoute& Route, std::string_view Request, size_t Pos, size_t& OutArgsBegin) const;
+
+		std::vector<FRoute> Routes;
+
+		/** Route ids by the first word of the template, newest first */
+		std::unordered_map<std::string, std::vector<int32_t>> RoutesByWord;
+
+		/** Routes whose first word is not fixed, newest first */
+		std::vector<int32_t> WildcardRoutes;
+	};
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// The core library only depends on the standard library, it is built by UBT as part of the module
+// and by the CMake project in Standalone/ for the mock server and the benchmarks.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef LYCHSIM_API
+#define LYCHSIM_API
+#endif
+
+namespace LychSim::Core
+{
+	/**
+	 * Every message on the socket, in both directions, is a little endian header
+	 *
+	 *   uint32 magic 0x9E2B83C1, uint32 payload size
+	 *
+	 * followed by the payload. A payload is never empty.
+	 */
+	constexpr uint32_t FrameMagic = 0x9E2B83C1;
+	constexpr size_t FrameHeaderSize = 8;
+
+	enum class EFrameError : uint8_t
+	{
+		None,
+		BadMagic,
+		EmptyPayload,
+	};
+
+	LYCHSIM_API const char* GetFrameErrorName(EFrameError Error);
+
+	/** Write the FrameHeaderSize bytes of the header to Dest */
+	LYCHSIM_API void WriteFrameHeader(uint8_t* Dest, uint32_t PayloadSize);
+
+	/** Read a header from FrameHeaderSize bytes */
+	LYCHSIM_API EFrameError ReadFrameHeader(const uint8_t* Src, uint32_t& OutPayloadSize);
+
+	/** Append the header and the payload to Out */
+	LYCHSIM_API void AppendFrame(std::vector<uint8_t>& Out, const void* Payload, size_t Size);
+
+	/**
+	 * Split a byte stream into payloads as the bytes arrive, for sockets that are read in chunks.
+	 * The stream can not be resumed after an error.
+	 */
+	class LYCHSIM_API FFrameReader
+	{
+	public:
+		void Append(const uint8_t* Data, size_t Size);
+
+		/** The next complete payload, valid until the next call. False if more bytes are needed or the stream is broken */
+		bool Next(const uint8_t*& OutPayload, uint32_t& OutSize);
+
+		EFrameError GetError() const { return Error; }
+
+		/** Bytes received but not returned by Next yet */
+		size_t GetNumPending() const { return Buffer.size() - Offset; }
+
+	private:
+		std::vector<uint8_t> Buffer;
+		size_t Offset = 0; // Start of the first frame not returned yet
+		EFrameError Error = EFrameError::None;
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef LYCHSIM_API
+#define LYCHSIM_API
+#endif
+
+namespace LychSim::Core
+{
+	/** The npy header of a Height x Width image, x Channel unless Channel is 1, in C order */
+	LYCHSIM_API std::vector<char> MakeNpyHeader(const float* TypeTag, int Width, int Height, int Channel);
+	LYCHSIM_API std::vector<char> MakeNpyHeader(const uint8_t* TypeTag, int Width, int Height, int Channel);
+
+	/** Append the header and the Width * Height * Channel elements of Data to Out */
+	LYCHSIM_API void AppendNpy(std::vector<uint8_t>& Out, const float* Data, int Width, int Height, int Channel);
+	LYCHSIM_API void AppendNpy(std::vector<uint8_t>& Out, const uint8_t* Data, int Width, int Height, int Channel);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef LYCHSIM_API
+#define LYCHSIM_API
+#endif
+
+namespace LychSim::Core
+{
+	/**
+	 * The "raw" format: a fixed header, then the tensor as it was read back, in C order, then
+	 * TrailerSize bytes of extra data. Little endian, the header is
+	 *
+	 *   0   uint32 magic 'LSRT', uint16 version 1, uint16 header size 128
+	 *   8   uint8 dtype, uint8 number of dims, char[4] channel order ("BGRA", "D", "XYZ"; zero
+	 *       padded), uint16 reserved
+	 *   16  uint32 shape[4], the unused dims are 0
+	 *   32  uint32 row stride in bytes, uint32 trailer size
+	 *   40  uint64 frame id
+	 *   48  float64 camera location[3] (cm) and rotation[3] (pitch, yaw, roll in degrees)
+	 *   96  float32 fov (degrees), then reserved up to 128
+	 *
+	 * so a client decodes the tensor with one np.frombuffer at offset 128.
+	 */
+	constexpr uint32_t RawTensorMagic = 0x5452534C; // 'LSRT'
+	constexpr uint16_t RawTensorVersion = 1;
+	constexpr size_t RawTensorHeaderSize = 128;
+
+	enum class ERawDType : uint8_t
+	{
+		UInt8 = 1,
+		Float16 = 2,
+		Float32 = 3,
+	};
+
+	struct FRawTensorHeader
+	{
+		ERawDType DType = ERawDType::UInt8;
+		uint8_t NumDims = 0;
+		char ChannelOrder[4] = {};
+		uint32_t Shape[4] = {};
+		uint32_t RowStride = 0;
+		uint32_t TrailerSize = 0;
+		uint64_t FrameId = 0;
+		double Location[3] = {};
+		double Rotation[3] = {};
+		float Fov = 0;
+	};
+
+	LYCHSIM_API size_t GetRawDTypeSize(ERawDType DType);
+
+	/** The header of a Height x Width image, x Channel unless Channel is 1 as in npy, with rows packed */
+	LYCHSIM_API FRawTensorHeader MakeRawImageHeader(ERawDType DType, int Width, int Height, int Channel, const char* ChannelOrder);
+
+	/** Bytes of the tensor, without the header and the trailer */
+	LYCHSIM_API size_t GetRawTensorSize(const FRawTensorHeader& Header);
+
+	/** Write the RawTensorHeaderSize bytes of the header to Dest */
+	LYCHSIM_API void WriteRawTensorHeader(uint8_t* Dest, const FRawTensorHeader& Header);
+
+	/** Read a header, false if Size is too small or the magic or version do not match */
+	LYCHSIM_API bool ReadRawTensorHeader(const uint8_t* Src, size_t Size, FRawTensorHeader& OutHeader);
+}
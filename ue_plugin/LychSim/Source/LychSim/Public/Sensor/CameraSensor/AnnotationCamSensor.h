@@ -15,9 +15,15 @@ public:
 
 	static void GetAnnotationComponents(UWorld* World, TArray<TWeakObjectPtr<UPrimitiveComponent> >& ComponentList);
 
+	/** Same as above, the list is gathered once per batch and reused when Shared is set */
+	static void GetAnnotationComponents(UWorld* World, TArray<TWeakObjectPtr<UPrimitiveComponent> >& ComponentList, FBatchCaptureShared* Shared);
+
+	/** Show only the annotated components, then send the scene capture */
+	virtual bool BeginCapture(FBatchCaptureShared* Shared = nullptr) override;
+
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction * T);
 
-	void CaptureSeg(TArray<FColor>& ImageData, int& Width, int& Height);
+	void CaptureSeg(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region = nullptr);
 
 	void InitTextureTarget(int FilmWidth, int FilmHeight);
 };
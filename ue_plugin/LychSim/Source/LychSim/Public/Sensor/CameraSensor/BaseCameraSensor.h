@@ -10,6 +10,15 @@
 
 #include "BaseCameraSensor.generated.h"
 
+struct FReadbackRegion;
+
+/** Work done once for all sensors captured in one batch, see LychSim::CaptureMulti */
+struct FBatchCaptureShared
+{
+	bool bHasAnnotationComponents = false;
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> AnnotationComponents;
+};
+
 /**
  * A base camera sensor for ground truth capture
  */
@@ -28,7 +37,15 @@ public:
 	void CaptureToFile(const FString& Filename);
 
 	/** The old version to read TextureBuffer, slow but is sync operation and  correct */
-	void Capture(TArray<FColor>& ImageData, int& Width, int& Height);
+	void Capture(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region = nullptr);
+
+	/** Send the scene capture to the rendering thread without waiting for it, return false if there is no valid TextureTarget */
+	virtual bool BeginCapture(FBatchCaptureShared* Shared = nullptr);
+
+	/** Queue the readback of the captured TextureTarget, the data is ready after FlushRenderingCommands */
+	bool EnqueueRead(TArray<FColor>& ImageData, FIntPoint& Size, const FReadbackRegion* Region = nullptr);
+
+	bool EnqueueRead(TArray<FFloat16Color>& ImageData, FIntPoint& Size, const FReadbackRegion* Region = nullptr);
 
 	/** Get/set the sensor location / rotation */
 	FVector GetSensorLocation()
@@ -61,6 +78,9 @@ public:
 	/** Get the projection matrix of this camera */
 	FString GetProjectionMatrix();
 
+	/** Build the view and projection matrices the scene capture renders with, including ortho mode */
+	void GetViewProjectionMatrix(FMatrix& ViewMatrix, FMatrix& ProjectionMatrix);
+
 	virtual void InitTextureTarget(int FilmWidth, int FilmHeight);
 
 	void SetPostProcessMaterial(UMaterial* PostProcessMaterial);
@@ -72,6 +92,11 @@ protected:
 	/** Check whether the TextureTarget is correctly initialized */
 	bool CheckTextureTarget();
 
+	/** Read the captured TextureTarget, only Region of it if set. False if the region can not be read, then the data is empty and the size 0 */
+	bool ReadTextureTarget(TArray<FColor>& ImageData, int& Width, int& Height, const FReadbackRegion* Region);
+
+	bool ReadTextureTarget(TArray<FFloat16Color>& ImageData, int& Width, int& Height, const FReadbackRegion* Region);
+
 	int FilmWidth;
 
 	int FilmHeight;
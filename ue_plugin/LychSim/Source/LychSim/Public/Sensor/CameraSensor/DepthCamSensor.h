@@ -13,10 +13,13 @@ class LYCHSIM_API UDepthCamSensor : public UBaseCameraSensor
 public:
 	UDepthCamSensor(const FObjectInitializer& ObjectInitializer);
 
-	void CaptureDepth(TArray<float>& DepthData, int& Width, int& Height);
+	void CaptureDepth(TArray<float>& DepthData, int& Width, int& Height, const FReadbackRegion* Region = nullptr);
 
 	virtual void InitTextureTarget(int FilmWidth, int FilmHeight) override;
 
+	/** Unless bIgnoreTransparentObjects, the annotated components are rendered with materials off so transparent objects have depth */
+	virtual bool BeginCapture(FBatchCaptureShared* Shared = nullptr) override;
+
 	UPROPERTY(EditInstanceOnly, Category = "lychsim")
 	bool bIgnoreTransparentObjects;
 };
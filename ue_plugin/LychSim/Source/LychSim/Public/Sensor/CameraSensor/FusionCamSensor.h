@@ -5,6 +5,8 @@
 #include "Runtime/Engine/Classes/Camera/CameraTypes.h"
 #include "FusionCamSensor.generated.h"
 
+struct FReadbackRegion;
+
 UENUM(BlueprintType)
 enum class ELitMode : uint8
 {
@@ -62,6 +64,18 @@ public:
 	UFUNCTION(BlueprintPure, Category = "lychsim")
 	void GetSeg(TArray<FColor>& ObjMaskData, int& Width, int& Height, ESegMode SegMode = ESegMode::AnnotationComponent);
 
+	/** Same as GetLit, GetDepth, GetNormal and GetSeg, but only Region is read back, cropped and resampled on the GPU */
+	void GetLitRegion(TArray<FColor>& LitData, int& Width, int& Height, const FReadbackRegion& Region);
+
+	void GetDepthRegion(TArray<float>& DepthData, int& Width, int& Height, const FReadbackRegion& Region);
+
+	void GetNormalRegion(TArray<FColor>& NormalData, int& Width, int& Height, const FReadbackRegion& Region);
+
+	void GetSegRegion(TArray<FColor>& ObjMaskData, int& Width, int& Height, const FReadbackRegion& Region);
+
+	/** The sensor that captures Mode (lit, depth, normal or seg), nullptr for other modes. See LychSim::CaptureMulti */
+	class UBaseCameraSensor* GetModeSensor(const FString& Mode);
+
 	UFUNCTION(BlueprintPure, Category = "lychsim")
 	FVector GetSensorLocation();
 
@@ -92,9 +106,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "lychsim")
 	void SetProjectionType(ECameraProjectionMode::Type ProjectionType);
 
+	UFUNCTION(BlueprintPure, Category = "lychsim")
+	ECameraProjectionMode::Type GetProjectionType();
+
 	UFUNCTION(BlueprintCallable, Category = "lychsim")
 	void SetOrthoWidth(float OrthoWidth);
 
+	/** View and projection matrices shared by all fusion sensors, see UBaseCameraSensor::GetViewProjectionMatrix */
+	void GetViewProjectionMatrix(FMatrix& ViewMatrix, FMatrix& ProjectionMatrix);
+
 	UFUNCTION(BlueprintCallable, Category = "lychsim")
 	void SetLitCaptureSource(ESceneCaptureSource CaptureSource);
 
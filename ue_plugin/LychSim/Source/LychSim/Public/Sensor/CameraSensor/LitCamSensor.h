@@ -19,5 +19,7 @@ public:
 
 	virtual void InitTextureTarget(int FilmWidth, int FilmHeight) override;
 
-	void CaptureLit(TArray<FColor>& Image, int& Width, int& Height);
+	virtual bool BeginCapture(FBatchCaptureShared* Shared = nullptr) override;
+
+	void CaptureLit(TArray<FColor>& Image, int& Width, int& Height, const FReadbackRegion* Region = nullptr);
 };
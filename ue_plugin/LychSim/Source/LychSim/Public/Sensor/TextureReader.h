@@ -10,5 +10,38 @@ LYCHSIM_API bool ReadTextureRenderTarget(UTextureRenderTarget2D* RenderTarget, T
 /** Read texture from UE4 and keep the texture size */
 LYCHSIM_API bool FastReadTexture2DAsync(FTexture2DRHIRef Texture2D, TFunction<void(FColor*, int32, int32)> Callback);
 
-/** Read texture from UE4 and resize to expected size */
-// LYCHSIM_API bool ResizeFastReadTexture2DAsync(FTexture2DRHIRef Texture2D, int TargetWidth, int TargetHeight, TFunction<void(FColor*, int32, int32)> Callback);
+/** The part of a render target to read back, and the size it is resampled to on the GPU */
+struct LYCHSIM_API FReadbackRegion
+{
+	/** Crop in film pixels, an empty rect means the whole film */
+	FIntRect Roi;
+
+	/** Output size, zero means the size of the crop */
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	/** Bilinear filtering for images, nearest neighbour keeps labels and depth values exact */
+	bool bBilinear = false;
+
+	/** The crop clamped to the film */
+	FIntRect GetRoi(FIntPoint FilmSize) const;
+
+	FIntPoint GetSize(FIntPoint FilmSize) const;
+
+	/** Whether the plain full frame readback gives the same pixels */
+	bool IsFullFrame(FIntPoint FilmSize) const;
+};
+
+/** Crop and resample the render target on the GPU, then read back only the output pixels. Blocks until the data is read, on failure the data is empty and the size 0 */
+LYCHSIM_API bool ResampleReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion& Region, TArray<FColor>& ImageData, int& Width, int& Height);
+
+/** Same as above for float render targets, e.g. depth */
+LYCHSIM_API bool ResampleReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion& Region, TArray<FFloat16Color>& ImageData, int& Width, int& Height);
+
+/**
+ * Queue the readback of Region of the render target (the whole film if null) on the render thread and return
+ * without waiting. ImageData is filled once FlushRenderingCommands returns, so it must stay alive and unmoved
+ * until then. Lets many render targets be read back with one flush
+ */
+LYCHSIM_API bool EnqueueReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion* Region, TArray<FColor>& ImageData, FIntPoint& OutSize);
+
+LYCHSIM_API bool EnqueueReadTexture(UTextureRenderTarget2D* RenderTarget, const FReadbackRegion* Region, TArray<FFloat16Color>& ImageData, FIntPoint& OutSize);
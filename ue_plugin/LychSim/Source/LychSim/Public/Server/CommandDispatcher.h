@@ -5,7 +5,7 @@
 #include "Containers/Map.h"
 #include "Delegates/Delegate.h"
 #include "ExecStatus.h"
-#include "Runtime/Core/Public/Internationalization/Regex.h"
+#include "LychCore/CommandRouter.h"
 
 // DECLARE_DELEGATE(FCallbackDelegate);
 DECLARE_DELEGATE_OneParam(FCallbackDelegate, FExecStatus); // Callback needs to be set before Exec, accept ExecStatus
@@ -20,6 +20,19 @@ DECLARE_DELEGATE_RetVal_ThreeParams(
 	const FStrMap&,
 	const FStrSet&);
 
+/** What Exec did with a command, for the request stats */
+struct FExecInfo
+{
+	/** The readable template the command matched, e.g. "lych cam get_lit", empty if none did */
+	FString Command;
+
+	/** Matching the template and parsing the arguments */
+	double DispatchSeconds = 0;
+
+	/** Running the handler, an async command may keep running after it returns */
+	double HandlerSeconds = 0;
+};
+
 /**
  * Engine to execute commands
  */
@@ -33,7 +46,7 @@ public:
 	bool Alias(const FString& Alias, const FString& Command, const FString& Description);
 	bool Alias(const FString& Alias, const TArray<FString>& Commands, const FString& Description);
 
-	FExecStatus Exec(const FString Uri);
+	FExecStatus Exec(const FString Uri, FExecInfo* OutInfo = nullptr);
 
 	/** Command handler for vrun */
 	FExecStatus AliasHelper(const TArray<FString>& Args);
@@ -41,15 +54,18 @@ public:
 	const TMap<FString, FString>& GetUriDescription();
 
 private:
-	/** Store which URI handler */
+	/** Store which URI handler, by the readable template */
 	TMap<FString, FDispatcherDelegate> UriMapping;
 	TMap<FString, FDispatcherDelegateUE> UriMappingUE;
 
-	/** The complete list of binded URI, the order of adding is preserved */
-	TArray<FString> UriList;
+	/** Match commands with the registered templates, the later one wins */
+	LychSim::Core::FCommandRouter Router;
+
+	/** The readable template of each route id of Router, the key of the request stats */
+	TArray<FString> RouteUris;
 
-	/** RegexPattern to match command with registered commands  */
-	TMap<FString, FRegexPattern> UriRegexPattern;
+	/** Whether each route is bound with BindCommandUE */
+	TArray<bool> RouteIsUE;
 
 	/** Store help message */
 	TMap<FString, FString> UriDescription; // Contains help message
@@ -57,11 +73,8 @@ private:
 	/** Store the definition of an alias */
 	TMap<FString, TArray<FString> > AliasMapping;
 
-	/** Store the regular expression for each type */
-	TMap<FString, FString> TypeRegexp; // Define regular expression for type
-
 	int32 NumArgsLimit = 32;
 
-	/** Convert from a human readable URI to a regular expression */
-	bool FormatUri(const FString& RawUri, FString& UriRexexp);
+	/** Add a readable template to Router, return false if it is malformed */
+	bool AddRoute(const FString& UriTemplate, bool bUEStyle);
 };
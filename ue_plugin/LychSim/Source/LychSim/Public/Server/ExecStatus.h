@@ -35,6 +35,7 @@ enum FExecStatusType
 {
 	OK,
 	ErrorMsg,
+	Pending,
 };
 
 /**
@@ -56,6 +57,14 @@ public:
 	static FExecStatus InvalidPointer;
 	/** Binary : A binary array */
 	static FExecStatus Binary(TArray<uint8>& InBinaryData);
+	/** Binary : A binary array, moved instead of copied */
+	static FExecStatus Binary(TArray<uint8>&& InBinaryData);
+	/** Binary : A small header and a large body, which are sent one after the other without joining them */
+	static FExecStatus Binary(TArray<uint8>&& InBinaryHeader, TArray<uint8>&& InBinaryData);
+	/** Pending : The reply is sent once the promise returns a status that is not pending */
+	static FExecStatus AsyncQuery(FPromise InPromise);
+	/** Pending : Returned by a promise whose task is still running */
+	static FExecStatus Pending(FString Message="");
 
 	/** The message body of this ExecStatus, the full message will also include the ExecStatusType */
 	FString MessageBody;
@@ -69,6 +78,10 @@ public:
 	/** Convert this ExecStatus to a binary array */
 	TArray<uint8> GetData() const;
 
+	/** The header and the body of a binary status, without copying them. The header can be empty */
+	const TArray<uint8>& GetBinaryHeader() const { return BinaryHeader; }
+	const TArray<uint8>& GetBinaryData() const { return BinaryData; }
+
 	/** Add this FExecStatus with other FExecStatus, useful for executing a few commands at the same time */
 	FExecStatus& operator+=(const FExecStatus& InExecStatus);
 
@@ -87,6 +100,8 @@ private:
 	FExecStatus(FExecStatusType InExecStatusType, TArray<uint8>& InBinaryData);
 	/** Binary data */
 	TArray<uint8> BinaryData;
+	/** Sent before BinaryData */
+	TArray<uint8> BinaryHeader;
 };
 
 bool operator==(const FExecStatus& ExecStatus, const FExecStatusType& ExecStatusEnum);
@@ -18,6 +18,18 @@ public:
 	bool EnableInput;
 	bool ExitOnFailure;
 	bool EnableRightEye;
+	/** Threads that encode and write captured data to files */
+	int WriterThreads;
+	/** Memory cap of the captured data waiting to be written */
+	int WriterQueueMB;
+	/** Only render the camera sensors, not the main viewport, see LychSim::FHeadlessMode */
+	bool Headless;
+	/** Structured request log, see LychSim::FRequestLog. off, errors, summary or full */
+	FString RequestLogVerbosity;
+	/** Share of the successful requests in the request log */
+	float RequestLogSampleRate;
+	/** JSONL file of the request log, empty for Saved/Logs/LychSimRequests.jsonl */
+	FString RequestLogPath;
 
 	TArray<FString> SupportedModes;
 
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stddef.h>  // offsetof()
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <string.h> // memset()
 #include <unistd.h>
@@ -41,12 +42,16 @@ public:
 
 	/** Add header to payload and send it out */
 	static bool WrapAndSendPayload(const TArray<uint8>& Payload, FSocket* Socket);
+	/** Send the payload followed by the tail as one message */
+	static bool WrapAndSendPayload(const TArray<uint8>& Payload, const TArray<uint8>& Tail, FSocket* Socket);
 	/** Receive packages and strip header */
 	static bool ReceivePayload(FArrayReader& OutPayload, FSocket* Socket);
 
 	// UDS implementation of send and receive data
 	/** Add header to payload and send it out */
 	static bool WrapAndSendPayloadUDS(const TArray<uint8>& Payload, int fd);
+	/** Send the payload followed by the tail as one message, with writev instead of joining them */
+	static bool WrapAndSendPayloadUDS(const TArray<uint8>& Payload, const TArray<uint8>& Tail, int fd);
 	/** Receive packages and strip header */
 	static bool ReceivePayloadUDS(FArrayReader& OutPayload, int fd);
 };
@@ -92,17 +97,20 @@ public:
 	/** Send a byte array to connected client, return false if failed to send. */
 	bool SendData(const TArray<uint8>& Payload);
 
+	/** Send Payload followed by Tail as one message, Tail is a large body that is not copied into the payload */
+	bool SendData(const TArray<uint8>& Payload, const TArray<uint8>& Tail);
+
 	/** Send a string to connected client, return false if false to send. Will fail if no connection available */
 	bool SendMessageINet(const FString& Message);
 
 	/** Send a byte array to connected client, return false if failed to send. */
-	bool SendDataINet(const TArray<uint8>& Payload);
+	bool SendDataINet(const TArray<uint8>& Payload, const TArray<uint8>& Tail);
 
 	/** Send a string with UDS, only works on Linux */
 	bool SendMessageUDS(const FString& Message);
 
 	/** Send a byte array with UDS, only works on Linux */
-	bool SendDataUDS(const TArray<uint8>& Payload);
+	bool SendDataUDS(const TArray<uint8>& Payload, const TArray<uint8>& Tail);
 
 	FReceivedEvent& OnReceived() { return ReceivedEvent;  } // The reference can not be changed
 
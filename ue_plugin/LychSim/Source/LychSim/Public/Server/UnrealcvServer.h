@@ -17,9 +17,15 @@ public:
 	FString Message;
 	uint32 RequestId;
 
+	/** FPlatformTime::Seconds when the message arrived, when Exec started and when it returned, for the request stats */
+	double ReceiveTime = 0;
+	double ExecStartTime = 0;
+	double ExecEndTime = 0;
+	FExecInfo ExecInfo;
+
 	FRequest() {}
 	FRequest(FString InEndpoint, FString InMessage, uint32 InRequestId)
-		: Endpoint(InEndpoint), Message(InMessage), RequestId(InRequestId) {}
+		: Endpoint(InEndpoint), Message(InMessage), RequestId(InRequestId), ReceiveTime(FPlatformTime::Seconds()) {}
 };
 
 /**
@@ -105,12 +111,27 @@ private:
 
 	void ProcessRequest(FRequest& Request);
 
+	/** Send the reply of the request waiting for an async command, return false while it is still running */
+	bool ProcessInFlightRequest();
+
+	/** Run the ready requests in order, return false if one of them is waiting for an async command */
+	bool ProcessReadyRequests();
+
+	void SendReply(const FRequest& Request, const FExecStatus& ExecStatus);
+
 	/** The number of incoming commands for the batch mode */
 	int BatchNum;
 
 	/** Array for batch commands */
 	TArray<FRequest> Batch;
 
+	/** Requests of a complete batch that have not run yet */
+	TArray<FRequest> ReadyRequests;
+
+	/** The request of an async command, e.g. lych sim step. Later requests wait until it is replied */
+	FRequest InFlightRequest;
+	FPromise InFlightPromise;
+
 	/** The Pawn of the Game */
 	APawn* Pawn;
 
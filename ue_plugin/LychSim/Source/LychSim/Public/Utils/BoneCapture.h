@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+namespace LychSim
+{
+	/** Bone transforms of many actors packed into one buffer */
+	struct FBoneCapture
+	{
+		TArray<FString> ActorNames;
+		TArray<uint32> Offsets;  // First bone row of each actor
+		TArray<uint32> Counts;   // Number of bones of each actor
+		TArray<uint32> Skeletons; // Index into SkeletonPaths of each actor
+
+		/** One entry per unique skeletal mesh, the bone names are in the row order of its actors */
+		TArray<FString> SkeletonPaths;
+		TArray<TArray<FString>> SkeletonBoneNames;
+
+		TArray<float> Transforms; // float32 [num bones, 3, 4], rotation and scale | translation
+
+		/**
+		 * 1 per bone row if the bone is evaluated at the current LOD of its component. The pose of a
+		 * bone that is not in the required bones is not updated, its transform is stale.
+		 */
+		TArray<uint8> Valid;
+	};
+
+	/**
+	 * Read all bones of the first skeletal mesh component of each actor, in component or world space.
+	 * Actors without a skeletal mesh are skipped. The component space poses are read on the game
+	 * thread and converted in parallel per component. Every bone of the skeleton is exported so the
+	 * layout does not change with the LOD, the bones the LOD skips are marked in Valid.
+	 */
+	LYCHSIM_API void CaptureBones(const TArray<AActor*>& Actors, bool bWorldSpace, FBoneCapture& Out);
+
+	/**
+	 * Layout (little endian): uint32 magic 'LBON', uint16 version, uint16 flags (bit 0 world space,
+	 * bit 1 bone names), uint32 num actors, uint32 num skeletons, uint32 num bones, then per actor
+	 * {uint32 offset, count, skeleton}, then float32 transforms [num bones, 3, 4], then uint8 valid
+	 * [num bones], 0 for a bone that is not evaluated at the current LOD, then per skeleton
+	 * {uint16 length, utf8 path, uint32 num names} followed by the bone names in the same string form
+	 * (none unless flagged), then the actor names.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeBoneCapture(const FBoneCapture& Capture, bool bWorldSpace, bool bBoneNames);
+}
@@ -14,17 +14,27 @@ namespace LychSim
 	    PngBinary,
 	    NpyBinary,
 	    BmpBinary,
+	    RawBinary, // The pixels after a header, see LychCore/RawTensor.h
 	    Invalid, // Unrecognized filename type
     };
 
+	/** The frame and the camera pose written into the header of a raw reply */
+	struct FRawFrameInfo
+	{
+		uint64 FrameId = 0;
+		FVector Location = FVector::ZeroVector;
+		FRotator Rotation = FRotator::ZeroRotator;
+		float Fov = 0;
+	};
+
     LYCHSIM_API EFilenameType ParseFilenameType(const FString& Filename);
-    LYCHSIM_API FExecStatus SerializeData(const TArray<FColor>& Data, int Width, int Height, const FString& Filename);
-	LYCHSIM_API FExecStatus SerializeData(const TArray<FFloat16Color>& Data, int Width, int Height, const FString& Filename);
-	LYCHSIM_API FExecStatus SerializeData(const TArray<float>& Data, int Width, int Height, const FString& Filename);
+    LYCHSIM_API FExecStatus SerializeData(const TArray<FColor>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo = nullptr);
+	LYCHSIM_API FExecStatus SerializeData(const TArray<FFloat16Color>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo = nullptr);
+	LYCHSIM_API FExecStatus SerializeData(const TArray<float>& Data, int Width, int Height, const FString& Filename, const FRawFrameInfo* FrameInfo = nullptr);
 
     template<class T>
 	void SaveData(const TArray<T>& Data, int Width, int Height,
-		const TArray<FString>& Args, FExecStatus& Status)
+		const TArray<FString>& Args, FExecStatus& Status, const FRawFrameInfo* FrameInfo = nullptr)
     {
         if (Args.Num() != 2)
 	    {
@@ -37,7 +47,7 @@ namespace LychSim
 		    Status = FExecStatus::Error("Captured data is empty");
 		    return;
 	    }
-	    Status = SerializeData(Data, Width, Height, Filename);
+	    Status = SerializeData(Data, Width, Height, Filename, FrameInfo);
 	    return;
     }
 }
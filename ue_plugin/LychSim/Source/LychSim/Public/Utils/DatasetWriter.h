@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utils/FileWriter.h"
+
+class IFileHandle;
+
+namespace LychSim
+{
+	struct FDatasetWriterOptions
+	{
+		/** Folder of the loose files or the shards */
+		FString RootFolder;
+
+		/** Pack every frame as one WebDataset sample into tar shards, instead of one file per record */
+		bool bTarShards = false;
+
+		/** Start a new shard once the current one is larger than this, a frame is never split */
+		int64 MaxShardBytes = 1024ll * 1024 * 1024;
+	};
+
+	/**
+	 * Encode and write the records of captured frames on the threads of FFileWriter.
+	 *
+	 * In file mode the name of a record is its file path. In shard mode it is the field of the
+	 * sample, e.g. "cam0.lit.png", the member is stored as "<frame>.cam0.lit.png" in a tar shard
+	 * named shard-000000.tar, shard-000001.tar, ... All members of a frame are appended together once
+	 * they are encoded, so a sample is contiguous as WebDataset expects.
+	 * Shards already in the folder are kept, the numbering continues after the last one.
+	 *
+	 * Call from the game thread only.
+	 */
+	class LYCHSIM_API FDatasetWriter
+	{
+	public:
+		explicit FDatasetWriter(const FDatasetWriterOptions& InOptions);
+
+		/** Write everything still queued and close the shard */
+		~FDatasetWriter();
+
+		/** Records added until EndFrame belong to this frame */
+		void BeginFrame(int32 FrameNumber);
+
+		void EndFrame();
+
+		/** Save as png, the alpha channel is set to opaque unless bKeepAlpha */
+		void AddPng(const FString& Name, TArray<FColor>&& Pixels, int32 Width, int32 Height, bool bKeepAlpha = false);
+
+		/** Save as a float32 npy of shape [Height, Width] */
+		void AddNpy(const FString& Name, TArray<float>&& Data, int32 Width, int32 Height);
+
+		/** Save as utf8 text, e.g. json */
+		void AddText(const FString& Name, FString&& Text);
+
+		/** Save Frame encoded as Format, see FFileWriter for the formats */
+		void Add(const FString& Name, const FString& Format, FFrameBuffer&& Frame);
+
+		/** Block until every record of the ended frames is on the disk */
+		void Flush();
+
+		bool IsSharded() const { return Options.bTarShards; }
+
+	private:
+		struct FFrame
+		{
+			int32 FrameNumber = 0;
+			TArray<FString> Names;
+			TArray<TArray<uint8>> Members;
+			int32 NumPending = 0;
+			bool bEnded = false;
+		};
+
+		void AppendFrame(FFrame& Frame);
+
+		void CloseShard();
+
+		const FDatasetWriterOptions Options;
+
+		/** The frame being captured, only used in shard mode */
+		TSharedPtr<FFrame> CurrentFrame;
+		FCriticalSection FrameLock;
+
+		/** Guarded by ShardLock */
+		FCriticalSection ShardLock;
+		IFileHandle* Shard = nullptr;
+		int32 ShardIndex = 0;
+		int64 ShardBytes = 0;
+	};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IImageWrapperModule;
+
+namespace LychSim
+{
+	class FWriterPool;
+
+	/** Captured data waiting to be encoded, one of the arrays is set */
+	struct FFrameBuffer
+	{
+		TArray<FColor> Colors;
+		TArray<FFloat16Color> HalfColors;
+		TArray<float> Floats;
+		TArray<uint8> Bytes; // Already encoded, e.g. utf8 text
+		int32 Width = 0;
+		int32 Height = 0;
+
+		/** Set the alpha of Colors to 255 before encoding, a zero alpha makes the image invisible */
+		bool bOpaque = false;
+
+		int64 GetAllocatedSize() const
+		{
+			return Colors.GetAllocatedSize() + HalfColors.GetAllocatedSize() + Floats.GetAllocatedSize() + Bytes.GetAllocatedSize();
+		}
+	};
+
+	/** Turn a frame into the bytes of a file format. Called from many writer threads at once */
+	class IFrameEncoder
+	{
+	public:
+		virtual ~IFrameEncoder() {}
+
+		/** The frame is owned by the caller and may be modified, return false if it can not be encoded */
+		virtual bool Encode(FFrameBuffer& Frame, TArray<uint8>& OutBytes) const = 0;
+	};
+
+	struct FFileWriterStats
+	{
+		int32 QueuedFiles = 0;    // Queued or being written
+		int64 QueuedBytes = 0;    // Captured data held by the queued files
+		int64 MaxQueuedBytes = 0; // Memory cap, 0 means none
+		int64 NumWritten = 0;
+		int64 NumFailed = 0;
+		int64 BytesWritten = 0;
+		double EncodeSeconds = 0; // Summed over the writer threads
+		double WriteSeconds = 0;
+	};
+
+	/**
+	 * Encode and write captured data on a pool of writer threads. The threads sleep until data is
+	 * queued, and the caller blocks while the queued data is over the memory cap.
+	 *
+	 * Encoders are looked up by format name, png, bmp, npy, exr and raw are built in. raw writes the
+	 * bytes of the set array as they are.
+	 */
+	class LYCHSIM_API FFileWriter
+	{
+	public:
+		/** The writer shared by the camera commands and the data capture actor */
+		static FFileWriter& Get();
+
+		/** Finish the queued files of the shared writer and destroy it, called when the module shuts down */
+		static void ReleaseShared();
+
+		FFileWriter(int32 NumThreads, int64 MaxQueuedBytes);
+
+		~FFileWriter();
+
+		/** Add or replace an encoder, call from the game thread */
+		void RegisterEncoder(const FString& Format, TSharedRef<IFrameEncoder> Encoder);
+
+		bool HasEncoder(const FString& Format) const;
+
+		/** Queue Frame to be encoded and saved to Filename */
+		void Write(const FString& Filename, const FString& Format, FFrameBuffer&& Frame);
+
+		/** Queue Frame to be encoded, OnEncoded receives the bytes (empty if it failed) on a writer thread */
+		void Encode(const FString& Format, FFrameBuffer&& Frame, TUniqueFunction<void(TArray<uint8>&&)>&& OnEncoded);
+
+		/** Queue other work on the writer threads, it counts as Bytes against the memory cap */
+		void Enqueue(TUniqueFunction<void()>&& Task, int64 Bytes = 0);
+
+		/** Block until every queued file is written, return false on timeout */
+		bool Flush(uint32 WaitTimeMs = MAX_uint32);
+
+		/** Finish the queued files and stop the threads, later writes run on the caller */
+		void Shutdown();
+
+		/** Count a file that could not be saved, it is reported by the next TakeFailures */
+		void AddFailure(const FString& Filename);
+
+		/** Return the number of failed files since the last call, and the first of their paths */
+		int64 TakeFailures(TArray<FString>& OutFilenames);
+
+		FFileWriterStats GetStats() const;
+
+		void ResetStats();
+
+	private:
+		bool EncodeFrame(const FString& Format, FFrameBuffer& Frame, TArray<uint8>& OutBytes);
+
+		TUniquePtr<FWriterPool> Pool;
+
+		int64 MaxQueuedBytes = 0;
+
+		mutable FCriticalSection EncodersLock;
+		TMap<FString, TSharedRef<IFrameEncoder>> Encoders; // Guarded by EncodersLock
+
+		mutable FCriticalSection StatsLock;
+		FFileWriterStats Stats; // Guarded by StatsLock, the queue fields are filled in GetStats
+
+		/** Failed files since the last TakeFailures, guarded by StatsLock. At most MaxFailedFilenames paths are kept */
+		int64 NumRecentFailures = 0;
+		TArray<FString> RecentFailedFilenames;
+	};
+}
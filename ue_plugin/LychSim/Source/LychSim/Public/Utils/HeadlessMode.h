@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+namespace LychSim
+{
+	/**
+	 * Skip the work that only serves the main viewport, when data is only read through camera
+	 * sensors. The game viewport stops drawing the world, the editor viewports stop realtime
+	 * updates, audio, the HUD and on screen debug messages are off. Scene captures of the sensors
+	 * still render on demand.
+	 *
+	 * Call from the game thread only.
+	 */
+	class LYCHSIM_API FHeadlessMode
+	{
+	public:
+		static FHeadlessMode& Get();
+
+		/** Apply to World, the settings changed are restored by Disable */
+		void Enable(UWorld* World);
+
+		void Disable();
+
+		bool IsEnabled() const { return bEnabled; }
+
+	private:
+		/** Restore the settings before the world is torn down, e.g. the PIE session ends */
+		void OnWorldCleanup(UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources);
+
+		bool bEnabled = false;
+
+		TWeakObjectPtr<UWorld> World;
+
+		FDelegateHandle WorldCleanupHandle;
+
+		/** Settings restored by Disable */
+		bool bSavedDisableWorldRendering = false;
+		bool bSavedAllowAudioPlayback = true;
+		bool bSavedOnScreenDebugMessages = true;
+		TArray<TPair<TWeakObjectPtr<class AHUD>, bool>> SavedShowHUD;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "ExecStatus.h"
+
+class UWorld;
+
+namespace LychSim
+{
+	/**
+	 * Lockstep simulation. The game world stays paused between commands and only advances by Step,
+	 * which runs a whole number of engine frames with a fixed delta time. The engine does not wait
+	 * for the wall clock in this mode, so frames run as fast as the hardware allows and every run
+	 * with the same commands sees the same game times.
+	 *
+	 * Call from the game thread only.
+	 */
+	class LYCHSIM_API FLockstep
+	{
+	public:
+		static FLockstep& Get();
+
+		/** Pause World and switch the engine to a fixed time step of DeltaTime seconds */
+		FExecStatus Enable(UWorld* World, float DeltaTime);
+
+		/** Restore the time step of the engine and unpause the world */
+		void Disable();
+
+		bool IsEnabled() const;
+
+		/** Unpause the world for NumTicks frames, it pauses itself after the last one */
+		FExecStatus Step(int32 NumTicks, float DeltaTime);
+
+		/** Whether the frames of the last Step are still running */
+		bool IsStepping() const;
+
+		float GetDeltaTime() const { return DeltaTime; }
+
+		/** Frames stepped since the mode was enabled */
+		int64 GetNumTicks() const { return NumTicks; }
+
+		UWorld* GetWorld() const { return World.Get(); }
+
+	private:
+		void OnWorldPostActorTick(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds);
+
+		/** Leave the mode when its world is torn down, e.g. the PIE session ends */
+		void OnWorldCleanup(UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources);
+
+		TWeakObjectPtr<UWorld> World;
+
+		float DeltaTime = 0;
+
+		int32 TicksLeft = 0;
+
+		int64 NumTicks = 0;
+
+		FDelegateHandle PostActorTickHandle;
+		FDelegateHandle WorldCleanupHandle;
+
+		/** Engine settings restored by Disable */
+		bool bSavedUseFixedTimeStep = false;
+		double SavedFixedDeltaTime = 0;
+		float SavedMaxFPS = 0;
+	};
+}
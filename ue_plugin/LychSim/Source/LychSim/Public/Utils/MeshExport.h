@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UStaticMesh;
+class UMeshComponent;
+
+namespace LychSim
+{
+	/** Vertex data of one LOD in mesh space */
+	struct FMeshBuffers
+	{
+		TArray<FVector3f> Positions;
+		TArray<FVector3f> Normals; // Empty when the mesh has none, e.g. skinned meshes
+		TArray<uint32> Indices;    // Empty when the index buffer is not CPU accessible
+		int32 LODIndex = 0;
+	};
+
+	/**
+	 * Read one LOD of a static mesh, the LOD is clamped to the available range.
+	 * The result is cached per mesh and LOD, and rebuilt when the render data changes.
+	 */
+	LYCHSIM_API TSharedPtr<const FMeshBuffers> GetStaticMeshBuffers(UStaticMesh* StaticMesh, int32 LODIndex);
+
+	/** Read the mesh of a static or skinned mesh component, skinned meshes are posed and never cached */
+	LYCHSIM_API TSharedPtr<const FMeshBuffers> GetMeshComponentBuffers(UMeshComponent* MeshComponent, int32 LODIndex);
+
+	enum EMeshExportFlags : uint16
+	{
+		MeshExportNormals = 1 << 0,
+		MeshExportIndices = 1 << 1,
+		MeshExportWorld   = 1 << 2,
+	};
+
+	/**
+	 * Pack the meshes of all mesh components of an actor, transformed in parallel into world space
+	 * or into the space of the actor. Layout (little endian): header {uint32 magic 'LMSH', uint16 version,
+	 * uint16 flags, uint32 num vertices, uint32 num indices, uint32 num sections}, then per component
+	 * {uint32 vertex offset, vertex count, index offset, index count, int32 lod}, then float32 positions
+	 * [V, 3], float32 normals [V, 3] if flagged, uint32 indices [I] if flagged, referring to the combined
+	 * vertex array, then {uint16 length, utf8} component names.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeActorMesh(const AActor* Actor, int32 LODIndex, uint16 Flags);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UFusionCamSensor;
+struct FReadbackRegion;
+
+namespace LychSim
+{
+	/** Captured image of one sensor, Colors for lit, normal and seg, Floats for depth */
+	struct FMultiCaptureImage
+	{
+		TArray<FColor> Colors;
+		TArray<float> Floats;
+		int32 Width = 0;
+		int32 Height = 0;
+	};
+
+	LYCHSIM_API bool IsMultiCaptureMode(const FString& Mode);
+
+	/**
+	 * Capture Mode (lit, depth, normal or seg) of many sensors with one wait for the rendering thread. The scene
+	 * captures of all sensors are sent first, then the readbacks are queued behind them, and the game thread
+	 * flushes once instead of once per sensor. The annotated components are gathered once for the whole batch.
+	 *
+	 * The sensors of an AStereoCameraActor are sent back to back, so a stereo pair renders the same show only
+	 * list with the same scene state. OutImages follows the order of Sensors, an invalid sensor gives an empty image.
+	 */
+	LYCHSIM_API bool CaptureMulti(const TArray<UFusionCamSensor*>& Sensors, const FString& Mode, const FReadbackRegion& Region, TArray<FMultiCaptureImage>& OutImages);
+
+	/**
+	 * Layout (little endian): uint32 magic 'LMCP', uint16 version, uint16 num parts, then per part {int32 sensor
+	 * id, uint32 width, uint32 height, uint32 num bytes}, then the encoded bytes of the parts in the same order.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeMultiCapture(const TArray<int32>& SensorIds, const TArray<FMultiCaptureImage>& Images, const TArray<TArray<uint8>>& Parts);
+}
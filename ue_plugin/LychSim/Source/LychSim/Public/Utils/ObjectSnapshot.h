@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/JsonWriter.h"
+
+namespace LychSim
+{
+	/** Raw per-actor state read on the game thread, everything else is derived from it */
+	struct FObjectSnapshotRow
+	{
+		FString ObjectId;
+		FString Guid;
+		bool bValid = false;
+		FBox AABB = FBox(ForceInit);
+		FVector BoundsCenter = FVector::ZeroVector;
+		FVector BoundsExtent = FVector::ZeroVector;
+		FTransform Transform;
+		FColor Color = FColor(0, 0, 0, 0);
+	};
+
+	/**
+	 * Read the state of each actor once: one GetActorBounds call and one component lookup
+	 * for the annotation color. Invalid actors produce rows with bValid = false.
+	 */
+	LYCHSIM_API void GatherObjectSnapshot(const TArray<AActor*>& Actors, TArray<FObjectSnapshotRow>& OutRows);
+
+	/** Write one row with the same fields as "lych obj get_annots" */
+	LYCHSIM_API void WriteObjectSnapshotJson(const TSharedRef<TJsonWriter<>>& Writer, const FObjectSnapshotRow& Row);
+
+	/**
+	 * Pack the rows as a structure-of-arrays blob, columns are filled in parallel.
+	 * Layout (little endian): uint32 magic 'LOBJ', uint16 version, uint16 num columns, uint32 num rows,
+	 * then per column {uint8 name length, name, uint8 width}, zero padding to 4 bytes,
+	 * then each column as float32 [num rows, width], then {uint16 length, utf8} object id and guid per row.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeObjectSnapshot(const TArray<FObjectSnapshotRow>& Rows);
+}
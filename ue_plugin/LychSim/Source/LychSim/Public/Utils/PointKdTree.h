@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace LychSim
+{
+	/**
+	 * A static 3D k-d tree for nearest point queries. The tree is stored implicitly in a reordered
+	 * copy of the points, each node splits on the widest axis of its range. Queries are const and
+	 * can run from many threads at once.
+	 */
+	class LYCHSIM_API FPointKdTree
+	{
+	public:
+		explicit FPointKdTree(const TArray<FVector>& InPoints);
+
+		/** Return the index of the nearest point in the input array, or INDEX_NONE if the tree is empty */
+		int32 FindNearest(const FVector& Query, double& OutDistanceSquared) const;
+
+		int32 Num() const { return Entries.Num(); }
+
+	private:
+		void Build(int32 Begin, int32 End);
+
+		void Search(int32 Begin, int32 End, const FVector3f& Query, int32& BestNode, float& BestDistanceSquared) const;
+
+		struct FEntry
+		{
+			FVector3f Point;
+			int32 SourceIndex;
+		};
+
+		TArray<FEntry> Entries;
+		TArray<uint8> SplitAxes; // Axis of the node at the middle of each range
+	};
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace LychSim
+{
+	/**
+	 * Project world space points into pixel coordinates in parallel.
+	 * Writes three floats [u, v, depth] per point, depth is the distance along the optical axis
+	 * and is not positive for points behind the camera.
+	 */
+	LYCHSIM_API void ProjectPoints(const FMatrix& ViewMatrix, const FMatrix& ProjectionMatrix,
+		int Width, int Height, const TArray<FVector>& Points, TArray<float>& OutUVD);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Core/Public/HAL/Runnable.h"
+#include "Utils/RequestStats.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+namespace LychSim
+{
+	enum class ERequestLogVerbosity : uint8
+	{
+		Off,
+		Errors,  // Only the requests that failed
+		Summary, // Sampled requests with their command template, timings and sizes, and every failed request
+		Full,    // Summary with the start of the request text
+	};
+
+	LYCHSIM_API const TCHAR* GetRequestLogVerbosityName(ERequestLogVerbosity Verbosity);
+
+	/** Return false if Name is not off, errors, summary or full */
+	LYCHSIM_API bool ParseRequestLogVerbosity(const FString& Name, ERequestLogVerbosity& OutVerbosity);
+
+	/** What the server knows about a replied request, the strings are only copied if it is logged */
+	struct FRequestLogEntry
+	{
+		uint32 RequestId = 0;
+		double ReceiveTime = 0; // FPlatformTime::Seconds
+		const FString* Command = nullptr;
+		const FString* Message = nullptr;
+		const FString* Error = nullptr; // Set if the request failed
+		double StageSeconds[(int32)ERequestStage::Num] = {};
+		int32 BytesIn = 0;
+		int32 BytesOut = 0;
+	};
+
+	/**
+	 * Structured log of the served requests. Add copies a sampled request into a fixed size binary
+	 * record in a lock free ring buffer, a background thread formats the records and appends them to
+	 * a JSONL file, one object per line. Nothing is formatted on the game thread, and a request that
+	 * is not sampled costs a few comparisons. Records are dropped, and counted, while the ring is full.
+	 *
+	 * Add is called from the game thread only, it is the single producer of the ring.
+	 */
+	class LYCHSIM_API FRequestLog
+	{
+	public:
+		/** Records held by the ring, about 1.5MB */
+		static constexpr int32 Capacity = 1 << 12;
+		static constexpr int32 MaxCommandLen = 63;
+		static constexpr int32 MaxTextLen = 127;
+
+		static FRequestLog& Get();
+
+		/** Start or stop logging, SampleRate (0 to 1) is the share of successful requests logged. An empty Path is Saved/Logs/LychSimRequests.jsonl */
+		void Configure(ERequestLogVerbosity InVerbosity, float InSampleRate, const FString& InPath);
+
+		void Add(const FRequestLogEntry& Entry);
+
+		/** Write the records in the ring and stop the flusher, called when the module shuts down */
+		void Shutdown();
+
+		ERequestLogVerbosity GetVerbosity() const { return Verbosity.load(std::memory_order_relaxed); }
+		float GetSampleRate() const { return SampleRate; }
+		FString GetPath() const;
+		uint64 GetNumLogged() const { return NumWritten.load(std::memory_order_relaxed); }
+		uint64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+
+	private:
+		struct FRecord
+		{
+			double ReceiveTime;
+			uint32 RequestId;
+			uint32 StageMicroseconds[(int32)ERequestStage::Num];
+			int32 BytesIn;
+			int32 BytesOut;
+			uint8 bError;
+			uint8 CommandLen;
+			uint8 RequestLen; // Only at Full verbosity
+			uint8 ErrorLen;
+			ANSICHAR Command[MaxCommandLen];
+			ANSICHAR Request[MaxTextLen];
+			ANSICHAR Error[MaxTextLen];
+		};
+
+		class FFlusher : public FRunnable
+		{
+		public:
+			explicit FFlusher(FRequestLog& InLog) : Log(InLog) {}
+			virtual uint32 Run() override;
+		private:
+			FRequestLog& Log;
+		};
+
+		FRequestLog();
+
+		/** Decide before anything is copied, advances the sampling counter */
+		bool ShouldLog(bool bError);
+
+		/** Format the records in the ring and append them to the file, on the flusher thread */
+		void Flush();
+
+		std::atomic<ERequestLogVerbosity> Verbosity{ ERequestLogVerbosity::Off };
+		float SampleRate = 1.0f;
+		float SampleCredit = 0.0f;
+
+		/** Ring of Capacity records, Head is written by the game thread and Tail by the flusher */
+		TArray<FRecord> Records;
+		std::atomic<uint64> Head{ 0 };
+		std::atomic<uint64> Tail{ 0 };
+		std::atomic<uint64> NumWritten{ 0 };
+		std::atomic<uint64> NumDropped{ 0 };
+		uint64 NumDroppedReported = 0;
+
+		/** Seconds to add to FPlatformTime::Seconds for unix time */
+		double UnixTimeOffset = 0;
+
+		FFlusher Flusher;
+		FRunnableThread* Thread = nullptr;
+		FEvent* WakeEvent = nullptr;
+		std::atomic<bool> bStopping{ false };
+
+		/** Guarded by FileLock */
+		mutable FCriticalSection FileLock;
+		FString Path;
+		IFileHandle* File = nullptr;
+	};
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+namespace LychSim
+{
+	/** A replied request as the recorder sees it */
+	struct FRecordedRequest
+	{
+		double ReceiveTime = 0; // FPlatformTime::Seconds
+		uint32 RequestId = 0;
+		const FString* Endpoint = nullptr;
+		const FString* Command = nullptr; // Template, e.g. "lych cam get_lit"
+		const FString* Message = nullptr;
+		bool bError = false;
+		const uint8* Reply = nullptr; // Without the "<id>:" header
+		int32 ReplySize = 0;
+		double LatencySeconds = 0; // Received until the reply is sent
+	};
+
+	/**
+	 * Record the served requests to a compact binary log, so a workload can be replayed against a
+	 * server with lychsim.tools.replay. Little endian, the file starts with
+	 *
+	 *   uint32 magic 'LREC', uint16 version 1, uint16 header size 16, double unix time of the start
+	 *
+	 * followed by records that start with a uint8 type:
+	 *
+	 *   1 string:  uint16 index, uint16 size, utf8 bytes. Endpoints and command templates are
+	 *              written once and referred to by index
+	 *   2 request: uint64 microseconds since the start, uint32 request id, uint16 endpoint,
+	 *              uint16 command, uint8 status (0 ok, 1 error), uint32 reply size, uint32 crc32
+	 *              of the reply (as zlib), uint32 latency in microseconds, uint32 size, utf8 request
+	 *
+	 * Records are buffered and written in blocks. Call from the game thread only.
+	 */
+	class LYCHSIM_API FRequestRecorder
+	{
+	public:
+		static constexpr uint32 Magic = 0x4345524C; // "LREC"
+		static constexpr uint16 Version = 1;
+
+		static FRequestRecorder& Get();
+
+		~FRequestRecorder();
+
+		/** Start a new log at Path, the current one is closed. Return false if the file can not be opened */
+		bool Start(const FString& InPath);
+
+		/** Write the buffered records and close the log */
+		void Stop();
+
+		bool IsRecording() const { return File != nullptr; }
+
+		void Add(const FRecordedRequest& Request);
+
+		const FString& GetPath() const { return Path; }
+		int64 GetNumRecorded() const { return NumRecorded; }
+		int64 GetBytesWritten() const { return BytesWritten + Buffer.Num(); }
+
+	private:
+		/** Index of Value in the string table, written to the log the first time it is seen */
+		uint16 FindOrAddString(const FString& Value);
+
+		void WriteBuffer();
+
+		IFileHandle* File = nullptr;
+		FString Path;
+		double StartTime = 0;
+		TMap<FString, uint16> Strings;
+		TArray<uint8> Buffer;
+		int64 NumRecorded = 0;
+		int64 BytesWritten = 0;
+	};
+}
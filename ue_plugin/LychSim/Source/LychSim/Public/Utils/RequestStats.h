@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+namespace LychSim
+{
+	/**
+	 * Histogram of non-negative integers, e.g. microseconds or bytes, with log-linear buckets as in HdrHistogram.
+	 * Every power of two is split into 16 buckets, so a percentile is within 1/16 of the recorded value.
+	 * Record is lock free and can be called from any thread.
+	 */
+	class LYCHSIM_API FLatencyHistogram
+	{
+	public:
+		static constexpr int32 SubBucketBits = 4;
+		static constexpr int32 SubBucketCount = 1 << SubBucketBits;
+		static constexpr int32 NumBuckets = (64 - SubBucketBits + 1) * SubBucketCount;
+
+		FLatencyHistogram();
+
+		void Record(uint64 Value);
+
+		void Reset();
+
+		uint64 GetCount() const { return Count.load(std::memory_order_relaxed); }
+		uint64 GetSum() const { return Sum.load(std::memory_order_relaxed); }
+		uint64 GetMax() const { return Max.load(std::memory_order_relaxed); }
+
+		/** The upper bound of the bucket that holds the Percentile (0 to 100), 0 if nothing is recorded */
+		uint64 GetPercentile(double Percentile) const;
+
+		static int32 GetBucketIndex(uint64 Value);
+
+		/** The largest value that falls into Index */
+		static uint64 GetBucketUpperBound(int32 Index);
+
+	private:
+		std::atomic<uint64> Buckets[NumBuckets];
+		std::atomic<uint64> Count;
+		std::atomic<uint64> Sum;
+		std::atomic<uint64> Max;
+	};
+
+	/** Where the time of a request goes, from the network thread to the reply on the socket */
+	enum class ERequestStage : uint8
+	{
+		QueueWait, // Received until it starts to run, including the wait for a batch or an async command
+		Dispatch,  // Match the command template and parse the arguments
+		Handler,   // Run the handler, until the promise is fulfilled for an async command
+		Serialize, // Build the reply bytes
+		Send,      // Write the reply to the socket
+		Num
+	};
+
+	LYCHSIM_API const TCHAR* GetRequestStageName(ERequestStage Stage);
+
+	struct FCommandStats
+	{
+		FLatencyHistogram Stages[(int32)ERequestStage::Num]; // Microseconds
+		FLatencyHistogram BytesIn;
+		FLatencyHistogram BytesOut;
+	};
+
+	/**
+	 * Latency and size histograms of the requests, one set per command template, e.g. "lych cam get_lit".
+	 * The templates are added on the game thread, the histograms can be recorded from any thread.
+	 */
+	class LYCHSIM_API FRequestStats
+	{
+	public:
+		static FRequestStats& Get();
+
+		/** The stats of a command template, the reference stays valid until the module shuts down */
+		FCommandStats& FindOrAdd(const FString& Command);
+
+		void Record(const FString& Command, ERequestStage Stage, double Seconds);
+
+		/** Clear the histograms, the templates are kept */
+		void Reset();
+
+		/** JSON with the count, mean, p50, p90, p99 and max of every stage and byte count per command */
+		FString ToJson() const;
+
+		/** Prometheus text exposition format, stages as summaries in seconds */
+		FString ToPrometheus() const;
+
+	private:
+		TMap<FString, TUniquePtr<FCommandStats>> Commands;
+
+		/** Seconds since the process started or since Reset */
+		double ResetTime = 0;
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace LychSim
+{
+	/** Bits of FSegInstanceStats::Truncation, set when the 2D box touches the image border */
+	enum ESegTruncation : uint8
+	{
+		SegTruncLeft   = 1 << 0,
+		SegTruncTop    = 1 << 1,
+		SegTruncRight  = 1 << 2,
+		SegTruncBottom = 1 << 3,
+	};
+
+	/** Per-instance statistics accumulated from a segmentation frame */
+	struct FSegInstanceStats
+	{
+		FColor Color;
+		uint32 PixelCount = 0;
+		int32 XMin = MAX_int32;
+		int32 YMin = MAX_int32;
+		int32 XMax = -1;
+		int32 YMax = -1;
+		uint8 Truncation = 0;
+	};
+
+	/**
+	 * Count pixels, tight 2D boxes and truncation flags for each instance color in one pass.
+	 * OutStats has the same order as InstanceColors, pixels of unknown colors are ignored.
+	 */
+	LYCHSIM_API void ComputeSegStats(const TArray<FColor>& SegData, int Width, int Height,
+		const TArray<FColor>& InstanceColors, TArray<FSegInstanceStats>& OutStats);
+
+	/**
+	 * Pack the stats into the compact binary table returned by "lych cam get_seg_stats".
+	 * Layout (little endian): header {uint32 magic 'LSEG', uint16 version, uint16 row size,
+	 * int32 width, int32 height, uint32 num rows, uint32 mask bytes}, then num rows x
+	 * {uint8 r, g, b, truncation, uint32 pixels, int32 xmin, ymin, xmax, ymax},
+	 * then one {uint16 length, utf8 bytes} name per row, then the optional encoded mask.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeSegStats(const TArray<FSegInstanceStats>& Stats,
+		const TArray<FString>& Names, int Width, int Height, const TArray<uint8>& MaskData);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+namespace LychSim
+{
+	/** World space vertices of many actors packed into one buffer */
+	struct FSkinnedVertexCapture
+	{
+		TArray<FString> ActorNames;
+		TArray<uint32> Offsets; // First vertex of each actor
+		TArray<uint32> Counts;  // Number of vertices of each actor, all its skinned components in order
+		TArray<float> Positions; // float32 [num vertices, 3]
+	};
+
+	/**
+	 * Skin every skinned mesh component of the actors at the given LOD (clamped per component).
+	 * The bone matrices are snapshotted on the game thread, then the components are skinned
+	 * and transformed to world space in parallel on the worker threads.
+	 */
+	LYCHSIM_API void CaptureSkinnedVertices(const TArray<AActor*>& Actors, int32 LODIndex, FSkinnedVertexCapture& Out);
+
+	/**
+	 * Layout (little endian): uint32 magic 'LSKV', uint16 version, uint16 reserved, uint32 num actors,
+	 * uint32 num vertices, then per actor {uint32 offset, uint32 count}, then float32 positions [V, 3],
+	 * then {uint16 length, utf8} actor names.
+	 */
+	LYCHSIM_API TArray<uint8> SerializeSkinnedVertices(const FSkinnedVertexCapture& Capture);
+
+	/**
+	 * The raw format of LychCore/RawTensor.h: a float32 [V, 3] "XYZ" tensor of the positions, then
+	 * a trailer of uint32 num actors, per actor {uint32 offset, uint32 count}, then the
+	 * {uint16 length, utf8} actor names. The header and the body are sent separately.
+	 */
+	LYCHSIM_API void SerializeSkinnedVerticesRaw(const FSkinnedVertexCapture& Capture, uint64 FrameId,
+		TArray<uint8>& OutHeader, TArray<uint8>& OutBody);
+}
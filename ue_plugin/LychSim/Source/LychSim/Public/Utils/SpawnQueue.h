@@ -0,0 +1,135 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Engine/StreamableManager.h"
+#include "Serialization/JsonWriter.h"
+
+class UStaticMesh;
+
+namespace LychSim
+{
+	/** One object of a spawn manifest */
+	struct FSpawnEntry
+	{
+		FString Name;
+		int32 AssetIndex = INDEX_NONE; // Into FSpawnManifest::AssetPaths
+		FTransform Transform;
+	};
+
+	struct FSpawnManifest
+	{
+		TArray<FString> AssetPaths; // Unique
+		TArray<FSpawnEntry> Entries;
+	};
+
+	/**
+	 * Parse a manifest, either JSON: [{"name", "path", "loc": [3], "rot": [3], "scale": [3]}, ...]
+	 * (optionally wrapped as {"objects": [...]}), or binary, little endian: uint32 magic 'LSPN',
+	 * uint32 num assets, per asset {uint16 length, utf8 path}, uint32 num objects, per object
+	 * {uint16 length, utf8 name, uint32 asset index, float32 x, y, z, pitch, yaw, roll, sx, sy, sz}.
+	 */
+	LYCHSIM_API bool ParseSpawnManifest(const TArray<uint8>& Data, FSpawnManifest& OutManifest, FString& OutError);
+}
+
+/**
+ * Spawns manifests of ALychSimBasicActor in the background. The unique meshes of a job are
+ * prefetched with one asynchronous streaming request, then actors are spawned across ticks
+ * within a per-tick time budget so the game thread never stalls on a large scene.
+ */
+class LYCHSIM_API FLychSimSpawnQueue : public FTickableGameObject
+{
+public:
+	struct FJobOptions
+	{
+		double BudgetSeconds = 0.004;
+		bool bSimulatePhysics = true;
+	};
+
+	/** Start a job and return its id */
+	int32 AddJob(UWorld* World, LychSim::FSpawnManifest&& Manifest, const FJobOptions& Options);
+
+	bool HasJob(int32 JobId) const
+	{
+		return Jobs.Contains(JobId);
+	}
+
+	/**
+	 * Write the progress of a job, return false if the id is unknown. The status of a finished
+	 * job is written once, the job is dropped after it.
+	 */
+	bool WriteJobStatus(int32 JobId, const TSharedRef<TJsonWriter<>>& Writer);
+
+	/** Stop spawning, actors already spawned are kept */
+	bool CancelJob(int32 JobId);
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const
+	{
+		return NumActiveJobs > 0;
+	}
+
+	virtual bool IsTickableWhenPaused() const
+	{
+		return true;
+	}
+
+	virtual bool IsTickableInEditor() const
+	{
+		return true;
+	}
+
+	virtual TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FLychSimSpawnQueue, STATGROUP_Tickables);
+	}
+
+private:
+	enum class EJobState : uint8
+	{
+		Loading,
+		Spawning,
+		Done,
+		Cancelled,
+	};
+
+	struct FJob
+	{
+		int32 Id = 0;
+		EJobState State = EJobState::Loading;
+		FJobOptions Options;
+		TWeakObjectPtr<UWorld> World;
+		LychSim::FSpawnManifest Manifest;
+		TSharedPtr<FStreamableHandle> Handle; // Keeps the meshes loaded while spawning
+		TArray<UStaticMesh*> Meshes;
+		int32 NumAssets = 0;
+		int32 NumAssetsLoaded = 0;
+		int32 NextEntry = 0;
+		int32 NumSpawned = 0;
+		int32 NumFailed = 0;
+		int32 Total = 0;
+		TArray<FString> Errors;
+		double StartTime = 0.0;
+		double LoadTime = 0.0;
+		double EndTime = 0.0;
+	};
+
+	/** Spawn entries until the time budget runs out, return true when the job is finished */
+	bool SpawnSome(FJob& Job);
+
+	void FinishJob(FJob& Job, EJobState State);
+
+	void AddError(FJob& Job, const FString& Error);
+
+	/** Drop the oldest finished jobs whose status was never read, beyond a fixed count */
+	void PruneFinishedJobs();
+
+	FStreamableManager StreamableManager;
+
+	TMap<int32, FJob> Jobs;
+
+	int32 NextJobId = 1;
+
+	int32 NumActiveJobs = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class UStaticMesh;
+class FStaticMeshRenderData;
+
+namespace LychSim
+{
+	/**
+	 * Data derived from static meshes, kept per mesh and reset when the mesh is replaced or its
+	 * render data is rebuilt in the editor. Entries of unloaded meshes are pruned whenever the map
+	 * has doubled since the last prune, so a lookup is amortized O(1) however many meshes are loaded.
+	 *
+	 * Call from the game thread only.
+	 */
+	template<typename ValueType>
+	class TStaticMeshCache
+	{
+	public:
+		/** The value of Mesh, default constructed if it is new or its render data changed */
+		ValueType& FindOrAdd(UStaticMesh* Mesh, const FStaticMeshRenderData* RenderData)
+		{
+			if (Entries.Num() >= PruneThreshold)
+			{
+				Prune();
+			}
+			FEntry& Entry = Entries.FindOrAdd(FObjectKey(Mesh));
+			if (Entry.Mesh.Get() != Mesh || Entry.RenderData != RenderData)
+			{
+				Entry.Mesh = Mesh;
+				Entry.RenderData = RenderData;
+				Entry.Value = ValueType();
+			}
+			return Entry.Value;
+		}
+
+		int32 Num() const { return Entries.Num(); }
+
+	private:
+		void Prune()
+		{
+			for (auto It = Entries.CreateIterator(); It; ++It)
+			{
+				if (!It->Value.Mesh.IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+			PruneThreshold = FMath::Max(MinPruneThreshold, Entries.Num() * 2);
+		}
+
+		struct FEntry
+		{
+			TWeakObjectPtr<UStaticMesh> Mesh;
+			const FStaticMeshRenderData* RenderData = nullptr;
+			ValueType Value;
+		};
+
+		static constexpr int32 MinPruneThreshold = 1024;
+
+		TMap<FObjectKey, FEntry> Entries;
+		int32 PruneThreshold = MinPruneThreshold;
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+namespace LychSim
+{
+	/**
+	 * Opt-in span tracing for hunting stalls. Every thread writes its spans into its own ring buffer, so
+	 * recording takes no lock, and a disabled trace costs one relaxed load per scope. Dump writes the
+	 * buffers as a Chrome trace, which chrome://tracing and ui.perfetto.dev open. Spans of one request
+	 * are linked by flow events on the request id.
+	 */
+	class LYCHSIM_API FTrace
+	{
+	public:
+		/** Events kept per thread, older events are overwritten */
+		static constexpr int32 EventsPerThread = 1 << 16;
+
+		static bool IsEnabled() { return bEnabled.load(std::memory_order_relaxed); }
+
+		/** Start recording, the events of an earlier session are dropped */
+		static void Enable();
+
+		static void Disable();
+
+		/** Name must be a string literal, it is stored as a pointer */
+		static void AddSpan(const TCHAR* Name, uint64 StartCycles, uint64 EndCycles, uint32 RequestId);
+
+		/** The recorded events as Chrome trace JSON. Spans recorded during the dump may be missing */
+		static FString ToChromeTrace();
+
+	private:
+		static std::atomic<bool> bEnabled;
+	};
+
+	/** Record the lifetime of the scope as a span if tracing is enabled */
+	class FTraceScope
+	{
+	public:
+		explicit FTraceScope(const TCHAR* InName, uint32 InRequestId = 0)
+			: Name(InName), RequestId(InRequestId), StartCycles(FTrace::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+		{
+		}
+
+		~FTraceScope()
+		{
+			if (StartCycles != 0 && FTrace::IsEnabled())
+			{
+				FTrace::AddSpan(Name, StartCycles, FPlatformTime::Cycles64(), RequestId);
+			}
+		}
+
+	private:
+		const TCHAR* Name;
+		uint32 RequestId;
+		uint64 StartCycles;
+	};
+}
+
+#define LYCHSIM_TRACE_SCOPE(Name) LychSim::FTraceScope PREPROCESSOR_JOIN(LychSimTraceScope, __LINE__)(TEXT(Name))
+#define LYCHSIM_TRACE_SCOPE_REQUEST(Name, RequestId) LychSim::FTraceScope PREPROCESSOR_JOIN(LychSimTraceScope, __LINE__)(TEXT(Name), RequestId)
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Core/Public/HAL/Runnable.h"
+#include "Runtime/Core/Public/Containers/Queue.h"
+
+class FRunnableThread;
+class FEvent;
+
+namespace LychSim
+{
+	/**
+	 * A fixed set of threads draining a bounded queue of encode / write tasks. The threads sleep
+	 * until a task is queued, Enqueue blocks while the queue is full, so a slow disk slows the
+	 * producer down instead of growing memory without bound. The queue is bounded by the number of
+	 * tasks and by the bytes the tasks hold, which are released when a task finishes.
+	 */
+	class LYCHSIM_API FWriterPool
+	{
+	public:
+		/** InMaxPendingBytes of 0 means no memory cap */
+		FWriterPool(const TCHAR* InName, int32 NumThreads, int32 InMaxQueuedTasks, int64 InMaxPendingBytes = 0);
+
+		/** Finish every queued task, then stop the threads */
+		~FWriterPool();
+
+		/**
+		 * Queue a task holding Bytes of memory. Blocks the caller while MaxQueuedTasks tasks are
+		 * waiting or the pending bytes would exceed the cap, a task is always accepted by an idle pool.
+		 */
+		void Enqueue(TUniqueFunction<void()>&& Task, int64 Bytes = 0);
+
+		/** Block until no task is queued or running, do not call from a task. Return false on timeout */
+		bool Flush(uint32 WaitTimeMs = MAX_uint32);
+
+		/** Tasks queued or running */
+		int32 NumPending() const;
+
+		/** Bytes held by the tasks queued or running */
+		int64 PendingBytes() const;
+
+	private:
+		class FWorker : public FRunnable
+		{
+		public:
+			explicit FWorker(FWriterPool& InPool) : Pool(InPool) {}
+			virtual uint32 Run() override;
+		private:
+			FWriterPool& Pool;
+		};
+
+		void FinishTask(int64 Bytes);
+
+		struct FTask
+		{
+			TUniqueFunction<void()> Function;
+			int64 Bytes = 0;
+		};
+
+		/** Wait for a task, return false when the pool is stopping and the queue is empty */
+		bool Dequeue(FTask& OutTask);
+
+		const int32 MaxQueuedTasks;
+		const int64 MaxPendingBytes;
+
+		mutable FCriticalSection Lock;
+		TQueue<FTask> Tasks; // Guarded by Lock
+		int32 NumQueued = 0;
+		int32 NumRunning = 0;
+		int64 NumPendingBytes = 0;
+		bool bStopping = false;
+
+		FEvent* WorkEvent = nullptr;  // Auto reset, a task was queued
+		FEvent* SpaceEvent = nullptr; // Auto reset, a task was taken or finished
+		FEvent* IdleEvent = nullptr;  // Manual reset, nothing queued or running
+
+		TArray<TUniquePtr<FWorker>> Workers;
+		TArray<FRunnableThread*> Threads;
+	};
+}
@@ -1,6 +1,7 @@
 # pragma once
 
 #include "CoreMinimal.h"
+#include "LychCore/ArgParse.h"
 
 #ifndef LYCHSIM_API
 #define LYCHSIM_API
@@ -26,7 +27,11 @@ namespace LychSim
 		}
     };
 
+    /** Parse with LychSim::Core::ParseArgs, which follows FParse::Token */
     LYCHSIM_API FParsedCmd ParseTailWithFParse(const FString& Tail);
 
+    /** Convert the arguments parsed by the core library, a later -key=value wins */
+    LYCHSIM_API FParsedCmd ToParsedCmd(const Core::FParsedArgs& Args);
+
     FString ParsedCmdToString(const FParsedCmd& Cmd);
 }
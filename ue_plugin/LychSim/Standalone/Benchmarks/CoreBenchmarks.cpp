@@ -0,0 +1,322 @@
+// Throughput of the parts of a request that do not need the engine: finding the handler, parsing
+// the arguments, encoding the reply and framing it. Run with --benchmark_filter to pick a group.
+#include <benchmark/benchmark.h>
+#include <cstring>
+
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ImageEncoders.h"
+#include "LychCore/ArgParse.h"
+#include "LychCore/CommandRouter.h"
+#include "LychCore/Framing.h"
+#include "LychCore/Npy.h"
+#include "LychCore/RawTensor.h"
+#include "MockScene.h"
+#include "MockServer.h"
+
+namespace
+{
+	/** A cut of the templates the plugin binds, in its order of binding */
+	const char* const PluginTemplates[] = {
+		"vrun [str]", "vrun [str] [str]", "vrun [str] [str] [str]", "vrun [str] [str] [str] [str]",
+		"vexec [str] [str]", "vexec [str] [str] [str]", "vexec [str] [str] [str] [str]",
+		"vbp [str] [str]", "vbp [str] [str] [str]", "vbp [str] [str] [str] [str]", "vbp [str] [str] [str] [str] [str]",
+		"vget /persistent_level/id", "vget /persistent_level/level_script_actor/id",
+		"vget /unrealcv/status", "vget /unrealcv/help", "vget /unrealcv/version", "vget /unrealcv/echo [str]",
+		"vget /unrealcv/stats", "vget /unrealcv/trace", "vget /unrealcv/request_log", "vget /unrealcv/record",
+		"vset /action/game/pause", "vset /action/game/resume", "vset /action/game/level [str]",
+		"vset /action/input/enable", "vset /action/input/disable", "vset /action/eyes_distance [float]",
+		"vset /action/keyboard [str] [float]", "vget /action/game/is_paused",
+		"vget /level/name", "vget /scene/name", "vget /objects", "vget /cameras", "vget /viewmode",
+		"vget /object/[str]/location", "vset /object/[str]/location [float] [float] [float]",
+		"vget /object/[str]/rotation", "vset /object/[str]/rotation [float] [float] [float]",
+		"vget /object/[str]/scale", "vget /object/[str]/bounds", "vget /object/[str]/color",
+		"vget /object/[str]/label", "vget /object/[str]/mobility", "vget /object/[str]/uclass_name",
+		"vget /object/[str]/vertex_location",
+		"vget /camera/[uint]/location", "vset /camera/[uint]/location [float] [float] [float]",
+		"vget /camera/[uint]/rotation", "vset /camera/[uint]/rotation [float] [float] [float]",
+		"vget /camera/[uint]/fov", "vget /camera/[uint]/size", "vget /screenshot [str]",
+		"vget /camera/[uint]/lit [str]", "vget /camera/[uint]/depth [str]", "vget /camera/[uint]/normal [str]",
+		"vget /camera/[uint]/object_mask [str]", "vget /camera/[uint]/seg [str]",
+		"vget /segmentation/mode", "lych /segmentation/mode", "lych /segmentation/mode [str]",
+		"lych /camera/[uint]/object_mask [str]", "lych /camera/[uint]/seg [str]",
+		"lych version", "lych sim step", "lych sim lockstep", "lych sim headless", "lych sim bench_capture",
+		"lych data info", "lych data flush", "lych data writer_stats", "lych data debug_line",
+		"lych cam get_loc [uint]", "lych cam set_loc [uint] [float] [float] [float]",
+		"lych cam get_rot [uint]", "lych cam set_rot [uint] [float] [float] [float]",
+		"lych cam get_fov [uint]", "lych cam get_c2w [uint]", "lych cam warmup [uint]",
+		"lych cam set_film_size [uint] [uint] [uint]", "lych cam get_annots [uint]",
+		"lych cam annotate_new", "lych cam clear_annot_comps",
+	};
+
+	/** The routes of "lych <group> <verb>" are followed by any arguments */
+	const char* const PluginTailTemplates[] = {
+		"lych cam get_lit", "lych cam get_seg", "lych cam get_depth", "lych cam get_normal", "lych cam get_multi",
+		"lych cam get_seg_stats", "lych cam project",
+		"lych obj list", "lych obj list_selected", "lych obj get_loc", "lych obj set_loc", "lych obj get_rot",
+		"lych obj set_rot", "lych obj get_aabb", "lych obj get_annots", "lych obj get_color", "lych obj get_mesh",
+		"lych obj get_mesh_extent", "lych obj get_bones", "lych obj get_skinned_verts", "lych obj update",
+		"lych obj update_batch", "lych obj spawn_batch", "lych obj spawn_status",
+	};
+
+	LychSim::Core::FCommandRouter MakePluginRouter()
+	{
+		LychSim::Core::FCommandRouter Router;
+		for (const char* Template : PluginTemplates)
+		{
+			Router.Add(Template, false);
+		}
+		for (const char* Template : PluginTailTemplates)
+		{
+			Router.Add(Template, true);
+		}
+		return Router;
+	}
+
+	const char* const MatchRequests[] = {
+		"vget /unrealcv/status",
+		"vset /camera/0/location 10.5 -20 300",
+		"vget /camera/1/lit png",
+		"lych obj get_loc -all",
+		"lych cam get_lit 0 -size=640x480 png",
+		"vrun stat fps",
+		"vget /no/such/command",
+	};
+
+	void BM_RouterMatch(benchmark::State& State)
+	{
+		const LychSim::Core::FCommandRouter Router = MakePluginRouter();
+		const std::string Request = MatchRequests[State.range(0)];
+		State.SetLabel(Request);
+		size_t ArgsBegin = 0;
+		for (auto _ : State)
+		{
+			benchmark::DoNotOptimize(Router.Match(Request, ArgsBegin));
+		}
+	}
+	BENCHMARK(BM_RouterMatch)->DenseRange(0, (int)std::size(MatchRequests) - 1);
+
+	void BM_RouterAdd(benchmark::State& State)
+	{
+		for (auto _ : State)
+		{
+			benchmark::DoNotOptimize(MakePluginRouter().Num());
+		}
+	}
+	BENCHMARK(BM_RouterAdd);
+
+	void BM_ParseArgs(benchmark::State& State)
+	{
+		const char* const Tails[] = {
+			"0 png",
+			"Object_1 Object_2 Object_3 -all",
+			"0 -size=1280x720 -roi=0,0,640,480 \"out dir/lit.png\" -fast",
+		};
+		const std::string Tail = Tails[State.range(0)];
+		State.SetLabel(Tail);
+		LychSim::Core::FParsedArgs Args;
+		for (auto _ : State)
+		{
+			LychSim::Core::ParseArgs(Tail, Args);
+			benchmark::DoNotOptimize(Args.Positionals.data());
+		}
+	}
+	BENCHMARK(BM_ParseArgs)->DenseRange(0, 2);
+
+	/** Matching, parsing and the handler of the mock server together, the dispatch cost of a request */
+	void BM_Dispatch(benchmark::State& State)
+	{
+		const char* const Requests[] = {
+			"vget /unrealcv/echo hello",
+			"vget /camera/0/location",
+			"lych obj get_loc -all",
+		};
+		LychSim::Mock::FMockServerConfig Config;
+		LychSim::Mock::FMockServer Server(Config);
+		const std::string Payload = std::string("42:") + Requests[State.range(0)];
+		State.SetLabel(Requests[State.range(0)]);
+		std::vector<uint8_t> Reply;
+		for (auto _ : State)
+		{
+			Server.HandlePayload(Payload, Reply);
+			benchmark::DoNotOptimize(Reply.data());
+		}
+	}
+	BENCHMARK(BM_Dispatch)->DenseRange(0, 2);
+
+	void BM_NpyDepth(benchmark::State& State)
+	{
+		const int Width = (int)State.range(0), Height = (int)State.range(1);
+		LychSim::Mock::FMockScene Scene(64, 1, Width, Height);
+		std::vector<float> Depth;
+		Scene.RenderDepth(Scene.Cameras[0], Width, Height, Depth);
+		std::vector<uint8_t> Out;
+		for (auto _ : State)
+		{
+			Out.clear();
+			LychSim::Core::AppendNpy(Out, Depth.data(), Width, Height, 1);
+			benchmark::DoNotOptimize(Out.data());
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Depth.size() * sizeof(float));
+	}
+	BENCHMARK(BM_NpyDepth)->Args({ 320, 240 })->Args({ 640, 480 })->Args({ 1920, 1080 });
+
+	void BM_PngLit(benchmark::State& State)
+	{
+		const int Width = (int)State.range(0), Height = (int)State.range(1);
+		LychSim::Mock::FMockScene Scene(64, 1, Width, Height);
+		std::vector<uint8_t> Pixels;
+		Scene.RenderLit(Scene.Cameras[0], Width, Height, Pixels);
+		std::vector<uint8_t> Out;
+		for (auto _ : State)
+		{
+			LychSim::Mock::EncodePng(Pixels.data(), Width, Height, Out, (int)State.range(2));
+			benchmark::DoNotOptimize(Out.data());
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Pixels.size());
+		State.counters["ratio"] = (double)Out.size() / (double)Pixels.size();
+	}
+	BENCHMARK(BM_PngLit)->Args({ 640, 480, -1 })->Args({ 640, 480, 1 })->Args({ 1920, 1080, -1 })->Args({ 1920, 1080, 1 });
+
+	void BM_BmpLit(benchmark::State& State)
+	{
+		const int Width = (int)State.range(0), Height = (int)State.range(1);
+		LychSim::Mock::FMockScene Scene(64, 1, Width, Height);
+		std::vector<uint8_t> Pixels;
+		Scene.RenderLit(Scene.Cameras[0], Width, Height, Pixels);
+		std::vector<uint8_t> Out;
+		for (auto _ : State)
+		{
+			LychSim::Mock::EncodeBmp(Pixels.data(), Width, Height, Out);
+			benchmark::DoNotOptimize(Out.data());
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Pixels.size());
+	}
+	BENCHMARK(BM_BmpLit)->Args({ 640, 480 })->Args({ 1920, 1080 });
+
+	/** The raw format, a header and the pixels as they are, as the plugin copies them into the reply */
+	void BM_RawLit(benchmark::State& State)
+	{
+		const int Width = (int)State.range(0), Height = (int)State.range(1);
+		LychSim::Mock::FMockScene Scene(64, 1, Width, Height);
+		std::vector<uint8_t> Pixels;
+		Scene.RenderLit(Scene.Cameras[0], Width, Height, Pixels);
+		std::vector<uint8_t> Out;
+		for (auto _ : State)
+		{
+			const LychSim::Core::FRawTensorHeader Header = LychSim::Core::MakeRawImageHeader(LychSim::Core::ERawDType::UInt8, Width, Height, 4, "BGRA");
+			Out.resize(LychSim::Core::RawTensorHeaderSize + Pixels.size());
+			LychSim::Core::WriteRawTensorHeader(Out.data(), Header);
+			std::memcpy(Out.data() + LychSim::Core::RawTensorHeaderSize, Pixels.data(), Pixels.size());
+			benchmark::DoNotOptimize(Out.data());
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Pixels.size());
+	}
+	BENCHMARK(BM_RawLit)->Args({ 640, 480 })->Args({ 1920, 1080 });
+
+	void BM_FrameWrite(benchmark::State& State)
+	{
+		const std::vector<uint8_t> Payload((size_t)State.range(0), 7);
+		std::vector<uint8_t> Out;
+		for (auto _ : State)
+		{
+			Out.clear();
+			LychSim::Core::AppendFrame(Out, Payload.data(), Payload.size());
+			benchmark::DoNotOptimize(Out.data());
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Payload.size());
+	}
+	BENCHMARK(BM_FrameWrite)->Arg(32)->Arg(4 << 10)->Arg(1 << 20);
+
+	/** Split a stream of frames that arrives in 64 KB reads, as from a socket */
+	void BM_FrameReader(benchmark::State& State)
+	{
+		const size_t PayloadSize = (size_t)State.range(0);
+		const std::vector<uint8_t> Payload(PayloadSize, 7);
+		std::vector<uint8_t> Stream;
+		while (Stream.size() < (4u << 20))
+		{
+			LychSim::Core::AppendFrame(Stream, Payload.data(), Payload.size());
+		}
+		constexpr size_t ChunkSize = 64 << 10;
+		for (auto _ : State)
+		{
+			LychSim::Core::FFrameReader Reader;
+			int64_t NumFrames = 0;
+			for (size_t Offset = 0; Offset < Stream.size(); Offset += ChunkSize)
+			{
+				Reader.Append(Stream.data() + Offset, std::min(ChunkSize, Stream.size() - Offset));
+				const uint8_t* Data = nullptr;
+				uint32_t Size = 0;
+				while (Reader.Next(Data, Size))
+				{
+					NumFrames++;
+				}
+			}
+			benchmark::DoNotOptimize(NumFrames);
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * Stream.size());
+	}
+	BENCHMARK(BM_FrameReader)->Arg(32)->Arg(4 << 10)->Arg(1 << 20);
+
+	bool SendAll(int Fd, const uint8_t* Data, size_t Size)
+	{
+		while (Size > 0)
+		{
+			const ssize_t Sent = send(Fd, Data, Size, 0);
+			if (Sent <= 0) return false;
+			Data += Sent;
+			Size -= (size_t)Sent;
+		}
+		return true;
+	}
+
+	/** A framed request and its reply over a unix socket pair, with the server side in this thread */
+	void BM_SocketRoundTrip(benchmark::State& State)
+	{
+		int Fds[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, Fds) != 0)
+		{
+			State.SkipWithError("socketpair failed");
+			return;
+		}
+		const std::vector<uint8_t> ReplyPayload((size_t)State.range(0), 7);
+		const char Request[] = "1:vget /camera/0/lit png";
+		std::vector<uint8_t> RequestFrame, ReplyFrame, Buffer(256 << 10);
+		LychSim::Core::AppendFrame(RequestFrame, Request, sizeof(Request) - 1);
+		LychSim::Core::AppendFrame(ReplyFrame, ReplyPayload.data(), ReplyPayload.size());
+		LychSim::Core::FFrameReader ServerReader, ClientReader;
+		for (auto _ : State)
+		{
+			SendAll(Fds[0], RequestFrame.data(), RequestFrame.size());
+			const uint8_t* Data = nullptr;
+			uint32_t Size = 0;
+			while (!ServerReader.Next(Data, Size))
+			{
+				const ssize_t Received = recv(Fds[1], Buffer.data(), Buffer.size(), 0);
+				ServerReader.Append(Buffer.data(), (size_t)Received);
+			}
+			// Interleave so neither socket buffer fills up with large replies
+			size_t Sent = 0;
+			while (!ClientReader.Next(Data, Size))
+			{
+				if (Sent < ReplyFrame.size())
+				{
+					const size_t Chunk = std::min(ReplyFrame.size() - Sent, (size_t)64 << 10);
+					SendAll(Fds[1], ReplyFrame.data() + Sent, Chunk);
+					Sent += Chunk;
+				}
+				const ssize_t Received = recv(Fds[0], Buffer.data(), Buffer.size(), 0);
+				ClientReader.Append(Buffer.data(), (size_t)Received);
+			}
+			benchmark::DoNotOptimize(Data);
+		}
+		State.SetBytesProcessed((int64_t)State.iterations() * ReplyPayload.size());
+		close(Fds[0]);
+		close(Fds[1]);
+	}
+	BENCHMARK(BM_SocketRoundTrip)->Arg(32)->Arg(640 * 480 * 4)->UseRealTime();
+}
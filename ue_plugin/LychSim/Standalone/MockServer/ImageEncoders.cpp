@@ -0,0 +1,98 @@
+#include "ImageEncoders.h"
+
+#include <cstring>
+#include <png.h>
+
+namespace
+{
+	void WritePngData(png_structp Png, png_bytep Data, png_size_t Size)
+	{
+		std::vector<uint8_t>* Out = static_cast<std::vector<uint8_t>*>(png_get_io_ptr(Png));
+		Out->insert(Out->end(), Data, Data + Size);
+	}
+
+	void FlushPngData(png_structp)
+	{
+	}
+
+	template<typename T>
+	void AppendValue(std::vector<uint8_t>& Out, T Value)
+	{
+		const size_t Start = Out.size();
+		Out.resize(Start + sizeof(T));
+		std::memcpy(Out.data() + Start, &Value, sizeof(T));
+	}
+}
+
+bool LychSim::Mock::EncodePng(const uint8_t* Bgra, int Width, int Height, std::vector<uint8_t>& Out, int Level)
+{
+	if (Width <= 0 || Height <= 0)
+	{
+		return false;
+	}
+	png_structp Png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop Info = Png ? png_create_info_struct(Png) : nullptr;
+	if (!Info)
+	{
+		png_destroy_write_struct(&Png, nullptr);
+		return false;
+	}
+	if (setjmp(png_jmpbuf(Png)))
+	{
+		png_destroy_write_struct(&Png, &Info);
+		return false;
+	}
+
+	Out.clear();
+	png_set_write_fn(Png, &Out, WritePngData, FlushPngData);
+	png_set_IHDR(Png, Info, Width, Height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	if (Level >= 0)
+	{
+		png_set_compression_level(Png, Level);
+	}
+	png_write_info(Png, Info);
+	png_set_bgr(Png);
+	for (int Row = 0; Row < Height; Row++)
+	{
+		png_write_row(Png, const_cast<png_bytep>(Bgra + (size_t)Row * Width * 4));
+	}
+	png_write_end(Png, nullptr);
+	png_destroy_write_struct(&Png, &Info);
+	return true;
+}
+
+bool LychSim::Mock::EncodeBmp(const uint8_t* Bgra, int Width, int Height, std::vector<uint8_t>& Out)
+{
+	if (Width <= 0 || Height <= 0)
+	{
+		return false;
+	}
+	const uint32_t NumBytes = (uint32_t)Width * Height * 4;
+	Out.clear();
+	Out.reserve(14 + 40 + 4 + NumBytes);
+
+	// BITMAPFILEHEADER
+	AppendValue<uint16_t>(Out, 0x4D42);
+	AppendValue<uint32_t>(Out, 14 + 40 + NumBytes);
+	AppendValue<uint16_t>(Out, 0);
+	AppendValue<uint16_t>(Out, 0);
+	AppendValue<uint32_t>(Out, 14 + 40);
+
+	// BITMAPINFOHEADER, a negative height is top down
+	AppendValue<uint32_t>(Out, 40);
+	AppendValue<int32_t>(Out, Width);
+	AppendValue<int32_t>(Out, -Height);
+	AppendValue<uint16_t>(Out, 1);
+	AppendValue<uint16_t>(Out, 32);
+	AppendValue<uint32_t>(Out, 0);
+	AppendValue<uint32_t>(Out, 0);
+	AppendValue<int32_t>(Out, 1024);
+	AppendValue<int32_t>(Out, 1024);
+	AppendValue<uint32_t>(Out, 0);
+	AppendValue<uint32_t>(Out, 0);
+
+	// The plugin serializes the pixels as a TArray, which writes the count first
+	AppendValue<int32_t>(Out, (int32_t)NumBytes);
+	Out.insert(Out.end(), Bgra, Bgra + NumBytes);
+	return true;
+}
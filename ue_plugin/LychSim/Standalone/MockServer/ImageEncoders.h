@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace LychSim::Mock
+{
+	/** PNG of a BGRA image (the layout of FColor), as FImageUtil::ConvertToPng. Level is the zlib level, -1 for the default */
+	bool EncodePng(const uint8_t* Bgra, int Width, int Height, std::vector<uint8_t>& Out, int Level = -1);
+
+	/** BMP of a BGRA image, byte for byte as FImageUtil::ConvertToBmp */
+	bool EncodeBmp(const uint8_t* Bgra, int Width, int Height, std::vector<uint8_t>& Out);
+}
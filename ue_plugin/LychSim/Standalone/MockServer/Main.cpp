@@ -0,0 +1,275 @@
+// A stand-in for the editor that speaks the LychSim protocol, for developing and benchmarking
+// clients without Unreal. Listens on a tcp port and optionally on /tmp/unrealcv_<port>.socket,
+// the unix socket path the plugin uses.
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "LychCore/Framing.h"
+#include "MockServer.h"
+
+namespace
+{
+	volatile std::sig_atomic_t bStopRequested = 0;
+
+	void HandleStopSignal(int)
+	{
+		bStopRequested = 1;
+	}
+
+	struct FConnection
+	{
+		int Fd = -1;
+		bool bUnix = false;
+		LychSim::Core::FFrameReader Reader;
+	};
+
+	/** Header, payload and the body after it in one frame with one writev, without copying them */
+	bool SendFrame(int Fd, const std::vector<uint8_t>& Payload, const uint8_t* Body = nullptr, size_t BodySize = 0)
+	{
+		uint8_t Header[LychSim::Core::FrameHeaderSize];
+		LychSim::Core::WriteFrameHeader(Header, (uint32_t)(Payload.size() + BodySize));
+		iovec Parts[3] = {
+			{ Header, sizeof(Header) },
+			{ const_cast<uint8_t*>(Payload.data()), Payload.size() },
+			{ const_cast<uint8_t*>(Body), BodySize },
+		};
+		int First = 0;
+		while (First < 3)
+		{
+			const ssize_t Sent = writev(Fd, Parts + First, 3 - First);
+			if (Sent < 0)
+			{
+				if (errno == EINTR) continue;
+				return false;
+			}
+			size_t Left = (size_t)Sent;
+			while (First < 3 && Left >= Parts[First].iov_len)
+			{
+				Left -= Parts[First].iov_len;
+				First++;
+			}
+			if (First < 3)
+			{
+				Parts[First].iov_base = static_cast<uint8_t*>(Parts[First].iov_base) + Left;
+				Parts[First].iov_len -= Left;
+			}
+		}
+		return true;
+	}
+
+	bool SendText(int Fd, const std::string& Text)
+	{
+		return SendFrame(Fd, std::vector<uint8_t>(Text.begin(), Text.end()));
+	}
+
+	int ListenTcp(const std::string& Host, int Port)
+	{
+		const int Fd = socket(AF_INET, SOCK_STREAM, 0);
+		const int Enable = 1;
+		setsockopt(Fd, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable));
+		sockaddr_in Address = {};
+		Address.sin_family = AF_INET;
+		Address.sin_port = htons((uint16_t)Port);
+		if (inet_pton(AF_INET, Host.c_str(), &Address.sin_addr) != 1
+			|| bind(Fd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || listen(Fd, 16) != 0)
+		{
+			std::perror("Can not listen on the tcp port");
+			close(Fd);
+			return -1;
+		}
+		return Fd;
+	}
+
+	int ListenUnix(const std::string& Path)
+	{
+		const int Fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		sockaddr_un Address = {};
+		Address.sun_family = AF_UNIX;
+		std::strncpy(Address.sun_path, Path.c_str(), sizeof(Address.sun_path) - 1);
+		unlink(Path.c_str());
+		if (bind(Fd, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || listen(Fd, 16) != 0)
+		{
+			std::perror("Can not listen on the unix socket");
+			close(Fd);
+			return -1;
+		}
+		return Fd;
+	}
+
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: lychsim_mock_server [options]\n"
+			"  --port N          tcp port, 9000\n"
+			"  --host ADDR       address to listen on, 127.0.0.1\n"
+			"  --unix            also listen on /tmp/unrealcv_<port>.socket\n"
+			"  --unix-path PATH  listen on this unix socket instead\n"
+			"  --width N         camera width, 640\n"
+			"  --height N        camera height, 480\n"
+			"  --cameras N       number of cameras, 2\n"
+			"  --objects N       number of objects, 64\n"
+			"  --render-us N     microseconds added to every capture, 0\n"
+			"  --png-level N     zlib level of png replies, -1 for the default\n");
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	LychSim::Mock::FMockServerConfig Config;
+	std::string Host = "127.0.0.1";
+	std::string UnixPath;
+	bool bUnix = false;
+	for (int Index = 1; Index < Argc; Index++)
+	{
+		const std::string Arg = Argv[Index];
+		const char* Value = Index + 1 < Argc ? Argv[Index + 1] : nullptr;
+		auto IntValue = [&](int& Out)
+		{
+			if (!Value)
+			{
+				std::fprintf(stderr, "%s needs a value\n", Arg.c_str());
+				std::exit(2);
+			}
+			Out = std::atoi(Value);
+			Index++;
+		};
+		if (Arg == "--port") IntValue(Config.Port);
+		else if (Arg == "--width") IntValue(Config.Width);
+		else if (Arg == "--height") IntValue(Config.Height);
+		else if (Arg == "--cameras") IntValue(Config.NumCameras);
+		else if (Arg == "--objects") IntValue(Config.NumObjects);
+		else if (Arg == "--render-us") IntValue(Config.RenderMicroseconds);
+		else if (Arg == "--png-level") IntValue(Config.PngLevel);
+		else if (Arg == "--unix") bUnix = true;
+		else if (Arg == "--unix-path" && Value) { UnixPath = Value; bUnix = true; Index++; }
+		else if (Arg == "--host" && Value) { Host = Value; Index++; }
+		else
+		{
+			PrintUsage();
+			return Arg == "--help" || Arg == "-h" ? 0 : 2;
+		}
+	}
+	if (bUnix && UnixPath.empty())
+	{
+		UnixPath = "/tmp/unrealcv_" + std::to_string(Config.Port) + ".socket";
+	}
+
+	std::signal(SIGPIPE, SIG_IGN);
+	std::signal(SIGINT, HandleStopSignal);
+	std::signal(SIGTERM, HandleStopSignal);
+
+	const int TcpListener = ListenTcp(Host, Config.Port);
+	const int UnixListener = bUnix ? ListenUnix(UnixPath) : -1;
+	if (TcpListener < 0 || (bUnix && UnixListener < 0))
+	{
+		return 1;
+	}
+	LychSim::Mock::FMockServer Server(Config);
+	std::printf("LychSim mock server listening on %s:%d%s%s\n", Host.c_str(), Config.Port, bUnix ? " and " : "", UnixPath.c_str());
+	std::fflush(stdout);
+
+	std::vector<FConnection> Connections;
+	std::vector<uint8_t> ReceiveBuffer(256 * 1024);
+	std::vector<uint8_t> Reply;
+	const uint8_t* Body = nullptr;
+	size_t BodySize = 0;
+	while (!bStopRequested)
+	{
+		std::vector<pollfd> Fds;
+		Fds.push_back({ TcpListener, POLLIN, 0 });
+		Fds.push_back({ UnixListener, POLLIN, 0 });
+		for (const FConnection& Connection : Connections)
+		{
+			Fds.push_back({ Connection.Fd, POLLIN, 0 });
+		}
+		if (poll(Fds.data(), Fds.size(), 500) <= 0)
+		{
+			continue;
+		}
+
+		for (int Listener = 0; Listener < 2; Listener++)
+		{
+			if (Fds[Listener].fd < 0 || !(Fds[Listener].revents & POLLIN))
+			{
+				continue;
+			}
+			FConnection Connection;
+			Connection.Fd = accept(Fds[Listener].fd, nullptr, nullptr);
+			Connection.bUnix = Listener == 1;
+			if (Connection.Fd < 0)
+			{
+				continue;
+			}
+			if (!Connection.bUnix)
+			{
+				const int Enable = 1;
+				setsockopt(Connection.Fd, IPPROTO_TCP, TCP_NODELAY, &Enable, sizeof(Enable));
+			}
+			// The confirmations of the plugin
+			SendText(Connection.Fd, Connection.bUnix ? "connected to UDS server\n" : "connected to LychSimMock");
+			Connections.push_back(std::move(Connection));
+		}
+
+		for (size_t Index = 2; Index < Fds.size(); Index++)
+		{
+			if (!(Fds[Index].revents & (POLLIN | POLLHUP | POLLERR)))
+			{
+				continue;
+			}
+			FConnection& Connection = Connections[Index - 2];
+			const ssize_t Received = recv(Connection.Fd, ReceiveBuffer.data(), ReceiveBuffer.size(), 0);
+			bool bOpen = Received > 0;
+			if (bOpen)
+			{
+				Connection.Reader.Append(ReceiveBuffer.data(), (size_t)Received);
+				const uint8_t* Payload = nullptr;
+				uint32_t PayloadSize = 0;
+				while (bOpen && Connection.Reader.Next(Payload, PayloadSize))
+				{
+					if (Server.HandlePayload(std::string_view(reinterpret_cast<const char*>(Payload), PayloadSize), Reply, Body, BodySize))
+					{
+						bOpen = SendFrame(Connection.Fd, Reply, Body, BodySize);
+					}
+				}
+				if (Connection.Reader.GetError() != LychSim::Core::EFrameError::None)
+				{
+					std::fprintf(stderr, "Closing a connection, %s\n", LychSim::Core::GetFrameErrorName(Connection.Reader.GetError()));
+					bOpen = false;
+				}
+			}
+			if (!bOpen)
+			{
+				close(Connection.Fd);
+				Connection.Fd = -1;
+			}
+		}
+		Connections.erase(std::remove_if(Connections.begin(), Connections.end(), [](const FConnection& Connection) { return Connection.Fd < 0; }), Connections.end());
+	}
+
+	for (const FConnection& Connection : Connections)
+	{
+		close(Connection.Fd);
+	}
+	close(TcpListener);
+	if (UnixListener >= 0)
+	{
+		close(UnixListener);
+		unlink(UnixPath.c_str());
+	}
+	std::printf("Served %llu requests\n", (unsigned long long)Server.GetNumRequests());
+	return 0;
+}
@@ -0,0 +1,219 @@
+#include "MockScene.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr float DegToRad = 3.14159265f / 180.0f;
+
+	/** Same sequence on every run, so replies can be compared between runs */
+	uint32_t NextRandom(uint32_t& State)
+	{
+		State = State * 1664525u + 1013904223u;
+		return State >> 8;
+	}
+
+	float RandomRange(uint32_t& State, float Min, float Max)
+	{
+		return Min + (Max - Min) * (float)(NextRandom(State) & 0xFFFF) / 65535.0f;
+	}
+
+	uint8_t ToByte(float Value)
+	{
+		return (uint8_t)std::min(255.0f, std::max(0.0f, Value));
+	}
+}
+
+LychSim::Mock::FMockScene::FMockScene(int NumObjects, int NumCameras, int Width, int Height)
+{
+	uint32_t State = 20240613;
+	Objects.resize(std::max(NumObjects, 0));
+	for (size_t Index = 0; Index < Objects.size(); Index++)
+	{
+		FMockObject& Object = Objects[Index];
+		Object.Name = "Object_" + std::to_string(Index);
+		Object.Location[0] = RandomRange(State, 300, 3000);
+		Object.Location[1] = RandomRange(State, -900, 900);
+		Object.Location[2] = RandomRange(State, -300, 300);
+		Object.Rotation[1] = RandomRange(State, -180, 180);
+		for (float& Extent : Object.Extent)
+		{
+			Extent = RandomRange(State, 20, 120);
+		}
+		// Distinct and never black, black is the background of the mask
+		const uint32_t Hash = (uint32_t)(Index + 1) * 2654435761u;
+		Object.Color[0] = (uint8_t)(Hash >> 24) | 0x10;
+		Object.Color[1] = (uint8_t)(Hash >> 16);
+		Object.Color[2] = (uint8_t)(Index & 0xFF);
+	}
+
+	Cameras.resize(std::max(NumCameras, 1));
+	for (size_t Index = 0; Index < Cameras.size(); Index++)
+	{
+		FMockCamera& Camera = Cameras[Index];
+		Camera.Location[1] = (float)Index * 100.0f;
+		Camera.Rotation[1] = (float)Index * 5.0f;
+		Camera.Width = Width;
+		Camera.Height = Height;
+	}
+}
+
+LychSim::Mock::FMockObject* LychSim::Mock::FMockScene::FindObject(const std::string& Name)
+{
+	for (FMockObject& Object : Objects)
+	{
+		if (Object.Name == Name)
+		{
+			return &Object;
+		}
+	}
+	return nullptr;
+}
+
+std::vector<LychSim::Mock::FMockScene::FRect> LychSim::Mock::FMockScene::Project(const FMockCamera& Camera, int Width, int Height) const
+{
+	const float Yaw = Camera.Rotation[1] * DegToRad;
+	const float CosYaw = std::cos(Yaw), SinYaw = std::sin(Yaw);
+	const float Focal = (float)Width * 0.5f / std::tan(std::max(Camera.Fov, 1.0f) * 0.5f * DegToRad);
+
+	std::vector<FRect> Rects;
+	Rects.reserve(Objects.size());
+	for (const FMockObject& Object : Objects)
+	{
+		const float DX = Object.Location[0] - Camera.Location[0];
+		const float DY = Object.Location[1] - Camera.Location[1];
+		const float DZ = Object.Location[2] - Camera.Location[2];
+		const float Forward = DX * CosYaw + DY * SinYaw;
+		const float Right = -DX * SinYaw + DY * CosYaw;
+		if (Forward < 10.0f)
+		{
+			continue;
+		}
+		const float CenterX = (float)Width * 0.5f + Focal * Right / Forward;
+		const float CenterY = (float)Height * 0.5f - Focal * DZ / Forward;
+		const float HalfWidth = Focal * Object.Extent[1] * Object.Scale[1] / Forward;
+		const float HalfHeight = Focal * Object.Extent[2] * Object.Scale[2] / Forward;
+
+		FRect Rect;
+		Rect.MinX = std::max(0, (int)std::floor(CenterX - HalfWidth));
+		Rect.MinY = std::max(0, (int)std::floor(CenterY - HalfHeight));
+		Rect.MaxX = std::min(Width, (int)std::ceil(CenterX + HalfWidth));
+		Rect.MaxY = std::min(Height, (int)std::ceil(CenterY + HalfHeight));
+		Rect.Depth = Forward - Object.Extent[0] * Object.Scale[0];
+		Rect.Object = &Object;
+		if (Rect.MinX < Rect.MaxX && Rect.MinY < Rect.MaxY)
+		{
+			Rects.push_back(Rect);
+		}
+	}
+	std::sort(Rects.begin(), Rects.end(), [](const FRect& A, const FRect& B) { return A.Depth > B.Depth; });
+	return Rects;
+}
+
+void LychSim::Mock::FMockScene::RenderLit(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out)
+{
+	Out.resize((size_t)Width * Height * 4);
+	const int Shift = (int)(NumFrames++ % 256);
+
+	// Sky to ground gradient with a texture that scrolls with the frame counter
+	for (int Y = 0; Y < Height; Y++)
+	{
+		uint8_t* Row = Out.data() + (size_t)Y * Width * 4;
+		const float T = (float)Y / (float)std::max(Height - 1, 1);
+		for (int X = 0; X < Width; X++)
+		{
+			const float Noise = (float)(((X + Shift) ^ Y) & 31);
+			Row[X * 4 + 0] = ToByte(230.0f - 150.0f * T + Noise); // B
+			Row[X * 4 + 1] = ToByte(180.0f - 60.0f * T + Noise);  // G
+			Row[X * 4 + 2] = ToByte(120.0f + 20.0f * T + Noise);  // R
+			Row[X * 4 + 3] = 255;
+		}
+	}
+
+	for (const FRect& Rect : Project(Camera, Width, Height))
+	{
+		const uint8_t* Color = Rect.Object->Color;
+		const float Shade = std::max(0.3f, 1.0f - Rect.Depth / 4000.0f);
+		for (int Y = Rect.MinY; Y < Rect.MaxY; Y++)
+		{
+			uint8_t* Row = Out.data() + (size_t)Y * Width * 4;
+			// Lighter on top, as if lit from above
+			const float Light = Shade * (1.2f - 0.4f * (float)(Y - Rect.MinY) / (float)(Rect.MaxY - Rect.MinY));
+			const uint8_t Pixel[4] = { ToByte(Color[2] * Light), ToByte(Color[1] * Light), ToByte(Color[0] * Light), 255 };
+			for (int X = Rect.MinX; X < Rect.MaxX; X++)
+			{
+				std::copy(Pixel, Pixel + 4, Row + X * 4);
+			}
+		}
+	}
+}
+
+void LychSim::Mock::FMockScene::RenderSeg(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out) const
+{
+	Out.assign((size_t)Width * Height * 4, 0);
+	for (size_t Index = 3; Index < Out.size(); Index += 4)
+	{
+		Out[Index] = 255;
+	}
+	for (const FRect& Rect : Project(Camera, Width, Height))
+	{
+		const uint8_t* Color = Rect.Object->Color;
+		const uint8_t Pixel[4] = { Color[2], Color[1], Color[0], Color[3] };
+		for (int Y = Rect.MinY; Y < Rect.MaxY; Y++)
+		{
+			uint8_t* Row = Out.data() + (size_t)Y * Width * 4;
+			for (int X = Rect.MinX; X < Rect.MaxX; X++)
+			{
+				std::copy(Pixel, Pixel + 4, Row + X * 4);
+			}
+		}
+	}
+}
+
+void LychSim::Mock::FMockScene::RenderNormal(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out) const
+{
+	// Normals are packed as (n * 0.5 + 0.5) * 255, the background faces the camera
+	const uint8_t Background[4] = { 255, 128, 128, 255 };
+	Out.resize((size_t)Width * Height * 4);
+	for (size_t Index = 0; Index < Out.size(); Index += 4)
+	{
+		std::copy(Background, Background + 4, Out.data() + Index);
+	}
+	for (const FRect& Rect : Project(Camera, Width, Height))
+	{
+		// The top fifth of a box is its top face, the rest its front face
+		const int TopEnd = Rect.MinY + std::max(1, (Rect.MaxY - Rect.MinY) / 5);
+		const uint8_t Top[4] = { 255, 128, 128, 255 };
+		const uint8_t Front[4] = { 128, 128, 0, 255 };
+		for (int Y = Rect.MinY; Y < Rect.MaxY; Y++)
+		{
+			const uint8_t* Pixel = Y < TopEnd ? Top : Front;
+			uint8_t* Row = Out.data() + (size_t)Y * Width * 4;
+			for (int X = Rect.MinX; X < Rect.MaxX; X++)
+			{
+				std::copy(Pixel, Pixel + 4, Row + X * 4);
+			}
+		}
+	}
+}
+
+void LychSim::Mock::FMockScene::RenderDepth(const FMockCamera& Camera, int Width, int Height, std::vector<float>& Out) const
+{
+	// A ground plane below the horizon and a far wall above it
+	Out.resize((size_t)Width * Height);
+	for (int Y = 0; Y < Height; Y++)
+	{
+		const float Below = (float)(Y - Height / 2) / (float)std::max(Height / 2, 1);
+		const float Depth = Below > 0.01f ? std::min(10000.0f, 200.0f / Below) : 10000.0f;
+		std::fill(Out.begin() + (size_t)Y * Width, Out.begin() + (size_t)(Y + 1) * Width, Depth);
+	}
+	for (const FRect& Rect : Project(Camera, Width, Height))
+	{
+		for (int Y = Rect.MinY; Y < Rect.MaxY; Y++)
+		{
+			float* Row = Out.data() + (size_t)Y * Width;
+			std::fill(Row + Rect.MinX, Row + Rect.MaxX, Rect.Depth);
+		}
+	}
+}
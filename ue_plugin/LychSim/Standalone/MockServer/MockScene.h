@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LychSim::Mock
+{
+	struct FMockObject
+	{
+		std::string Name;
+		float Location[3] = {};
+		float Rotation[3] = {}; // Pitch, yaw, roll
+		float Scale[3] = { 1, 1, 1 };
+		float Extent[3] = { 50, 50, 50 };
+		uint8_t Color[4] = { 0, 0, 0, 255 }; // R, G, B, A of the segmentation mask
+	};
+
+	struct FMockCamera
+	{
+		float Location[3] = {};
+		float Rotation[3] = {};
+		float Fov = 90;
+		int Width = 640;
+		int Height = 480;
+	};
+
+	/**
+	 * A scene of boxes in front of the cameras, standing in for the level. The sensors draw the
+	 * boxes as screen aligned rectangles, enough for frames that change when objects move and have
+	 * the sizes and the content statistics of real ones. Every capture advances the frame counter,
+	 * which shifts the lit background, so consecutive lit frames differ.
+	 */
+	class FMockScene
+	{
+	public:
+		FMockScene(int NumObjects, int NumCameras, int Width, int Height);
+
+		std::vector<FMockObject> Objects;
+		std::vector<FMockCamera> Cameras;
+
+		FMockObject* FindObject(const std::string& Name);
+
+		/** BGRA, the layout of FColor */
+		void RenderLit(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out);
+		void RenderSeg(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out) const;
+		void RenderNormal(const FMockCamera& Camera, int Width, int Height, std::vector<uint8_t>& Out) const;
+
+		/** Distance along the view direction, in cm */
+		void RenderDepth(const FMockCamera& Camera, int Width, int Height, std::vector<float>& Out) const;
+
+		uint64_t GetNumFrames() const { return NumFrames; }
+
+	private:
+		struct FRect
+		{
+			int MinX, MinY, MaxX, MaxY; // MaxX and MaxY are exclusive
+			float Depth;
+			const FMockObject* Object;
+		};
+
+		/** The objects in front of the camera, far to near */
+		std::vector<FRect> Project(const FMockCamera& Camera, int Width, int Height) const;
+
+		uint64_t NumFrames = 0;
+	};
+}
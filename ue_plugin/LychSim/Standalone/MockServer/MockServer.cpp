@@ -0,0 +1,619 @@
+#include "MockServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "ImageEncoders.h"
+#include "LychCore/Npy.h"
+
+namespace
+{
+	enum ECaptureMode
+	{
+		CaptureLit,
+		CaptureSeg,
+		CaptureNormal,
+	};
+
+	void AppendText(std::vector<uint8_t>& Out, std::string_view Text)
+	{
+		Out.insert(Out.end(), Text.begin(), Text.end());
+	}
+
+	std::string FormatVector(const float* Values)
+	{
+		char Buffer[96];
+		std::snprintf(Buffer, sizeof(Buffer), "%.3f %.3f %.3f", Values[0], Values[1], Values[2]);
+		return Buffer;
+	}
+
+	/** Numbers as the json writer of the engine prints doubles */
+	void AppendJsonNumber(std::string& Out, double Value)
+	{
+		char Buffer[32];
+		std::snprintf(Buffer, sizeof(Buffer), "%.17g", Value);
+		Out += Buffer;
+	}
+
+	void AppendJsonArray(std::string& Out, const char* Name, const float* Values, int Num)
+	{
+		Out += '"';
+		Out += Name;
+		Out += "\":[";
+		for (int Index = 0; Index < Num; Index++)
+		{
+			if (Index > 0) Out += ',';
+			AppendJsonNumber(Out, Values[Index]);
+		}
+		Out += ']';
+	}
+
+	bool HasExtension(const std::string& Filename, const char* Extension)
+	{
+		const size_t Dot = Filename.rfind('.');
+		return Dot != std::string::npos && Filename.compare(Dot + 1, std::string::npos, Extension) == 0;
+	}
+
+	bool WriteFile(const std::string& Filename, const std::vector<uint8_t>& Data)
+	{
+		std::ofstream File(Filename, std::ios::binary);
+		File.write(reinterpret_cast<const char*>(Data.data()), (std::streamsize)Data.size());
+		return (bool)File;
+	}
+}
+
+void LychSim::Mock::FMockServer::FReply::Ok(std::string_view Message)
+{
+	AppendText(Data, Message.empty() ? std::string_view("ok") : Message);
+}
+
+void LychSim::Mock::FMockServer::FReply::Error(std::string_view Message)
+{
+	bError = true;
+	AppendText(Data, "error ");
+	AppendText(Data, Message);
+}
+
+LychSim::Mock::FMockServer::FMockServer(const FMockServerConfig& InConfig)
+	: Config(InConfig)
+	, Scene(InConfig.NumObjects, InConfig.NumCameras, InConfig.Width, InConfig.Height)
+{
+	Bind("vget /unrealcv/status", false, &FMockServer::GetStatus);
+	Bind("vget /unrealcv/version", false, &FMockServer::GetVersion);
+	Bind("vget /unrealcv/echo [str]", false, &FMockServer::Echo);
+
+	Bind("vget /cameras", false, &FMockServer::GetCameraList);
+	Bind("vget /camera/[uint]/location", false, &FMockServer::GetCameraLocation);
+	Bind("vset /camera/[uint]/location [float] [float] [float]", false, &FMockServer::SetCameraLocation);
+	Bind("vget /camera/[uint]/rotation", false, &FMockServer::GetCameraRotation);
+	Bind("vset /camera/[uint]/rotation [float] [float] [float]", false, &FMockServer::SetCameraRotation);
+	Bind("vget /camera/[uint]/fov", false, &FMockServer::GetCameraFov);
+	Bind("vget /camera/[uint]/lit [str]", false, &FMockServer::GetLit);
+	Bind("vget /camera/[uint]/object_mask [str]", false, &FMockServer::GetSeg);
+	Bind("vget /camera/[uint]/normal [str]", false, &FMockServer::GetNormal);
+	Bind("vget /camera/[uint]/depth [str]", false, &FMockServer::GetDepth);
+
+	Bind("lych cam get_loc [uint]", false, &FMockServer::GetCameraLocation);
+	Bind("lych cam set_loc [uint] [float] [float] [float]", false, &FMockServer::SetCameraLocation);
+	Bind("lych cam get_rot [uint]", false, &FMockServer::GetCameraRotation);
+	Bind("lych cam set_rot [uint] [float] [float] [float]", false, &FMockServer::SetCameraRotation);
+	Bind("lych cam get_fov [uint]", false, &FMockServer::GetCameraFov);
+	Bind("lych cam set_film_size [uint] [uint] [uint]", false, &FMockServer::SetFilmSize);
+	Bind("lych cam get_lit", true, &FMockServer::GetLit);
+	Bind("lych cam get_seg", true, &FMockServer::GetSeg);
+	Bind("lych cam get_normal", true, &FMockServer::GetNormal);
+	Bind("lych cam get_depth", true, &FMockServer::GetDepth);
+
+	Bind("lych obj list", false, &FMockServer::ListObjects);
+	Bind("lych obj get_loc", true, &FMockServer::GetObjectLocations);
+	Bind("lych obj get_rot", true, &FMockServer::GetObjectRotations);
+	Bind("lych obj set_loc", true, &FMockServer::SetObjectLocation);
+	Bind("lych obj set_rot", true, &FMockServer::SetObjectRotation);
+	Bind("lych obj get_annots", true, &FMockServer::GetObjectAnnotations);
+}
+
+void LychSim::Mock::FMockServer::Bind(const char* Template, bool bTail, FHandler Handler)
+{
+	std::string Error;
+	const int32_t RouteId = Router.Add(Template, bTail, &Error);
+	if (RouteId < 0)
+	{
+		std::fprintf(stderr, "The template %s is malformed, %s\n", Template, Error.c_str());
+		std::abort();
+	}
+	Handlers.resize(RouteId + 1);
+	Handlers[RouteId] = Handler;
+}
+
+bool LychSim::Mock::FMockServer::HandlePayload(std::string_view Payload, std::vector<uint8_t>& OutReply)
+{
+	const uint8_t* Body = nullptr;
+	size_t BodySize = 0;
+	if (!HandlePayload(Payload, OutReply, Body, BodySize))
+	{
+		return false;
+	}
+	OutReply.insert(OutReply.end(), Body, Body + BodySize);
+	return true;
+}
+
+bool LychSim::Mock::FMockServer::HandlePayload(std::string_view Payload, std::vector<uint8_t>& OutReply, const uint8_t*& OutBody, size_t& OutBodySize)
+{
+	// <id>:<command>, as the plugin reads it
+	size_t Colon = 0;
+	while (Colon < Payload.size() && Payload[Colon] >= '0' && Payload[Colon] <= '9')
+	{
+		Colon++;
+	}
+	if (Colon == 0 || Colon >= Payload.size() || Payload[Colon] != ':')
+	{
+		return false;
+	}
+	const uint32_t RequestId = (uint32_t)std::strtoul(std::string(Payload.substr(0, Colon)).c_str(), nullptr, 10);
+	std::string_view Command = Payload.substr(Colon + 1);
+	const size_t LineEnd = Command.find_first_of("\r\n");
+	if (LineEnd != std::string_view::npos)
+	{
+		Command = Command.substr(0, LineEnd);
+	}
+
+	OutReply.clear();
+	AppendText(OutReply, std::to_string((int32_t)RequestId));
+	OutReply.push_back(':');
+	FReply Reply{ OutReply };
+	Run(Command, Reply);
+	OutBody = Reply.Body;
+	OutBodySize = Reply.BodySize;
+	return true;
+}
+
+void LychSim::Mock::FMockServer::Exec(std::string_view Command, std::vector<uint8_t>& OutReply)
+{
+	FReply Reply{ OutReply };
+	Run(Command, Reply);
+	OutReply.insert(OutReply.end(), Reply.Body, Reply.Body + Reply.BodySize);
+}
+
+void LychSim::Mock::FMockServer::Run(std::string_view Command, FReply& Reply)
+{
+	NumRequests++;
+	size_t ArgsBegin = 0;
+	const int32_t RouteId = Router.Match(Command, ArgsBegin);
+	if (RouteId < 0)
+	{
+		Reply.Error("Can not find a handler for URI '" + std::string(Command) + "'");
+		return;
+	}
+	Core::ParseArgs(Command.substr(ArgsBegin), ParsedArgs);
+	(this->*Handlers[RouteId])(ParsedArgs, Reply);
+}
+
+void LychSim::Mock::FMockServer::AttachRaw(const FMockCamera& Camera, Core::ERawDType DType, int Width, int Height, int Channel,
+	const char* ChannelOrder, const void* Data, FReply& Reply) const
+{
+	Core::FRawTensorHeader Header = Core::MakeRawImageHeader(DType, Width, Height, Channel, ChannelOrder);
+	Header.FrameId = Scene.GetNumFrames();
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Header.Location[Axis] = Camera.Location[Axis];
+		Header.Rotation[Axis] = Camera.Rotation[Axis];
+	}
+	Header.Fov = Camera.Fov;
+	const size_t Offset = Reply.Data.size();
+	Reply.Data.resize(Offset + Core::RawTensorHeaderSize);
+	Core::WriteRawTensorHeader(Reply.Data.data() + Offset, Header);
+	Reply.Body = static_cast<const uint8_t*>(Data);
+	Reply.BodySize = Core::GetRawTensorSize(Header);
+}
+
+void LychSim::Mock::FMockServer::SimulateRender() const
+{
+	if (Config.RenderMicroseconds > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(Config.RenderMicroseconds));
+	}
+}
+
+void LychSim::Mock::FMockServer::GetStatus(const Core::FParsedArgs& /*Args*/, FReply& Reply)
+{
+	Reply.Ok("Is Listening\nClient Connected\n" + std::to_string(Config.Port) + "\nConfiguration\nMock server, "
+		+ std::to_string(Scene.Objects.size()) + " objects, " + std::to_string(Scene.Cameras.size()) + " cameras\n");
+}
+
+void LychSim::Mock::FMockServer::GetVersion(const Core::FParsedArgs& /*Args*/, FReply& Reply)
+{
+	Reply.Ok("0.1.0");
+}
+
+void LychSim::Mock::FMockServer::Echo(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	Reply.Ok(Args.Positionals.empty() ? std::string_view() : std::string_view(Args.Positionals[0]));
+}
+
+LychSim::Mock::FMockCamera* LychSim::Mock::FMockServer::FindCamera(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	if (Args.Positionals.empty())
+	{
+		Reply.Error("No sensor id is available");
+		return nullptr;
+	}
+	// atoi as the plugin, the id of "vget /camera/0/lit" arrives as "0/lit"
+	const int CameraId = std::atoi(Args.Positionals[0].c_str());
+	if (CameraId < 0 || CameraId >= (int)Scene.Cameras.size())
+	{
+		Reply.Error("Invalid sensor id");
+		return nullptr;
+	}
+	return &Scene.Cameras[CameraId];
+}
+
+void LychSim::Mock::FMockServer::GetCameraList(const Core::FParsedArgs& /*Args*/, FReply& Reply)
+{
+	std::string Names;
+	for (size_t Index = 0; Index < Scene.Cameras.size(); Index++)
+	{
+		Names += "FusionCameraActor_" + std::to_string(Index) + " ";
+	}
+	Reply.Ok(Names);
+}
+
+void LychSim::Mock::FMockServer::GetCameraLocation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	if (FMockCamera* Camera = FindCamera(Args, Reply))
+	{
+		Reply.Ok(FormatVector(Camera->Location));
+	}
+}
+
+void LychSim::Mock::FMockServer::SetCameraLocation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockCamera* Camera = FindCamera(Args, Reply);
+	if (!Camera) return;
+	if (Args.Positionals.size() < 4)
+	{
+		Reply.Error("Expect a sensor id and x y z");
+		return;
+	}
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Camera->Location[Axis] = std::strtof(Args.Positionals[Axis + 1].c_str(), nullptr);
+	}
+	Reply.Ok();
+}
+
+void LychSim::Mock::FMockServer::GetCameraRotation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	if (FMockCamera* Camera = FindCamera(Args, Reply))
+	{
+		Reply.Ok(FormatVector(Camera->Rotation));
+	}
+}
+
+void LychSim::Mock::FMockServer::SetCameraRotation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockCamera* Camera = FindCamera(Args, Reply);
+	if (!Camera) return;
+	if (Args.Positionals.size() < 4)
+	{
+		Reply.Error("Expect a sensor id and pitch yaw roll");
+		return;
+	}
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		Camera->Rotation[Axis] = std::strtof(Args.Positionals[Axis + 1].c_str(), nullptr);
+	}
+	Reply.Ok();
+}
+
+void LychSim::Mock::FMockServer::GetCameraFov(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	if (FMockCamera* Camera = FindCamera(Args, Reply))
+	{
+		char Buffer[32];
+		std::snprintf(Buffer, sizeof(Buffer), "%f", Camera->Fov);
+		Reply.Ok(Buffer);
+	}
+}
+
+void LychSim::Mock::FMockServer::SetFilmSize(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockCamera* Camera = FindCamera(Args, Reply);
+	if (!Camera) return;
+	if (Args.Positionals.size() != 3)
+	{
+		Reply.Error("Invalid argument");
+		return;
+	}
+	Camera->Width = std::max(1, std::atoi(Args.Positionals[1].c_str()));
+	Camera->Height = std::max(1, std::atoi(Args.Positionals[2].c_str()));
+	Reply.Ok();
+}
+
+namespace
+{
+	/** The size of the reply, -size=<w>x<h> or the size of -roi=<x>,<y>,<w>,<h>, the mock renders at that size directly */
+	bool ParseCaptureSize(const LychSim::Core::FParsedArgs& Args, int& Width, int& Height, std::string& Error)
+	{
+		if (const std::string* Size = Args.Find("size"))
+		{
+			int W = 0, H = 0;
+			if (std::sscanf(Size->c_str(), "%dx%d", &W, &H) != 2 || W <= 0 || H <= 0)
+			{
+				Error = "Invalid size " + *Size + ", expect <w>x<h>";
+				return false;
+			}
+			Width = W;
+			Height = H;
+		}
+		else if (const std::string* Roi = Args.Find("roi"))
+		{
+			int X = 0, Y = 0, W = 0, H = 0;
+			if (std::sscanf(Roi->c_str(), "%d,%d,%d,%d", &X, &Y, &W, &H) != 4 || W <= 0 || H <= 0)
+			{
+				Error = "Invalid roi " + *Roi + ", expect <x>,<y>,<w>,<h>";
+				return false;
+			}
+			Width = W;
+			Height = H;
+		}
+		return true;
+	}
+}
+
+void LychSim::Mock::FMockServer::CaptureColor(const Core::FParsedArgs& Args, FReply& Reply, int Mode)
+{
+	FMockCamera* Camera = FindCamera(Args, Reply);
+	if (!Camera) return;
+	int Width = Camera->Width, Height = Camera->Height;
+	std::string Error;
+	if (!ParseCaptureSize(Args, Width, Height, Error))
+	{
+		Reply.Error(Error);
+		return;
+	}
+	const std::string Filename = Args.Positionals.size() > 1 ? Args.Positionals[1] : std::string();
+
+	SimulateRender();
+	if (Mode == CaptureLit) Scene.RenderLit(*Camera, Width, Height, Pixels);
+	else if (Mode == CaptureSeg) Scene.RenderSeg(*Camera, Width, Height, Pixels);
+	else Scene.RenderNormal(*Camera, Width, Height, Pixels);
+
+	if (Filename == "raw")
+	{
+		AttachRaw(*Camera, Core::ERawDType::UInt8, Width, Height, 4, "BGRA", Pixels.data(), Reply);
+		return;
+	}
+
+	// A bare extension is the binary mode, anything else is a file to write
+	std::vector<uint8_t> Encoded;
+	const bool bPng = Filename == "png" || HasExtension(Filename, "png");
+	const bool bBmp = Filename == "bmp" || HasExtension(Filename, "bmp");
+	if (bPng) EncodePng(Pixels.data(), Width, Height, Encoded, Config.PngLevel);
+	else if (bBmp) EncodeBmp(Pixels.data(), Width, Height, Encoded);
+	else
+	{
+		Reply.Error("Invalid filename type, filename " + Filename);
+		return;
+	}
+
+	if (Filename == "png" || Filename == "bmp")
+	{
+		Reply.Data.insert(Reply.Data.end(), Encoded.begin(), Encoded.end());
+	}
+	else if (WriteFile(Filename, Encoded))
+	{
+		Reply.Ok(Filename);
+	}
+	else
+	{
+		Reply.Error("Can not write " + Filename);
+	}
+}
+
+void LychSim::Mock::FMockServer::GetLit(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	CaptureColor(Args, Reply, CaptureLit);
+}
+
+void LychSim::Mock::FMockServer::GetSeg(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	CaptureColor(Args, Reply, CaptureSeg);
+}
+
+void LychSim::Mock::FMockServer::GetNormal(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	CaptureColor(Args, Reply, CaptureNormal);
+}
+
+void LychSim::Mock::FMockServer::GetDepth(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockCamera* Camera = FindCamera(Args, Reply);
+	if (!Camera) return;
+	int Width = Camera->Width, Height = Camera->Height;
+	std::string Error;
+	if (!ParseCaptureSize(Args, Width, Height, Error))
+	{
+		Reply.Error(Error);
+		return;
+	}
+	const std::string Filename = Args.Positionals.size() > 1 ? Args.Positionals[1] : std::string();
+	if (Filename != "npy" && Filename != "raw" && !HasExtension(Filename, "npy"))
+	{
+		Reply.Error("Invalid filename type, filename " + Filename);
+		return;
+	}
+
+	SimulateRender();
+	Scene.RenderDepth(*Camera, Width, Height, Depth);
+	if (Filename == "raw")
+	{
+		AttachRaw(*Camera, Core::ERawDType::Float32, Width, Height, 1, "D", Depth.data(), Reply);
+		return;
+	}
+	if (Filename == "npy")
+	{
+		Core::AppendNpy(Reply.Data, Depth.data(), Width, Height, 1);
+		return;
+	}
+	std::vector<uint8_t> Encoded;
+	Core::AppendNpy(Encoded, Depth.data(), Width, Height, 1);
+	if (WriteFile(Filename, Encoded))
+	{
+		Reply.Ok(Filename);
+	}
+	else
+	{
+		Reply.Error("Can not write " + Filename);
+	}
+}
+
+void LychSim::Mock::FMockServer::ListObjects(const Core::FParsedArgs& /*Args*/, FReply& Reply)
+{
+	std::string Names;
+	for (const FMockObject& Object : Scene.Objects)
+	{
+		Names += Object.Name + " ";
+	}
+	Reply.Ok(Names);
+}
+
+namespace
+{
+	/** -all or the ids in the positionals, nullptr for the ones not found */
+	std::vector<std::pair<std::string, LychSim::Mock::FMockObject*>> SelectObjects(const LychSim::Core::FParsedArgs& Args, LychSim::Mock::FMockScene& Scene)
+	{
+		std::vector<std::pair<std::string, LychSim::Mock::FMockObject*>> Selected;
+		if (Args.HasFlag("all"))
+		{
+			for (LychSim::Mock::FMockObject& Object : Scene.Objects)
+			{
+				Selected.emplace_back(Object.Name, &Object);
+			}
+		}
+		else
+		{
+			for (const std::string& Id : Args.Positionals)
+			{
+				Selected.emplace_back(Id, Scene.FindObject(Id));
+			}
+		}
+		return Selected;
+	}
+
+	template<typename FWriteRow>
+	std::string WriteOutputs(const std::vector<std::pair<std::string, LychSim::Mock::FMockObject*>>& Selected, FWriteRow&& WriteRow)
+	{
+		std::string Out = "{\"status\":\"ok\",\"outputs\":[";
+		for (size_t Index = 0; Index < Selected.size(); Index++)
+		{
+			if (Index > 0) Out += ',';
+			Out += "{\"object_id\":\"" + Selected[Index].first + "\",";
+			if (!Selected[Index].second)
+			{
+				Out += "\"status\":\"not_found\"}";
+				continue;
+			}
+			Out += "\"status\":\"ok\",";
+			WriteRow(Out, *Selected[Index].second);
+			Out += '}';
+		}
+		Out += "]}";
+		return Out;
+	}
+}
+
+void LychSim::Mock::FMockServer::GetObjectLocations(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	Reply.Ok(WriteOutputs(SelectObjects(Args, Scene), [](std::string& Out, const FMockObject& Object)
+	{
+		AppendJsonArray(Out, "location", Object.Location, 3);
+	}));
+}
+
+void LychSim::Mock::FMockServer::GetObjectRotations(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	Reply.Ok(WriteOutputs(SelectObjects(Args, Scene), [](std::string& Out, const FMockObject& Object)
+	{
+		AppendJsonArray(Out, "rotation", Object.Rotation, 3);
+	}));
+}
+
+void LychSim::Mock::FMockServer::SetObjectLocation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockObject* Object = Args.Positionals.empty() ? nullptr : Scene.FindObject(Args.Positionals[0]);
+	if (Args.Positionals.empty()) Reply.Ok("{\"status\":\"Object ID not specified\"}");
+	else if (!Object) Reply.Ok("{\"status\":\"Object not found\"}");
+	else if (Args.Positionals.size() < 4) Reply.Error("Expect an object id and x y z");
+	else
+	{
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Object->Location[Axis] = std::strtof(Args.Positionals[Axis + 1].c_str(), nullptr);
+		}
+		Reply.Ok("{\"status\":\"ok\"}");
+	}
+}
+
+void LychSim::Mock::FMockServer::SetObjectRotation(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	FMockObject* Object = Args.Positionals.empty() ? nullptr : Scene.FindObject(Args.Positionals[0]);
+	if (Args.Positionals.empty()) Reply.Ok("{\"status\":\"Object ID not specified\"}");
+	else if (!Object) Reply.Ok("{\"status\":\"Object not found\"}");
+	else if (Args.Positionals.size() < 4) Reply.Error("Expect an object id and pitch yaw roll");
+	else
+	{
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Object->Rotation[Axis] = std::strtof(Args.Positionals[Axis + 1].c_str(), nullptr);
+		}
+		Reply.Ok("{\"status\":\"ok\"}");
+	}
+}
+
+void LychSim::Mock::FMockServer::GetObjectAnnotations(const Core::FParsedArgs& Args, FReply& Reply)
+{
+	const std::string* Format = Args.Find("format");
+	if (Format && *Format != "json")
+	{
+		Reply.Error("The mock server only replies json annotations");
+		return;
+	}
+	// The fields of LychSim::WriteObjectSnapshotJson, the boxes are axis aligned in the mock scene
+	Reply.Ok(WriteOutputs(SelectObjects(Args, Scene), [](std::string& Out, const FMockObject& Object)
+	{
+		char Guid[40];
+		std::snprintf(Guid, sizeof(Guid), "%032zX", std::hash<std::string>()(Object.Name));
+		const float Extent[3] = { Object.Extent[0] * Object.Scale[0], Object.Extent[1] * Object.Scale[1], Object.Extent[2] * Object.Scale[2] };
+		const float Color[4] = { (float)Object.Color[0], (float)Object.Color[1], (float)Object.Color[2], (float)Object.Color[3] };
+
+		Out += "\"guid\":\"";
+		Out += Guid;
+		Out += "\",\"aabb\":{";
+		AppendJsonArray(Out, "center", Object.Location, 3);
+		Out += ',';
+		AppendJsonArray(Out, "extent", Extent, 3);
+		Out += "},\"obb\":{";
+		AppendJsonArray(Out, "center", Object.Location, 3);
+		Out += ',';
+		AppendJsonArray(Out, "extent", Extent, 3);
+		Out += ',';
+		AppendJsonArray(Out, "rotation", Object.Rotation, 3);
+		Out += "},\"bounds\":{";
+		AppendJsonArray(Out, "center", Object.Location, 3);
+		Out += ',';
+		AppendJsonArray(Out, "extent", Extent, 3);
+		Out += "},";
+		AppendJsonArray(Out, "location", Object.Location, 3);
+		Out += ',';
+		AppendJsonArray(Out, "rotation", Object.Rotation, 3);
+		Out += ',';
+		AppendJsonArray(Out, "scale", Object.Scale, 3);
+		Out += ',';
+		AppendJsonArray(Out, "color", Color, 4);
+	}));
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LychCore/ArgParse.h"
+#include "LychCore/CommandRouter.h"
+#include "LychCore/RawTensor.h"
+#include "MockScene.h"
+
+namespace LychSim::Mock
+{
+	struct FMockServerConfig
+	{
+		int Port = 9000;
+		int NumObjects = 64;
+		int NumCameras = 2;
+		int Width = 640;
+		int Height = 480;
+
+		/** Added to every capture, as the time the engine would spend rendering */
+		int RenderMicroseconds = 0;
+
+		/** zlib level of the png replies, -1 for the default */
+		int PngLevel = -1;
+	};
+
+	/**
+	 * Answer requests as the plugin does, without the engine. The commands of the python clients
+	 * are registered with the same templates and reply formats as the plugin, with a mock scene
+	 * behind them (see MockScene.h). This class only knows payloads, Main.cpp owns the sockets.
+	 */
+	class FMockServer
+	{
+	public:
+		explicit FMockServer(const FMockServerConfig& InConfig);
+
+		/** Reply to a "<id>:<command>" payload with "<id>:<reply>". False if the payload has no id, then nothing is sent, as the plugin does */
+		bool HandlePayload(std::string_view Payload, std::vector<uint8_t>& OutReply);
+
+		/**
+		 * As above, but the pixels of a raw reply are not appended to OutReply. They are OutBody,
+		 * valid until the next request, and are sent after OutReply in the same frame.
+		 */
+		bool HandlePayload(std::string_view Payload, std::vector<uint8_t>& OutReply, const uint8_t*& OutBody, size_t& OutBodySize);
+
+		/** Run one command and append the reply without the id */
+		void Exec(std::string_view Command, std::vector<uint8_t>& OutReply);
+
+		const FMockServerConfig& GetConfig() const { return Config; }
+		FMockScene& GetScene() { return Scene; }
+		uint64_t GetNumRequests() const { return NumRequests; }
+
+	private:
+		struct FReply
+		{
+			std::vector<uint8_t>& Data;
+			bool bError = false;
+
+			/** Sent after Data, see HandlePayload */
+			const uint8_t* Body = nullptr;
+			size_t BodySize = 0;
+
+			void Ok(std::string_view Message = std::string_view());
+			void Error(std::string_view Message);
+		};
+
+		using FHandler = void (FMockServer::*)(const Core::FParsedArgs& Args, FReply& Reply);
+
+		void Bind(const char* Template, bool bTail, FHandler Handler);
+		void Run(std::string_view Command, FReply& Reply);
+		void AttachRaw(const FMockCamera& Camera, Core::ERawDType DType, int Width, int Height, int Channel,
+			const char* ChannelOrder, const void* Data, FReply& Reply) const;
+
+		FMockCamera* FindCamera(const Core::FParsedArgs& Args, FReply& Reply);
+		void CaptureColor(const Core::FParsedArgs& Args, FReply& Reply, int Mode);
+		void CaptureDepth(const Core::FParsedArgs& Args, FReply& Reply);
+		void SimulateRender() const;
+
+		// Plugin
+		void GetStatus(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetVersion(const Core::FParsedArgs& Args, FReply& Reply);
+		void Echo(const Core::FParsedArgs& Args, FReply& Reply);
+
+		// lych cam, and the vget /camera/... commands of UnrealCv_API
+		void GetCameraList(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetCameraLocation(const Core::FParsedArgs& Args, FReply& Reply);
+		void SetCameraLocation(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetCameraRotation(const Core::FParsedArgs& Args, FReply& Reply);
+		void SetCameraRotation(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetCameraFov(const Core::FParsedArgs& Args, FReply& Reply);
+		void SetFilmSize(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetLit(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetSeg(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetNormal(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetDepth(const Core::FParsedArgs& Args, FReply& Reply);
+
+		// lych obj
+		void ListObjects(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetObjectLocations(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetObjectRotations(const Core::FParsedArgs& Args, FReply& Reply);
+		void SetObjectLocation(const Core::FParsedArgs& Args, FReply& Reply);
+		void SetObjectRotation(const Core::FParsedArgs& Args, FReply& Reply);
+		void GetObjectAnnotations(const Core::FParsedArgs& Args, FReply& Reply);
+
+		FMockServerConfig Config;
+		FMockScene Scene;
+		Core::FCommandRouter Router;
+		std::vector<FHandler> Handlers; // By route id
+
+		/** Reused between requests */
+		Core::FParsedArgs ParsedArgs;
+		std::vector<uint8_t> Pixels;
+		std::vector<float> Depth;
+
+		uint64_t NumRequests = 0;
+	};
+}
@@ -0,0 +1,103 @@
+// Tokens and switches of ParseArgs, which replaced the FParse based parsing of command tails.
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LychCore/ArgParse.h"
+
+using LychSim::Core::FParsedArgs;
+
+namespace
+{
+	std::vector<std::string> Tokens(std::string_view Str)
+	{
+		std::vector<std::string> Result;
+		std::string Token;
+		while (LychSim::Core::NextToken(Str, Token))
+		{
+			Result.push_back(Token);
+		}
+		return Result;
+	}
+
+	FParsedArgs Parse(std::string_view Tail)
+	{
+		FParsedArgs Args;
+		LychSim::Core::ParseArgs(Tail, Args);
+		return Args;
+	}
+
+	using FStrings = std::vector<std::string>;
+}
+
+TEST(ArgParse, SplitsTokensAtWhitespace)
+{
+	EXPECT_EQ(Tokens("0 png"), (FStrings{ "0", "png" }));
+	EXPECT_EQ(Tokens("  0\tpng \r\n"), (FStrings{ "0", "png" }));
+	EXPECT_EQ(Tokens(""), FStrings{});
+	EXPECT_EQ(Tokens("   "), FStrings{});
+}
+
+TEST(ArgParse, HandlesQuotes)
+{
+	// A quoted token loses its quotes, a quote inside a token keeps them and joins the words
+	EXPECT_EQ(Tokens("\"a b\" c"), (FStrings{ "a b", "c" }));
+	EXPECT_EQ(Tokens("-name=\"a b\" c"), (FStrings{ "-name=\"a b\"", "c" }));
+	EXPECT_EQ(Tokens("\"a b"), (FStrings{ "a b" }));
+	EXPECT_EQ(Tokens("\"a\"b c"), (FStrings{ "a", "b", "c" }));
+
+	const FParsedArgs Args = Parse("\"/tmp/my file.png\" -label=\"a b\"");
+	EXPECT_EQ(Args.Positionals, (FStrings{ "/tmp/my file.png" }));
+	ASSERT_NE(Args.Find("label"), nullptr);
+	EXPECT_EQ(*Args.Find("label"), "\"a b\"");
+}
+
+TEST(ArgParse, SplitsPositionalsSwitchesAndFlags)
+{
+	const FParsedArgs Args = Parse("0 png -size=64x64 -fast -roi=0,0,32,32");
+	EXPECT_EQ(Args.Positionals, (FStrings{ "0", "png" }));
+	ASSERT_EQ(Args.Kwargs.size(), 2u);
+	EXPECT_EQ(Args.Kwargs[0].first, "size");
+	EXPECT_EQ(Args.Kwargs[0].second, "64x64");
+	EXPECT_EQ(*Args.Find("roi"), "0,0,32,32");
+	EXPECT_EQ(Args.Find("missing"), nullptr);
+	EXPECT_TRUE(Args.HasFlag("fast"));
+	EXPECT_FALSE(Args.HasFlag("size"));
+}
+
+TEST(ArgParse, KeepsNegativeNumbersPositional)
+{
+	const FParsedArgs Args = Parse("-1 -.5 -0.5 - -x");
+	EXPECT_EQ(Args.Positionals, (FStrings{ "-1", "-.5", "-0.5", "-" }));
+	EXPECT_EQ(Args.Flags, (FStrings{ "x" }));
+}
+
+TEST(ArgParse, LaterKeyWins)
+{
+	const FParsedArgs Args = Parse("-size=1 -format=png -size=2");
+	ASSERT_EQ(Args.Kwargs.size(), 3u);
+	EXPECT_EQ(Args.Kwargs[0].second, "1");
+	EXPECT_EQ(Args.Kwargs[2].second, "2");
+	EXPECT_EQ(*Args.Find("size"), "2");
+	EXPECT_EQ(*Args.Find("format"), "png");
+}
+
+TEST(ArgParse, EmptyValuesAndKeys)
+{
+	const FParsedArgs Args = Parse("-size= -=x");
+	ASSERT_EQ(Args.Kwargs.size(), 2u);
+	EXPECT_EQ(*Args.Find("size"), "");
+	EXPECT_EQ(*Args.Find(""), "x");
+}
+
+TEST(ArgParse, ResetsTheOutput)
+{
+	FParsedArgs Args;
+	LychSim::Core::ParseArgs("a -b=1 -c", Args);
+	LychSim::Core::ParseArgs("d", Args);
+	EXPECT_EQ(Args.Positionals, (FStrings{ "d" }));
+	EXPECT_TRUE(Args.Kwargs.empty());
+	EXPECT_TRUE(Args.Flags.empty());
+}
@@ -0,0 +1,191 @@
+// Matching of command templates by FCommandRouter, which replaced the regular expressions of the
+// dispatcher. The cases pin the behavior the dispatcher relies on.
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "LychCore/CommandRouter.h"
+
+using LychSim::Core::FCommandRouter;
+
+namespace
+{
+	/** The matched route, and the rest of the request from the argument offset */
+	struct FRouted
+	{
+		int32_t Id = -1;
+		std::string Args;
+	};
+
+	FRouted Route(const FCommandRouter& Router, std::string_view Request)
+	{
+		FRouted Result;
+		size_t ArgsBegin = 0;
+		Result.Id = Router.Match(Request, ArgsBegin);
+		if (Result.Id >= 0)
+		{
+			EXPECT_LE(ArgsBegin, Request.size());
+			Result.Args = std::string(Request.substr(ArgsBegin));
+		}
+		return Result;
+	}
+}
+
+TEST(CommandRouter, RejectsMalformedTemplates)
+{
+	FCommandRouter Router;
+	std::string Error;
+	EXPECT_EQ(Router.Add("vget /x/[int]", false, &Error), -1);
+	EXPECT_FALSE(Error.empty());
+	EXPECT_EQ(Router.Add("vget /x/[str", false), -1);
+	EXPECT_EQ(Router.Add("vget /x/str]", false), -1);
+	EXPECT_EQ(Router.Add("vget /x/[[str]]", false), -1);
+	EXPECT_EQ(Router.Num(), 0u);
+	EXPECT_EQ(Router.Add("vget /x/[str]", false), 0);
+}
+
+TEST(CommandRouter, AnchorsAtTheStartAfterSpaces)
+{
+	FCommandRouter Router;
+	Router.Add("vget /objects", false);
+	EXPECT_EQ(Route(Router, "vget /objects").Id, 0);
+	EXPECT_EQ(Route(Router, "   vget /objects").Id, 0);
+	EXPECT_EQ(Route(Router, "vget /objects   ").Id, 0);
+	// The regular expressions searched the whole request, the router does not
+	EXPECT_EQ(Route(Router, "xvget /objects").Id, -1);
+	EXPECT_EQ(Route(Router, "echo vget /objects").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /objects/0").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /objects extra").Id, -1);
+	EXPECT_EQ(Route(Router, "\tvget /objects").Id, -1);
+	EXPECT_EQ(Route(Router, "").Id, -1);
+}
+
+TEST(CommandRouter, MatchesFloats)
+{
+	FCommandRouter Router;
+	Router.Add("vset /action/eyes_distance [float]", false);
+	for (const char* Value : { "5", "-5", "+5", "0.5", ".5", "-.5", "+.5", "12.25", "-0.0" })
+	{
+		EXPECT_EQ(Route(Router, std::string("vset /action/eyes_distance ") + Value).Id, 0) << Value;
+	}
+	for (const char* Value : { "1.", "-", "+", ".", "-.", "1.2.3", "1-2", "--1", "1e3", "abc", "" })
+	{
+		EXPECT_EQ(Route(Router, std::string("vset /action/eyes_distance ") + Value).Id, -1) << Value;
+	}
+}
+
+TEST(CommandRouter, MatchesUIntAndStr)
+{
+	FCommandRouter Router;
+	Router.Add("vget /camera/[uint]/lit [str]", false);
+	EXPECT_EQ(Route(Router, "vget /camera/12/lit png").Id, 0);
+	EXPECT_EQ(Route(Router, "vget /camera/12/lit /tmp/a.png").Id, 0);
+	// Both can be empty, as \d* and [^ ]* could
+	EXPECT_EQ(Route(Router, "vget /camera//lit ").Id, 0);
+	EXPECT_EQ(Route(Router, "vget /camera/-1/lit png").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /camera/1a/lit png").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /camera/0/lit a b").Id, -1);
+}
+
+TEST(CommandRouter, BacktracksOverStr)
+{
+	FCommandRouter Router;
+	// [str] can take a /, the literal after it has to be found by backtracking
+	Router.Add("vget /object/[str]/location", false);
+	const FRouted Routed = Route(Router, "vget /object/Folder/Chair/location");
+	EXPECT_EQ(Routed.Id, 0);
+	EXPECT_EQ(Routed.Args, "Folder/Chair/location");
+}
+
+TEST(CommandRouter, MatchesStrTail)
+{
+	FCommandRouter Router;
+	Router.Add("vrun [str+]", false);
+	EXPECT_EQ(Route(Router, "vrun stat fps").Args, "stat fps");
+	EXPECT_EQ(Route(Router, "vrun stat").Id, 0);
+	EXPECT_EQ(Route(Router, "vrun stat   fps  ").Id, 0);
+	EXPECT_EQ(Route(Router, "vrun stat fps\n").Id, 0);
+	EXPECT_EQ(Route(Router, "vrun stat fps\r\n").Id, 0);
+	EXPECT_EQ(Route(Router, "vrun ").Id, -1);
+	EXPECT_EQ(Route(Router, "vrun").Id, -1);
+	EXPECT_EQ(Route(Router, "vrun  stat").Id, -1);
+}
+
+TEST(CommandRouter, AllowsOneTrailingLineBreak)
+{
+	FCommandRouter Router;
+	Router.Add("vget /unrealcv/status", false);
+	EXPECT_EQ(Route(Router, "vget /unrealcv/status\n").Id, 0);
+	EXPECT_EQ(Route(Router, "vget /unrealcv/status  \r\n").Id, 0);
+	EXPECT_EQ(Route(Router, "vget /unrealcv/status\n\n").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /unrealcv/status\r").Id, -1);
+	EXPECT_EQ(Route(Router, "vget /unrealcv/status\nvget").Id, -1);
+}
+
+TEST(CommandRouter, MatchesTailRoutes)
+{
+	FCommandRouter Router;
+	Router.Add("lych cam get_lit", true);
+	EXPECT_EQ(Route(Router, "lych cam get_lit").Args, "");
+	EXPECT_EQ(Route(Router, "lych cam get_lit 0 png -size=64x64").Args, "0 png -size=64x64");
+	EXPECT_EQ(Route(Router, "lych cam get_lit   0 png  ").Args, "0 png  ");
+	EXPECT_EQ(Route(Router, "lych cam get_lit 0 png\r\n").Args, "0 png\r\n");
+	EXPECT_EQ(Route(Router, "lych cam get_lit\n").Id, 0);
+	EXPECT_EQ(Route(Router, "lych cam get_litx").Id, -1);
+	EXPECT_EQ(Route(Router, "lych cam get_lit_slow 0").Id, -1);
+}
+
+TEST(CommandRouter, NewestMatchWins)
+{
+	FCommandRouter Router;
+	ASSERT_EQ(Router.Add("vget /camera/[uint]/lit [str]", false), 0);
+	ASSERT_EQ(Router.Add("vget /camera/[str]/lit [str]", false), 1);
+	EXPECT_EQ(Route(Router, "vget /camera/0/lit png").Id, 1);
+	EXPECT_EQ(Route(Router, "vget /camera/a/lit png").Id, 1);
+
+	ASSERT_EQ(Router.Add("vget /camera/[uint]/lit png", false), 2);
+	EXPECT_EQ(Route(Router, "vget /camera/0/lit png").Id, 2);
+	EXPECT_EQ(Route(Router, "vget /camera/0/lit exr").Id, 1);
+}
+
+TEST(CommandRouter, NewestMatchWinsAcrossFirstWords)
+{
+	// Routes with a fixed first word and routes without one are kept apart and merged when matching
+	FCommandRouter Router;
+	ASSERT_EQ(Router.Add("vget /x", false), 0);
+	ASSERT_EQ(Router.Add("[str] /x", false), 1);
+	ASSERT_EQ(Router.Add("vget /y", false), 2);
+	EXPECT_EQ(Route(Router, "vget /x").Id, 1);
+	EXPECT_EQ(Route(Router, "vset /x").Id, 1);
+	EXPECT_EQ(Route(Router, "vget /y").Id, 2);
+
+	ASSERT_EQ(Router.Add("[str] /y", false), 3);
+	EXPECT_EQ(Route(Router, "vget /y").Id, 3);
+}
+
+TEST(CommandRouter, ReportsArgumentOffsets)
+{
+	FCommandRouter Router;
+	Router.Add("vset /camera/[uint]/location [float] [float] [float]", false);
+	Router.Add("vget /objects", false);
+	Router.Add("lych obj get_loc", true);
+
+	std::string_view Request = "vset /camera/12/location 1 -2.5 .3";
+	size_t ArgsBegin = 0;
+	EXPECT_EQ(Router.Match(Request, ArgsBegin), 0);
+	EXPECT_EQ(ArgsBegin, std::string_view("vset /camera/").size());
+
+	Request = "  vset /camera/12/location 1 -2.5 .3";
+	EXPECT_EQ(Router.Match(Request, ArgsBegin), 0);
+	EXPECT_EQ(ArgsBegin, std::string_view("  vset /camera/").size());
+
+	// Without arguments they start at the end of the match
+	Request = "vget /objects  ";
+	EXPECT_EQ(Router.Match(Request, ArgsBegin), 1);
+	EXPECT_EQ(ArgsBegin, Request.size());
+
+	Request = " lych obj get_loc  Chair ";
+	EXPECT_EQ(Router.Match(Request, ArgsBegin), 2);
+	EXPECT_EQ(ArgsBegin, std::string_view(" lych obj get_loc  ").size());
+}